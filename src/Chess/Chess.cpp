@@ -1,7 +1,7 @@
 #include "../include/Chess/Chess.h"
 #include "ChessUtils.cpp"
 
-Chess::GameApplication::GameApplication(std::shared_ptr<LogManager> lm_ptr)
+Chess::GameApplication::GameApplication(std::shared_ptr<LogManager> lm_ptr, const std::string& fen)
 {
     this->lm = lm_ptr;
     this->chessLogger = lm->getLogger("Chess");
@@ -33,9 +33,31 @@ Chess::GameApplication::GameApplication(std::shared_ptr<LogManager> lm_ptr)
     // Initialize the chess board
     drawChessBoard();
 
+    // Set up the game, falling back to the starting position if the FEN is no good
+    if(!this->board.setFen(fen))
+    {
+        this->chessLogger->error("Invalid FEN \"{}\", starting from the initial position.", fen);
+        this->board.setStartPosition();
+    }
+
     // Initialize the pieces
     initializeChessPieces();
 
+    // The user plays white against the engine
+    this->engine = std::make_unique<EngineThread>();
+    this->engineColor = BLACK;
+    this->engineSearchId = 0;
+    this->ponderSearchId = 0;
+    this->dragFrom = SQ_NONE;
+    this->changeDetected = false;
+    this->explorerOpen = false;
+    this->showMetrics = false;
+    this->moveCounter = 0;
+    this->isWhiteTurn = this->board.sideToMove() == WHITE;
+
+    // A position with black to move starts with the engine thinking
+    startEngineSearch();
+
     this->status = Status::INITIALIZED;
     this->chessLogger->info("Board Initialized.");
 }
@@ -44,6 +66,13 @@ Chess::GameApplication::~GameApplication()
 {
     this->chessLogger->debug("Cleaning up Chess...");
 
+    // Stop the engine before the window goes away
+    if(this->engine)
+    {
+        this->engine->cancel();
+    }
+    this->engine = nullptr;
+
     this->mainWindow = nullptr;
 
     this->chessLogger->debug("Cleaned up Chess...");
@@ -53,68 +82,410 @@ void Chess::GameApplication::run()
 {
     this->status = Status::RUNNING;
 
-    // Main loop for the application
+    // Main loop for the application. Each frame handles the pending events, picks up what
+    // the engine found and redraws if anything changed, then sleeps out the rest of the
+    // frame. Nothing in here waits on the engine.
     SDL_Event event;
-    
+
     while(this->status != Status::SHUTDOWN_REQUESTED)
     {
-        bool changeDetected = false;
+        Uint32 frameStart = SDL_GetTicks();
 
         // Poll for events
-        SDL_PollEvent(&event);
+        while(SDL_PollEvent(&event))
+        {
+            this->handleEvent(event);
+        }
+
+        this->processEngineUpdates();
 
         // Keep the chess board updated
-        if (changeDetected)
+        if (this->changeDetected)
         {
-            this->drawChessBoard();
-            this->drawChessPiecesFromLatestPositions();
+            this->drawFrame();
+            this->changeDetected = false;
+        }
 
-            changeDetected = !changeDetected;
+        Uint32 frameTime = SDL_GetTicks() - frameStart;
+        if(frameTime < FRAME_TIME_MS)
+        {
+            SDL_Delay(FRAME_TIME_MS - frameTime);
         }
+    }
+
+    this->chessLogger->info("Shutdown normally.");
+}
 
-        switch(event.type)
+void Chess::GameApplication::drawFrame()
+{
+    CHESS_TRACE_SCOPE("frame");
+    this->drawChessBoard();
+    this->drawChessPiecesFromLatestPositions();
+    if(this->showMetrics)
+    {
+        this->drawMetricsOverlay();
+    }
+    this->mainWindow->render();
+}
+
+void Chess::GameApplication::handleEvent(const SDL_Event& event)
+{
+    switch(event.type)
+    {
+        // Break the loop and exit
+        case SDL_QUIT:
+            this->status = Status::SHUTDOWN_REQUESTED;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        {
+            Square from = this->squareAt(event.button.x, event.button.y);
+            this->chessLogger->debug("started dragging the mouse ({}, {})", event.button.y, event.button.x);
+
+            // Only the user's own pieces can be picked up, and only on their turn
+            if(from != SQ_NONE && this->engineSearchId == 0 && this->board.sideToMove() != this->engineColor &&
+               this->board.pieceOn(from) != NO_PIECE && colorOf(this->board.pieceOn(from)) == this->board.sideToMove())
+            {
+                this->dragFrom = from;
+            }
+            break;
+        }
+        case SDL_MOUSEBUTTONUP:
         {
-            // Break the loop and exit
-            case SDL_QUIT:
-                this->status = Status::SHUTDOWN_REQUESTED;
-                break;
-            case SDL_MOUSEBUTTONDOWN:
-                int mouseX, mouseY;
-                SDL_GetMouseState(&mouseX, &mouseY);
-
-                // Determine the row and col of the click
-                int row = (mouseY - this->boardBorderPixels) / this->squareSize;
-                int col = (mouseX - this->boardBorderPixels) / this->squareSize;
-                this->chessLogger->debug("started dragging the mouse ({}, {})", row, col);
-
-                // Grab the chess piece at that square
-                std::shared_ptr<Chess::ChessPiece> chessPiece = this->positionToPieceMap.at({row, col});
-                //this->pieceToLocationMap.insert(chessPiece, std::pair<int, int>(mouseX, mouseY));
-
-                bool stoppedDragging = false;
-                while(stoppedDragging != true)
+            Square to = this->squareAt(event.button.x, event.button.y);
+            this->chessLogger->debug("Stopped dragging the mouse ({}, {})", event.button.y, event.button.x);
+
+            if(this->dragFrom != SQ_NONE && to != SQ_NONE)
+            {
+                this->tryUserMove(this->dragFrom, to);
+            }
+            this->dragFrom = SQ_NONE;
+            break;
+        }
+        case SDL_KEYDOWN:
+            // Space makes the engine move now, N starts a new game, E shows the explorer,
+            // M toggles the search metrics
+            if(event.key.keysym.sym == SDLK_SPACE && this->engineSearchId != 0)
+            {
+                this->engine->stop();
+            }
+            else if(event.key.keysym.sym == SDLK_n)
+            {
+                this->newGame();
+            }
+            else if(event.key.keysym.sym == SDLK_e)
+            {
+                this->showExplorer();
+            }
+            else if(event.key.keysym.sym == SDLK_m)
+            {
+                this->showMetrics = !this->showMetrics;
+                this->changeDetected = true;
+                if(this->showMetrics)
                 {
-                    SDL_PollEvent(&event);
-                    if(event.type == SDL_MOUSEBUTTONUP)
-                    {
-                        SDL_GetMouseState(&mouseX, &mouseY);
-                        row = (mouseY - this->boardBorderPixels) / this->squareSize;
-                        col = (mouseX - this->boardBorderPixels) / this->squareSize;
-                        this->chessLogger->debug("Stopped dragging the mouse ({}, {})", row, col);
-                        //this->pieceToLocationMap.insert(chessPiece, convertFromLocationToPosition(std::make_pair(mouseX, mouseY), this->boardBorderPixels, this->squareSize));
-                        stoppedDragging = true;
-                        break;
-                    }
+                    this->logMetrics();
                 }
+            }
+            break;
+        default:
+            break;
+    }
+}
 
-                this->chessLogger->trace("Square Clicked: {}, {}", row, col);
-                changeDetected = true;
+Chess::Square Chess::GameApplication::squareAt(int mouseX, int mouseY)
+{
+    // Determine the row and col of the click
+    int row = (mouseY - this->boardBorderPixels) / this->squareSize;
+    int col = (mouseX - this->boardBorderPixels) / this->squareSize;
+    if(mouseY < this->boardBorderPixels || mouseX < this->boardBorderPixels || row >= 8 || col >= 8)
+    {
+        return SQ_NONE;
+    }
+
+    this->chessLogger->trace("Square Clicked: {}, {}", row, col);
+    return makeSquare(row, col);
+}
 
-                break;
+void Chess::GameApplication::tryUserMove(Square from, Square to)
+{
+    std::string uci = squareToString(from) + squareToString(to);
+
+    // Pawns reaching the last row always become queens
+    int toRow = to / 8;
+    if(typeOf(this->board.pieceOn(from)) == Type::PAWN && (toRow == 0 || toRow == 7))
+    {
+        uci += 'q';
+    }
+
+    Move move = findLegalMove(this->board, uci);
+    if(!move.isValid())
+    {
+        this->chessLogger->debug("Illegal move {}", uci);
+        return;
+    }
+
+    this->playMove(move);
+
+    // A correct guess lets the pondering search carry on as the real one, with everything
+    // it has searched so far. Otherwise it is thrown away and the engine starts over.
+    if(this->ponderSearchId != 0)
+    {
+        if(move == this->ponderMove)
+        {
+            this->chessLogger->debug("Ponder hit on {}", move.toUci());
+            this->engine->ponderhit();
+            this->engineSearchId = this->ponderSearchId;
+            this->ponderSearchId = 0;
+            return;
         }
+
+        this->chessLogger->debug("Ponder miss, expected {}", this->ponderMove.toUci());
+        this->engine->cancel();
+        this->ponderSearchId = 0;
     }
 
-    this->chessLogger->info("Shutdown normally.");
+    this->startEngineSearch();
+}
+
+void Chess::GameApplication::playMove(Move move)
+{
+    this->chessLogger->info("Move {}: {}", this->moveCounter + 1, move.toUci());
+
+    this->board.makeMove(move);
+    this->moveCounter++;
+    this->isWhiteTurn = this->board.sideToMove() == WHITE;
+
+    this->syncPiecesFromBoard();
+    this->changeDetected = true;
+
+    MoveList moves;
+    generateLegalMoves(this->board, moves);
+    if(moves.size() == 0)
+    {
+        this->chessLogger->info("{}", this->board.inCheck() ? "Checkmate." : "Stalemate.");
+    }
+
+    if(this->explorerOpen)
+    {
+        this->showExplorer();
+    }
+}
+
+void Chess::GameApplication::syncPiecesFromBoard()
+{
+    this->positionToPieceMap.clear();
+    this->pieceToPositionMap.clear();
+    this->pieceToLocationMap.clear();
+
+    for(Square s = 0; s < SQUARE_NB; s++)
+    {
+        Piece p = this->board.pieceOn(s);
+        if(p == NO_PIECE)
+        {
+            continue;
+        }
+
+        int row = s / 8;
+        int col = s % 8;
+        std::shared_ptr<Chess::ChessPiece> piece = this->createChessPiece(typeOf(p), row, col, colorOf(p) == WHITE);
+        this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), piece);
+
+        const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
+        this->pieceToLocationMap.insert_or_assign(piece, loc);
+    }
+}
+
+std::shared_ptr<Chess::ChessPiece> Chess::GameApplication::createChessPiece(Type type, int row, int col, bool isWhite)
+{
+    switch(type)
+    {
+        case Type::PAWN:
+            return std::make_shared<Chess::Pawn>(row, col, isWhite);
+        case Type::KNIGHT:
+            return std::make_shared<Chess::Knight>(row, col, isWhite);
+        case Type::BISHOP:
+            return std::make_shared<Chess::Bishop>(row, col, isWhite);
+        case Type::ROOK:
+            return std::make_shared<Chess::Rook>(row, col, isWhite);
+        case Type::QUEEN:
+            return std::make_shared<Chess::Queen>(row, col, isWhite);
+        case Type::KING:
+            return std::make_shared<Chess::King>(row, col, isWhite);
+    }
+    throw "Unknown piece type";
+}
+
+void Chess::GameApplication::startEngineSearch()
+{
+    if(this->board.sideToMove() != this->engineColor)
+    {
+        return;
+    }
+
+    MoveList moves;
+    generateLegalMoves(this->board, moves);
+    if(moves.size() == 0)
+    {
+        return;
+    }
+
+    // Book moves are played straight away
+    Move bookMove = this->book.pick(this->board, Polyglot::Selection::WEIGHTED_RANDOM);
+    if(bookMove.isValid())
+    {
+        this->chessLogger->info("Book move {}", bookMove.toUci());
+        this->playMove(bookMove);
+        return;
+    }
+
+    SearchLimits limits;
+    limits.movetime = ENGINE_MOVE_TIME_MS;
+    this->engineSearchId = this->engine->search(this->board, limits);
+}
+
+void Chess::GameApplication::startPondering(Move expectedReply)
+{
+    if(!expectedReply.isValid() || !this->board.isPseudoLegal(expectedReply) || !this->board.isLegal(expectedReply))
+    {
+        return;
+    }
+
+    Board ponderBoard = this->board;
+    ponderBoard.makeMove(expectedReply);
+
+    MoveList moves;
+    generateLegalMoves(ponderBoard, moves);
+    if(moves.size() == 0)
+    {
+        return;
+    }
+
+    // The move time only starts counting on a ponder hit, so the user waits no longer
+    // than without pondering but the search has had their thinking time on top
+    SearchLimits limits;
+    limits.movetime = ENGINE_MOVE_TIME_MS;
+    limits.ponder = true;
+    this->ponderMove = expectedReply;
+    this->ponderSearchId = this->engine->search(ponderBoard, limits);
+}
+
+void Chess::GameApplication::processEngineUpdates()
+{
+    EngineUpdate update;
+    while(this->engine->poll(update))
+    {
+        // Updates of searches that were cancelled or replaced are stale
+        if(update.searchId != this->engineSearchId && update.searchId != this->ponderSearchId)
+        {
+            continue;
+        }
+
+        if(update.type == EngineUpdate::INFO)
+        {
+            std::string pv;
+            for(int i = 0; i < update.pvLength; i++)
+            {
+                pv += (i ? " " : "") + update.pv[i].toUci();
+            }
+
+            // While pondering the line starts with the user's expected move
+            if(update.searchId == this->ponderSearchId)
+            {
+                pv = "(" + this->ponderMove.toUci() + ") " + pv;
+            }
+
+            std::string title = std::format("Chess - depth {} score {:+.2f} nodes {} pv {}", update.depth, update.score / 100.0, update.nodes, pv);
+            SDL_SetWindowTitle(this->mainWindow->getWindow(), title.c_str());
+            this->chessLogger->debug("Engine: depth {} score {} nodes {} nps {} pv {}", update.depth, update.score, update.nodes, update.nps, pv);
+
+            this->metrics = std::move(update.metrics);
+            if(this->showMetrics)
+            {
+                this->logMetrics();
+                this->changeDetected = true;
+            }
+        }
+        else
+        {
+            this->engineSearchId = 0;
+            if(update.bestMove.isValid())
+            {
+                this->playMove(update.bestMove);
+                this->startPondering(update.ponderMove);
+            }
+        }
+    }
+}
+
+void Chess::GameApplication::newGame()
+{
+    this->chessLogger->info("Starting a new game.");
+
+    this->engine->cancel();
+    this->engine->newGame();
+    this->engineSearchId = 0;
+    this->ponderSearchId = 0;
+    this->dragFrom = SQ_NONE;
+
+    this->board.setStartPosition();
+    this->moveCounter = 0;
+    this->isWhiteTurn = true;
+
+    this->syncPiecesFromBoard();
+    this->changeDetected = true;
+    this->startEngineSearch();
+}
+
+bool Chess::GameApplication::openBook(const std::string& bookPath)
+{
+    if(!this->book.open(bookPath))
+    {
+        this->chessLogger->error("Could not open the book {}", bookPath);
+        return false;
+    }
+
+    this->chessLogger->info("Book opened with {} entries", this->book.size());
+    return true;
+}
+
+bool Chess::GameApplication::openExplorer(const std::string& archivePath, const std::string& indexPath)
+{
+    this->explorerOpen = this->explorerArchive.open(archivePath, MappedFile::Access::RANDOM)
+                         && this->explorerIndex.open(indexPath);
+    if(!this->explorerOpen)
+    {
+        this->chessLogger->error("Could not open the explorer archive {} with index {}", archivePath, indexPath);
+        return false;
+    }
+
+    this->chessLogger->info("Explorer opened with {} games", this->explorerArchive.size());
+    this->showExplorer();
+    return true;
+}
+
+void Chess::GameApplication::showExplorer()
+{
+    if(!this->explorerOpen)
+    {
+        this->chessLogger->info("No explorer database, start with --explorer <archive> <index>");
+        return;
+    }
+
+    std::vector<PositionIndex::MoveStats> moves = this->explorerIndex.explore(this->board.key(), this->explorerArchive);
+    if(moves.empty())
+    {
+        this->chessLogger->info("Explorer: no games reached this position");
+        return;
+    }
+
+    // Scores are from white's point of view, over the games with a known result
+    for(size_t i = 0; i < moves.size() && i < EXPLORER_MOVES; i++)
+    {
+        const PositionIndex::MoveStats& stats = moves[i];
+        uint32_t decided = stats.whiteWins + stats.draws + stats.blackWins;
+        std::string move = stats.move.isValid() ? toSan(this->board, stats.move) : "(game ended)";
+        this->chessLogger->info("Explorer: {:<14} {:>8} games, white scores {}", move, stats.games,
+                                decided ? std::format("{:.1f}%", 100.0 * (stats.whiteWins + 0.5 * stats.draws) / decided) : "-");
+    }
 }
 
 void Chess::GameApplication::displayBanner()
@@ -126,6 +497,7 @@ void Chess::GameApplication::displayBanner()
 
 void Chess::GameApplication::drawChessBoard()
 {
+    CHESS_TRACE_SCOPE("draw board");
     // Create a blank background// Create a blank background
     try
     {
@@ -188,142 +560,14 @@ void Chess::GameApplication::drawChessBoard()
 void Chess::GameApplication::initializeChessPieces()
 {
     // Assumption: The board has already been initialized
-    // Create pawns on each square on the first row
-    for(int col=0; col<8; col++)
-    {
-        for(int row=0; row<8; row++)
-        {
-            if(row == 1)
-            {
-                std::shared_ptr<Chess::Pawn> pawnToDraw = std::make_shared<Chess::Pawn>(row, col, true);
-                this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), pawnToDraw);
-
-                const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                this->pieceToLocationMap.insert_or_assign(pawnToDraw, loc);
-            }
-
-            if(row == 6)
-            {
-                std::shared_ptr<Chess::Pawn> pawnToDraw = std::make_shared<Chess::Pawn>(row, col, false);
-                this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), pawnToDraw);
-
-                const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                this->pieceToLocationMap.insert_or_assign(pawnToDraw, loc);
-            }
-
-            if(col == 0 || col == 7)
-            {
-                if(row == 0)
-                {
-                    std::shared_ptr<Chess::Rook> rookToDraw = std::make_shared<Chess::Rook>(row, col, true);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), rookToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(rookToDraw, loc);
-                }
-
-                if(row == 7)
-                {
-                    std::shared_ptr<Chess::Rook> rookToDraw = std::make_shared<Chess::Rook>(row, col, false);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), rookToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(rookToDraw, loc);
-                }
-            }
-
-            if(col == 1 || col == 6)
-            {
-                if(row == 0)
-                {
-                    std::shared_ptr<Chess::Knight> knightToDraw = std::make_shared<Chess::Knight>(row, col, true);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), knightToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(knightToDraw, loc);
-                }
-
-                if(row == 7)
-                {
-                    std::shared_ptr<Chess::Knight> knightToDraw = std::make_shared<Chess::Knight>(row, col, false);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), knightToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(knightToDraw, loc);
-                }
-            }
-
-            if(col == 2 || col == 5)
-            {
-                if(row == 0)
-                {
-                    std::shared_ptr<Chess::Bishop> bishopToDraw = std::make_shared<Chess::Bishop>(row, col, true);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), bishopToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(bishopToDraw, loc);
-                }
-
-                if(row == 7)
-                {
-                    std::shared_ptr<Chess::Bishop> bishopToDraw = std::make_shared<Chess::Bishop>(row, col, false);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), bishopToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(bishopToDraw, loc);
-                }
-            }
-
-            if(col == 3)
-            {
-                if(row == 0)
-                {
-                    std::shared_ptr<Chess::Queen> queenToDraw = std::make_shared<Chess::Queen>(row, col, true);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), queenToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(queenToDraw, loc);
-                }
-
-                if(row == 7)
-                {
-                    std::shared_ptr<Chess::Queen> queenToDraw = std::make_shared<Chess::Queen>(row, col, false);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), queenToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(queenToDraw, loc);
-                }
-            }
-
-            if(col == 4)
-            {
-                if(row == 0)
-                {
-                    std::shared_ptr<Chess::King> kingToDraw = std::make_shared<Chess::King>(row, col, true);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), kingToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(kingToDraw, loc);
-                }
-
-                if(row == 7)
-                {
-                    std::shared_ptr<Chess::King> kingToDraw = std::make_shared<Chess::King>(row, col, false);
-                    this->positionToPieceMap.insert_or_assign(std::pair<int, int>(row, col), kingToDraw);
-
-                    const std::pair<int, int> loc = convertFromPositionToLocation(std::pair<int, int>(row, col), this->boardBorderPixels, this->squareSize);
-                    this->pieceToLocationMap.insert_or_assign(kingToDraw, loc);
-                }
-            }
-        }
-    }
-
+    this->syncPiecesFromBoard();
     this->drawChessPiecesFromLatestPositions();
     this->mainWindow->render();
 }
 
 void Chess::GameApplication::drawChessPiecesFromLatestPositions()
 {
+    CHESS_TRACE_SCOPE("draw pieces");
     this->chessLogger->debug("Drawing chess pieces from the location map");
     
     for(auto& keyValue: this->pieceToLocationMap)
@@ -476,6 +720,7 @@ void Chess::GameApplication::drawKing(std::shared_ptr<Chess::King> piece, int ro
 
 void Chess::GameApplication::drawChessPiece(std::shared_ptr<Chess::ChessPiece> piece, int row, int col, bool isWhite)
 {
+    CHESS_TRACE_SCOPE("draw piece");
     if(row >= 8 || col >= 8 || row < 0 || col < 0)
     {
         throw "Invalid row or column provided.  Row: " + std::to_string(row) + ", Col: " + std::to_string(col);
@@ -569,4 +814,81 @@ void Chess::GameApplication::drawChessPiece(std::shared_ptr<Chess::ChessPiece> p
 
     this->pieceToPositionMap[piece] = {row, col};
     this->positionToPieceMap[{row, col}] = piece;
-}
\ No newline at end of file
+}
+
+void Chess::GameApplication::drawMetricsOverlay()
+{
+    CHESS_TRACE_SCOPE("draw metrics");
+
+    // One bar per value on a dark panel, filled in proportion to it. From the top: TT hit
+    // rate, TT cutoff rate, hashfull, re-search rate and quiescence share, which fill the
+    // bar at 1; then each thread's speed relative to the fastest thread; then the
+    // branching factor of every iteration from depth 2, full at METRICS_MAX_BRANCHING.
+    const SearchStats& totals = this->metrics.totals;
+    std::vector<std::pair<double, SDL_Color>> bars = {
+        { totals.ttHitRate(), {64, 160, 255, 255} },
+        { totals.ttCutoffRate(), {64, 160, 255, 255} },
+        { this->metrics.hashfull / 1000.0, {64, 160, 255, 255} },
+        { totals.researchRate(), {255, 96, 96, 255} },
+        { totals.qsearchShare(), {255, 96, 96, 255} }
+    };
+    uint64_t fastest = this->metrics.threadNps.empty() ? 0 : *std::max_element(this->metrics.threadNps.begin(), this->metrics.threadNps.end());
+    for(uint64_t nps : this->metrics.threadNps)
+    {
+        bars.push_back({ fastest ? double(nps) / double(fastest) : 0.0, {96, 208, 96, 255} });
+    }
+    for(int depth = 2; depth <= this->metrics.depth; depth++)
+    {
+        bars.push_back({ totals.branchingFactor(depth) / METRICS_MAX_BRANCHING, {255, 176, 64, 255} });
+    }
+
+    // Only as many bars as fit on the board
+    int boardSize = (int) this->squareSize * 8;
+    size_t maxBars = size_t((boardSize - METRICS_BAR_GAP) / (METRICS_BAR_HEIGHT + METRICS_BAR_GAP));
+    bars.resize(std::min(bars.size(), maxBars));
+
+    SDL_Rect panel;
+    panel.x = (int) this->boardBorderPixels;
+    panel.y = (int) this->boardBorderPixels;
+    panel.w = boardSize;
+    panel.h = int(bars.size()) * (METRICS_BAR_HEIGHT + METRICS_BAR_GAP) + METRICS_BAR_GAP;
+    try
+    {
+        this->mainWindow->drawFilledRect(&panel, {32, 32, 32, 255});
+        for(size_t i = 0; i < bars.size(); i++)
+        {
+            SDL_Rect bar;
+            bar.x = panel.x + METRICS_BAR_GAP;
+            bar.y = panel.y + METRICS_BAR_GAP + int(i) * (METRICS_BAR_HEIGHT + METRICS_BAR_GAP);
+            bar.w = (int) ((panel.w - 2 * METRICS_BAR_GAP) * std::clamp(bars[i].first, 0.0, 1.0));
+            bar.h = METRICS_BAR_HEIGHT;
+            if(bar.w > 0)
+            {
+                this->mainWindow->drawFilledRect(&bar, bars[i].second);
+            }
+        }
+    }
+    catch(const char* error)
+    {
+        this->chessLogger->error("Failed to draw the search metrics. {}", error);
+    }
+}
+
+void Chess::GameApplication::logMetrics()
+{
+    const SearchStats& totals = this->metrics.totals;
+    std::string threadNps, branching;
+    for(uint64_t nps : this->metrics.threadNps)
+    {
+        threadNps += (threadNps.empty() ? "" : ",") + std::to_string(nps);
+    }
+    for(int depth = 2; depth <= this->metrics.depth; depth++)
+    {
+        branching += std::format("{}{}:{:.2f}", branching.empty() ? "" : ",", depth, totals.branchingFactor(depth));
+    }
+
+    this->chessLogger->info("Metrics: nodes {} qnodes {} nps {} thread nps {} TT hit rate {:.3f} cutoff rate {:.3f} hashfull {} "
+                            "re-search rate {:.3f} tbhits {} branching {}",
+                            totals.nodes, totals.qsearchNodes, this->metrics.nps, threadNps, totals.ttHitRate(),
+                            totals.ttCutoffRate(), this->metrics.hashfull, totals.researchRate(), totals.tbHits, branching);
+}
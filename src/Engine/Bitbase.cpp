@@ -0,0 +1,676 @@
+#include "../include/Engine/Bitbase.h"
+#include "../include/Engine/Bitboards.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using namespace Chess;
+    using namespace Chess::Bitboards;
+
+    // Positions a thread decides at a time during a sweep, a multiple of the 32 in a word
+    // so no two threads ever write the same word
+    constexpr uint64_t CHUNK_POSITIONS = 32 * 256;
+
+    // Squares of the white king in the index without pawns: the a1-d1-d4 triangle
+    constexpr Square TriangleSquares[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+    // Result of a move that leaves the mover's own king attacked
+    constexpr int ILLEGAL = -1;
+
+    constexpr Type Promotions[4] = { Type::QUEEN, Type::ROOK, Type::BISHOP, Type::KNIGHT };
+
+    // Position of a piece type in the canonical order, kings first and pawns last
+    int typeRank(Type t)
+    {
+        return PIECE_TYPE_NB - 1 - typeIndex(t);
+    }
+
+    char typeLetter(Type t)
+    {
+        return "PNBRQK"[typeIndex(t)];
+    }
+
+    Square flipDiagonal(Square s)
+    {
+        return makeSquare(colOf(s), rowOf(s));
+    }
+
+    uint64_t materialKey(int count, const Color colors[], const Type types[])
+    {
+        uint64_t key = 0;
+        for(int i = 0; i < count; i++)
+        {
+            key += uint64_t(1) << (4 * (colors[i] * PIECE_TYPE_NB + typeIndex(types[i])));
+        }
+        return key;
+    }
+
+    // The key of a board's material, with the colors swapped if mirrored
+    uint64_t materialKey(const Board& board, bool mirrored)
+    {
+        uint64_t key = 0;
+        for(int c = WHITE; c <= BLACK; c++)
+        {
+            for(int t = 0; t < PIECE_TYPE_NB; t++)
+            {
+                int color = mirrored ? 1 - c : c;
+                key += uint64_t(popCount(board.pieces(Color(c), Type(t)))) << (4 * (color * PIECE_TYPE_NB + t));
+            }
+        }
+        return key;
+    }
+
+    // Puts the pieces of a position in canonical order, keeping their squares alongside
+    void sortSlots(int count, Color colors[], Type types[], Square squares[])
+    {
+        for(int i = 1; i < count; i++)
+        {
+            for(int j = i; j > 0; j--)
+            {
+                bool before = colors[j] != colors[j - 1] ? colors[j] < colors[j - 1] : typeRank(types[j]) < typeRank(types[j - 1]);
+                if(!before)
+                {
+                    break;
+                }
+                std::swap(colors[j], colors[j - 1]);
+                std::swap(types[j], types[j - 1]);
+                std::swap(squares[j], squares[j - 1]);
+            }
+        }
+    }
+
+    // Fills in a material from its pieces in any order. Returns false unless each side
+    // has exactly one king and there are at most MAX_PIECES pieces.
+    bool makeMaterial(int count, const Color colors[], const Type types[], Bitbase::Material& material)
+    {
+        if(count < 2 || count > Bitbase::MAX_PIECES)
+        {
+            return false;
+        }
+
+        Bitbase::Material m;
+        m.count = count;
+        Square unused[Bitbase::MAX_PIECES] = {};
+        std::copy(colors, colors + count, m.colors);
+        std::copy(types, types + count, m.types);
+        sortSlots(count, m.colors, m.types, unused);
+
+        int kings[COLOR_NB] = { 0, 0 };
+        for(int i = 0; i < count; i++)
+        {
+            if(m.types[i] == Type::KING)
+            {
+                kings[m.colors[i]]++;
+                m.kingSlot[m.colors[i]] = i;
+            }
+            m.hasPawns |= m.types[i] == Type::PAWN;
+        }
+        if(kings[WHITE] != 1 || kings[BLACK] != 1)
+        {
+            return false;
+        }
+
+        m.kingSquares = m.hasPawns ? 32 : 10;
+        m.positions = COLOR_NB * m.kingSquares;
+        for(int i = 1; i < count; i++)
+        {
+            m.positions *= SQUARE_NB;
+        }
+        m.key = materialKey(count, m.colors, m.types);
+        material = m;
+        return true;
+    }
+
+    // Reads material like "KQKR": white's pieces starting with its king, then black's
+    bool parseSignature(const std::string& signature, Bitbase::Material& material)
+    {
+        Color colors[Bitbase::MAX_PIECES];
+        Type types[Bitbase::MAX_PIECES];
+        int count = 0;
+        int kings = 0;
+        for(char letter : signature)
+        {
+            const char* found = std::strchr("PNBRQK", letter);
+            if(letter == '\0' || found == nullptr || count == Bitbase::MAX_PIECES)
+            {
+                return false;
+            }
+            Type t = Type(found - "PNBRQK");
+            if(count == 0 && t != Type::KING)
+            {
+                return false;
+            }
+            kings += t == Type::KING;
+            colors[count] = kings == 2 ? BLACK : WHITE;
+            types[count] = t;
+            count++;
+        }
+        return makeMaterial(count, colors, types, material);
+    }
+
+    std::string signatureOf(const Bitbase::Material& material)
+    {
+        std::string signature;
+        for(int i = 0; i < material.count; i++)
+        {
+            signature += typeLetter(material.types[i]);
+        }
+        return signature;
+    }
+
+    // Index of a position whose pieces are in the material's slots. The board is first
+    // mirrored so the white king lands on one of the indexed squares.
+    uint64_t indexOf(const Bitbase::Material& m, const Square squares[], Color stm)
+    {
+        int flip = colOf(squares[0]) > 3 ? 7 : 0;
+        if(!m.hasPawns && rowOf(squares[0]) > 3)
+        {
+            flip ^= 56;
+        }
+        Square king = squares[0] ^ flip;
+        bool diagonal = !m.hasPawns && rowOf(king) > colOf(king);
+        if(diagonal)
+        {
+            king = flipDiagonal(king);
+        }
+
+        uint64_t kingIndex = m.hasPawns ? uint64_t(rowOf(king) * 4 + colOf(king))
+                                        : uint64_t(std::find(TriangleSquares, TriangleSquares + 10, king) - TriangleSquares);
+        uint64_t index = uint64_t(stm) * m.kingSquares + kingIndex;
+        for(int i = 1; i < m.count; i++)
+        {
+            Square s = squares[i] ^ flip;
+            index = index * SQUARE_NB + uint64_t(diagonal ? flipDiagonal(s) : s);
+        }
+        return index;
+    }
+
+    // The squares and side to move of an index
+    Color decode(const Bitbase::Material& m, uint64_t index, Square squares[])
+    {
+        for(int i = m.count - 1; i >= 1; i--)
+        {
+            squares[i] = Square(index % SQUARE_NB);
+            index /= SQUARE_NB;
+        }
+        uint64_t kingIndex = index % m.kingSquares;
+        squares[0] = m.hasPawns ? makeSquare(int(kingIndex / 4), int(kingIndex % 4)) : TriangleSquares[kingIndex];
+        return Color(index / m.kingSquares);
+    }
+
+    // Whether the king of a color is attacked by the other side's pieces
+    bool kingAttacked(int count, const Color colors[], const Type types[], const Square squares[], Color c)
+    {
+        Bitboard occupied = 0;
+        Square king = SQ_NONE;
+        for(int i = 0; i < count; i++)
+        {
+            occupied |= squareBB(squares[i]);
+            if(colors[i] == c && types[i] == Type::KING)
+            {
+                king = squares[i];
+            }
+        }
+        for(int i = 0; i < count; i++)
+        {
+            if(colors[i] == c)
+            {
+                continue;
+            }
+            Bitboard attacked = types[i] == Type::PAWN ? pawnAttacksBB(colors[i], squareBB(squares[i]))
+                                                       : attacks(types[i], squares[i], occupied);
+            if(attacked & squareBB(king))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * The results of one endgame while it is generated. Threads read any word but only
+     * write the words of the chunk they own.
+     */
+    struct Table
+    {
+        Bitbase::Material material;
+        uint64_t wordCount = 0;
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+
+        Bitbase::Value get(uint64_t index) const
+        {
+            return Bitbase::Value((this->words[index / 32].load(std::memory_order_relaxed) >> (2 * (index % 32))) & 3);
+        }
+    };
+
+    /**
+     * Every endgame generated so far by material key, and what the top one took
+     */
+    struct Generator
+    {
+        int threads = 1;
+        std::unordered_map<uint64_t, std::unique_ptr<Table>> tables;
+        Bitbase::GenerateStats* stats = nullptr;
+
+        const Table& find(uint64_t key) const { return *this->tables.at(key); }
+    };
+
+    // Runs work on chunks of the positions from every thread until all are done and
+    // returns the sum of what it returned
+    template<typename Work>
+    uint64_t sweep(uint64_t positions, int threads, const Work& work)
+    {
+        std::atomic<uint64_t> nextChunk{0};
+        std::atomic<uint64_t> total{0};
+        uint64_t chunks = (positions + CHUNK_POSITIONS - 1) / CHUNK_POSITIONS;
+        auto run = [&]()
+        {
+            uint64_t sum = 0;
+            for(uint64_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+            {
+                sum += work(chunk * CHUNK_POSITIONS, std::min(positions, (chunk + 1) * CHUNK_POSITIONS));
+            }
+            total += sum;
+        };
+
+        std::vector<std::thread> workers;
+        for(int i = 1; i < threads; i++)
+        {
+            workers.emplace_back(run);
+        }
+        run();
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        return total;
+    }
+
+    // The result for the opponent after piece i of the side to move goes to a square,
+    // turning into the given type, or ILLEGAL if that leaves its own king attacked
+    int childValue(const Generator& generator, const Table& table, const Square squares[], Color stm, int i, Square to, Type becomes)
+    {
+        const Bitbase::Material& m = table.material;
+        int captured = -1;
+        for(int j = 0; j < m.count; j++)
+        {
+            if(j != i && squares[j] == to)
+            {
+                captured = j;
+            }
+        }
+
+        if(captured < 0 && becomes == m.types[i])
+        {
+            Square next[Bitbase::MAX_PIECES];
+            std::copy(squares, squares + m.count, next);
+            next[i] = to;
+            if(kingAttacked(m.count, m.colors, m.types, next, stm))
+            {
+                return ILLEGAL;
+            }
+            return table.get(indexOf(m, next, ~stm));
+        }
+
+        // Captures and promotions continue in a smaller endgame
+        Color colors[Bitbase::MAX_PIECES];
+        Type types[Bitbase::MAX_PIECES];
+        Square next[Bitbase::MAX_PIECES];
+        int count = 0;
+        for(int j = 0; j < m.count; j++)
+        {
+            if(j == captured)
+            {
+                continue;
+            }
+            colors[count] = m.colors[j];
+            types[count] = j == i ? becomes : m.types[j];
+            next[count] = j == i ? to : squares[j];
+            count++;
+        }
+        if(kingAttacked(count, colors, types, next, stm))
+        {
+            return ILLEGAL;
+        }
+        sortSlots(count, colors, types, next);
+        const Table& child = generator.find(materialKey(count, colors, types));
+        return child.get(indexOf(child.material, next, ~stm));
+    }
+
+    // The result of a possible position from its children: won if a move leaves the
+    // opponent lost, lost if every move leaves it won, UNKNOWN if neither is known yet
+    Bitbase::Value evaluate(const Generator& generator, const Table& table, const Square squares[], Color stm)
+    {
+        const Bitbase::Material& m = table.material;
+        Bitboard occupied = 0, own = 0;
+        for(int i = 0; i < m.count; i++)
+        {
+            occupied |= squareBB(squares[i]);
+            if(m.colors[i] == stm)
+            {
+                own |= squareBB(squares[i]);
+            }
+        }
+
+        bool anyMove = false, allWin = true;
+        for(int i = 0; i < m.count; i++)
+        {
+            if(m.colors[i] != stm)
+            {
+                continue;
+            }
+
+            Type t = m.types[i];
+            Bitboard targets;
+            if(t == Type::PAWN)
+            {
+                Bitboard pawn = squareBB(squares[i]);
+                Bitboard push = pawnPush(stm, pawn) & ~occupied;
+                Bitboard doublePush = pawnPush(stm, push & (stm == WHITE ? RANK_1 << 16 : RANK_1 << 40)) & ~occupied;
+                targets = push | doublePush | (pawnAttacksBB(stm, pawn) & occupied & ~own);
+            }
+            else
+            {
+                targets = attacks(t, squares[i], occupied) & ~own;
+            }
+
+            while(targets)
+            {
+                Square to = popLsb(targets);
+                bool promotes = t == Type::PAWN && relativeRow(stm, to) == 7;
+                for(int p = 0; p < (promotes ? 4 : 1); p++)
+                {
+                    int value = childValue(generator, table, squares, stm, i, to, promotes ? Promotions[p] : t);
+                    if(value == ILLEGAL)
+                    {
+                        continue;
+                    }
+                    anyMove = true;
+                    if(value == Bitbase::LOSS)
+                    {
+                        return Bitbase::WIN;
+                    }
+                    allWin &= value == Bitbase::WIN;
+                }
+            }
+        }
+
+        if(!anyMove)
+        {
+            return kingAttacked(m.count, m.colors, m.types, squares, stm) ? Bitbase::LOSS : Bitbase::DRAW;
+        }
+        return allWin ? Bitbase::LOSS : Bitbase::UNKNOWN;
+    }
+
+    // Whether the decoded squares make a position that can occur: no two pieces on a
+    // square, no pawn on a back rank and the side that just moved not in check
+    bool isPossible(const Bitbase::Material& m, const Square squares[], Color stm)
+    {
+        Bitboard occupied = 0;
+        for(int i = 0; i < m.count; i++)
+        {
+            if((occupied & squareBB(squares[i])) || (m.types[i] == Type::PAWN && (squareBB(squares[i]) & (RANK_1 | RANK_8))))
+            {
+                return false;
+            }
+            occupied |= squareBB(squares[i]);
+        }
+        return !kingAttacked(m.count, m.colors, m.types, squares, ~stm);
+    }
+
+    const Table& build(Generator& generator, const Bitbase::Material& m, bool top)
+    {
+        auto existing = generator.tables.find(m.key);
+        if(existing != generator.tables.end())
+        {
+            return *existing->second;
+        }
+
+        // Every endgame a capture or promotion can lead to comes first
+        for(int i = 0; i < m.count; i++)
+        {
+            Color colors[Bitbase::MAX_PIECES];
+            Type types[Bitbase::MAX_PIECES];
+            Bitbase::Material child;
+            if(m.types[i] != Type::KING)
+            {
+                int count = 0;
+                for(int j = 0; j < m.count; j++)
+                {
+                    if(j != i)
+                    {
+                        colors[count] = m.colors[j];
+                        types[count++] = m.types[j];
+                    }
+                }
+                makeMaterial(count, colors, types, child);
+                build(generator, child, false);
+            }
+            if(m.types[i] == Type::PAWN)
+            {
+                for(Type promotion : Promotions)
+                {
+                    std::copy(m.colors, m.colors + m.count, colors);
+                    std::copy(m.types, m.types + m.count, types);
+                    types[i] = promotion;
+                    makeMaterial(m.count, colors, types, child);
+                    build(generator, child, false);
+                }
+            }
+        }
+
+        auto table = std::make_unique<Table>();
+        table->material = m;
+        table->wordCount = (m.positions + 31) / 32;
+        table->words = std::make_unique<std::atomic<uint64_t>[]>(table->wordCount);
+        Table& t = *table;
+        generator.tables.emplace(m.key, std::move(table));
+        generator.stats->memoryBytes += t.wordCount * sizeof(uint64_t);
+
+        // The first sweep also marks impossible positions drawn so later ones skip them,
+        // and counts the others
+        std::atomic<uint64_t> legal{0};
+        int passes = 0;
+        for(bool first = true; ; first = false)
+        {
+            passes++;
+            uint64_t changed = sweep(m.positions, generator.threads, [&](uint64_t begin, uint64_t end)
+            {
+                uint64_t decided = 0, possible = 0;
+                for(uint64_t w = begin / 32; w * 32 < end; w++)
+                {
+                    uint64_t bits = t.words[w].load(std::memory_order_relaxed);
+                    uint64_t updated = bits;
+                    for(uint64_t index = w * 32; index < std::min(end, w * 32 + 32); index++)
+                    {
+                        int shift = int(2 * (index % 32));
+                        if((bits >> shift) & 3)
+                        {
+                            continue;
+                        }
+
+                        Square squares[Bitbase::MAX_PIECES];
+                        Color stm = decode(m, index, squares);
+                        Bitbase::Value value;
+                        if(first && !isPossible(m, squares, stm))
+                        {
+                            value = Bitbase::DRAW;
+                        }
+                        else
+                        {
+                            possible += first;
+                            value = evaluate(generator, t, squares, stm);
+                            decided += value != Bitbase::UNKNOWN;
+                        }
+                        if(value != Bitbase::UNKNOWN)
+                        {
+                            updated |= uint64_t(value) << shift;
+                            // Later positions of the chunk see the result right away
+                            t.words[w].store(updated, std::memory_order_relaxed);
+                        }
+                    }
+                }
+                legal += possible;
+                return decided;
+            });
+            if(!first && changed == 0)
+            {
+                break;
+            }
+        }
+
+        // Whatever is still undecided can never be forced either way
+        constexpr uint64_t LOW_BITS = 0x5555555555555555ULL;
+        uint64_t wins = 0, losses = 0;
+        for(uint64_t w = 0; w < t.wordCount; w++)
+        {
+            uint64_t bits = t.words[w].load(std::memory_order_relaxed);
+            uint64_t unknown = ~(bits | (bits >> 1)) & LOW_BITS;
+            bits |= unknown | (unknown << 1);
+            t.words[w].store(bits, std::memory_order_relaxed);
+            wins += uint64_t(popCount(bits & ~(bits >> 1) & LOW_BITS));
+            losses += uint64_t(popCount((bits >> 1) & ~bits & LOW_BITS));
+        }
+
+        if(top)
+        {
+            Bitbase::GenerateStats& stats = *generator.stats;
+            stats.positions = m.positions;
+            stats.legal = legal;
+            stats.wins = wins;
+            stats.losses = losses;
+            stats.draws = legal - wins - losses;
+            stats.passes = passes;
+            stats.subtables = int(generator.tables.size()) - 1;
+        }
+        return t;
+    }
+};
+
+std::string Chess::Bitbase::normalize(const std::string& signature)
+{
+    Material material;
+    return parseSignature(signature, material) ? signatureOf(material) : std::string();
+}
+
+bool Chess::Bitbase::generate(const std::string& signature, const std::string& path, int threads, GenerateStats& stats)
+{
+    Material material;
+    if(!parseSignature(signature, material))
+    {
+        return false;
+    }
+    Bitboards::init();
+
+    auto start = std::chrono::steady_clock::now();
+    stats = GenerateStats();
+    Generator generator;
+    generator.threads = std::max(1, threads);
+    generator.stats = &stats;
+    const Table& table = build(generator, material, true);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // An empty path only measures generation
+    if(path.empty())
+    {
+        return true;
+    }
+
+    Header header = {};
+    std::copy(MAGIC, MAGIC + 8, header.magic);
+    header.version = VERSION;
+    header.pieceCount = uint32_t(material.count);
+    std::string name = signatureOf(material);
+    std::copy(name.begin(), name.end(), header.signature);
+    header.positions = material.positions;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<uint64_t> buffer;
+    for(uint64_t w = 0; w < table.wordCount; w++)
+    {
+        buffer.push_back(table.words[w].load(std::memory_order_relaxed));
+        if(buffer.size() == 4096 || w + 1 == table.wordCount)
+        {
+            file.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size() * sizeof(uint64_t)));
+            buffer.clear();
+        }
+    }
+    return bool(file);
+}
+
+bool Chess::Bitbase::open(const std::string& path)
+{
+    this->header = nullptr;
+    this->words = nullptr;
+    if(!this->file.open(path, MappedFile::Access::RANDOM) || this->file.size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header* candidate = reinterpret_cast<const Header*>(this->file.data());
+    std::string name(candidate->signature, strnlen(candidate->signature, sizeof(candidate->signature)));
+    if(std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION
+       || !parseSignature(name, this->material) || signatureOf(this->material) != name
+       || candidate->positions != this->material.positions
+       || this->file.size() < sizeof(Header) + (candidate->positions + 31) / 32 * sizeof(uint64_t))
+    {
+        this->file.close();
+        return false;
+    }
+
+    this->header = candidate;
+    this->words = reinterpret_cast<const uint64_t*>(this->file.data() + sizeof(Header));
+    return true;
+}
+
+std::string Chess::Bitbase::signature() const
+{
+    return this->header ? signatureOf(this->material) : std::string();
+}
+
+Chess::Bitbase::Value Chess::Bitbase::probe(const Board& board) const
+{
+    if(!isOpen())
+    {
+        return UNKNOWN;
+    }
+
+    bool mirrored;
+    if(materialKey(board, false) == this->material.key)
+    {
+        mirrored = false;
+    }
+    else if(materialKey(board, true) == this->material.key)
+    {
+        mirrored = true;
+    }
+    else
+    {
+        return UNKNOWN;
+    }
+
+    // Pieces of the same kind go to their slots in square order
+    Square squares[MAX_PIECES];
+    Bitboard used = 0;
+    for(int i = 0; i < this->material.count; i++)
+    {
+        Color c = mirrored ? ~this->material.colors[i] : this->material.colors[i];
+        Square s = lsb(board.pieces(c, this->material.types[i]) & ~used);
+        used |= squareBB(s);
+        squares[i] = mirrored ? flipSquare(s) : s;
+    }
+
+    Color stm = mirrored ? ~board.sideToMove() : board.sideToMove();
+    uint64_t index = indexOf(this->material, squares, stm);
+    return Value((this->words[index / 32] >> (2 * (index % 32))) & 3);
+}
@@ -0,0 +1,218 @@
+#include "../include/Engine/Bitboards.h"
+
+#include <mutex>
+
+Chess::Bitboard Chess::Bitboards::PawnAttacks[COLOR_NB][SQUARE_NB];
+Chess::Bitboard Chess::Bitboards::KnightAttacks[SQUARE_NB];
+Chess::Bitboard Chess::Bitboards::KingAttacks[SQUARE_NB];
+Chess::Bitboard Chess::Bitboards::BetweenBB[SQUARE_NB][SQUARE_NB];
+Chess::Bitboard Chess::Bitboards::LineBB[SQUARE_NB][SQUARE_NB];
+Chess::Bitboards::Magic Chess::Bitboards::RookMagics[SQUARE_NB];
+Chess::Bitboards::Magic Chess::Bitboards::BishopMagics[SQUARE_NB];
+
+namespace
+{
+    using namespace Chess;
+    using namespace Chess::Bitboards;
+
+    // Backing storage for the magic attack tables. The sizes are the sums of
+    // 2^(relevant occupancy bits) over all squares.
+    Bitboard RookTable[0x19000];
+    Bitboard BishopTable[0x1480];
+
+    // Row and column steps for each slider direction
+    constexpr int RookDirections[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+    constexpr int BishopDirections[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+    /**
+     * Small xorshift64* generator used to search for magic numbers. Seeded with fixed
+     * values so the tables are identical on every run.
+     */
+    class MagicRng
+    {
+        public:
+            MagicRng(uint64_t seed) : state(seed) {}
+
+            uint64_t next()
+            {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                return state * 2685821657736338717ULL;
+            }
+
+            // Random number with roughly 1/8 of its bits set, which makes good magic candidates
+            uint64_t sparse() { return next() & next() & next(); }
+
+        private:
+            uint64_t state;
+    };
+
+    // Whether a row and column are on the board
+    bool onBoard(int row, int col)
+    {
+        return row >= 0 && row < 8 && col >= 0 && col < 8;
+    }
+
+    // Computes slider attacks by walking each ray until it hits a piece. Only used to build
+    // the magic tables.
+    Bitboard slidingAttacks(const int directions[4][2], Square s, Bitboard occupied)
+    {
+        Bitboard result = 0;
+        for(int d = 0; d < 4; d++)
+        {
+            int row = rowOf(s) + directions[d][0];
+            int col = colOf(s) + directions[d][1];
+            while(onBoard(row, col))
+            {
+                Bitboard b = squareBB(makeSquare(row, col));
+                result |= b;
+                if(occupied & b)
+                {
+                    break;
+                }
+                row += directions[d][0];
+                col += directions[d][1];
+            }
+        }
+        return result;
+    }
+
+    // Attacks for a set of fixed steps, e.g. the knight or king
+    Bitboard stepAttacks(Square s, const int steps[8][2])
+    {
+        Bitboard result = 0;
+        for(int i = 0; i < 8; i++)
+        {
+            int row = rowOf(s) + steps[i][0];
+            int col = colOf(s) + steps[i][1];
+            if(onBoard(row, col))
+            {
+                result |= squareBB(makeSquare(row, col));
+            }
+        }
+        return result;
+    }
+
+    // Finds magic numbers for every square of one slider type and fills its attack table
+    void initMagics(const int directions[4][2], Magic magics[], Bitboard table[])
+    {
+        // Seeds per row that are known to find magics quickly
+        constexpr uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+        Bitboard occupancy[4096];
+        Bitboard reference[4096];
+        int epoch[4096] = {};
+        int currentEpoch = 0;
+        int size = 0;
+
+        for(Square s = 0; s < SQUARE_NB; s++)
+        {
+            // Board edges are not relevant to the occupancy unless the slider is on them
+            Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * rowOf(s))))
+                           | ((FILE_A | FILE_H) & ~(FILE_A << colOf(s)));
+
+            Magic& m = magics[s];
+            m.mask = slidingAttacks(directions, s, 0) & ~edges;
+            m.shift = 64 - popCount(m.mask);
+            m.attacks = s == 0 ? table : magics[s - 1].attacks + size;
+
+            // Enumerate every subset of the mask with the Carry-Rippler trick and store
+            // the attacks for each one.
+            Bitboard b = 0;
+            size = 0;
+            do
+            {
+                occupancy[size] = b;
+                reference[size] = slidingAttacks(directions, s, b);
+                size++;
+                b = (b - m.mask) & m.mask;
+            } while(b);
+
+            // Try random candidates until one maps every subset without a destructive collision
+            MagicRng rng(seeds[rowOf(s)]);
+            for(int i = 0; i < size; )
+            {
+                for(m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6; )
+                {
+                    m.magic = rng.sparse();
+                }
+
+                currentEpoch++;
+                for(i = 0; i < size; i++)
+                {
+                    unsigned idx = m.index(occupancy[i]);
+                    if(epoch[idx] < currentEpoch)
+                    {
+                        epoch[idx] = currentEpoch;
+                        m.attacks[idx] = reference[i];
+                    }
+                    else if(m.attacks[idx] != reference[i])
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void buildTables()
+    {
+        constexpr int knightSteps[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+        constexpr int kingSteps[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+        for(Square s = 0; s < SQUARE_NB; s++)
+        {
+            KnightAttacks[s] = stepAttacks(s, knightSteps);
+            KingAttacks[s] = stepAttacks(s, kingSteps);
+            PawnAttacks[WHITE][s] = pawnAttacksBB(WHITE, squareBB(s));
+            PawnAttacks[BLACK][s] = pawnAttacksBB(BLACK, squareBB(s));
+        }
+
+        initMagics(RookDirections, RookMagics, RookTable);
+        initMagics(BishopDirections, BishopMagics, BishopTable);
+
+        for(Square a = 0; a < SQUARE_NB; a++)
+        {
+            for(Square b = 0; b < SQUARE_NB; b++)
+            {
+                BetweenBB[a][b] = LineBB[a][b] = 0;
+                if(a == b)
+                {
+                    continue;
+                }
+
+                if(bishopAttacks(a, 0) & squareBB(b))
+                {
+                    LineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                    BetweenBB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+                }
+                else if(rookAttacks(a, 0) & squareBB(b))
+                {
+                    LineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                    BetweenBB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+                }
+            }
+        }
+    }
+};
+
+void Chess::Bitboards::init()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, buildTables);
+}
+
+std::string Chess::Bitboards::toString(Bitboard b)
+{
+    std::string result;
+    for(int row = 7; row >= 0; row--)
+    {
+        for(int col = 0; col < 8; col++)
+        {
+            result += (b & squareBB(makeSquare(row, col))) ? "X " : ". ";
+        }
+        result += '\n';
+    }
+    return result;
+}
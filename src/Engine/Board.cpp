@@ -0,0 +1,855 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MoveGen.h"
+
+#include <algorithm>
+#include <string_view>
+
+using namespace Chess::Bitboards;
+
+namespace
+{
+    using namespace Chess;
+
+    // Castling rights that survive a move touching each square
+    constexpr auto buildCastlingMasks()
+    {
+        struct { uint8_t mask[SQUARE_NB]; } result{};
+        for(Square s = 0; s < SQUARE_NB; s++)
+        {
+            result.mask[s] = ALL_CASTLING;
+        }
+        result.mask[0] = ALL_CASTLING & ~WHITE_OOO;
+        result.mask[4] = ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+        result.mask[7] = ALL_CASTLING & ~WHITE_OO;
+        result.mask[56] = ALL_CASTLING & ~BLACK_OOO;
+        result.mask[60] = ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+        result.mask[63] = ALL_CASTLING & ~BLACK_OO;
+        return result;
+    }
+
+    constexpr auto CastlingMask = buildCastlingMasks();
+
+    // Number of states reserved up front. Games longer than this still work, the
+    // stack just grows once.
+    constexpr size_t RESERVED_STATES = 1024;
+
+    // The rook's from and to squares for a castling move, given the king's destination
+    inline void castlingRookSquares(Square kingTo, Square& rookFrom, Square& rookTo)
+    {
+        bool kingSide = colOf(kingTo) == 6;
+        rookFrom = kingSide ? kingTo + 1 : kingTo - 2;
+        rookTo = kingSide ? kingTo - 1 : kingTo + 1;
+    }
+};
+
+Chess::Board::Board()
+{
+    Bitboards::init();
+    Zobrist::init();
+    Psqt::init();
+
+    this->states.reserve(RESERVED_STATES);
+    this->accumulators = nullptr;
+    setStartPosition();
+}
+
+void Chess::Board::clear()
+{
+    for(int t = 0; t < PIECE_TYPE_NB; t++)
+    {
+        this->byType[t] = 0;
+    }
+    this->byColor[WHITE] = this->byColor[BLACK] = 0;
+    this->occupied = 0;
+    this->psqt = { 0, 0 };
+    this->phase = 0;
+    for(Square s = 0; s < SQUARE_NB; s++)
+    {
+        this->mailbox[s] = NO_PIECE;
+    }
+
+    this->stm = WHITE;
+    this->ply = 0;
+    this->startPly = 0;
+    this->states.clear();
+    this->states.push_back(StateInfo{ 0, Zobrist::NoPawns, 0, 0, SQ_NONE, NO_CASTLING, NO_PIECE, 0, 0 });
+}
+
+void Chess::Board::setStartPosition()
+{
+    setFen(START_FEN);
+}
+
+bool Chess::Board::setFen(std::string_view fen)
+{
+    // Parse into a scratch position first so a bad FEN leaves the board alone
+    Fen::Position position;
+    if(!Fen::parse(fen, position))
+    {
+        return false;
+    }
+    return setPosition(position);
+}
+
+bool Chess::Board::setPosition(const Fen::Position& position)
+{
+    clear();
+    for(Square s = 0; s < SQUARE_NB; s++)
+    {
+        if(position.squares[s] != NO_PIECE)
+        {
+            putPiece(position.squares[s], s);
+        }
+    }
+    this->stm = position.sideToMove;
+    this->startPly = 2 * (std::clamp(position.fullmoveNumber, 1, Fen::MAX_MOVE_COUNTER) - 1) + (this->stm == BLACK);
+
+    StateInfo& st = this->states.back();
+    st.castling = position.castling;
+    st.halfmoveClock = std::max(position.halfmoveClock, 0);
+    st.key = Zobrist::Castling[st.castling] ^ (this->stm == BLACK ? Zobrist::Side : 0);
+    for(Square s = 0; s < SQUARE_NB; s++)
+    {
+        if(this->mailbox[s] != NO_PIECE)
+        {
+            st.key ^= Zobrist::PieceSquare[this->mailbox[s]][s];
+            if(typeOf(this->mailbox[s]) == Type::PAWN)
+            {
+                st.pawnKey ^= Zobrist::PieceSquare[this->mailbox[s]][s];
+            }
+        }
+    }
+
+    // Like makeMove, only keep an en passant square that can actually be used
+    Square epSquare = position.epSquare;
+    if(epSquare != SQ_NONE && relativeRow(this->stm, epSquare) == 5
+        && (PawnAttacks[~this->stm][epSquare] & pieces(this->stm, Type::PAWN)))
+    {
+        st.epSquare = epSquare;
+        st.key ^= Zobrist::EnPassant[colOf(epSquare)];
+    }
+
+    updateCheckInfo(st);
+
+    // The side that just moved can not be in check
+    if(isAttacked(kingSquare(~this->stm), this->stm))
+    {
+        setStartPosition();
+        return false;
+    }
+
+    if(this->accumulators)
+    {
+        attachAccumulators(this->accumulators);
+    }
+    return true;
+}
+
+Chess::Fen::Position Chess::Board::getPosition() const
+{
+    Fen::Position position;
+    std::copy(this->mailbox, this->mailbox + SQUARE_NB, position.squares);
+    position.sideToMove = this->stm;
+    position.castling = state().castling;
+    position.epSquare = state().epSquare;
+    position.halfmoveClock = state().halfmoveClock;
+    position.fullmoveNumber = fullmoveNumber();
+    return position;
+}
+
+size_t Chess::Board::writeFen(char* buffer) const
+{
+    return Fen::write(getPosition(), buffer);
+}
+
+std::string Chess::Board::fen() const
+{
+    char buffer[Fen::MAX_LENGTH];
+    return std::string(buffer, writeFen(buffer));
+}
+
+void Chess::Board::attachAccumulators(Nnue::AccumulatorStack* stack)
+{
+    this->accumulators = stack;
+    if(stack)
+    {
+        stack->reset();
+        Nnue::refresh(*this, stack->current(), WHITE);
+        Nnue::refresh(*this, stack->current(), BLACK);
+    }
+}
+
+void Chess::Board::pushAccumulator(const Nnue::DirtyPieces& dirty, Piece moved)
+{
+    this->accumulators->push();
+    const Nnue::Accumulator& parent = this->accumulators->previous();
+    Nnue::Accumulator& child = this->accumulators->current();
+
+    for(Color perspective : { WHITE, BLACK })
+    {
+        if(moved == makePiece(perspective, Type::KING))
+        {
+            Nnue::refresh(*this, child, perspective);
+        }
+        else
+        {
+            Nnue::update(parent, child, perspective, kingSquare(perspective), dirty);
+        }
+    }
+}
+
+void Chess::Board::putPiece(Piece p, Square s)
+{
+    Bitboard b = squareBB(s);
+    this->byType[typeIndex(typeOf(p))] |= b;
+    this->byColor[colorOf(p)] |= b;
+    this->occupied |= b;
+    this->mailbox[s] = p;
+    this->psqt += Psqt::Table[p][s];
+    this->phase += Psqt::PhaseWeight[typeIndex(typeOf(p))];
+}
+
+void Chess::Board::removePiece(Square s)
+{
+    Piece p = this->mailbox[s];
+    Bitboard b = squareBB(s);
+    this->byType[typeIndex(typeOf(p))] ^= b;
+    this->byColor[colorOf(p)] ^= b;
+    this->occupied ^= b;
+    this->mailbox[s] = NO_PIECE;
+    this->psqt -= Psqt::Table[p][s];
+    this->phase -= Psqt::PhaseWeight[typeIndex(typeOf(p))];
+}
+
+void Chess::Board::movePiece(Square from, Square to)
+{
+    Piece p = this->mailbox[from];
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    this->byType[typeIndex(typeOf(p))] ^= fromTo;
+    this->byColor[colorOf(p)] ^= fromTo;
+    this->occupied ^= fromTo;
+    this->mailbox[from] = NO_PIECE;
+    this->mailbox[to] = p;
+    this->psqt += Psqt::Table[p][to] - Psqt::Table[p][from];
+}
+
+Chess::Bitboard Chess::Board::attackersTo(Square s, Bitboard occupancy) const
+{
+    return (PawnAttacks[BLACK][s] & pieces(WHITE, Type::PAWN))
+         | (PawnAttacks[WHITE][s] & pieces(BLACK, Type::PAWN))
+         | (KnightAttacks[s] & pieces(Type::KNIGHT))
+         | (bishopAttacks(s, occupancy) & (pieces(Type::BISHOP) | pieces(Type::QUEEN)))
+         | (rookAttacks(s, occupancy) & (pieces(Type::ROOK) | pieces(Type::QUEEN)))
+         | (KingAttacks[s] & pieces(Type::KING));
+}
+
+bool Chess::Board::isAttacked(Square s, Color by) const
+{
+    return (PawnAttacks[~by][s] & pieces(by, Type::PAWN))
+        || (KnightAttacks[s] & pieces(by, Type::KNIGHT))
+        || (KingAttacks[s] & pieces(by, Type::KING))
+        || (bishopAttacks(s, this->occupied) & pieces(by, Type::BISHOP, Type::QUEEN))
+        || (rookAttacks(s, this->occupied) & pieces(by, Type::ROOK, Type::QUEEN));
+}
+
+void Chess::Board::updateCheckInfo(StateInfo& st) const
+{
+    Color us = this->stm;
+    Color them = ~us;
+    Square ksq = kingSquare(us);
+
+    st.checkers = attackersTo(ksq, this->occupied) & pieces(them);
+
+    // A piece is pinned if it is the only piece between our king and an enemy slider
+    st.pinned = 0;
+    Bitboard snipers = (rookAttacks(ksq, 0) & pieces(them, Type::ROOK, Type::QUEEN))
+                     | (bishopAttacks(ksq, 0) & pieces(them, Type::BISHOP, Type::QUEEN));
+    while(snipers)
+    {
+        Bitboard between = BetweenBB[ksq][popLsb(snipers)] & this->occupied;
+        if(between && !moreThanOne(between))
+        {
+            st.pinned |= between & pieces(us);
+        }
+    }
+}
+
+bool Chess::Board::isPseudoLegal(Move m) const
+{
+    if(!m.isValid())
+    {
+        return false;
+    }
+
+    Color us = this->stm;
+    Square from = m.from();
+    Square to = m.to();
+    Piece pc = this->mailbox[from];
+    MoveFlag flag = m.flag();
+
+    if(pc == NO_PIECE || colorOf(pc) != us || (pieces(us) & squareBB(to)))
+    {
+        return false;
+    }
+
+    if(m.isCastling())
+    {
+        Square kingFrom = us == WHITE ? 4 : 60;
+        uint8_t right = flag == KING_CASTLE ? (us == WHITE ? WHITE_OO : BLACK_OO)
+                                            : (us == WHITE ? WHITE_OOO : BLACK_OOO);
+        Square rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+
+        return from == kingFrom
+            && to == (flag == KING_CASTLE ? kingFrom + 2 : kingFrom - 2)
+            && (state().castling & right)
+            && !(BetweenBB[kingFrom][rookFrom] & this->occupied);
+    }
+
+    // Captures must land on an enemy piece and everything else on an empty square
+    Piece target = this->mailbox[to];
+    if(flag == EN_PASSANT)
+    {
+        return typeOf(pc) == Type::PAWN
+            && to == state().epSquare
+            && (PawnAttacks[us][from] & squareBB(to));
+    }
+    if(m.isCapture() != (target != NO_PIECE))
+    {
+        return false;
+    }
+
+    if(typeOf(pc) == Type::PAWN)
+    {
+        // Promotion flags must be present exactly when the pawn reaches the last row
+        if(m.isPromotion() != (relativeRow(us, to) == 7))
+        {
+            return false;
+        }
+
+        int forward = us == WHITE ? 8 : -8;
+        if(m.isCapture())
+        {
+            return (m.isPromotion() || flag == CAPTURE) && (PawnAttacks[us][from] & squareBB(to));
+        }
+        if(flag == DOUBLE_PUSH)
+        {
+            return relativeRow(us, from) == 1
+                && to == from + 2 * forward
+                && this->mailbox[from + forward] == NO_PIECE;
+        }
+        return to == from + forward;
+    }
+
+    // Only pawns can make special moves
+    if(flag != QUIET && flag != CAPTURE)
+    {
+        return false;
+    }
+
+    return attacks(typeOf(pc), from, this->occupied) & squareBB(to);
+}
+
+bool Chess::Board::isLegal(Move m) const
+{
+    Color us = this->stm;
+    Color them = ~us;
+    Square from = m.from();
+    Square to = m.to();
+    Square ksq = kingSquare(us);
+
+    if(m.flag() == EN_PASSANT)
+    {
+        // Two pieces leave the same row, so simulate the capture and look for any attacker
+        Square capturedSquare = to - (us == WHITE ? 8 : -8);
+        Bitboard occupancy = (this->occupied ^ squareBB(from) ^ squareBB(capturedSquare)) | squareBB(to);
+        return !(attackersTo(ksq, occupancy) & pieces(them) & occupancy);
+    }
+
+    if(m.isCastling())
+    {
+        if(inCheck())
+        {
+            return false;
+        }
+        int step = to > from ? 1 : -1;
+        for(Square s = from + step; s != to + step; s += step)
+        {
+            if(isAttacked(s, them))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if(from == ksq)
+    {
+        return !(attackersTo(to, this->occupied ^ squareBB(from)) & pieces(them));
+    }
+
+    // When in check every other move must capture the checker or block the check
+    Bitboard checkers = state().checkers;
+    if(checkers)
+    {
+        if(moreThanOne(checkers))
+        {
+            return false;
+        }
+        if(!((BetweenBB[ksq][lsb(checkers)] | checkers) & squareBB(to)))
+        {
+            return false;
+        }
+    }
+
+    // Pinned pieces may only move along the line through the king
+    return !(state().pinned & squareBB(from)) || (LineBB[from][to] & squareBB(ksq));
+}
+
+bool Chess::Board::givesCheck(Move m) const
+{
+    Color us = this->stm;
+    Square ksq = kingSquare(~us);
+    Square from = m.from();
+    Square to = m.to();
+    Type type = m.isPromotion() ? m.promotionType() : typeOf(this->mailbox[from]);
+
+    // Squares vacated by the move, and the occupancy once it has been played
+    Bitboard vacated = squareBB(from);
+    Bitboard occupancy = this->occupied ^ squareBB(from);
+    if(m.flag() == EN_PASSANT)
+    {
+        occupancy ^= squareBB(to - (us == WHITE ? 8 : -8));
+    }
+
+    if(m.isCastling())
+    {
+        // Only the rook can give check after castling
+        Square rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        occupancy = (occupancy ^ squareBB(rookFrom)) | squareBB(to) | squareBB(rookTo);
+        return rookAttacks(rookTo, occupancy) & squareBB(ksq);
+    }
+    occupancy |= squareBB(to);
+
+    // Direct check from the moved piece
+    if(type == Type::PAWN)
+    {
+        if(PawnAttacks[us][to] & squareBB(ksq))
+        {
+            return true;
+        }
+    }
+    else if(attacks(type, to, occupancy) & squareBB(ksq))
+    {
+        return true;
+    }
+
+    // Discovered check from a slider behind the vacated square
+    Bitboard sliders = ((bishopAttacks(ksq, occupancy) & pieces(us, Type::BISHOP, Type::QUEEN))
+                      | (rookAttacks(ksq, occupancy) & pieces(us, Type::ROOK, Type::QUEEN)));
+    return sliders & ~vacated;
+}
+
+bool Chess::Board::isDraw(int ply) const
+{
+    const StateInfo& st = state();
+    if(st.halfmoveClock >= 100 && (!st.checkers || hasLegalMove()))
+    {
+        return true;
+    }
+
+    // Only positions with the same side to move and no irreversible move in between
+    // can repeat
+    int current = int(this->states.size()) - 1;
+    int end = std::min({ st.halfmoveClock, st.pliesFromNull, current });
+    int repetitions = 0;
+    for(int i = 4; i <= end; i += 2)
+    {
+        if(this->states[current - i].key == st.key)
+        {
+            // Inside the search tree one repetition is a draw, otherwise it takes two
+            if(i < ply || ++repetitions == 2)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Chess::Board::hasLegalMove() const
+{
+    MoveList list;
+    generateMoves<ALL>(*this, list);
+    for(const ScoredMove& sm: list)
+    {
+        if(isLegal(sm.move))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+Chess::Square Chess::Board::leastValuableAttacker(Bitboard attackers, Color c, Type& type) const
+{
+    for(int t = 0; t < PIECE_TYPE_NB; t++)
+    {
+        Bitboard b = attackers & pieces(c, Type(t));
+        if(b)
+        {
+            type = Type(t);
+            return lsb(b);
+        }
+    }
+    return SQ_NONE;
+}
+
+int Chess::Board::see(Move m) const
+{
+    if(m.isCastling())
+    {
+        return 0;
+    }
+
+    Square from = m.from();
+    Square to = m.to();
+    Bitboard occupancy = this->occupied;
+    Type attacker = typeOf(this->mailbox[from]);
+
+    // gain[d] is the material balance after d captures, from the point of view of the
+    // side that made capture d
+    int gain[32];
+    int depth = 0;
+
+    if(m.flag() == EN_PASSANT)
+    {
+        gain[0] = PieceValue[typeIndex(Type::PAWN)];
+        occupancy ^= squareBB(to - (this->stm == WHITE ? 8 : -8));
+    }
+    else
+    {
+        gain[0] = m.isCapture() ? PieceValue[typeIndex(typeOf(this->mailbox[to]))] : 0;
+    }
+    if(m.isPromotion())
+    {
+        attacker = m.promotionType();
+        gain[0] += PieceValue[typeIndex(attacker)] - PieceValue[typeIndex(Type::PAWN)];
+    }
+
+    Bitboard bishopsQueens = pieces(Type::BISHOP) | pieces(Type::QUEEN);
+    Bitboard rooksQueens = pieces(Type::ROOK) | pieces(Type::QUEEN);
+    occupancy ^= squareBB(from);
+    Bitboard attackers = attackersTo(to, occupancy) & occupancy;
+    Color side = ~this->stm;
+
+    while(depth < 31)
+    {
+        Type nextAttacker = Type::PAWN;
+        Square s = leastValuableAttacker(attackers & pieces(side), side, nextAttacker);
+        if(s == SQ_NONE)
+        {
+            break;
+        }
+
+        // The king may only recapture if the square is no longer defended
+        if(nextAttacker == Type::KING && (attackers & pieces(~side) & occupancy))
+        {
+            break;
+        }
+
+        depth++;
+        gain[depth] = PieceValue[typeIndex(attacker)] - gain[depth - 1];
+        attacker = nextAttacker;
+
+        // Removing the attacker may reveal a slider behind it (an x-ray)
+        occupancy ^= squareBB(s);
+        if(nextAttacker == Type::PAWN || nextAttacker == Type::BISHOP || nextAttacker == Type::QUEEN)
+        {
+            attackers |= bishopAttacks(to, occupancy) & bishopsQueens;
+        }
+        if(nextAttacker == Type::ROOK || nextAttacker == Type::QUEEN)
+        {
+            attackers |= rookAttacks(to, occupancy) & rooksQueens;
+        }
+        attackers &= occupancy;
+        side = ~side;
+    }
+
+    // Each side may stop capturing when continuing would lose material
+    while(depth > 0)
+    {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+bool Chess::Board::seeGe(Move m, int threshold) const
+{
+    // Castling and promotions are rare enough in exchanges that they are judged as even
+    if(m.isCastling() || m.isPromotion())
+    {
+        return 0 >= threshold;
+    }
+
+    Square from = m.from();
+    Square to = m.to();
+
+    // Even if the capture is won for free the threshold is out of reach
+    int swap = (m.flag() == EN_PASSANT ? PieceValue[typeIndex(Type::PAWN)]
+                : m.isCapture() ? PieceValue[typeIndex(typeOf(this->mailbox[to]))] : 0) - threshold;
+    if(swap < 0)
+    {
+        return false;
+    }
+
+    // Even if the moved piece is lost the threshold is still met
+    swap = PieceValue[typeIndex(typeOf(this->mailbox[from]))] - swap;
+    if(swap <= 0)
+    {
+        return true;
+    }
+
+    Bitboard occupancy = this->occupied ^ squareBB(from) ^ squareBB(to);
+    if(m.flag() == EN_PASSANT)
+    {
+        occupancy ^= squareBB(to - (this->stm == WHITE ? 8 : -8));
+    }
+
+    Bitboard bishopsQueens = pieces(Type::BISHOP) | pieces(Type::QUEEN);
+    Bitboard rooksQueens = pieces(Type::ROOK) | pieces(Type::QUEEN);
+    Bitboard attackers = attackersTo(to, occupancy);
+    Color side = this->stm;
+
+    // res is 1 while the side that made the last capture is winning the exchange
+    int res = 1;
+    while(true)
+    {
+        side = ~side;
+        attackers &= occupancy;
+
+        Bitboard sideAttackers = attackers & pieces(side);
+        if(!sideAttackers)
+        {
+            break;
+        }
+
+        res ^= 1;
+
+        // Capture with the least valuable attacker. If that already leaves the side to
+        // move ahead of the swap value the exchange can stop here.
+        Type type = Type::PAWN;
+        Square s = leastValuableAttacker(sideAttackers, side, type);
+        if(type == Type::KING)
+        {
+            // The king can only recapture if the other side has no attackers left
+            return (attackers & ~pieces(side)) ? res ^ 1 : res;
+        }
+
+        swap = PieceValue[typeIndex(type)] - swap;
+        if(swap < res)
+        {
+            break;
+        }
+
+        // Removing the attacker may reveal a slider behind it (an x-ray)
+        occupancy ^= squareBB(s);
+        if(type == Type::PAWN || type == Type::BISHOP || type == Type::QUEEN)
+        {
+            attackers |= bishopAttacks(to, occupancy) & bishopsQueens;
+        }
+        if(type == Type::ROOK || type == Type::QUEEN)
+        {
+            attackers |= rookAttacks(to, occupancy) & rooksQueens;
+        }
+    }
+
+    return res;
+}
+
+void Chess::Board::makeMove(Move m)
+{
+    StateInfo next = this->states.back();
+    Color us = this->stm;
+    Color them = ~us;
+    Square from = m.from();
+    Square to = m.to();
+    Piece pc = this->mailbox[from];
+    Nnue::DirtyPieces dirty;
+
+    next.captured = NO_PIECE;
+    next.halfmoveClock++;
+    next.pliesFromNull++;
+    next.key ^= Zobrist::Side;
+
+    if(next.epSquare != SQ_NONE)
+    {
+        next.key ^= Zobrist::EnPassant[colOf(next.epSquare)];
+        next.epSquare = SQ_NONE;
+    }
+
+    if(m.isCastling())
+    {
+        Square rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        Piece rook = makePiece(us, Type::ROOK);
+
+        movePiece(from, to);
+        movePiece(rookFrom, rookTo);
+        next.key ^= Zobrist::PieceSquare[pc][from] ^ Zobrist::PieceSquare[pc][to]
+                  ^ Zobrist::PieceSquare[rook][rookFrom] ^ Zobrist::PieceSquare[rook][rookTo];
+        dirty.remove(rook, rookFrom);
+        dirty.add(rook, rookTo);
+    }
+    else
+    {
+        if(m.isCapture())
+        {
+            Square capturedSquare = m.flag() == EN_PASSANT ? to - (us == WHITE ? 8 : -8) : to;
+            next.captured = this->mailbox[capturedSquare];
+            next.key ^= Zobrist::PieceSquare[next.captured][capturedSquare];
+            if(typeOf(next.captured) == Type::PAWN)
+            {
+                next.pawnKey ^= Zobrist::PieceSquare[next.captured][capturedSquare];
+            }
+            next.halfmoveClock = 0;
+            removePiece(capturedSquare);
+            dirty.remove(next.captured, capturedSquare);
+        }
+
+        movePiece(from, to);
+        next.key ^= Zobrist::PieceSquare[pc][from] ^ Zobrist::PieceSquare[pc][to];
+        if(typeOf(pc) != Type::KING)
+        {
+            dirty.remove(pc, from);
+            if(!m.isPromotion())
+            {
+                dirty.add(pc, to);
+            }
+        }
+
+        if(typeOf(pc) == Type::PAWN)
+        {
+            next.halfmoveClock = 0;
+            next.pawnKey ^= Zobrist::PieceSquare[pc][from] ^ Zobrist::PieceSquare[pc][to];
+
+            // Only record the en passant square if it can actually be used, so
+            // transpositions hash the same
+            if(m.flag() == DOUBLE_PUSH)
+            {
+                Square ep = (from + to) / 2;
+                if(PawnAttacks[us][ep] & pieces(them, Type::PAWN))
+                {
+                    next.epSquare = ep;
+                    next.key ^= Zobrist::EnPassant[colOf(ep)];
+                }
+            }
+            else if(m.isPromotion())
+            {
+                Piece promoted = makePiece(us, m.promotionType());
+                removePiece(to);
+                putPiece(promoted, to);
+                next.key ^= Zobrist::PieceSquare[pc][to] ^ Zobrist::PieceSquare[promoted][to];
+                next.pawnKey ^= Zobrist::PieceSquare[pc][to];
+                dirty.add(promoted, to);
+            }
+        }
+    }
+
+    uint8_t castling = next.castling & CastlingMask.mask[from] & CastlingMask.mask[to];
+    if(castling != next.castling)
+    {
+        next.key ^= Zobrist::Castling[next.castling] ^ Zobrist::Castling[castling];
+        next.castling = castling;
+    }
+
+    this->stm = them;
+    this->ply++;
+    updateCheckInfo(next);
+    this->states.push_back(next);
+
+    if(this->accumulators)
+    {
+        pushAccumulator(dirty, pc);
+    }
+}
+
+void Chess::Board::unmakeMove(Move m)
+{
+    this->stm = ~this->stm;
+    this->ply--;
+
+    Color us = this->stm;
+    Square from = m.from();
+    Square to = m.to();
+
+    if(m.isCastling())
+    {
+        Square rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        movePiece(to, from);
+        movePiece(rookTo, rookFrom);
+    }
+    else
+    {
+        if(m.isPromotion())
+        {
+            removePiece(to);
+            putPiece(makePiece(us, Type::PAWN), to);
+        }
+
+        movePiece(to, from);
+
+        Piece captured = state().captured;
+        if(captured != NO_PIECE)
+        {
+            Square capturedSquare = m.flag() == EN_PASSANT ? to - (us == WHITE ? 8 : -8) : to;
+            putPiece(captured, capturedSquare);
+        }
+    }
+
+    this->states.pop_back();
+    if(this->accumulators)
+    {
+        this->accumulators->pop();
+    }
+}
+
+void Chess::Board::makeNullMove()
+{
+    StateInfo next = this->states.back();
+
+    next.captured = NO_PIECE;
+    next.halfmoveClock++;
+    next.pliesFromNull = 0;
+    next.key ^= Zobrist::Side;
+    if(next.epSquare != SQ_NONE)
+    {
+        next.key ^= Zobrist::EnPassant[colOf(next.epSquare)];
+        next.epSquare = SQ_NONE;
+    }
+
+    this->stm = ~this->stm;
+    this->ply++;
+    updateCheckInfo(next);
+    this->states.push_back(next);
+
+    // Nothing moved, so the accumulator carries over as is
+    if(this->accumulators)
+    {
+        pushAccumulator(Nnue::DirtyPieces(), NO_PIECE);
+    }
+}
+
+void Chess::Board::unmakeNullMove()
+{
+    this->stm = ~this->stm;
+    this->ply--;
+    this->states.pop_back();
+    if(this->accumulators)
+    {
+        this->accumulators->pop();
+    }
+}
@@ -0,0 +1,176 @@
+#include "../include/Engine/EngineThread.h"
+#include "../include/Engine/Trace.h"
+
+#include <algorithm>
+
+Chess::EngineThread::EngineThread(int threads, size_t hashMb)
+{
+    this->nextSearchId = 1;
+    this->cancelledSearchId = 0;
+    this->quitting = false;
+
+    this->pool.setThreadCount(threads);
+    this->pool.setHashSize(hashMb);
+
+    this->thread = std::thread(&EngineThread::run, this);
+}
+
+Chess::EngineThread::~EngineThread()
+{
+    // Nobody drains the updates any more, so a finishing search must not wait for room
+    this->quitting = true;
+
+    EngineCommand command;
+    command.type = EngineCommand::QUIT;
+    send(std::move(command));
+
+    this->thread.join();
+}
+
+uint32_t Chess::EngineThread::search(const Board& board, const SearchLimits& limits)
+{
+    EngineCommand command;
+    command.type = EngineCommand::SEARCH;
+    command.searchId = this->nextSearchId++;
+    command.board = board;
+    command.limits = limits;
+
+    uint32_t id = command.searchId;
+    send(std::move(command));
+    return id;
+}
+
+void Chess::EngineThread::stop()
+{
+    EngineCommand command;
+    command.type = EngineCommand::STOP;
+    send(std::move(command));
+}
+
+void Chess::EngineThread::ponderhit()
+{
+    EngineCommand command;
+    command.type = EngineCommand::PONDERHIT;
+    send(std::move(command));
+}
+
+void Chess::EngineThread::cancel()
+{
+    EngineCommand command;
+    command.type = EngineCommand::CANCEL;
+    command.searchId = this->nextSearchId - 1;
+    send(std::move(command));
+}
+
+void Chess::EngineThread::newGame()
+{
+    EngineCommand command;
+    command.type = EngineCommand::NEW_GAME;
+    send(std::move(command));
+}
+
+bool Chess::EngineThread::poll(EngineUpdate& update)
+{
+    return this->updates.pop(update);
+}
+
+void Chess::EngineThread::run()
+{
+    CHESS_TRACE_THREAD("engine");
+    EngineCommand command;
+    while(true)
+    {
+        while(!this->commands.pop(command))
+        {
+            this->commands.wait();
+        }
+
+        switch(command.type)
+        {
+            case EngineCommand::SEARCH:
+            {
+                uint32_t id = command.searchId;
+                this->pool.start(command.board, command.limits,
+                    [this, id](const SearchInfo& info)
+                    {
+                        EngineUpdate update;
+                        update.type = EngineUpdate::INFO;
+                        update.searchId = id;
+                        update.depth = info.depth;
+                        update.score = info.score;
+                        update.nodes = info.nodes;
+                        update.nps = info.nps;
+                        update.time = info.time;
+                        update.pvLength = info.pvLength;
+                        std::copy(info.pv, info.pv + info.pvLength, update.pv);
+                        update.metrics = info.metrics;
+                        publish(std::move(update));
+                    },
+                    [this, id](const SearchResult& result)
+                    {
+                        if(this->cancelledSearchId == id)
+                        {
+                            return;
+                        }
+
+                        EngineUpdate update;
+                        update.type = EngineUpdate::BEST_MOVE;
+                        update.searchId = id;
+                        update.depth = result.depth;
+                        update.score = result.score;
+                        update.nodes = result.stats.nodes;
+                        update.pvLength = result.pvLength;
+                        std::copy(result.pv, result.pv + result.pvLength, update.pv);
+                        update.bestMove = result.bestMove;
+                        if(result.pvLength > 1)
+                        {
+                            update.ponderMove = result.pv[1];
+                        }
+                        publish(std::move(update));
+                    });
+                break;
+            }
+            case EngineCommand::STOP:
+                this->pool.stop();
+                break;
+            case EngineCommand::PONDERHIT:
+                this->pool.ponderhit();
+                break;
+            case EngineCommand::CANCEL:
+                this->cancelledSearchId = command.searchId;
+                this->pool.stop();
+                this->pool.wait();
+                break;
+            case EngineCommand::NEW_GAME:
+                this->pool.stop();
+                this->pool.clear();
+                break;
+            case EngineCommand::QUIT:
+                this->pool.stop();
+                this->pool.wait();
+                return;
+        }
+    }
+}
+
+void Chess::EngineThread::send(EngineCommand&& command)
+{
+    while(!this->commands.push(std::move(command)))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void Chess::EngineThread::publish(EngineUpdate&& update)
+{
+    if(update.type == EngineUpdate::INFO)
+    {
+        this->updates.push(std::move(update));
+        return;
+    }
+
+    while(!this->updates.push(std::move(update)) && !this->quitting)
+    {
+        std::this_thread::yield();
+    }
+}
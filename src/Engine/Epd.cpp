@@ -0,0 +1,143 @@
+#include "../include/Engine/Epd.h"
+
+#include <fstream>
+
+namespace
+{
+    // Guess of the average line length, used to reserve room before loading
+    constexpr size_t TYPICAL_LINE_LENGTH = 64;
+
+    std::string_view trim(std::string_view text)
+    {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        if(start == std::string_view::npos)
+        {
+            return {};
+        }
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(start, end - start + 1);
+    }
+};
+
+bool Chess::EpdFile::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file)
+    {
+        return false;
+    }
+
+    clear();
+    size_t fileSize = size_t(file.tellg());
+    file.seekg(0);
+    this->positions.reserve(fileSize / TYPICAL_LINE_LENGTH);
+    this->operationOffsets.reserve(fileSize / TYPICAL_LINE_LENGTH + 1);
+    this->operationText.reserve(fileSize / 4);
+
+    // Read in large chunks. A line cut off at the end of a chunk is moved to the front
+    // of the buffer and completed by the next read.
+    std::vector<char> buffer(READ_CHUNK_SIZE);
+    size_t pending = 0;
+    while(true)
+    {
+        if(pending == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+        file.read(buffer.data() + pending, std::streamsize(buffer.size() - pending));
+        size_t count = pending + size_t(file.gcount());
+        this->bytesRead += uint64_t(file.gcount());
+        bool atEnd = file.gcount() == 0;
+
+        std::string_view chunk(buffer.data(), count);
+        size_t lineStart = 0;
+        size_t newline;
+        while((newline = chunk.find('\n', lineStart)) != std::string_view::npos)
+        {
+            std::string_view line = trim(chunk.substr(lineStart, newline - lineStart));
+            if(!line.empty() && line[0] != '#' && !add(line))
+            {
+                this->skippedLines++;
+            }
+            lineStart = newline + 1;
+        }
+
+        // The last line of the file may not end with a newline
+        if(atEnd)
+        {
+            std::string_view line = trim(chunk.substr(lineStart));
+            if(!line.empty() && line[0] != '#' && !add(line))
+            {
+                this->skippedLines++;
+            }
+            break;
+        }
+
+        pending = count - lineStart;
+        std::copy(buffer.data() + lineStart, buffer.data() + count, buffer.data());
+    }
+    return true;
+}
+
+bool Chess::EpdFile::add(std::string_view line)
+{
+    Fen::Position position;
+    size_t length = Fen::parse(line, position);
+    if(!length)
+    {
+        return false;
+    }
+
+    this->positions.push_back(position);
+    this->operationText.append(trim(line.substr(length)));
+    this->operationOffsets.push_back(uint32_t(this->operationText.size()));
+    return true;
+}
+
+void Chess::EpdFile::clear()
+{
+    this->positions.clear();
+    this->operationOffsets.assign(1, 0);
+    this->operationText.clear();
+    this->skippedLines = 0;
+    this->bytesRead = 0;
+}
+
+std::string_view Chess::EpdFile::operations(size_t index) const
+{
+    uint32_t start = this->operationOffsets[index];
+    return std::string_view(this->operationText).substr(start, this->operationOffsets[index + 1] - start);
+}
+
+std::string_view Chess::EpdFile::operation(size_t index, std::string_view opcode) const
+{
+    std::string_view ops = operations(index);
+    while(!ops.empty())
+    {
+        // Operations end at a semicolon that is not inside a quoted string
+        size_t end = 0;
+        bool quoted = false;
+        while(end < ops.size() && (quoted || ops[end] != ';'))
+        {
+            quoted ^= ops[end++] == '"';
+        }
+        end = end < ops.size() ? end : std::string_view::npos;
+
+        std::string_view op = trim(ops.substr(0, end));
+        ops = end == std::string_view::npos ? std::string_view() : ops.substr(end + 1);
+
+        size_t space = op.find(' ');
+        if(op.substr(0, space) != opcode)
+        {
+            continue;
+        }
+
+        std::string_view operand = space == std::string_view::npos ? std::string_view() : trim(op.substr(space + 1));
+        if(operand.size() >= 2 && operand.front() == '"' && operand.back() == '"')
+        {
+            operand = operand.substr(1, operand.size() - 2);
+        }
+        return operand;
+    }
+    return {};
+}
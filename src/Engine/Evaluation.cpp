@@ -0,0 +1,34 @@
+#include "../include/Engine/Evaluation.h"
+
+#include <algorithm>
+
+using namespace Chess::Bitboards;
+
+int Chess::evaluate(const Board& board, PawnTable& pawnTable)
+{
+    if(const Nnue::Accumulator* accumulator = board.accumulator())
+    {
+        return Nnue::evaluate(*accumulator, board.sideToMove());
+    }
+
+    const PawnEntry& pawns = pawnTable.probe(board);
+    Score total = board.psqtScore() + pawns.score + pawns.shelter[WHITE] - pawns.shelter[BLACK];
+
+    // Whether a passed pawn can advance depends on the other pieces, so it is not cached
+    for(Color c : { WHITE, BLACK })
+    {
+        Bitboard freePassers = pawns.passed[c] & pawnPush(~c, ~board.pieces());
+        while(freePassers)
+        {
+            int row = relativeRow(c, popLsb(freePassers));
+            Score bonus = { FREE_PASSER_BONUS.mg * row, FREE_PASSER_BONUS.eg * row };
+            total += c == WHITE ? bonus : -bonus;
+        }
+    }
+
+    // Promotions can push the phase above its starting value
+    int phase = std::min(board.gamePhase(), Psqt::MAX_PHASE);
+    int score = (total.mg * phase + total.eg * (Psqt::MAX_PHASE - phase)) / Psqt::MAX_PHASE;
+
+    return (board.sideToMove() == WHITE ? score : -score) + TEMPO_BONUS;
+}
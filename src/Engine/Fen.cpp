@@ -0,0 +1,252 @@
+#include "../include/Engine/Fen.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace
+{
+    using namespace Chess;
+
+    // Piece letters in Piece order
+    constexpr std::string_view PieceChars = "PNBRQKpnbrqk";
+
+    // The piece for each character, NO_PIECE for characters that are not piece letters.
+    // Replaces a search of PieceChars for every character of the placement.
+    constexpr auto buildPieceLookup()
+    {
+        struct { Piece piece[256]; } result{};
+        for(int c = 0; c < 256; c++)
+        {
+            result.piece[c] = NO_PIECE;
+        }
+        for(size_t i = 0; i < PieceChars.size(); i++)
+        {
+            result.piece[uint8_t(PieceChars[i])] = Piece(i);
+        }
+        return result;
+    }
+
+    constexpr auto PieceLookup = buildPieceLookup();
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Returns the next space separated field starting at pos and moves pos past it
+    std::string_view nextField(std::string_view text, size_t& pos)
+    {
+        while(pos < text.size() && isSpace(text[pos]))
+        {
+            pos++;
+        }
+        size_t start = pos;
+        while(pos < text.size() && !isSpace(text[pos]))
+        {
+            pos++;
+        }
+        return text.substr(start, pos - start);
+    }
+
+    // Parses a field made only of digits. Returns false, leaving value alone, otherwise.
+    // Numbers too large for an int come out as INT_MIN or INT_MAX, so that range checks
+    // reject them rather than taking the field for something else
+    bool parseNumber(std::string_view field, int& value)
+    {
+        int result;
+        auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), result);
+        if(field.empty() || end != field.data() + field.size())
+        {
+            return false;
+        }
+        if(error == std::errc::result_out_of_range)
+        {
+            result = field[0] == '-' ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+        }
+        else if(error != std::errc())
+        {
+            return false;
+        }
+        value = result;
+        return true;
+    }
+
+    char* writeNumber(char* out, int value)
+    {
+        return std::to_chars(out, out + 12, value).ptr;
+    }
+};
+
+size_t Chess::Fen::parse(std::string_view text, Position& position)
+{
+    size_t pos = 0;
+    std::string_view placement = nextField(text, pos);
+    std::string_view side = nextField(text, pos);
+    std::string_view castling = nextField(text, pos);
+    std::string_view ep = nextField(text, pos);
+    if(ep.empty())
+    {
+        return 0;
+    }
+
+    // Kings are counted and pawns checked while placing, rather than in a second pass
+    std::fill(position.squares, position.squares + SQUARE_NB, NO_PIECE);
+    int kings[COLOR_NB] = { 0, 0 };
+    int row = 7, col = 0;
+    for(char c : placement)
+    {
+        if(c == '/')
+        {
+            if(col != 8 || --row < 0)
+            {
+                return 0;
+            }
+            col = 0;
+        }
+        else if(c >= '1' && c <= '8')
+        {
+            col += c - '0';
+        }
+        else
+        {
+            Piece p = PieceLookup.piece[uint8_t(c)];
+            if(p == NO_PIECE || col > 7)
+            {
+                return 0;
+            }
+            if(p == W_KING || p == B_KING)
+            {
+                kings[colorOf(p)]++;
+            }
+            else if((p == W_PAWN || p == B_PAWN) && (row == 0 || row == 7))
+            {
+                return 0;
+            }
+            position.squares[makeSquare(row, col++)] = p;
+        }
+
+        if(col > 8)
+        {
+            return 0;
+        }
+    }
+    if(row != 0 || col != 8 || kings[WHITE] != 1 || kings[BLACK] != 1)
+    {
+        return 0;
+    }
+    if(side.size() != 1 || (side[0] != 'w' && side[0] != 'b'))
+    {
+        return 0;
+    }
+    position.sideToMove = side[0] == 'w' ? WHITE : BLACK;
+
+    const Piece* sq = position.squares;
+    position.castling = NO_CASTLING;
+    for(char c : castling)
+    {
+        switch(c)
+        {
+            case 'K': position.castling |= sq[4] == W_KING && sq[7] == W_ROOK ? WHITE_OO : 0; break;
+            case 'Q': position.castling |= sq[4] == W_KING && sq[0] == W_ROOK ? WHITE_OOO : 0; break;
+            case 'k': position.castling |= sq[60] == B_KING && sq[63] == B_ROOK ? BLACK_OO : 0; break;
+            case 'q': position.castling |= sq[60] == B_KING && sq[56] == B_ROOK ? BLACK_OOO : 0; break;
+            case '-': break;
+            default: return 0;
+        }
+    }
+
+    position.epSquare = SQ_NONE;
+    if(ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && (ep[1] == '3' || ep[1] == '6'))
+    {
+        position.epSquare = makeSquare(ep[1] - '1', ep[0] - 'a');
+    }
+    else if(ep != "-")
+    {
+        return 0;
+    }
+
+    // The counters are optional. EPD puts operations here instead, which never start
+    // with a digit. Counters out of range would overflow the ply count, so they make the
+    // FEN invalid.
+    position.halfmoveClock = 0;
+    position.fullmoveNumber = 1;
+    size_t end = pos;
+    if(parseNumber(nextField(text, pos), position.halfmoveClock))
+    {
+        end = pos;
+        if(parseNumber(nextField(text, pos), position.fullmoveNumber))
+        {
+            end = pos;
+        }
+    }
+    if(position.halfmoveClock < 0 || position.halfmoveClock > MAX_MOVE_COUNTER
+       || position.fullmoveNumber < 0 || position.fullmoveNumber > MAX_MOVE_COUNTER)
+    {
+        return 0;
+    }
+    position.fullmoveNumber = std::max(position.fullmoveNumber, 1);
+    return end;
+}
+
+size_t Chess::Fen::write(const Position& position, char* buffer)
+{
+    char* out = buffer;
+    for(int row = 7; row >= 0; row--)
+    {
+        int empty = 0;
+        for(int col = 0; col < 8; col++)
+        {
+            Piece p = position.squares[makeSquare(row, col)];
+            if(p == NO_PIECE)
+            {
+                empty++;
+                continue;
+            }
+            if(empty)
+            {
+                *out++ = char('0' + empty);
+                empty = 0;
+            }
+            *out++ = PieceChars[p];
+        }
+        if(empty)
+        {
+            *out++ = char('0' + empty);
+        }
+        if(row)
+        {
+            *out++ = '/';
+        }
+    }
+
+    *out++ = ' ';
+    *out++ = position.sideToMove == WHITE ? 'w' : 'b';
+    *out++ = ' ';
+    if(position.castling == NO_CASTLING)
+    {
+        *out++ = '-';
+    }
+    if(position.castling & WHITE_OO) *out++ = 'K';
+    if(position.castling & WHITE_OOO) *out++ = 'Q';
+    if(position.castling & BLACK_OO) *out++ = 'k';
+    if(position.castling & BLACK_OOO) *out++ = 'q';
+
+    *out++ = ' ';
+    if(position.epSquare == SQ_NONE)
+    {
+        *out++ = '-';
+    }
+    else
+    {
+        *out++ = char('a' + colOf(position.epSquare));
+        *out++ = char('1' + rowOf(position.epSquare));
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, position.halfmoveClock);
+    *out++ = ' ';
+    out = writeNumber(out, position.fullmoveNumber);
+    *out = '\0';
+    return size_t(out - buffer);
+}
@@ -0,0 +1,608 @@
+#include "../include/Engine/GameArchive.h"
+#include "../include/Engine/MoveGen.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    // Plies reserved for the move array up front, longer games grow it once
+    constexpr size_t RESERVED_PLIES = 1024;
+
+    // Converted PGN is buffered and written in pieces of about this size
+    constexpr size_t WRITE_CHUNK_SIZE = 1 << 20;
+
+    // Records and the string offsets are 4 byte aligned, the index 8 byte aligned
+    size_t padding(uint64_t offset, size_t alignment)
+    {
+        return size_t((alignment - offset % alignment) % alignment);
+    }
+
+    // Rows a pawn promotes on
+    constexpr Bitboard PROMOTION_ROWS = Bitboards::RANK_1 | Bitboards::RANK_8;
+
+    // Moves are numbered in an order that can be worked out one piece at a time instead
+    // of generating a move list: the side to move's pieces from a1 to h8, each piece's
+    // destinations from a1 to h8 with a promotion counting as four moves (knight to
+    // queen), then king side and queen side castling. Every pseudo-legal move gets a
+    // number below MAX_MOVES, so a move fits in one byte.
+
+    // Destinations of the piece on a square, as the move generator would give them
+    // apart from castling
+    Bitboard targets(const Board& board, Square from, Type type)
+    {
+        Color us = board.sideToMove();
+        if(type != Type::PAWN)
+        {
+            return Bitboards::attacks(type, from, board.pieces()) & ~board.pieces(us);
+        }
+
+        Bitboard empty = ~board.pieces();
+        Bitboard push = Bitboards::pawnPush(us, Bitboards::squareBB(from)) & empty;
+        Bitboard startPush = push & (us == WHITE ? Bitboards::RANK_2 << 8 : Bitboards::RANK_7 >> 8);
+        Bitboard captureTargets = board.pieces(Color(!us));
+        if(board.epSquare() != SQ_NONE)
+        {
+            captureTargets |= Bitboards::squareBB(board.epSquare());
+        }
+        return push | (Bitboards::pawnPush(us, startPush) & empty)
+             | (Bitboards::pawnAttacksBB(us, Bitboards::squareBB(from)) & captureTargets);
+    }
+
+    // Number of moves a piece has to the given destinations
+    int moveCount(Bitboard to, Type type)
+    {
+        return Bitboards::popCount(to) + (type == Type::PAWN ? 3 * Bitboards::popCount(to & PROMOTION_ROWS) : 0);
+    }
+
+    // The move with a given number, or an invalid Move if there is none
+    Move moveAt(const Board& board, int index)
+    {
+        Color us = board.sideToMove();
+        Bitboard pieces = board.pieces(us);
+        while(pieces)
+        {
+            Square from = Bitboards::popLsb(pieces);
+            Type type = typeOf(board.pieceOn(from));
+            Bitboard to = targets(board, from, type);
+            int count = moveCount(to, type);
+            if(index >= count)
+            {
+                index -= count;
+                continue;
+            }
+
+            // A pawn that can promote has nothing but promotions
+            bool promotion = type == Type::PAWN && (to & PROMOTION_ROWS);
+            for(int skip = promotion ? index / 4 : index; skip > 0; skip--)
+            {
+                to &= to - 1;
+            }
+            Square target = Bitboards::lsb(to);
+            bool capture = board.pieceOn(target) != NO_PIECE;
+
+            if(promotion)
+            {
+                return Move(from, target, MoveFlag((capture ? PROMO_CAPTURE_KNIGHT : PROMO_KNIGHT) + index % 4));
+            }
+            if(type == Type::PAWN && (target - from == 16 || from - target == 16))
+            {
+                return Move(from, target, DOUBLE_PUSH);
+            }
+            if(type == Type::PAWN && target == board.epSquare() && !capture)
+            {
+                return Move(from, target, EN_PASSANT);
+            }
+            return Move(from, target, capture ? CAPTURE : QUIET);
+        }
+
+        Square king = board.kingSquare(us);
+        if(index == 0) return Move(king, king + 2, KING_CASTLE);
+        if(index == 1) return Move(king, king - 2, QUEEN_CASTLE);
+        return Move();
+    }
+
+    // The number of a move, the inverse of moveAt for every pseudo-legal move
+    int moveIndex(const Board& board, Move m)
+    {
+        Color us = board.sideToMove();
+        Square from = m.from();
+        int index = 0;
+        Bitboard pieces = board.pieces(us) & (m.isCastling() ? ~Bitboard(0) : Bitboards::squareBB(from) - 1);
+        while(pieces)
+        {
+            Square s = Bitboards::popLsb(pieces);
+            Type type = typeOf(board.pieceOn(s));
+            index += moveCount(targets(board, s, type), type);
+        }
+        if(m.isCastling())
+        {
+            return index + (m.flag() == QUEEN_CASTLE ? 1 : 0);
+        }
+
+        Bitboard before = targets(board, from, typeOf(board.pieceOn(from))) & (Bitboards::squareBB(m.to()) - 1);
+        if(m.isPromotion())
+        {
+            return index + 4 * Bitboards::popCount(before) + (m.flag() & 3);
+        }
+        return index + Bitboards::popCount(before);
+    }
+
+    // Splits a PGN tag section into (name, value) pairs. Values are kept as written,
+    // escapes included, so they are written back unchanged.
+    void parseTags(std::string_view text, std::vector<std::pair<std::string_view, std::string_view>>& tags)
+    {
+        tags.clear();
+        size_t pos = 0;
+        while((pos = text.find('[', pos)) != std::string_view::npos)
+        {
+            size_t nameEnd = text.find_first_of(" \"]", ++pos);
+            size_t open = text.find('"', pos);
+            if(nameEnd == std::string_view::npos || open == std::string_view::npos)
+            {
+                return;
+            }
+
+            size_t close = open + 1;
+            while(close < text.size() && (text[close] != '"' || text[close - 1] == '\\'))
+            {
+                close++;
+            }
+            if(close >= text.size())
+            {
+                return;
+            }
+
+            tags.emplace_back(text.substr(pos, nameEnd - pos), text.substr(open + 1, close - open - 1));
+            pos = close + 1;
+        }
+    }
+};
+
+Chess::Archive::Result Chess::Archive::parseResult(std::string_view text)
+{
+    if(text == "1-0") return Result::WHITE_WINS;
+    if(text == "0-1") return Result::BLACK_WINS;
+    if(text == "1/2-1/2") return Result::DRAW;
+    return Result::UNKNOWN;
+}
+
+const char* Chess::Archive::resultText(Result result)
+{
+    switch(result)
+    {
+        case Result::WHITE_WINS: return "1-0";
+        case Result::BLACK_WINS: return "0-1";
+        case Result::DRAW: return "1/2-1/2";
+        default: return "*";
+    }
+}
+
+std::string_view Chess::Archive::Game::tagName(int i) const
+{
+    return this->archive->string(this->tags[i].name);
+}
+
+std::string_view Chess::Archive::Game::tagValue(int i) const
+{
+    return this->archive->string(this->tags[i].value);
+}
+
+std::string_view Chess::Archive::Game::tag(std::string_view name) const
+{
+    for(int i = 0; i < this->tagCount; i++)
+    {
+        if(tagName(i) == name)
+        {
+            return tagValue(i);
+        }
+    }
+    return {};
+}
+
+Chess::Archive::Writer::~Writer()
+{
+    if(this->file.is_open())
+    {
+        finish();
+    }
+}
+
+bool Chess::Archive::Writer::open(const std::string& path)
+{
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    if(!this->file)
+    {
+        return false;
+    }
+
+    // The header is written for real once the sizes are known
+    Header header{};
+    this->file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    this->failed = !this->file;
+    this->stringIds.clear();
+    this->strings.clear();
+    this->offsets = { sizeof(Header) };
+    return !this->failed;
+}
+
+uint32_t Chess::Archive::Writer::intern(std::string_view s)
+{
+    auto [entry, added] = this->stringIds.try_emplace(std::string(s), uint32_t(this->strings.size()));
+    if(added)
+    {
+        // Keys of an unordered_map do not move, so the view stays valid
+        this->strings.push_back(entry->first);
+    }
+    return entry->second;
+}
+
+bool Chess::Archive::Writer::add(const Pgn::Game& game)
+{
+    parseTags(game.tags, this->tagPairs);
+    return add(this->tagPairs, game.start, game.moves, game.plies, parseResult(game.result), game.complete);
+}
+
+bool Chess::Archive::Writer::add(const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                                 const Fen::Position& start, const Move* moves, int plies, Result result, bool complete)
+{
+    // The start position is only stored as a FEN tag, so one is added if it is needed
+    // and missing
+    char fen[Fen::MAX_LENGTH];
+    size_t fenLength = Fen::write(start, fen);
+
+    bool hasFen = false;
+    for(const auto& tag : tags)
+    {
+        hasFen |= tag.first == "FEN";
+    }
+    bool addFen = !hasFen && std::string_view(fen, fenLength) != START_FEN;
+
+    size_t tagCount = tags.size() + (addFen ? 2 : 0);
+    if(tagCount > UINT16_MAX || plies < 0)
+    {
+        return false;
+    }
+
+    size_t size = sizeof(RecordHeader) + tagCount * sizeof(Tag) + size_t(plies);
+    this->record.assign(size + padding(size, 4), 0);
+
+    RecordHeader recordHeader{ uint32_t(plies), uint16_t(tagCount), result, uint8_t(complete) };
+    std::memcpy(this->record.data(), &recordHeader, sizeof(recordHeader));
+
+    Tag* recordTags = reinterpret_cast<Tag*>(this->record.data() + sizeof(RecordHeader));
+    for(const auto& tag : tags)
+    {
+        *recordTags++ = { intern(tag.first), intern(tag.second) };
+    }
+    if(addFen)
+    {
+        *recordTags++ = { intern("SetUp"), intern("1") };
+        *recordTags++ = { intern("FEN"), intern(std::string_view(fen, fenLength)) };
+    }
+
+    uint8_t* indices = reinterpret_cast<uint8_t*>(recordTags);
+    if(!this->board.setPosition(start))
+    {
+        return false;
+    }
+    for(int ply = 0; ply < plies; ply++)
+    {
+        // Numbering the move back and forth also catches moves of pieces that are not
+        // there or not ours
+        Move m = moves[ply];
+        if(this->board.pieceOn(m.from()) == NO_PIECE || colorOf(this->board.pieceOn(m.from())) != this->board.sideToMove())
+        {
+            return false;
+        }
+        int index = moveIndex(this->board, m);
+        if(index >= MAX_MOVES || moveAt(this->board, index) != m || !this->board.isPseudoLegal(m) || !this->board.isLegal(m))
+        {
+            return false;
+        }
+        indices[ply] = uint8_t(index);
+        this->board.makeMove(m);
+    }
+
+    this->file.write(this->record.data(), std::streamsize(this->record.size()));
+    this->failed |= !this->file;
+    this->offsets.push_back(this->offsets.back() + this->record.size());
+    return true;
+}
+
+bool Chess::Archive::Writer::finish()
+{
+    if(!this->file.is_open())
+    {
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.stringCount = uint32_t(this->strings.size());
+    header.gameCount = size();
+    header.stringsOffset = this->offsets.back();
+
+    // String offsets, then the characters
+    std::vector<uint32_t> stringOffsets = { 0 };
+    for(std::string_view s : this->strings)
+    {
+        stringOffsets.push_back(stringOffsets.back() + uint32_t(s.size()));
+    }
+    this->file.write(reinterpret_cast<const char*>(stringOffsets.data()),
+                     std::streamsize(stringOffsets.size() * sizeof(uint32_t)));
+    for(std::string_view s : this->strings)
+    {
+        this->file.write(s.data(), std::streamsize(s.size()));
+    }
+
+    uint64_t end = header.stringsOffset + stringOffsets.size() * sizeof(uint32_t) + stringOffsets.back();
+    const char zeros[8] = {};
+    this->file.write(zeros, std::streamsize(padding(end, 8)));
+    header.indexOffset = end + padding(end, 8);
+    this->file.write(reinterpret_cast<const char*>(this->offsets.data()),
+                     std::streamsize(this->offsets.size() * sizeof(uint64_t)));
+
+    this->file.seekp(0);
+    this->file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    this->failed |= !this->file;
+    this->file.close();
+    return !this->failed;
+}
+
+Chess::Archive::Reader::Reader()
+{
+    Fen::parse(START_FEN, this->startPosition);
+    this->moves.reserve(RESERVED_PLIES);
+    this->keys.reserve(RESERVED_PLIES + 1);
+}
+
+bool Chess::Archive::Reader::open(const std::string& path, MappedFile::Access access)
+{
+    this->header = nullptr;
+    if(!this->file.open(path, access) || this->file.size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header* candidate = reinterpret_cast<const Header*>(this->file.data());
+    uint64_t size = this->file.size();
+    if(std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION
+        || candidate->stringsOffset + (uint64_t(candidate->stringCount) + 1) * sizeof(uint32_t) > size
+        || candidate->indexOffset + (candidate->gameCount + 1) * sizeof(uint64_t) > size)
+    {
+        return false;
+    }
+
+    this->header = candidate;
+    this->stringOffsets = reinterpret_cast<const uint32_t*>(this->file.data() + candidate->stringsOffset);
+    this->stringData = reinterpret_cast<const char*>(this->stringOffsets + candidate->stringCount + 1);
+    this->recordOffsets = reinterpret_cast<const uint64_t*>(this->file.data() + candidate->indexOffset);
+    this->fenId = findString("FEN");
+    return true;
+}
+
+uint32_t Chess::Archive::Reader::findString(std::string_view s) const
+{
+    for(uint32_t id = 0; id < stringCount(); id++)
+    {
+        if(string(id) == s)
+        {
+            return id;
+        }
+    }
+    return UINT32_MAX;
+}
+
+bool Chess::Archive::Reader::game(uint64_t index, Game& game, bool replay)
+{
+    // A record must lie between the header and the string table
+    uint64_t offset = this->recordOffsets[index];
+    const char* record = this->file.data() + offset;
+    const RecordHeader* recordHeader = reinterpret_cast<const RecordHeader*>(record);
+    if(offset < sizeof(Header) || offset + sizeof(RecordHeader) > this->header->stringsOffset
+        || offset + sizeof(RecordHeader) + recordHeader->tagCount * sizeof(Tag) + recordHeader->plies
+           > this->header->stringsOffset)
+    {
+        return false;
+    }
+
+    game.index = index;
+    game.result = recordHeader->result;
+    game.complete = recordHeader->complete != 0;
+    game.plies = int(recordHeader->plies);
+    game.tags = reinterpret_cast<const Tag*>(record + sizeof(RecordHeader));
+    game.tagCount = recordHeader->tagCount;
+    game.archive = this;
+    game.moves = nullptr;
+    game.keys = nullptr;
+
+    // Like the PGN reader, a FEN tag that does not parse means the standard start
+    game.start = this->startPosition;
+    for(int i = 0; i < game.tagCount && this->fenId != UINT32_MAX; i++)
+    {
+        if(game.tags[i].name == this->fenId && !Fen::parse(string(game.tags[i].value), game.start))
+        {
+            game.start = this->startPosition;
+        }
+    }
+    if(!replay)
+    {
+        return true;
+    }
+
+    // Move numbers were only ever written for legal moves, so they are played without
+    // checking legality again
+    const uint8_t* indices = reinterpret_cast<const uint8_t*>(game.tags + game.tagCount);
+    this->board.setPosition(game.start);
+    this->moves.resize(size_t(game.plies));
+    this->keys.resize(size_t(game.plies) + 1);
+    for(int ply = 0; ply < game.plies; ply++)
+    {
+        Move m = moveAt(this->board, indices[ply]);
+        if(!m.isValid())
+        {
+            return false;
+        }
+        this->moves[ply] = m;
+        this->keys[ply] = this->board.key();
+        this->board.makeMove(m);
+    }
+    this->keys[game.plies] = this->board.key();
+    game.moves = this->moves.data();
+    game.keys = this->keys.data();
+    return true;
+}
+
+uint64_t Chess::Archive::Reader::read(uint64_t first, uint64_t last, const GameCallback& onGame, bool replay)
+{
+    uint64_t corrupt = 0;
+    Game game;
+    for(uint64_t i = first; i < last && i < size(); i++)
+    {
+        if(!this->game(i, game, replay))
+        {
+            corrupt++;
+            continue;
+        }
+        onGame(game);
+    }
+    return corrupt;
+}
+
+uint64_t Chess::Archive::readParallel(const std::string& path, int threads, const ParallelGameCallback& onGame,
+                                      bool replay)
+{
+    threads = std::max(threads, 1);
+    std::vector<Reader> readers(threads);
+    for(Reader& reader : readers)
+    {
+        if(!reader.open(path))
+        {
+            return UINT64_MAX;
+        }
+    }
+
+    uint64_t games = readers[0].size();
+    std::vector<uint64_t> corrupt(threads);
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&, i]()
+        {
+            uint64_t first = games / uint64_t(threads) * uint64_t(i);
+            uint64_t last = i == threads - 1 ? games : games / uint64_t(threads) * uint64_t(i + 1);
+            corrupt[i] = readers[i].read(first, last, [&](const Game& game) { onGame(game, i); }, replay);
+        });
+    }
+
+    uint64_t total = 0;
+    for(int i = 0; i < threads; i++)
+    {
+        workers[i].join();
+        total += corrupt[i];
+    }
+    return total;
+}
+
+void Chess::Archive::appendPgn(const Game& game, Board& board, std::string& out)
+{
+    for(int i = 0; i < game.tagCount; i++)
+    {
+        out += '[';
+        out += game.tagName(i);
+        out += " \"";
+        out += game.tagValue(i);
+        out += "\"]\n";
+    }
+    out += '\n';
+
+    // Movetext wrapped before 80 columns, with a move number before every white move and
+    // before the first move if black starts
+    board.setPosition(game.start);
+    size_t lineStart = out.size();
+    std::string token;
+    for(int ply = 0; ply < game.plies && game.moves; ply++)
+    {
+        token.clear();
+        if(board.sideToMove() == WHITE || ply == 0)
+        {
+            token += std::to_string(board.fullmoveNumber());
+            token += board.sideToMove() == WHITE ? ". " : "... ";
+        }
+        token += toSan(board, game.moves[ply]);
+        board.makeMove(game.moves[ply]);
+
+        if(out.size() > lineStart && out.size() - lineStart + token.size() + 1 > 79)
+        {
+            out += '\n';
+            lineStart = out.size();
+        }
+        else if(out.size() > lineStart)
+        {
+            out += ' ';
+        }
+        out += token;
+    }
+
+    if(out.size() > lineStart)
+    {
+        out += ' ';
+    }
+    out += resultText(game.result);
+    out += "\n\n";
+}
+
+bool Chess::Archive::fromPgn(const std::string& pgnPath, const std::string& archivePath, ConvertStats& stats)
+{
+    MappedFile pgn;
+    Writer writer;
+    if(!pgn.open(pgnPath) || !writer.open(archivePath))
+    {
+        return false;
+    }
+
+    Pgn::Reader reader;
+    reader.read(pgn.view(), [&](const Pgn::Game& game)
+    {
+        if(!writer.add(game))
+        {
+            stats.errors++;
+            return;
+        }
+        stats.games++;
+        stats.plies += uint64_t(game.plies);
+        stats.errors += game.complete ? 0 : 1;
+    });
+    return writer.finish();
+}
+
+bool Chess::Archive::toPgn(const std::string& archivePath, const std::string& pgnPath, ConvertStats& stats)
+{
+    Reader reader;
+    std::ofstream pgn(pgnPath, std::ios::binary | std::ios::trunc);
+    if(!reader.open(archivePath) || !pgn)
+    {
+        return false;
+    }
+
+    Board board;
+    std::string text;
+    stats.errors += reader.read([&](const Game& game)
+    {
+        appendPgn(game, board, text);
+        stats.games++;
+        stats.plies += uint64_t(game.plies);
+        if(text.size() >= WRITE_CHUNK_SIZE)
+        {
+            pgn.write(text.data(), std::streamsize(text.size()));
+            text.clear();
+        }
+    });
+    pgn.write(text.data(), std::streamsize(text.size()));
+    return bool(pgn);
+}
@@ -0,0 +1,76 @@
+#include "../include/Engine/History.h"
+
+#include <algorithm>
+
+Chess::HistoryTables::HistoryTables()
+{
+    clear();
+}
+
+void Chess::HistoryTables::clear()
+{
+    std::fill(&this->butterfly[0][0][0], &this->butterfly[0][0][0] + sizeof(this->butterfly) / sizeof(int16_t), int16_t(0));
+    std::fill(&this->continuation[0][0][0][0], &this->continuation[0][0][0][0] + sizeof(this->continuation) / sizeof(int16_t), int16_t(0));
+    std::fill(&this->killers[0][0], &this->killers[0][0] + sizeof(this->killers) / sizeof(Move), Move());
+    std::fill(&this->counterMoves[0][0], &this->counterMoves[0][0] + sizeof(this->counterMoves) / sizeof(Move), Move());
+}
+
+void Chess::HistoryTables::age()
+{
+    int16_t* entries = &this->butterfly[0][0][0];
+    for(size_t i = 0; i < sizeof(this->butterfly) / sizeof(int16_t); i++)
+    {
+        entries[i] /= 2;
+    }
+
+    entries = &this->continuation[0][0][0][0];
+    for(size_t i = 0; i < sizeof(this->continuation) / sizeof(int16_t); i++)
+    {
+        entries[i] /= 2;
+    }
+
+    // Killers belong to plies of the previous search's tree, which has moved on by now
+    std::fill(&this->killers[0][0], &this->killers[0][0] + sizeof(this->killers) / sizeof(Move), Move());
+}
+
+void Chess::HistoryTables::storeKiller(int ply, Move m)
+{
+    if(this->killers[ply][0] != m)
+    {
+        this->killers[ply][1] = this->killers[ply][0];
+        this->killers[ply][0] = m;
+    }
+}
+
+int Chess::HistoryTables::statBonus(int depth)
+{
+    return std::min(16 * depth * depth + 64 * depth, 1600);
+}
+
+void Chess::HistoryTables::updateQuiet(Color us, Piece piece, Move m, int bonus, PieceToHistory* const* continuations)
+{
+    updateHistoryEntry(this->butterfly[us][m.from()][m.to()], bonus);
+    for(int i = 0; i < 2; i++)
+    {
+        if(continuations[i])
+        {
+            updateHistoryEntry((*continuations[i])[piece][m.to()], bonus);
+        }
+    }
+}
+
+void Chess::HistoryTables::updateQuietStats(Color us, Piece piece, Move best, const Move* triedQuiets,
+                                           const Piece* triedPieces, int triedCount, int depth,
+                                           PieceToHistory* const* continuations)
+{
+    int bonus = statBonus(depth);
+
+    updateQuiet(us, piece, best, bonus, continuations);
+    for(int i = 0; i < triedCount; i++)
+    {
+        if(triedQuiets[i] != best)
+        {
+            updateQuiet(us, triedPieces[i], triedQuiets[i], -bonus, continuations);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include "../include/Engine/MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Chess::MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool Chess::MappedFile::open(const std::string& path, Access access)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // An empty file can not be mapped but is still a valid, empty view
+    size_t size = size_t(info.st_size);
+    if(size > 0)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        madvise(mapping, size, access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        this->bytes = static_cast<const char*>(mapping);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    this->length = size;
+    this->opened = true;
+    return true;
+}
+
+void Chess::MappedFile::close()
+{
+    if(this->bytes)
+    {
+        munmap(const_cast<char*>(this->bytes), this->length);
+    }
+    this->bytes = nullptr;
+    this->length = 0;
+    this->opened = false;
+}
@@ -0,0 +1,410 @@
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Trace.h"
+
+using namespace Chess::Bitboards;
+
+namespace
+{
+    using namespace Chess;
+
+    // Letters of the piece types in SAN, in Type order. Pawns have none.
+    constexpr std::string_view SanPieceChars = " NBRQK";
+
+    // Adds all four promotions of a pawn arriving on a square
+    inline void addPromotions(MoveList& list, Square from, Square to, bool isCapture)
+    {
+        MoveFlag base = isCapture ? PROMO_CAPTURE_KNIGHT : PROMO_KNIGHT;
+        for(int i = 3; i >= 0; i--)
+        {
+            list.add(Move(from, to, MoveFlag(base + i)));
+        }
+    }
+
+    template<GenType T>
+    void generatePawnMoves(const Board& board, MoveList& list)
+    {
+        Color us = board.sideToMove();
+        Color them = ~us;
+        int forward = us == WHITE ? 8 : -8;
+        Bitboard empty = ~board.pieces();
+        Bitboard enemies = board.pieces(them);
+        Bitboard pawns = board.pieces(us, Type::PAWN);
+        Bitboard lastRow = us == WHITE ? RANK_8 : RANK_1;
+        Bitboard thirdRow = us == WHITE ? (RANK_2 << 8) : (RANK_7 >> 8);
+
+        if(T != QUIETS)
+        {
+            // Promotions by pushing
+            Bitboard b = pawnPush(us, pawns) & empty & lastRow;
+            while(b)
+            {
+                Square to = popLsb(b);
+                addPromotions(list, to - forward, to, false);
+            }
+
+            // Captures, with and without promotion
+            Bitboard pawnSet = pawns;
+            while(pawnSet)
+            {
+                Square from = popLsb(pawnSet);
+                Bitboard targets = PawnAttacks[us][from] & enemies;
+                while(targets)
+                {
+                    Square to = popLsb(targets);
+                    if(squareBB(to) & lastRow)
+                    {
+                        addPromotions(list, from, to, true);
+                    }
+                    else
+                    {
+                        list.add(Move(from, to, CAPTURE));
+                    }
+                }
+            }
+
+            Square ep = board.epSquare();
+            if(ep != SQ_NONE)
+            {
+                Bitboard attackers = PawnAttacks[them][ep] & pawns;
+                while(attackers)
+                {
+                    list.add(Move(popLsb(attackers), ep, EN_PASSANT));
+                }
+            }
+        }
+
+        if(T != CAPTURES)
+        {
+            Bitboard single = pawnPush(us, pawns) & empty;
+            Bitboard doubled = pawnPush(us, single & thirdRow) & empty;
+            single &= ~lastRow;
+
+            while(single)
+            {
+                Square to = popLsb(single);
+                list.add(Move(to - forward, to, QUIET));
+            }
+            while(doubled)
+            {
+                Square to = popLsb(doubled);
+                list.add(Move(to - 2 * forward, to, DOUBLE_PUSH));
+            }
+        }
+    }
+
+    template<GenType T>
+    void generatePieceMoves(const Board& board, MoveList& list, Type type)
+    {
+        Color us = board.sideToMove();
+        Bitboard occupancy = board.pieces();
+        Bitboard enemies = board.pieces(~us);
+        Bitboard empty = ~occupancy;
+
+        Bitboard pieceSet = board.pieces(us, type);
+        while(pieceSet)
+        {
+            Square from = popLsb(pieceSet);
+            Bitboard targets = attacks(type, from, occupancy);
+
+            if(T != QUIETS)
+            {
+                Bitboard captures = targets & enemies;
+                while(captures)
+                {
+                    list.add(Move(from, popLsb(captures), CAPTURE));
+                }
+            }
+            if(T != CAPTURES)
+            {
+                Bitboard quiets = targets & empty;
+                while(quiets)
+                {
+                    list.add(Move(from, popLsb(quiets), QUIET));
+                }
+            }
+        }
+    }
+
+    // Adds castling moves whose path is empty. Attacked squares are checked by Board::isLegal.
+    void generateCastling(const Board& board, MoveList& list)
+    {
+        Color us = board.sideToMove();
+        uint8_t rights = board.castlingRights() & (us == WHITE ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+        if(!rights)
+        {
+            return;
+        }
+
+        Square king = us == WHITE ? 4 : 60;
+        Bitboard occupancy = board.pieces();
+        if((rights & (WHITE_OO | BLACK_OO)) && !(BetweenBB[king][king + 3] & occupancy))
+        {
+            list.add(Move(king, king + 2, KING_CASTLE));
+        }
+        if((rights & (WHITE_OOO | BLACK_OOO)) && !(BetweenBB[king][king - 4] & occupancy))
+        {
+            list.add(Move(king, king - 2, QUEEN_CASTLE));
+        }
+    }
+};
+
+template<Chess::GenType T>
+void Chess::generateMoves(const Board& board, MoveList& list)
+{
+    CHESS_TRACE_SCOPE(T == CAPTURES ? "generate captures" : T == QUIETS ? "generate quiets" : "generate moves");
+    generatePawnMoves<T>(board, list);
+    generatePieceMoves<T>(board, list, Type::KNIGHT);
+    generatePieceMoves<T>(board, list, Type::BISHOP);
+    generatePieceMoves<T>(board, list, Type::ROOK);
+    generatePieceMoves<T>(board, list, Type::QUEEN);
+    generatePieceMoves<T>(board, list, Type::KING);
+
+    if(T != CAPTURES)
+    {
+        generateCastling(board, list);
+    }
+}
+
+template void Chess::generateMoves<Chess::CAPTURES>(const Board& board, MoveList& list);
+template void Chess::generateMoves<Chess::QUIETS>(const Board& board, MoveList& list);
+template void Chess::generateMoves<Chess::ALL>(const Board& board, MoveList& list);
+
+void Chess::generateLegalMoves(const Board& board, MoveList& list)
+{
+    CHESS_TRACE_SCOPE("generate legal moves");
+    MoveList pseudoLegal;
+    generateMoves<ALL>(board, pseudoLegal);
+
+    for(const ScoredMove& sm: pseudoLegal)
+    {
+        if(board.isLegal(sm.move))
+        {
+            list.add(sm.move);
+        }
+    }
+}
+
+Chess::Move Chess::findLegalMove(const Board& board, std::string_view uci)
+{
+    MoveList list;
+    generateLegalMoves(board, list);
+    for(const ScoredMove& sm: list)
+    {
+        if(sm.move.toUci() == uci)
+        {
+            return sm.move;
+        }
+    }
+    return Move();
+}
+
+Chess::Move Chess::findSanMove(const Board& board, std::string_view san)
+{
+    while(!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+    {
+        san.remove_suffix(1);
+    }
+    if(san.size() < 2)
+    {
+        return Move();
+    }
+
+    // Candidate moves are built straight from the text and the attack tables rather than
+    // by generating every move, then checked with isPseudoLegal and isLegal
+    Color us = board.sideToMove();
+    if(san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+    {
+        Square kingFrom = us == WHITE ? 4 : 60;
+        Move m = san.size() == 3 ? Move(kingFrom, kingFrom + 2, KING_CASTLE) : Move(kingFrom, kingFrom - 2, QUEEN_CASTLE);
+        return board.isPseudoLegal(m) && board.isLegal(m) ? m : Move();
+    }
+
+    // Promotion piece, written "e8=Q" or "e8Q"
+    size_t promotion = 0;
+    bool hasEquals = san[san.size() - 2] == '=';
+    if(hasEquals || (san[0] >= 'a' && san[0] <= 'h' && san[san.size() - 2] >= '1' && san[san.size() - 2] <= '8'
+        && san.back() >= 'A' && san.back() <= 'Z'))
+    {
+        promotion = SanPieceChars.find(san.back());
+        if(promotion == 0 || promotion == std::string_view::npos || promotion == size_t(typeIndex(Type::KING)))
+        {
+            return Move();
+        }
+        san.remove_suffix(hasEquals ? 2 : 1);
+    }
+
+    Type type = Type::PAWN;
+    size_t pieceIndex = SanPieceChars.find(san[0]);
+    if(pieceIndex != std::string_view::npos && pieceIndex > 0)
+    {
+        type = Type(pieceIndex);
+        san.remove_prefix(1);
+    }
+
+    // The destination is always last, anything before it narrows down the origin
+    if(san.size() < 2 || san[san.size() - 2] < 'a' || san[san.size() - 2] > 'h'
+        || san.back() < '1' || san.back() > '8')
+    {
+        return Move();
+    }
+    Square to = makeSquare(san.back() - '1', san[san.size() - 2] - 'a');
+    san.remove_suffix(2);
+
+    int fromRow = -1, fromCol = -1;
+    for(char c : san)
+    {
+        if(c >= 'a' && c <= 'h') fromCol = c - 'a';
+        else if(c >= '1' && c <= '8') fromRow = c - '1';
+        else if(c != 'x' && c != ':' && c != '-') return Move();
+    }
+
+    bool isCapture = board.pieceOn(to) != NO_PIECE;
+    if(type == Type::PAWN)
+    {
+        // A pawn comes from straight behind, two squares behind, or diagonally behind
+        // on the file given for a capture
+        int forward = us == WHITE ? 8 : -8;
+        Square from;
+        MoveFlag flag = QUIET;
+        if(fromCol >= 0 && fromCol != colOf(to))
+        {
+            from = makeSquare(rowOf(to - forward), fromCol);
+            flag = to == board.epSquare() && !isCapture ? EN_PASSANT : CAPTURE;
+        }
+        else if(to - forward >= 0 && to - forward < SQUARE_NB && board.pieceOn(to - forward) == NO_PIECE)
+        {
+            from = to - 2 * forward;
+            flag = DOUBLE_PUSH;
+        }
+        else
+        {
+            from = to - forward;
+        }
+        if(from < 0 || from >= SQUARE_NB || (fromRow >= 0 && rowOf(from) != fromRow))
+        {
+            return Move();
+        }
+
+        if(promotion)
+        {
+            flag = MoveFlag((flag == CAPTURE ? PROMO_CAPTURE_KNIGHT : PROMO_KNIGHT) + int(promotion) - 1);
+        }
+        Move m(from, to, flag);
+        return board.pieceOn(from) == makePiece(us, Type::PAWN) && board.isPseudoLegal(m) && board.isLegal(m) ? m : Move();
+    }
+    if(promotion)
+    {
+        return Move();
+    }
+
+    Bitboard candidates = board.attackersTo(to, board.pieces()) & board.pieces(us, type);
+    Move found;
+    while(candidates)
+    {
+        Square from = Bitboards::popLsb(candidates);
+        Move m(from, to, isCapture ? CAPTURE : QUIET);
+        if((fromCol >= 0 && colOf(from) != fromCol) || (fromRow >= 0 && rowOf(from) != fromRow)
+            || !board.isPseudoLegal(m) || !board.isLegal(m))
+        {
+            continue;
+        }
+
+        // Two legal moves match, the text is ambiguous
+        if(found.isValid())
+        {
+            return Move();
+        }
+        found = m;
+    }
+    return found;
+}
+
+std::string Chess::toSan(Board& board, Move m)
+{
+    std::string san;
+    if(m.flag() == KING_CASTLE || m.flag() == QUEEN_CASTLE)
+    {
+        san = m.flag() == KING_CASTLE ? "O-O" : "O-O-O";
+    }
+    else
+    {
+        Type type = typeOf(board.movedPiece(m));
+        if(type == Type::PAWN)
+        {
+            if(m.isCapture())
+            {
+                san += char('a' + colOf(m.from()));
+            }
+        }
+        else
+        {
+            san += SanPieceChars[typeIndex(type)];
+
+            // Name the origin's file, or its row, or both, if another piece of the same
+            // kind could also go to the destination
+            MoveList list;
+            generateMoves<ALL>(board, list);
+            bool ambiguous = false, sameCol = false, sameRow = false;
+            for(const ScoredMove& sm: list)
+            {
+                Move other = sm.move;
+                if(other.to() == m.to() && other.from() != m.from() && typeOf(board.movedPiece(other)) == type
+                    && board.isLegal(other))
+                {
+                    ambiguous = true;
+                    sameCol |= colOf(other.from()) == colOf(m.from());
+                    sameRow |= rowOf(other.from()) == rowOf(m.from());
+                }
+            }
+            if(ambiguous && (!sameCol || sameRow))
+            {
+                san += char('a' + colOf(m.from()));
+            }
+            if(ambiguous && sameCol)
+            {
+                san += char('1' + rowOf(m.from()));
+            }
+        }
+
+        if(m.isCapture())
+        {
+            san += 'x';
+        }
+        san += squareToString(m.to());
+        if(m.isPromotion())
+        {
+            san += '=';
+            san += SanPieceChars[typeIndex(m.promotionType())];
+        }
+    }
+
+    if(board.givesCheck(m))
+    {
+        board.makeMove(m);
+        MoveList replies;
+        generateLegalMoves(board, replies);
+        san += replies.size() == 0 ? '#' : '+';
+        board.unmakeMove(m);
+    }
+    return san;
+}
+
+uint64_t Chess::perft(Board& board, int depth)
+{
+    MoveList list;
+    generateLegalMoves(board, list);
+
+    if(depth <= 1)
+    {
+        return depth == 1 ? list.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+    for(const ScoredMove& sm: list)
+    {
+        board.makeMove(sm.move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove(sm.move);
+    }
+    return nodes;
+}
@@ -0,0 +1,255 @@
+#include "../include/Engine/MovePicker.h"
+#include "../include/Engine/MoveGen.h"
+
+Chess::MovePicker::MovePicker(const Board& board, Move ttMove, const Move* killers, Move counterMove,
+                              const ButterflyHistory* history, PieceToHistory* const* continuations)
+    : board(board), ttMove(ttMove), counterMove(counterMove), history(history), generateChecks(false)
+{
+    this->continuations[0] = history ? continuations[0] : nullptr;
+    this->continuations[1] = history ? continuations[1] : nullptr;
+    this->killers[0] = killers[0];
+    this->killers[1] = killers[1];
+    this->current = 0;
+    this->badCaptureCount = 0;
+
+    // Skip straight to the captures if there is no usable hash move
+    this->stage = (ttMove.isValid() && board.isPseudoLegal(ttMove)) ? TT_MOVE : CAPTURE_INIT;
+}
+
+Chess::MovePicker::MovePicker(const Board& board, Move ttMove, bool generateChecks)
+    : board(board), ttMove(ttMove), counterMove(), history(nullptr), generateChecks(generateChecks)
+{
+    this->killers[0] = this->killers[1] = Move();
+    this->continuations[0] = this->continuations[1] = nullptr;
+    this->current = 0;
+    this->badCaptureCount = 0;
+
+    // A hash move from a deeper search may be quiet, only use it if it fits this node
+    bool ttMoveFits = ttMove.isValid() && (board.inCheck() || ttMove.isNoisy()) && board.isPseudoLegal(ttMove);
+    if(!ttMoveFits)
+    {
+        this->ttMove = Move();
+    }
+
+    // Evasions go through the main stages so every escape is considered
+    if(board.inCheck())
+    {
+        this->stage = ttMoveFits ? TT_MOVE : CAPTURE_INIT;
+    }
+    else
+    {
+        this->stage = ttMoveFits ? QS_TT_MOVE : QS_CAPTURE_INIT;
+    }
+}
+
+void Chess::MovePicker::scoreCaptures()
+{
+    for(ScoredMove& sm: this->captures)
+    {
+        Move m = sm.move;
+        Type attacker = typeOf(this->board.movedPiece(m));
+        int victimValue = m.flag() == EN_PASSANT ? PieceValue[typeIndex(Type::PAWN)]
+                        : m.isCapture()          ? PieceValue[typeIndex(typeOf(this->board.pieceOn(m.to())))]
+                        : 0;
+        int promotionValue = m.isPromotion() ? PieceValue[typeIndex(m.promotionType())] : 0;
+
+        sm.score = (victimValue + promotionValue) * 16 - typeIndex(attacker);
+    }
+}
+
+void Chess::MovePicker::scoreQuiets()
+{
+    if(!this->history)
+    {
+        return;
+    }
+
+    Color us = this->board.sideToMove();
+    for(ScoredMove& sm: this->quiets)
+    {
+        Move m = sm.move;
+        Piece pc = this->board.movedPiece(m);
+
+        sm.score = (*this->history)[us][m.from()][m.to()];
+        for(const PieceToHistory* continuation: this->continuations)
+        {
+            if(continuation)
+            {
+                sm.score += (*continuation)[pc][m.to()];
+            }
+        }
+    }
+}
+
+bool Chess::MovePicker::isLosingCapture(Move m) const
+{
+    // Under-promotions are almost never best, so they wait until the end
+    if(m.isPromotion())
+    {
+        return m.promotionType() != Type::QUEEN;
+    }
+
+    return !this->board.seeGe(m, 0);
+}
+
+bool Chess::MovePicker::isSpecialQuiet(Move m) const
+{
+    return m == this->ttMove || m == this->killers[0] || m == this->killers[1] || m == this->counterMove;
+}
+
+Chess::Move Chess::MovePicker::pickBest(MoveList& list)
+{
+    int best = this->current;
+    for(int i = this->current + 1; i < list.size(); i++)
+    {
+        if(list[i].score > list[best].score)
+        {
+            best = i;
+        }
+    }
+
+    ScoredMove picked = list[best];
+    list[best] = list[this->current];
+    list[this->current] = picked;
+    this->current++;
+
+    return picked.move;
+}
+
+Chess::Move Chess::MovePicker::nextMove(bool skipQuiets)
+{
+    while(true)
+    {
+        switch(this->stage)
+        {
+            case TT_MOVE:
+                this->stage++;
+                return this->ttMove;
+
+            case CAPTURE_INIT:
+                generateMoves<CAPTURES>(this->board, this->captures);
+                scoreCaptures();
+                this->current = 0;
+                this->stage++;
+                break;
+
+            case GOOD_CAPTURE:
+                while(this->current < this->captures.size())
+                {
+                    Move m = pickBest(this->captures);
+                    if(m == this->ttMove)
+                    {
+                        continue;
+                    }
+
+                    // Park losing captures at the front of the list for the last stage
+                    if(isLosingCapture(m))
+                    {
+                        this->captures[this->badCaptureCount++].move = m;
+                        continue;
+                    }
+                    return m;
+                }
+                this->stage++;
+                break;
+
+            case KILLER_1:
+            case KILLER_2:
+            {
+                Move killer = this->killers[this->stage - KILLER_1];
+                this->stage++;
+                if(!skipQuiets && killer != this->ttMove && !killer.isNoisy()
+                   && this->board.isPseudoLegal(killer))
+                {
+                    return killer;
+                }
+                break;
+            }
+
+            case COUNTERMOVE:
+                this->stage++;
+                if(!skipQuiets && this->counterMove != this->ttMove
+                   && this->counterMove != this->killers[0] && this->counterMove != this->killers[1]
+                   && !this->counterMove.isNoisy() && this->board.isPseudoLegal(this->counterMove))
+                {
+                    return this->counterMove;
+                }
+                break;
+
+            case QUIET_INIT:
+                if(!skipQuiets)
+                {
+                    generateMoves<QUIETS>(this->board, this->quiets);
+                    scoreQuiets();
+                }
+                this->current = 0;
+                this->stage++;
+                break;
+
+            case QUIET:
+                while(!skipQuiets && this->current < this->quiets.size())
+                {
+                    Move m = pickBest(this->quiets);
+                    if(!isSpecialQuiet(m))
+                    {
+                        return m;
+                    }
+                }
+                this->current = 0;
+                this->stage++;
+                break;
+
+            case BAD_CAPTURE:
+                if(this->current < this->badCaptureCount)
+                {
+                    return this->captures[this->current++].move;
+                }
+                this->stage++;
+                break;
+
+            case QS_TT_MOVE:
+                this->stage++;
+                return this->ttMove;
+
+            case QS_CAPTURE_INIT:
+                generateMoves<CAPTURES>(this->board, this->captures);
+                scoreCaptures();
+                this->current = 0;
+                this->stage++;
+                break;
+
+            case QS_CAPTURE:
+                while(this->current < this->captures.size())
+                {
+                    Move m = pickBest(this->captures);
+                    if(m != this->ttMove)
+                    {
+                        return m;
+                    }
+                }
+                this->stage = this->generateChecks ? QS_CHECK_INIT : QS_DONE;
+                break;
+
+            case QS_CHECK_INIT:
+                generateMoves<QUIETS>(this->board, this->quiets);
+                this->current = 0;
+                this->stage++;
+                break;
+
+            case QS_CHECK:
+                while(this->current < this->quiets.size())
+                {
+                    Move m = this->quiets[this->current++].move;
+                    if(m != this->ttMove && this->board.givesCheck(m))
+                    {
+                        return m;
+                    }
+                }
+                this->stage++;
+                break;
+
+            default:
+                return Move();
+        }
+    }
+}
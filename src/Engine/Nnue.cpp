@@ -0,0 +1,340 @@
+#include "../include/Engine/Nnue.h"
+#include "../include/Engine/Board.h"
+#include "../include/Engine/NnueKernels.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    using namespace Chess;
+    using namespace Chess::Nnue;
+
+    // The dense layers' input: both perspectives of the accumulator side by side
+    constexpr int TRANSFORMED_DIMENSIONS = HALF_DIMENSIONS * 2;
+
+    // Divisor turning the network's output into centipawns
+    constexpr int OUTPUT_SCALE = 16;
+
+    // Most pieces that can be features at once: everything but the two kings
+    constexpr int MAX_ACTIVE_FEATURES = 30;
+
+    // Reserved accumulator stack size, enough for a search from any game position
+    constexpr size_t RESERVED_ACCUMULATORS = 1024;
+
+    /**
+     * All of the network's parameters. Rows are 64 byte aligned so the kernels can use
+     * aligned loads everywhere.
+     */
+    struct Network
+    {
+        alignas(64) int16_t transformerBiases[HALF_DIMENSIONS];
+        alignas(64) int16_t transformerWeights[INPUT_DIMENSIONS][HALF_DIMENSIONS];
+
+        alignas(64) int32_t hidden1Biases[HIDDEN1_DIMENSIONS];
+        alignas(64) int8_t hidden1Weights[HIDDEN1_DIMENSIONS][TRANSFORMED_DIMENSIONS];
+
+        alignas(64) int32_t hidden2Biases[HIDDEN2_DIMENSIONS];
+        alignas(64) int8_t hidden2Weights[HIDDEN2_DIMENSIONS][HIDDEN1_DIMENSIONS];
+
+        alignas(64) int32_t outputBias[1];
+        alignas(64) int8_t outputWeights[1][HIDDEN2_DIMENSIONS];
+    };
+
+    // The network in use, null until one is loaded or generated
+    std::unique_ptr<Network> CurrentNetwork;
+
+    // The kernels in use. The best one is chosen once, on first use or by setKernel(),
+    // whichever comes first; search threads only ever read them.
+    std::once_flag KernelChosen;
+    std::atomic<Kernel> ActiveKernel{Kernel::SCALAR};
+    std::atomic<const KernelSet*> ActiveKernels{&ScalarKernels};
+
+    const KernelSet& kernelSet(Kernel kernel)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        switch(kernel)
+        {
+            case Kernel::AVX2: return Avx2Kernels;
+            case Kernel::SSE41: return Sse41Kernels;
+            default: break;
+        }
+#endif
+        return ScalarKernels;
+    }
+
+    // Picks the best kernel the CPU supports, the first time it is called
+    void chooseKernel()
+    {
+        std::call_once(KernelChosen, []()
+        {
+            Kernel kernel = bestKernel();
+            ActiveKernel.store(kernel, std::memory_order_relaxed);
+            ActiveKernels.store(&kernelSet(kernel), std::memory_order_release);
+        });
+    }
+
+    const KernelSet& kernels()
+    {
+        chooseKernel();
+        return *ActiveKernels.load(std::memory_order_acquire);
+    }
+
+    // Squares as seen by a perspective. Black's view is the board rotated.
+    inline Square orient(Color perspective, Square s)
+    {
+        return perspective == WHITE ? s : s ^ 63;
+    }
+
+    // Index of a piece on a square among the features of a perspective with its king on kingSquare
+    inline int featureIndex(Color perspective, Square kingSquare, Piece p, Square s)
+    {
+        int kind = typeIndex(typeOf(p)) * 2 + (colorOf(p) == perspective ? 0 : 1);
+        return 1 + kind * SQUARE_NB + orient(perspective, s) + PIECE_SQUARE_NB * orient(perspective, kingSquare);
+    }
+
+    inline const int16_t* featureRow(Color perspective, Square kingSquare, Piece p, Square s)
+    {
+        return CurrentNetwork->transformerWeights[featureIndex(perspective, kingSquare, p, s)];
+    }
+
+    template <typename T>
+    bool readValues(std::istream& in, T* values, size_t count)
+    {
+        // Files are little endian, like every machine this runs on
+        return bool(in.read(reinterpret_cast<char*>(values), std::streamsize(sizeof(T) * count)));
+    }
+
+    // Deterministic SplitMix64 sequence for randomize()
+    struct Random
+    {
+        uint64_t state;
+
+        uint64_t next()
+        {
+            uint64_t z = (this->state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [low, high]
+        int range(int low, int high)
+        {
+            return low + int(next() % uint64_t(high - low + 1));
+        }
+    };
+};
+
+Chess::Nnue::AccumulatorStack::AccumulatorStack()
+{
+    this->entries.reserve(RESERVED_ACCUMULATORS);
+    this->entries.emplace_back();
+    this->top = 0;
+}
+
+bool Chess::Nnue::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        return false;
+    }
+
+    uint32_t version, hash, descriptionLength;
+    if(!readValues(file, &version, 1) || !readValues(file, &hash, 1) || !readValues(file, &descriptionLength, 1)
+       || version != FILE_VERSION)
+    {
+        return false;
+    }
+    file.ignore(descriptionLength);
+
+    // Read into a new network so a bad file leaves the current one alone. The hashes
+    // in front of each part are skipped, the version and the exact file size are
+    // enough to tell the architecture apart.
+    auto network = std::make_unique<Network>();
+
+    uint32_t partHash;
+    bool ok = readValues(file, &partHash, 1)
+           && readValues(file, network->transformerBiases, HALF_DIMENSIONS)
+           && readValues(file, &network->transformerWeights[0][0], size_t(INPUT_DIMENSIONS) * HALF_DIMENSIONS)
+           && readValues(file, &partHash, 1)
+           && readValues(file, network->hidden1Biases, HIDDEN1_DIMENSIONS)
+           && readValues(file, &network->hidden1Weights[0][0], HIDDEN1_DIMENSIONS * TRANSFORMED_DIMENSIONS)
+           && readValues(file, network->hidden2Biases, HIDDEN2_DIMENSIONS)
+           && readValues(file, &network->hidden2Weights[0][0], HIDDEN2_DIMENSIONS * HIDDEN1_DIMENSIONS)
+           && readValues(file, network->outputBias, 1)
+           && readValues(file, &network->outputWeights[0][0], HIDDEN2_DIMENSIONS);
+
+    // The whole file must have been used
+    if(!ok || file.peek() != std::ifstream::traits_type::eof())
+    {
+        return false;
+    }
+
+    CurrentNetwork = std::move(network);
+    return true;
+}
+
+void Chess::Nnue::randomize(uint64_t seed)
+{
+    auto network = std::make_unique<Network>();
+    Random random{ seed };
+
+    // Ranges are picked so the layers see values across their whole clipping range
+    for(int i = 0; i < HALF_DIMENSIONS; i++)
+    {
+        network->transformerBiases[i] = int16_t(random.range(0, 64));
+    }
+    for(int f = 0; f < INPUT_DIMENSIONS; f++)
+    {
+        for(int i = 0; i < HALF_DIMENSIONS; i++)
+        {
+            network->transformerWeights[f][i] = int16_t(random.range(-12, 12));
+        }
+    }
+    for(int i = 0; i < HIDDEN1_DIMENSIONS; i++)
+    {
+        network->hidden1Biases[i] = random.range(-2048, 2048);
+        for(int j = 0; j < TRANSFORMED_DIMENSIONS; j++)
+        {
+            network->hidden1Weights[i][j] = int8_t(random.range(-8, 8));
+        }
+    }
+    for(int i = 0; i < HIDDEN2_DIMENSIONS; i++)
+    {
+        network->hidden2Biases[i] = random.range(-2048, 2048);
+        for(int j = 0; j < HIDDEN1_DIMENSIONS; j++)
+        {
+            network->hidden2Weights[i][j] = int8_t(random.range(-32, 32));
+        }
+    }
+    network->outputBias[0] = 0;
+    for(int j = 0; j < HIDDEN2_DIMENSIONS; j++)
+    {
+        network->outputWeights[0][j] = int8_t(random.range(-64, 64));
+    }
+
+    CurrentNetwork = std::move(network);
+}
+
+bool Chess::Nnue::isLoaded()
+{
+    return CurrentNetwork != nullptr;
+}
+
+bool Chess::Nnue::isSupported(Kernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    switch(kernel)
+    {
+        case Kernel::AVX2: return __builtin_cpu_supports("avx2");
+        case Kernel::SSE41: return __builtin_cpu_supports("sse4.1");
+        default: return true;
+    }
+#else
+    return kernel == Kernel::SCALAR;
+#endif
+}
+
+Chess::Nnue::Kernel Chess::Nnue::bestKernel()
+{
+    for(Kernel kernel : { Kernel::AVX2, Kernel::SSE41 })
+    {
+        if(isSupported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return Kernel::SCALAR;
+}
+
+Chess::Nnue::Kernel Chess::Nnue::currentKernel()
+{
+    chooseKernel();
+    return ActiveKernel.load(std::memory_order_relaxed);
+}
+
+bool Chess::Nnue::setKernel(Kernel kernel)
+{
+    if(!isSupported(kernel))
+    {
+        return false;
+    }
+
+    // The default choice must not override this one later
+    chooseKernel();
+    ActiveKernel.store(kernel, std::memory_order_relaxed);
+    ActiveKernels.store(&kernelSet(kernel), std::memory_order_release);
+    return true;
+}
+
+const char* Chess::Nnue::kernelName(Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Kernel::AVX2: return "avx2";
+        case Kernel::SSE41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+void Chess::Nnue::refresh(const Board& board, Accumulator& accumulator, Color perspective)
+{
+    const int16_t* rows[MAX_ACTIVE_FEATURES];
+    int count = 0;
+
+    Square kingSquare = board.kingSquare(perspective);
+    Bitboard features = board.pieces() & ~board.pieces(Type::KING);
+    while(features && count < MAX_ACTIVE_FEATURES)
+    {
+        Square s = Bitboards::popLsb(features);
+        rows[count++] = featureRow(perspective, kingSquare, board.pieceOn(s), s);
+    }
+
+    kernels().updateAccumulator(CurrentNetwork->transformerBiases, accumulator.values[perspective],
+                                nullptr, 0, rows, count);
+}
+
+void Chess::Nnue::update(const Accumulator& parent, Accumulator& child, Color perspective, Square kingSquare,
+                         const DirtyPieces& dirty)
+{
+    const int16_t* removed[2];
+    const int16_t* added[2];
+    for(int i = 0; i < dirty.removedCount; i++)
+    {
+        removed[i] = featureRow(perspective, kingSquare, dirty.removedPieces[i], dirty.removedSquares[i]);
+    }
+    for(int i = 0; i < dirty.addedCount; i++)
+    {
+        added[i] = featureRow(perspective, kingSquare, dirty.addedPieces[i], dirty.addedSquares[i]);
+    }
+
+    kernels().updateAccumulator(parent.values[perspective], child.values[perspective],
+                                removed, dirty.removedCount, added, dirty.addedCount);
+}
+
+int Chess::Nnue::evaluate(const Accumulator& accumulator, Color sideToMove)
+{
+    const KernelSet& k = kernels();
+    const Network& net = *CurrentNetwork;
+
+    alignas(64) uint8_t transformed[TRANSFORMED_DIMENSIONS];
+    alignas(64) int32_t hidden1[HIDDEN1_DIMENSIONS];
+    alignas(64) uint8_t hidden1Clipped[HIDDEN1_DIMENSIONS];
+    alignas(64) int32_t hidden2[HIDDEN2_DIMENSIONS];
+    alignas(64) uint8_t hidden2Clipped[HIDDEN2_DIMENSIONS];
+    int32_t output;
+
+    k.transform(accumulator.values[sideToMove], accumulator.values[~sideToMove], transformed);
+    k.affine(transformed, TRANSFORMED_DIMENSIONS, &net.hidden1Weights[0][0], net.hidden1Biases, hidden1, HIDDEN1_DIMENSIONS);
+    k.clippedRelu(hidden1, hidden1Clipped, HIDDEN1_DIMENSIONS);
+    k.affine(hidden1Clipped, HIDDEN1_DIMENSIONS, &net.hidden2Weights[0][0], net.hidden2Biases, hidden2, HIDDEN2_DIMENSIONS);
+    k.clippedRelu(hidden2, hidden2Clipped, HIDDEN2_DIMENSIONS);
+    k.affine(hidden2Clipped, HIDDEN2_DIMENSIONS, &net.outputWeights[0][0], net.outputBias, &output, 1);
+
+    return output / OUTPUT_SCALE;
+}
@@ -0,0 +1,294 @@
+#include "../include/Engine/NnueKernels.h"
+#include "../include/Engine/Nnue.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Each instruction set lives in functions compiled for that target only, so the binary
+// runs anywhere and Nnue picks the fastest set the CPU supports at runtime.
+
+namespace
+{
+    using namespace Chess::Nnue;
+
+    // Right shift applied to the dense layers' outputs before clamping
+    constexpr int WEIGHT_SCALE_BITS = 6;
+
+    void scalarUpdateAccumulator(const int16_t* parent, int16_t* child,
+                                 const int16_t* const* removed, int removedCount,
+                                 const int16_t* const* added, int addedCount)
+    {
+        for(int i = 0; i < HALF_DIMENSIONS; i++)
+        {
+            int value = parent[i];
+            for(int r = 0; r < removedCount; r++)
+            {
+                value -= removed[r][i];
+            }
+            for(int a = 0; a < addedCount; a++)
+            {
+                value += added[a][i];
+            }
+            child[i] = int16_t(value);
+        }
+    }
+
+    void scalarTransform(const int16_t* us, const int16_t* them, uint8_t* output)
+    {
+        for(int i = 0; i < HALF_DIMENSIONS; i++)
+        {
+            output[i] = uint8_t(std::clamp<int>(us[i], 0, 127));
+            output[HALF_DIMENSIONS + i] = uint8_t(std::clamp<int>(them[i], 0, 127));
+        }
+    }
+
+    void scalarAffine(const uint8_t* input, int inputDim, const int8_t* weights,
+                      const int32_t* biases, int32_t* output, int outputDim)
+    {
+        for(int i = 0; i < outputDim; i++)
+        {
+            int32_t sum = biases[i];
+            const int8_t* row = weights + i * inputDim;
+            for(int j = 0; j < inputDim; j++)
+            {
+                sum += row[j] * input[j];
+            }
+            output[i] = sum;
+        }
+    }
+
+    void scalarClippedRelu(const int32_t* input, uint8_t* output, int dim)
+    {
+        for(int i = 0; i < dim; i++)
+        {
+            output[i] = uint8_t(std::clamp(input[i] >> WEIGHT_SCALE_BITS, 0, 127));
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    __attribute__((target("sse4.1")))
+    void sse41UpdateAccumulator(const int16_t* parent, int16_t* child,
+                                const int16_t* const* removed, int removedCount,
+                                const int16_t* const* added, int addedCount)
+    {
+        // 8 values per register, 32 registers cover the accumulator. Work through it in
+        // blocks small enough to stay in registers.
+        constexpr int BLOCK = 8;
+        for(int base = 0; base < HALF_DIMENSIONS / 8; base += BLOCK)
+        {
+            __m128i acc[BLOCK];
+            const __m128i* in = reinterpret_cast<const __m128i*>(parent) + base;
+            for(int k = 0; k < BLOCK; k++)
+            {
+                acc[k] = _mm_load_si128(in + k);
+            }
+            for(int r = 0; r < removedCount; r++)
+            {
+                const __m128i* row = reinterpret_cast<const __m128i*>(removed[r]) + base;
+                for(int k = 0; k < BLOCK; k++)
+                {
+                    acc[k] = _mm_sub_epi16(acc[k], _mm_load_si128(row + k));
+                }
+            }
+            for(int a = 0; a < addedCount; a++)
+            {
+                const __m128i* row = reinterpret_cast<const __m128i*>(added[a]) + base;
+                for(int k = 0; k < BLOCK; k++)
+                {
+                    acc[k] = _mm_add_epi16(acc[k], _mm_load_si128(row + k));
+                }
+            }
+            __m128i* out = reinterpret_cast<__m128i*>(child) + base;
+            for(int k = 0; k < BLOCK; k++)
+            {
+                _mm_store_si128(out + k, acc[k]);
+            }
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    void sse41Transform(const int16_t* us, const int16_t* them, uint8_t* output)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const int16_t* halves[2] = { us, them };
+        for(int h = 0; h < 2; h++)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(halves[h]);
+            __m128i* out = reinterpret_cast<__m128i*>(output + h * HALF_DIMENSIONS);
+            for(int i = 0; i < HALF_DIMENSIONS / 16; i++)
+            {
+                // Saturating pack to int8 clamps at 127, the max with zero clamps at 0
+                __m128i packed = _mm_packs_epi16(_mm_load_si128(in + 2 * i), _mm_load_si128(in + 2 * i + 1));
+                _mm_store_si128(out + i, _mm_max_epi8(packed, zero));
+            }
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    inline int32_t sse41HorizontalSum(__m128i v)
+    {
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+        return _mm_cvtsi128_si32(v);
+    }
+
+    __attribute__((target("sse4.1")))
+    void sse41Affine(const uint8_t* input, int inputDim, const int8_t* weights,
+                     const int32_t* biases, int32_t* output, int outputDim)
+    {
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i* in = reinterpret_cast<const __m128i*>(input);
+        int chunks = inputDim / 16;
+
+        for(int i = 0; i < outputDim; i++)
+        {
+            const __m128i* row = reinterpret_cast<const __m128i*>(weights + i * inputDim);
+            __m128i sum = _mm_setzero_si128();
+            for(int j = 0; j < chunks; j++)
+            {
+                // u8 x i8 products summed in pairs to i16, then in pairs again to i32
+                __m128i product = _mm_maddubs_epi16(_mm_load_si128(in + j), _mm_load_si128(row + j));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(product, ones));
+            }
+            output[i] = biases[i] + sse41HorizontalSum(sum);
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    void sse41ClippedRelu(const int32_t* input, uint8_t* output, int dim)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i* in = reinterpret_cast<const __m128i*>(input);
+        __m128i* out = reinterpret_cast<__m128i*>(output);
+        for(int i = 0; i < dim / 16; i++)
+        {
+            __m128i words0 = _mm_srai_epi16(_mm_packs_epi32(_mm_load_si128(in + 4 * i + 0), _mm_load_si128(in + 4 * i + 1)), WEIGHT_SCALE_BITS);
+            __m128i words1 = _mm_srai_epi16(_mm_packs_epi32(_mm_load_si128(in + 4 * i + 2), _mm_load_si128(in + 4 * i + 3)), WEIGHT_SCALE_BITS);
+            _mm_store_si128(out + i, _mm_max_epi8(_mm_packs_epi16(words0, words1), zero));
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void avx2UpdateAccumulator(const int16_t* parent, int16_t* child,
+                               const int16_t* const* removed, int removedCount,
+                               const int16_t* const* added, int addedCount)
+    {
+        // 16 values per register, 16 registers cover the accumulator
+        constexpr int BLOCK = 8;
+        for(int base = 0; base < HALF_DIMENSIONS / 16; base += BLOCK)
+        {
+            __m256i acc[BLOCK];
+            const __m256i* in = reinterpret_cast<const __m256i*>(parent) + base;
+            for(int k = 0; k < BLOCK; k++)
+            {
+                acc[k] = _mm256_load_si256(in + k);
+            }
+            for(int r = 0; r < removedCount; r++)
+            {
+                const __m256i* row = reinterpret_cast<const __m256i*>(removed[r]) + base;
+                for(int k = 0; k < BLOCK; k++)
+                {
+                    acc[k] = _mm256_sub_epi16(acc[k], _mm256_load_si256(row + k));
+                }
+            }
+            for(int a = 0; a < addedCount; a++)
+            {
+                const __m256i* row = reinterpret_cast<const __m256i*>(added[a]) + base;
+                for(int k = 0; k < BLOCK; k++)
+                {
+                    acc[k] = _mm256_add_epi16(acc[k], _mm256_load_si256(row + k));
+                }
+            }
+            __m256i* out = reinterpret_cast<__m256i*>(child) + base;
+            for(int k = 0; k < BLOCK; k++)
+            {
+                _mm256_store_si256(out + k, acc[k]);
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void avx2Transform(const int16_t* us, const int16_t* them, uint8_t* output)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const int16_t* halves[2] = { us, them };
+        for(int h = 0; h < 2; h++)
+        {
+            const __m256i* in = reinterpret_cast<const __m256i*>(halves[h]);
+            __m256i* out = reinterpret_cast<__m256i*>(output + h * HALF_DIMENSIONS);
+            for(int i = 0; i < HALF_DIMENSIONS / 32; i++)
+            {
+                // Packing works within 128 bit lanes, the permute puts the quarters back in order
+                __m256i packed = _mm256_packs_epi16(_mm256_load_si256(in + 2 * i), _mm256_load_si256(in + 2 * i + 1));
+                packed = _mm256_permute4x64_epi64(_mm256_max_epi8(packed, zero), 0xD8);
+                _mm256_store_si256(out + i, packed);
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void avx2Affine(const uint8_t* input, int inputDim, const int8_t* weights,
+                    const int32_t* biases, int32_t* output, int outputDim)
+    {
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i* in = reinterpret_cast<const __m256i*>(input);
+        int chunks = inputDim / 32;
+
+        for(int i = 0; i < outputDim; i++)
+        {
+            const __m256i* row = reinterpret_cast<const __m256i*>(weights + i * inputDim);
+            __m256i sum = _mm256_setzero_si256();
+            for(int j = 0; j < chunks; j++)
+            {
+                __m256i product = _mm256_maddubs_epi16(_mm256_load_si256(in + j), _mm256_load_si256(row + j));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+            }
+
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            output[i] = biases[i] + _mm_cvtsi128_si32(half);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void avx2ClippedRelu(const int32_t* input, uint8_t* output, int dim)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i order = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+        const __m256i* in = reinterpret_cast<const __m256i*>(input);
+        __m256i* out = reinterpret_cast<__m256i*>(output);
+        for(int i = 0; i < dim / 32; i++)
+        {
+            __m256i words0 = _mm256_srai_epi16(_mm256_packs_epi32(_mm256_load_si256(in + 4 * i + 0), _mm256_load_si256(in + 4 * i + 1)), WEIGHT_SCALE_BITS);
+            __m256i words1 = _mm256_srai_epi16(_mm256_packs_epi32(_mm256_load_si256(in + 4 * i + 2), _mm256_load_si256(in + 4 * i + 3)), WEIGHT_SCALE_BITS);
+            __m256i bytes = _mm256_max_epi8(_mm256_packs_epi16(words0, words1), zero);
+            _mm256_store_si256(out + i, _mm256_permutevar8x32_epi32(bytes, order));
+        }
+    }
+
+#endif
+};
+
+const Chess::Nnue::KernelSet Chess::Nnue::ScalarKernels =
+{
+    scalarUpdateAccumulator, scalarTransform, scalarAffine, scalarClippedRelu
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+const Chess::Nnue::KernelSet Chess::Nnue::Sse41Kernels =
+{
+    sse41UpdateAccumulator, sse41Transform, sse41Affine, sse41ClippedRelu
+};
+
+const Chess::Nnue::KernelSet Chess::Nnue::Avx2Kernels =
+{
+    avx2UpdateAccumulator, avx2Transform, avx2Affine, avx2ClippedRelu
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "../include/Engine/Pawns.h"
+
+#include <algorithm>
+
+using namespace Chess::Bitboards;
+
+namespace
+{
+    using namespace Chess;
+
+    // Bonus for a passed pawn by its row, from its own side's point of view
+    constexpr Score PassedBonus[8] =
+    {
+        { 0, 0 }, { 5, 10 }, { 10, 20 }, { 15, 35 }, { 30, 60 }, { 50, 100 }, { 80, 150 }, { 0, 0 }
+    };
+
+    // Penalties for weak pawns
+    constexpr Score IsolatedPenalty = { 5, 15 };
+    constexpr Score DoubledPenalty = { 10, 20 };
+    constexpr Score BackwardPenalty = { 8, 12 };
+
+    // Shelter bonus by how many rows in front of the king the closest own pawn on a file
+    // is. Files without such a pawn get the last entry.
+    constexpr int ShelterBonus[4] = { 0, 20, 10, -15 };
+
+    /**
+     * Masks describing the squares around a pawn
+     */
+    struct PawnMasks
+    {
+        // Squares on the same file in front of a pawn, by color
+        Bitboard forwardFile[COLOR_NB][SQUARE_NB];
+
+        // Squares an enemy pawn would have to be on to stop a pawn from being passed
+        Bitboard passedSpan[COLOR_NB][SQUARE_NB];
+
+        // Squares on the neighbouring files on the same row as a pawn or behind it
+        Bitboard supportSpan[COLOR_NB][SQUARE_NB];
+
+        // The files next to each file
+        Bitboard adjacentFiles[8];
+    };
+
+    constexpr PawnMasks buildPawnMasks()
+    {
+        PawnMasks masks{};
+        for(int col = 0; col < 8; col++)
+        {
+            masks.adjacentFiles[col] = (col > 0 ? FILE_A << (col - 1) : 0) | (col < 7 ? FILE_A << (col + 1) : 0);
+        }
+
+        for(Square s = 0; s < SQUARE_NB; s++)
+        {
+            Bitboard file = FILE_A << colOf(s);
+            Bitboard adjacent = masks.adjacentFiles[colOf(s)];
+            for(int row = 0; row < 8; row++)
+            {
+                Bitboard rank = RANK_1 << (8 * row);
+                if(row > rowOf(s))
+                {
+                    masks.forwardFile[WHITE][s] |= file & rank;
+                    masks.passedSpan[WHITE][s] |= (file | adjacent) & rank;
+                    masks.supportSpan[BLACK][s] |= adjacent & rank;
+                }
+                else if(row < rowOf(s))
+                {
+                    masks.forwardFile[BLACK][s] |= file & rank;
+                    masks.passedSpan[BLACK][s] |= (file | adjacent) & rank;
+                    masks.supportSpan[WHITE][s] |= adjacent & rank;
+                }
+                else
+                {
+                    masks.supportSpan[WHITE][s] |= adjacent & rank;
+                    masks.supportSpan[BLACK][s] |= adjacent & rank;
+                }
+            }
+        }
+        return masks;
+    }
+
+    constexpr PawnMasks Masks = buildPawnMasks();
+
+    // Structure score of one side's pawns, filling in its passed pawns
+    Score evaluateStructure(const Board& board, Color us, Bitboard& passed)
+    {
+        Color them = ~us;
+        Bitboard ourPawns = board.pieces(us, Type::PAWN);
+        Bitboard theirPawns = board.pieces(them, Type::PAWN);
+
+        Score score = { 0, 0 };
+        passed = 0;
+        Bitboard b = ourPawns;
+        while(b)
+        {
+            Square s = popLsb(b);
+            bool doubled = ourPawns & Masks.forwardFile[us][s];
+
+            if(!(ourPawns & Masks.adjacentFiles[colOf(s)]))
+            {
+                score -= IsolatedPenalty;
+            }
+            else if(!(ourPawns & Masks.supportSpan[us][s]))
+            {
+                // No pawn can ever defend it and advancing runs into an enemy pawn's capture
+                Square stop = us == WHITE ? s + 8 : s - 8;
+                if(PawnAttacks[us][stop] & theirPawns)
+                {
+                    score -= BackwardPenalty;
+                }
+            }
+
+            if(doubled)
+            {
+                score -= DoubledPenalty;
+            }
+            else if(!(theirPawns & Masks.passedSpan[us][s]))
+            {
+                passed |= squareBB(s);
+                score += PassedBonus[relativeRow(us, s)];
+            }
+        }
+        return score;
+    }
+
+    // Bonus for the pawns in front of a king
+    Score evaluateShelter(const Board& board, Color us, Square kingSquare)
+    {
+        Bitboard ourPawns = board.pieces(us, Type::PAWN);
+        int kingCol = std::clamp(colOf(kingSquare), 1, 6);
+
+        int bonus = 0;
+        for(int col = kingCol - 1; col <= kingCol + 1; col++)
+        {
+            Bitboard shield = ourPawns & (FILE_A << col) & Masks.passedSpan[us][kingSquare];
+            int distance = 3;
+            if(shield)
+            {
+                Square closest = us == WHITE ? lsb(shield) : msb(shield);
+                distance = std::min(relativeRow(us, closest) - relativeRow(us, kingSquare), 3);
+            }
+            bonus += ShelterBonus[distance];
+        }
+        return { bonus, 0 };
+    }
+};
+
+Chess::PawnTable::PawnTable()
+{
+    this->entries.resize(ENTRY_COUNT);
+    clear();
+}
+
+void Chess::PawnTable::clear()
+{
+    std::fill(this->entries.begin(), this->entries.end(), PawnEntry{});
+    resetStats();
+}
+
+void Chess::PawnTable::resetStats()
+{
+    this->probes = 0;
+    this->hits = 0;
+}
+
+const Chess::PawnEntry& Chess::PawnTable::probe(const Board& board)
+{
+    uint64_t key = board.pawnKey();
+    PawnEntry& entry = this->entries[key & (ENTRY_COUNT - 1)];
+    this->probes++;
+
+    if(entry.key == key)
+    {
+        this->hits++;
+    }
+    else
+    {
+        entry.key = key;
+        entry.score = evaluateStructure(board, WHITE, entry.passed[WHITE])
+                    - evaluateStructure(board, BLACK, entry.passed[BLACK]);
+        entry.kingSquares[WHITE] = entry.kingSquares[BLACK] = SQ_NONE;
+    }
+
+    for(Color c : { WHITE, BLACK })
+    {
+        Square kingSquare = board.kingSquare(c);
+        if(entry.kingSquares[c] != kingSquare)
+        {
+            entry.kingSquares[c] = kingSquare;
+            entry.shelter[c] = evaluateShelter(board, c, kingSquare);
+        }
+    }
+    return entry;
+}
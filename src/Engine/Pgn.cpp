@@ -0,0 +1,286 @@
+#include "../include/Engine/Pgn.h"
+#include "../include/Engine/MoveGen.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    // Plies reserved for the move array up front, longer games grow it once
+    constexpr size_t RESERVED_PLIES = 1024;
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool isResult(std::string_view token)
+    {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+    // Whether position pos of text is the first character of a line
+    bool atLineStart(std::string_view text, size_t pos)
+    {
+        return pos == 0 || text[pos - 1] == '\n';
+    }
+
+    // Moves pos past the character closing a block opened at pos, e.g. a comment in
+    // braces. Variations nest and may contain comments.
+    size_t skipBlock(std::string_view text, size_t pos)
+    {
+        if(text[pos] == '{')
+        {
+            size_t end = text.find('}', pos);
+            return end == std::string_view::npos ? text.size() : end + 1;
+        }
+
+        int depth = 0;
+        while(pos < text.size())
+        {
+            char c = text[pos];
+            if(c == '{')
+            {
+                pos = skipBlock(text, pos);
+                continue;
+            }
+            pos++;
+            if(c == '(')
+            {
+                depth++;
+            }
+            else if(c == ')' && --depth == 0)
+            {
+                break;
+            }
+        }
+        return pos;
+    }
+};
+
+std::string_view Chess::Pgn::Game::tag(std::string_view name) const
+{
+    size_t pos = 0;
+    while((pos = this->tags.find('[', pos)) != std::string_view::npos)
+    {
+        pos++;
+        if(this->tags.substr(pos, name.size()) != name || pos + name.size() >= this->tags.size()
+            || this->tags[pos + name.size()] != ' ')
+        {
+            continue;
+        }
+
+        size_t open = this->tags.find('"', pos + name.size());
+        size_t close = open == std::string_view::npos ? open : this->tags.find('"', open + 1);
+        if(close == std::string_view::npos)
+        {
+            return {};
+        }
+        return this->tags.substr(open + 1, close - open - 1);
+    }
+    return {};
+}
+
+Chess::Pgn::Stats& Chess::Pgn::Stats::operator+=(const Stats& other)
+{
+    this->games += other.games;
+    this->plies += other.plies;
+    this->errors += other.errors;
+    this->bytes += other.bytes;
+    return *this;
+}
+
+Chess::Pgn::Reader::Reader()
+{
+    this->moves.reserve(RESERVED_PLIES);
+}
+
+Chess::Pgn::Stats Chess::Pgn::Reader::read(std::string_view text, const GameCallback& onGame)
+{
+    Stats stats;
+    stats.bytes = text.size();
+
+    size_t pos = 0;
+    size_t size = text.size();
+    while(true)
+    {
+        while(pos < size && isSpace(text[pos]))
+        {
+            pos++;
+        }
+        if(pos >= size)
+        {
+            break;
+        }
+
+        // Tag pairs, one per line
+        Game game;
+        size_t tagsStart = pos;
+        size_t tagsEnd = pos;
+        while(pos < size && text[pos] == '[')
+        {
+            size_t lineEnd = text.find('\n', pos);
+            pos = lineEnd == std::string_view::npos ? size : lineEnd + 1;
+            tagsEnd = pos;
+            while(pos < size && isSpace(text[pos]))
+            {
+                pos++;
+            }
+        }
+        game.tags = text.substr(tagsStart, tagsEnd - tagsStart);
+
+        std::string_view fen = game.tag("FEN");
+        if(fen.empty() || !Fen::parse(fen, game.start))
+        {
+            Fen::parse(START_FEN, game.start);
+        }
+        this->board.setPosition(game.start);
+        this->moves.clear();
+        game.complete = true;
+
+        // Move text, up to the result or the next game's tags
+        while(pos < size)
+        {
+            char c = text[pos];
+            if(isSpace(c))
+            {
+                pos++;
+                continue;
+            }
+            if(c == '[' && atLineStart(text, pos))
+            {
+                break;
+            }
+            if(c == '{' || c == '(')
+            {
+                pos = skipBlock(text, pos);
+                continue;
+            }
+            if(c == ';' || c == '%')
+            {
+                size_t lineEnd = text.find('\n', pos);
+                pos = lineEnd == std::string_view::npos ? size : lineEnd;
+                continue;
+            }
+
+            size_t tokenStart = pos;
+            while(pos < size && !isSpace(text[pos]) && text[pos] != '{' && text[pos] != '(' && text[pos] != ')'
+                  && text[pos] != ';')
+            {
+                pos++;
+            }
+            if(pos == tokenStart)
+            {
+                // A stray closing parenthesis
+                pos++;
+                continue;
+            }
+            std::string_view token = text.substr(tokenStart, pos - tokenStart);
+
+            if(isResult(token))
+            {
+                game.result = token;
+                break;
+            }
+            if(token[0] == '$')
+            {
+                continue;
+            }
+
+            // Move numbers, possibly glued to the move as in "12.e4" or "12...Nf6"
+            if(token[0] >= '1' && token[0] <= '9')
+            {
+                size_t digits = token.find_first_not_of("0123456789");
+                if(digits != std::string_view::npos && token[digits] == '.')
+                {
+                    token.remove_prefix(std::min(token.find_first_not_of('.', digits), token.size()));
+                }
+            }
+            if(token.empty() || !game.complete)
+            {
+                continue;
+            }
+
+            Move m = findSanMove(this->board, token);
+            if(!m.isValid())
+            {
+                game.complete = false;
+                continue;
+            }
+            this->board.makeMove(m);
+            this->moves.push_back(m);
+        }
+
+        game.moves = this->moves.data();
+        game.plies = int(this->moves.size());
+        stats.games++;
+        stats.plies += uint64_t(game.plies);
+        stats.errors += game.complete ? 0 : 1;
+        onGame(game);
+    }
+    return stats;
+}
+
+size_t Chess::Pgn::nextGameStart(std::string_view text, size_t from)
+{
+    size_t pos = from;
+    while((pos = text.find('[', pos)) != std::string_view::npos)
+    {
+        // The previous line has to be blank, otherwise this is a later tag of a game
+        // that started earlier
+        if(pos == 0)
+        {
+            return pos;
+        }
+        if(text[pos - 1] == '\n')
+        {
+            size_t end = pos - 1;
+            if(end > 0 && text[end - 1] == '\r')
+            {
+                end--;
+            }
+            if(end == 0 || text[end - 1] == '\n')
+            {
+                return pos;
+            }
+        }
+        pos++;
+    }
+    return text.size();
+}
+
+Chess::Pgn::Stats Chess::Pgn::readParallel(std::string_view text, int threads, const ParallelGameCallback& onGame)
+{
+    threads = std::max(threads, 1);
+
+    // Piece boundaries, each moved forward to the next game start
+    std::vector<size_t> bounds = { 0 };
+    for(int i = 1; i < threads; i++)
+    {
+        size_t target = text.size() / size_t(threads) * size_t(i);
+        bounds.push_back(std::max(nextGameStart(text, target), bounds.back()));
+    }
+    bounds.push_back(text.size());
+
+    std::vector<Stats> results(threads);
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&, i]()
+        {
+            Reader reader;
+            std::string_view piece = text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+            results[i] = reader.read(piece, [&](const Game& game) { onGame(game, i); });
+        });
+    }
+
+    Stats total;
+    for(int i = 0; i < threads; i++)
+    {
+        workers[i].join();
+        total += results[i];
+    }
+    return total;
+}
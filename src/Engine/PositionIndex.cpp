@@ -0,0 +1,276 @@
+#include "../include/Engine/PositionIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    typedef PositionIndex::Entry Entry;
+
+    // Entries buffered by the builder before they are written
+    constexpr size_t WRITE_CHUNK_ENTRIES = 1 << 16;
+
+    // The order of the entries in the file
+    bool entryLess(const Entry& a, const Entry& b)
+    {
+        if(a.key != b.key) return a.key < b.key;
+        if(a.game != b.game) return a.game < b.game;
+        return a.ply < b.ply;
+    }
+
+    // Key of the standard start position with the Zobrist keys in use
+    uint64_t startPositionKey()
+    {
+        Board board;
+        board.setStartPosition();
+        return board.key();
+    }
+
+    // Lays out the sorted block keys in Eytzinger order: an in-order walk of the implicit
+    // tree where node k has children 2k and 2k + 1 visits the keys in sorted order.
+    // Returns the next key to place.
+    size_t fillTree(const std::vector<uint64_t>& keys, std::vector<uint64_t>& tree, std::vector<uint32_t>& blocks,
+                    size_t next, size_t node)
+    {
+        if(node < tree.size())
+        {
+            next = fillTree(keys, tree, blocks, next, 2 * node);
+            tree[node] = keys[next];
+            blocks[node] = uint32_t(next);
+            next = fillTree(keys, tree, blocks, next + 1, 2 * node + 1);
+        }
+        return next;
+    }
+};
+
+bool Chess::PositionIndex::open(const std::string& path)
+{
+    this->header = nullptr;
+    if(!this->file.open(path, MappedFile::Access::RANDOM) || this->file.size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header* candidate = reinterpret_cast<const Header*>(this->file.data());
+    uint64_t size = this->file.size();
+    if(std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION
+        || candidate->blockSize != BLOCK_SIZE || candidate->startKey != startPositionKey()
+        || sizeof(Header) + candidate->entryCount * sizeof(Entry) > candidate->treeOffset
+        || candidate->treeOffset + (candidate->blockCount + 1) * (sizeof(uint64_t) + sizeof(uint32_t)) > size)
+    {
+        return false;
+    }
+
+    this->header = candidate;
+    this->first = reinterpret_cast<const Entry*>(this->file.data() + sizeof(Header));
+    this->treeKeys = reinterpret_cast<const uint64_t*>(this->file.data() + candidate->treeOffset);
+    this->treeBlocks = reinterpret_cast<const uint32_t*>(this->treeKeys + candidate->blockCount + 1);
+    return true;
+}
+
+const Chess::PositionIndex::Entry* Chess::PositionIndex::lowerBound(uint64_t key, Search search) const
+{
+    const Entry* end = this->first + size();
+    auto keyLess = [](const Entry& entry, uint64_t k) { return entry.key < k; };
+    if(search == Search::BINARY)
+    {
+        return std::lower_bound(this->first, end, key, keyLess);
+    }
+
+    // Walk down the tree to the first block whose first key is not below key, fetching
+    // the cache line of the great-grandchildren ahead of time. Going right sets a bit, so
+    // the last left turn is found by stripping the trailing ones.
+    uint64_t blocks = this->header->blockCount;
+    uint64_t node = 1;
+    while(node <= blocks)
+    {
+        __builtin_prefetch(this->treeKeys + 8 * node);
+        node = 2 * node + (this->treeKeys[node] < key);
+    }
+    node >>= std::countr_one(node) + 1;
+    uint64_t block = node ? this->treeBlocks[node] : blocks;
+
+    // That block's first key is not below key and the previous block's is, so the
+    // answer is in the previous block or is the first entry of this one
+    const Entry* low = this->first + (block > 0 ? (block - 1) * BLOCK_SIZE : 0);
+    const Entry* high = std::min(this->first + block * BLOCK_SIZE, end);
+    return std::lower_bound(low, high, key, keyLess);
+}
+
+std::span<const Chess::PositionIndex::Entry> Chess::PositionIndex::find(uint64_t key, Search search) const
+{
+    if(!this->header)
+    {
+        return {};
+    }
+
+    // Most positions have a handful of entries, so the end is found by galloping from the
+    // start rather than by a second search from the top
+    const Entry* low = lowerBound(key, search);
+    const Entry* end = this->first + size();
+    size_t step = 1;
+    const Entry* known = low;
+    while(known + step < end && known[step].key == key)
+    {
+        known += step;
+        step *= 2;
+    }
+    const Entry* high = std::upper_bound(known, std::min(known + step, end), key,
+                                         [](uint64_t k, const Entry& entry) { return k < entry.key; });
+    return std::span<const Entry>(low, high);
+}
+
+std::vector<Chess::PositionIndex::MoveStats> Chess::PositionIndex::explore(uint64_t key, Archive::Reader& archive) const
+{
+    std::vector<MoveStats> moves;
+    std::vector<uint16_t> movesOfGame;
+    uint32_t lastGame = UINT32_MAX;
+    Archive::Game game;
+    for(const Entry& entry : find(key))
+    {
+        // Entries of one game are next to each other
+        if(entry.game != lastGame)
+        {
+            movesOfGame.clear();
+            lastGame = entry.game;
+        }
+        if(std::find(movesOfGame.begin(), movesOfGame.end(), entry.move) != movesOfGame.end())
+        {
+            continue;
+        }
+        movesOfGame.push_back(entry.move);
+
+        Move move = Move::fromRaw(entry.move);
+        auto stats = std::find_if(moves.begin(), moves.end(), [&](const MoveStats& s) { return s.move == move; });
+        if(stats == moves.end())
+        {
+            moves.push_back({ move });
+            stats = moves.end() - 1;
+        }
+        stats->games++;
+
+        if(entry.game < archive.size() && archive.game(entry.game, game, false))
+        {
+            stats->whiteWins += game.result == Archive::Result::WHITE_WINS;
+            stats->draws += game.result == Archive::Result::DRAW;
+            stats->blackWins += game.result == Archive::Result::BLACK_WINS;
+        }
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const MoveStats& a, const MoveStats& b) { return a.games > b.games; });
+    return moves;
+}
+
+bool Chess::PositionIndex::build(const std::string& archivePath, const std::string& indexPath, int threads,
+                                 BuildStats& stats)
+{
+    threads = std::max(threads, 1);
+
+    // Every thread collects the entries of its share of the games, then sorts them
+    std::vector<std::vector<Entry>> runs(threads);
+    std::vector<uint64_t> games(threads);
+    uint64_t errors = Archive::readParallel(archivePath, threads, [&](const Archive::Game& game, int thread)
+    {
+        int plies = std::min(game.plies, int(UINT16_MAX));
+        for(int ply = 0; ply <= plies; ply++)
+        {
+            uint16_t move = ply < game.plies ? game.moves[ply].raw() : 0;
+            runs[thread].push_back({ game.keys[ply], uint32_t(game.index), uint16_t(ply), move });
+        }
+        games[thread]++;
+    });
+    if(errors == UINT64_MAX)
+    {
+        return false;
+    }
+
+    std::vector<std::thread> sorters;
+    for(int i = 0; i < threads; i++)
+    {
+        sorters.emplace_back([&, i]() { std::sort(runs[i].begin(), runs[i].end(), entryLess); });
+    }
+    for(std::thread& sorter : sorters)
+    {
+        sorter.join();
+    }
+
+    Archive::Reader archive;
+    archive.open(archivePath);
+
+    std::ofstream file(indexPath, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        return false;
+    }
+    Header header{};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Merge the sorted runs into the file, noting the first key of every block
+    auto later = [&](const std::pair<Entry, int>& a, const std::pair<Entry, int>& b) { return entryLess(b.first, a.first); };
+    std::priority_queue<std::pair<Entry, int>, std::vector<std::pair<Entry, int>>, decltype(later)> heads(later);
+    std::vector<size_t> positions(threads, 0);
+    for(int i = 0; i < threads; i++)
+    {
+        if(!runs[i].empty())
+        {
+            heads.push({ runs[i][0], i });
+        }
+    }
+
+    std::vector<Entry> chunk;
+    chunk.reserve(WRITE_CHUNK_ENTRIES);
+    std::vector<uint64_t> blockKeys;
+    uint64_t entries = 0;
+    while(!heads.empty())
+    {
+        auto [entry, run] = heads.top();
+        heads.pop();
+        if(++positions[run] < runs[run].size())
+        {
+            heads.push({ runs[run][positions[run]], run });
+        }
+
+        if(entries++ % BLOCK_SIZE == 0)
+        {
+            blockKeys.push_back(entry.key);
+        }
+        chunk.push_back(entry);
+        if(chunk.size() == WRITE_CHUNK_ENTRIES || heads.empty())
+        {
+            file.write(reinterpret_cast<const char*>(chunk.data()), std::streamsize(chunk.size() * sizeof(Entry)));
+            chunk.clear();
+        }
+    }
+
+    // The search tree, keys first and then the block each node stands for
+    std::vector<uint64_t> treeKeys(blockKeys.size() + 1, 0);
+    std::vector<uint32_t> treeBlocks(blockKeys.size() + 1, 0);
+    fillTree(blockKeys, treeKeys, treeBlocks, 0, 1);
+    file.write(reinterpret_cast<const char*>(treeKeys.data()), std::streamsize(treeKeys.size() * sizeof(uint64_t)));
+    file.write(reinterpret_cast<const char*>(treeBlocks.data()), std::streamsize(treeBlocks.size() * sizeof(uint32_t)));
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.blockSize = BLOCK_SIZE;
+    header.entryCount = entries;
+    header.gameCount = archive.size();
+    header.startKey = startPositionKey();
+    header.treeOffset = sizeof(Header) + entries * sizeof(Entry);
+    header.blockCount = blockKeys.size();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for(uint64_t g : games)
+    {
+        stats.games += g;
+    }
+    stats.entries = entries;
+    stats.errors = errors;
+    return bool(file);
+}
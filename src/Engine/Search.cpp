@@ -0,0 +1,632 @@
+#include "../include/Engine/Search.h"
+#include "../include/Engine/Evaluation.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/MovePicker.h"
+#include "../include/Engine/Trace.h"
+
+#include <algorithm>
+
+Chess::Searcher::Searcher(TranspositionTable& tt, int threadIndex) : tt(tt), threadIndex(threadIndex)
+{
+    this->stopRequested = false;
+    this->pondering = false;
+    this->searchStartTime = 0;
+    this->nextCheck = 0;
+    this->rootBestMoveNodes = 0;
+    this->publishedNodes = 0;
+    this->publishedTbHits = 0;
+    this->aborted = false;
+    this->rootInTB = false;
+    this->rootTbScore = VALUE_DRAW;
+    this->tbProbing = false;
+    this->history = std::make_unique<HistoryTables>();
+    this->pawnTable = std::make_unique<PawnTable>();
+    this->accumulators = std::make_unique<Nnue::AccumulatorStack>();
+}
+
+void Chess::Searcher::stop()
+{
+    this->stopRequested.store(true, std::memory_order_relaxed);
+}
+
+void Chess::Searcher::newSearch(bool ponder)
+{
+    this->stopRequested.store(false, std::memory_order_relaxed);
+    this->pondering.store(ponder, std::memory_order_relaxed);
+    this->publishedNodes.store(0, std::memory_order_relaxed);
+    this->publishedTbHits.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(this->publishedMutex);
+    this->publishedStats = SearchStats();
+}
+
+void Chess::Searcher::ponderhit()
+{
+    this->timeManager.restart();
+    this->pondering.store(false, std::memory_order_release);
+}
+
+void Chess::Searcher::setIterationCallback(IterationCallback callback)
+{
+    this->onIteration = std::move(callback);
+}
+
+uint64_t Chess::Searcher::getNodes() const
+{
+    return this->publishedNodes.load(std::memory_order_relaxed);
+}
+
+uint64_t Chess::Searcher::getTbHits() const
+{
+    return this->publishedTbHits.load(std::memory_order_relaxed);
+}
+
+const Chess::SearchStats& Chess::Searcher::getStats() const
+{
+    return this->stats;
+}
+
+Chess::SearchStats Chess::Searcher::getPublishedStats() const
+{
+    std::lock_guard<std::mutex> lock(this->publishedMutex);
+    return this->publishedStats;
+}
+
+void Chess::Searcher::publishStats()
+{
+    this->publishedNodes.store(this->stats.nodes, std::memory_order_relaxed);
+    this->publishedTbHits.store(this->stats.tbHits, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(this->publishedMutex);
+    this->publishedStats = this->stats;
+}
+
+void Chess::SearchStats::add(const SearchStats& other)
+{
+    this->nodes += other.nodes;
+    this->qsearchNodes += other.qsearchNodes;
+    this->deltaPrunes += other.deltaPrunes;
+    this->seePrunes += other.seePrunes;
+    this->pawnProbes += other.pawnProbes;
+    this->pawnHits += other.pawnHits;
+    this->tbProbes += other.tbProbes;
+    this->tbHits += other.tbHits;
+    this->ttProbes += other.ttProbes;
+    this->ttHits += other.ttHits;
+    this->ttCutoffs += other.ttCutoffs;
+    this->nullWindowSearches += other.nullWindowSearches;
+    this->nullWindowResearches += other.nullWindowResearches;
+}
+
+void Chess::Searcher::clearHistory()
+{
+    this->history->clear();
+    this->pawnTable->clear();
+}
+
+int Chess::Searcher::evaluate(const Board& board)
+{
+    CHESS_TRACE_SCOPE("evaluate");
+    int score = Chess::evaluate(board, *this->pawnTable);
+    this->stats.pawnProbes = this->pawnTable->getProbes();
+    this->stats.pawnHits = this->pawnTable->getHits();
+    return score;
+}
+
+bool Chess::Searcher::shouldStop()
+{
+    if(this->limits.nodes && this->stats.nodes >= this->limits.nodes)
+    {
+        return true;
+    }
+
+    // Checked at every node so a stop request is acted on right away
+    if(this->stopRequested.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    if(this->stats.nodes < this->nextCheck)
+    {
+        return false;
+    }
+    publishStats();
+
+    // Read the clock again after about TimeManager::CHECK_PERIOD_MS at the current speed
+    int64_t time = TimeManager::now();
+    this->nextCheck = this->stats.nodes + TimeManager::checkInterval(this->stats.nodes, time - this->searchStartTime);
+
+    // Only the main thread watches the clock, it stops the others when time is up
+    return this->threadIndex == 0
+        && !this->pondering.load(std::memory_order_acquire)
+        && this->timeManager.hardLimitReached(time);
+}
+
+void Chess::Searcher::probeRoot(Board& board)
+{
+    this->rootInTB = false;
+    this->rootMoves.clear();
+    int cardinality = Syzygy::cardinality();
+    this->tbProbing = cardinality > 0;
+    if(Bitboards::popCount(board.pieces()) > cardinality || board.castlingRights() != NO_CASTLING)
+    {
+        return;
+    }
+
+    std::vector<Syzygy::RootMove> ranked;
+    bool byDtz = Syzygy::rootProbe(board, ranked);
+    if(!byDtz && !Syzygy::rootProbeWdl(board, ranked))
+    {
+        return;
+    }
+    this->stats.tbHits += ranked.size();
+
+    for(const Syzygy::RootMove& rm : ranked)
+    {
+        if(rm.rank == ranked[0].rank)
+        {
+            this->rootMoves.add(rm.move);
+        }
+    }
+    this->rootInTB = true;
+    this->rootTbScore = ranked[0].score;
+
+    // Probing below the root only helps to find a win the WDL ranking already promises
+    this->tbProbing = !byDtz && this->rootTbScore > VALUE_DRAW;
+}
+
+void Chess::Searcher::updatePv(int ply, Move m)
+{
+    this->pvTable[ply][0] = m;
+    int childLength = this->pvLength[ply + 1];
+    for(int i = 0; i < childLength; i++)
+    {
+        this->pvTable[ply][i + 1] = this->pvTable[ply + 1][i];
+    }
+    this->pvLength[ply] = childLength + 1;
+}
+
+Chess::SearchResult Chess::Searcher::think(Board& board, const SearchLimits& limits)
+{
+    CHESS_TRACE_SCOPE("think");
+    this->limits = limits;
+    this->stats = SearchStats();
+    this->aborted = false;
+    this->previousBestMove = Move();
+    publishStats();
+    this->searchStartTime = TimeManager::now();
+    this->nextCheck = TimeManager::MIN_CHECK_INTERVAL;
+    this->history->age();
+    this->pawnTable->resetStats();
+    std::fill(this->stack, this->stack + MAX_PLY + 2, SearchStackEntry{ Move(), NO_PIECE, nullptr });
+
+    SearchResult result;
+
+    // Always have a move to play, even if the first iteration gets cut short
+    MoveList legal;
+    generateLegalMoves(board, legal);
+    if(legal.size() == 0)
+    {
+        result.score = board.inCheck() ? -VALUE_MATE : VALUE_DRAW;
+        return result;
+    }
+    probeRoot(board);
+    result.bestMove = this->rootInTB ? this->rootMoves[0].move : legal[0].move;
+    this->timeManager.init(limits, this->rootInTB ? this->rootMoves.size() : legal.size());
+
+    if(Nnue::isLoaded())
+    {
+        board.attachAccumulators(this->accumulators.get());
+    }
+
+    // Helper threads start one iteration deeper every other thread, so they do not
+    // all search the same tree at the same time
+    int maxDepth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+    for(int depth = 1 + this->threadIndex % 2; depth <= maxDepth; depth++)
+    {
+        CHESS_TRACE_SCOPE("iteration");
+        uint64_t iterationStart = this->stats.nodes;
+        this->rootBestMoveNodes = 0;
+        int score = search(board, -VALUE_INFINITE, VALUE_INFINITE, depth, 0);
+
+        // An aborted iteration is only trusted if it already found a move to play
+        if(this->aborted && (depth > 1 || this->pvLength[0] == 0))
+        {
+            break;
+        }
+
+        // Below mate scores the tablebases know better than the search
+        result.score = this->rootInTB && std::abs(score) < VALUE_MATE_IN_MAX_PLY ? this->rootTbScore : score;
+        result.depth = depth;
+        result.pvLength = this->pvLength[0];
+        std::copy(this->pvTable[0], this->pvTable[0] + result.pvLength, result.pv);
+        result.bestMove = result.pv[0];
+        this->previousBestMove = result.bestMove;
+
+        if(this->aborted)
+        {
+            break;
+        }
+
+        this->stats.iterationNodes[depth] = this->stats.nodes - iterationStart;
+        publishStats();
+        result.stats = this->stats;
+        if(this->onIteration)
+        {
+            this->onIteration(result);
+        }
+
+        // Deeper iterations can not find anything better than a mate, unless the search
+        // has to go on anyway
+        if(std::abs(score) >= VALUE_MATE_IN_MAX_PLY && !limits.infinite && !limits.ponder)
+        {
+            break;
+        }
+
+        // The main thread decides whether another iteration is worth its time. It keeps
+        // track of the best move while pondering but only acts once the clock runs.
+        uint64_t iterationNodes = this->stats.nodes - iterationStart;
+        double bestMoveShare = iterationNodes ? double(this->rootBestMoveNodes) / double(iterationNodes) : 1.0;
+        bool timeUp = this->timeManager.stopAfterIteration(result.bestMove, score, bestMoveShare);
+        if(this->threadIndex == 0 && timeUp && !this->pondering.load(std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    board.attachAccumulators(nullptr);
+    publishStats();
+    result.stats = this->stats;
+    return result;
+}
+
+int Chess::Searcher::search(Board& board, int alpha, int beta, int depth, int ply)
+{
+    this->pvLength[ply] = 0;
+
+    bool pvNode = beta - alpha > 1;
+    bool inCheck = board.inCheck();
+
+    // Look one ply deeper when in check so forced sequences are not cut at the horizon
+    if(inCheck)
+    {
+        depth++;
+    }
+
+    if(depth <= 0)
+    {
+        return qsearch(board, alpha, beta, ply, 0);
+    }
+
+    this->stats.nodes++;
+    if(this->aborted || shouldStop())
+    {
+        this->aborted = true;
+        return 0;
+    }
+
+    if(ply > 0)
+    {
+        if(board.isDraw(ply))
+        {
+            return VALUE_DRAW;
+        }
+        if(ply >= MAX_PLY - 1)
+        {
+            return inCheck ? VALUE_DRAW : evaluate(board);
+        }
+
+        // Mate distance pruning. Even mating right now can not beat a shorter mate
+        // already found elsewhere in the tree.
+        alpha = std::max(alpha, -VALUE_MATE + ply);
+        beta = std::min(beta, VALUE_MATE - ply - 1);
+        if(alpha >= beta)
+        {
+            return alpha;
+        }
+    }
+
+    // A stored result that is deep enough and whose bound settles this window can be
+    // returned directly. PV nodes always search so the principal variation stays whole.
+    TTEntry ttEntry;
+    bool ttHit = this->tt.probe(board.key(), ttEntry);
+    this->stats.ttProbes++;
+    this->stats.ttHits += ttHit;
+    if(ttHit && !pvNode && ttEntry.depth >= depth)
+    {
+        int ttScore = scoreFromTT(ttEntry.score, ply);
+        if(ttEntry.bound & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))
+        {
+            this->stats.ttCutoffs++;
+            return ttScore;
+        }
+    }
+
+    // Endgame tablebases, exact right after a capture or pawn move. The score is returned
+    // if it settles the window; in PV nodes it bounds the search's score instead.
+    int tbBestScore = -VALUE_INFINITE;
+    int maxScore = VALUE_INFINITE;
+    if(ply > 0 && this->tbProbing && board.halfmoveClock() == 0 && board.castlingRights() == NO_CASTLING
+       && Bitboards::popCount(board.pieces()) <= Syzygy::cardinality())
+    {
+        this->stats.tbProbes++;
+        Syzygy::ProbeState state;
+        Syzygy::WdlScore wdl = Syzygy::probeWdl(board, state);
+        if(state != Syzygy::ProbeState::FAIL)
+        {
+            this->stats.tbHits++;
+
+            // Cursed wins and blessed losses are drawn by the fifty move rule, they score
+            // just off a draw
+            int score = wdl < Syzygy::WDL_BLESSED_LOSS ? -VALUE_TB_WIN + ply
+                      : wdl > Syzygy::WDL_CURSED_WIN ? VALUE_TB_WIN - ply
+                      : VALUE_DRAW + 2 * wdl;
+            Bound bound = wdl < Syzygy::WDL_BLESSED_LOSS ? BOUND_UPPER : wdl > Syzygy::WDL_CURSED_WIN ? BOUND_LOWER : BOUND_EXACT;
+            if(bound == BOUND_EXACT || (bound == BOUND_LOWER ? score >= beta : score <= alpha))
+            {
+                this->tt.store(board.key(), Move(), scoreToTT(score, ply), VALUE_NONE, std::min(MAX_PLY - 1, depth + 6), bound);
+                return score;
+            }
+            if(pvNode && bound == BOUND_LOWER)
+            {
+                tbBestScore = score;
+                alpha = std::max(alpha, score);
+            }
+            else if(pvNode)
+            {
+                maxScore = score;
+            }
+        }
+    }
+
+    SearchStackEntry* ss = &this->stack[ply + 2];
+    PieceToHistory* continuations[2] = { (ss - 1)->continuation, (ss - 2)->continuation };
+    Move counterMove = (ss - 1)->currentMove.isValid()
+                     ? this->history->getCounterMove((ss - 1)->movedPiece, (ss - 1)->currentMove.to())
+                     : Move();
+
+    Move ttMove = ttHit ? ttEntry.move : Move();
+    if(ply == 0 && this->previousBestMove.isValid())
+    {
+        ttMove = this->previousBestMove;
+    }
+    MovePicker picker(board, ttMove, this->history->getKillers(ply), counterMove,
+                      &this->history->getButterfly(), continuations);
+
+    // Quiet moves that did not cause a cutoff, penalised if a later quiet move does
+    Move quietsTried[64];
+    Piece quietPiecesTried[64];
+    int quietCount = 0;
+
+    int bestScore = tbBestScore;
+    Move bestMove;
+    int legalMoves = 0;
+    Move m;
+    while((m = picker.nextMove()).isValid())
+    {
+        if(!board.isLegal(m))
+        {
+            continue;
+        }
+
+        // Root moves the tablebases rank below the best are not searched
+        if(ply == 0 && this->rootInTB
+           && std::none_of(this->rootMoves.begin(), this->rootMoves.end(), [&](const ScoredMove& sm) { return sm.move == m; }))
+        {
+            continue;
+        }
+        legalMoves++;
+
+        Piece movedPiece = board.movedPiece(m);
+        ss->currentMove = m;
+        ss->movedPiece = movedPiece;
+        ss->continuation = this->history->getContinuation(movedPiece, m.to());
+
+        uint64_t nodesBefore = this->stats.nodes;
+        board.makeMove(m);
+        int score;
+        if(legalMoves == 1)
+        {
+            score = -search(board, -beta, -alpha, depth - 1, ply + 1);
+        }
+        else
+        {
+            // Later moves are only expected to fail low, so prove it with a null
+            // window and re-search if they do not
+            score = -search(board, -alpha - 1, -alpha, depth - 1, ply + 1);
+            this->stats.nullWindowSearches++;
+            if(score > alpha && score < beta)
+            {
+                this->stats.nullWindowResearches++;
+                score = -search(board, -beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+        board.unmakeMove(m);
+
+        if(this->aborted)
+        {
+            return 0;
+        }
+
+        if(score > bestScore)
+        {
+            bestScore = score;
+            if(score > alpha)
+            {
+                alpha = score;
+                bestMove = m;
+                updatePv(ply, m);
+                if(ply == 0)
+                {
+                    this->rootBestMoveNodes = this->stats.nodes - nodesBefore;
+                }
+                if(score >= beta)
+                {
+                    if(!m.isNoisy())
+                    {
+                        this->history->storeKiller(ply, m);
+                        if((ss - 1)->currentMove.isValid())
+                        {
+                            this->history->storeCounterMove((ss - 1)->movedPiece, (ss - 1)->currentMove.to(), m);
+                        }
+                        this->history->updateQuietStats(board.sideToMove(), movedPiece, m, quietsTried,
+                                                        quietPiecesTried, quietCount, depth, continuations);
+                    }
+                    break;
+                }
+            }
+        }
+
+        if(!m.isNoisy() && quietCount < 64)
+        {
+            quietsTried[quietCount] = m;
+            quietPiecesTried[quietCount] = movedPiece;
+            quietCount++;
+        }
+    }
+
+    if(legalMoves == 0)
+    {
+        return inCheck ? -VALUE_MATE + ply : VALUE_DRAW;
+    }
+    if(pvNode)
+    {
+        bestScore = std::min(bestScore, maxScore);
+    }
+
+    Bound bound = bestScore >= beta ? BOUND_LOWER : bestMove.isValid() ? BOUND_EXACT : BOUND_UPPER;
+    this->tt.store(board.key(), bestMove, scoreToTT(bestScore, ply), VALUE_NONE, depth, bound);
+
+    return bestScore;
+}
+
+int Chess::Searcher::qsearch(Board& board, int alpha, int beta, int ply, int qsPly)
+{
+    this->pvLength[ply] = 0;
+    this->stats.nodes++;
+    this->stats.qsearchNodes++;
+
+    if(this->aborted || shouldStop())
+    {
+        this->aborted = true;
+        return 0;
+    }
+
+    if(board.isDraw(ply))
+    {
+        return VALUE_DRAW;
+    }
+
+    bool inCheck = board.inCheck();
+    if(ply >= MAX_PLY - 1)
+    {
+        return inCheck ? VALUE_DRAW : evaluate(board);
+    }
+
+    bool pvNode = beta - alpha > 1;
+    TTEntry ttEntry;
+    bool ttHit = this->tt.probe(board.key(), ttEntry);
+    this->stats.ttProbes++;
+    this->stats.ttHits += ttHit;
+    if(ttHit && !pvNode)
+    {
+        int ttScore = scoreFromTT(ttEntry.score, ply);
+        if(ttEntry.bound & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))
+        {
+            this->stats.ttCutoffs++;
+            return ttScore;
+        }
+    }
+
+    // Stand pat: the side to move can usually do at least as well as the static
+    // evaluation by not capturing at all. Not available when in check.
+    int standPat = -VALUE_INFINITE;
+    int staticEval = VALUE_NONE;
+    int bestScore = -VALUE_INFINITE;
+    if(!inCheck)
+    {
+        staticEval = ttHit && ttEntry.eval != VALUE_NONE ? ttEntry.eval : evaluate(board);
+        standPat = bestScore = staticEval;
+        if(standPat >= beta)
+        {
+            if(!ttHit)
+            {
+                this->tt.store(board.key(), Move(), scoreToTT(standPat, ply), staticEval, 0, BOUND_LOWER);
+            }
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+    }
+
+    MovePicker picker(board, ttHit ? ttEntry.move : Move(), qsPly == 0);
+    Move bestMove;
+
+    int legalMoves = 0;
+    Move m;
+    while((m = picker.nextMove()).isValid())
+    {
+        if(!board.isLegal(m))
+        {
+            continue;
+        }
+        legalMoves++;
+
+        if(!inCheck)
+        {
+            // Delta pruning: even winning the captured piece plus a margin would not
+            // raise alpha, so only a check could make this capture worth searching
+            if(m.isCapture() && !m.isPromotion())
+            {
+                int captured = m.flag() == EN_PASSANT ? PieceValue[typeIndex(Type::PAWN)]
+                                                      : PieceValue[typeIndex(typeOf(board.pieceOn(m.to())))];
+                if(standPat + captured + DELTA_MARGIN <= alpha && !board.givesCheck(m))
+                {
+                    this->stats.deltaPrunes++;
+                    continue;
+                }
+            }
+
+            // SEE pruning: moves that lose material can not improve on standing pat
+            if(!board.seeGe(m, 0))
+            {
+                this->stats.seePrunes++;
+                continue;
+            }
+        }
+
+        board.makeMove(m);
+        int score = -qsearch(board, -beta, -alpha, ply + 1, qsPly + 1);
+        board.unmakeMove(m);
+
+        if(this->aborted)
+        {
+            return 0;
+        }
+
+        if(score > bestScore)
+        {
+            bestScore = score;
+            if(score > alpha)
+            {
+                alpha = score;
+                bestMove = m;
+                updatePv(ply, m);
+                if(score >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Every evasion was searched, so no legal move means checkmate
+    if(inCheck && legalMoves == 0)
+    {
+        return -VALUE_MATE + ply;
+    }
+
+    Bound bound = bestScore >= beta ? BOUND_LOWER : pvNode && bestMove.isValid() ? BOUND_EXACT : BOUND_UPPER;
+    this->tt.store(board.key(), bestMove, scoreToTT(bestScore, ply), staticEval, 0, bound);
+
+    return bestScore;
+}
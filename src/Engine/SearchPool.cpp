@@ -0,0 +1,227 @@
+#include "../include/Engine/SearchPool.h"
+#include "../include/Engine/Trace.h"
+
+#include <algorithm>
+
+Chess::SearchPool::SearchPool()
+{
+    this->searching = false;
+    this->startTime = 0;
+    this->endTime = 0;
+    this->stopped = false;
+    this->pondering = false;
+    setThreadCount(1);
+}
+
+Chess::SearchPool::~SearchPool()
+{
+    stop();
+    wait();
+}
+
+void Chess::SearchPool::setThreadCount(int count)
+{
+    wait();
+    count = std::clamp(count, 1, MAX_THREADS);
+    this->searchers.resize(count);
+    for(int i = 0; i < count; i++)
+    {
+        if(!this->searchers[i])
+        {
+            this->searchers[i] = std::make_unique<Searcher>(this->tt, i);
+        }
+    }
+}
+
+int Chess::SearchPool::getThreadCount() const
+{
+    return int(this->searchers.size());
+}
+
+void Chess::SearchPool::setHashSize(size_t megabytes)
+{
+    wait();
+    this->tt.resize(std::clamp<size_t>(megabytes, 1, MAX_HASH_MB));
+}
+
+void Chess::SearchPool::clear()
+{
+    wait();
+    this->tt.clear();
+    for(auto& searcher : this->searchers)
+    {
+        searcher->clearHistory();
+    }
+}
+
+void Chess::SearchPool::start(const Board& board, const SearchLimits& limits, InfoCallback onInfo, DoneCallback onDone)
+{
+    stop();
+    wait();
+
+    this->stopped = false;
+    this->pondering = limits.ponder;
+    this->tt.newSearch();
+    for(auto& searcher : this->searchers)
+    {
+        searcher->newSearch(limits.ponder);
+    }
+
+    // Every thread gets its own copy to make moves on
+    std::vector<Board> boards(this->searchers.size(), board);
+    this->searching = true;
+    this->startTime = TimeManager::now();
+    this->endTime = 0;
+    this->mainThread = std::thread(&SearchPool::run, this, std::move(boards), limits, std::move(onInfo), std::move(onDone));
+}
+
+void Chess::SearchPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopped = true;
+    }
+    this->condition.notify_all();
+
+    for(auto& searcher : this->searchers)
+    {
+        searcher->stop();
+    }
+}
+
+void Chess::SearchPool::ponderhit()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pondering = false;
+    }
+    this->condition.notify_all();
+
+    for(auto& searcher : this->searchers)
+    {
+        searcher->ponderhit();
+    }
+}
+
+void Chess::SearchPool::wait()
+{
+    if(this->mainThread.joinable())
+    {
+        this->mainThread.join();
+    }
+}
+
+bool Chess::SearchPool::isSearching() const
+{
+    return this->searching;
+}
+
+int Chess::SearchPool::hashfull() const
+{
+    return this->tt.hashfull();
+}
+
+Chess::SearchMetrics Chess::SearchPool::metrics() const
+{
+    SearchMetrics metrics;
+    int64_t end = this->endTime;
+    metrics.time = std::max<int64_t>((end ? end : TimeManager::now()) - this->startTime, 0);
+    metrics.hashfull = this->tt.hashfull();
+
+    uint64_t elapsed = uint64_t(std::max<int64_t>(metrics.time, 1));
+    for(size_t i = 0; i < this->searchers.size(); i++)
+    {
+        SearchStats stats = this->searchers[i]->getPublishedStats();
+        if(i == 0)
+        {
+            metrics.totals = stats;
+        }
+        else
+        {
+            metrics.totals.add(stats);
+        }
+        metrics.threadNps.push_back(stats.nodes * 1000 / elapsed);
+    }
+    metrics.nps = metrics.totals.nodes * 1000 / elapsed;
+
+    for(int depth = MAX_PLY - 1; depth > 0; depth--)
+    {
+        if(metrics.totals.iterationNodes[depth])
+        {
+            metrics.depth = depth;
+            break;
+        }
+    }
+    return metrics;
+}
+
+void Chess::SearchPool::run(std::vector<Board> boards, SearchLimits limits, InfoCallback onInfo, DoneCallback onDone)
+{
+    CHESS_TRACE_THREAD("search 0");
+
+    std::vector<std::thread> helpers;
+    for(size_t i = 1; i < this->searchers.size(); i++)
+    {
+        helpers.emplace_back([this, i, &boards, &limits]()
+        {
+            CHESS_TRACE_THREAD("search " + std::to_string(i));
+            this->searchers[i]->think(boards[i], limits);
+        });
+    }
+
+    Searcher& main = *this->searchers[0];
+    main.setIterationCallback([&](const SearchResult& result)
+    {
+        if(!onInfo)
+        {
+            return;
+        }
+
+        // The main thread has just published its counters
+        SearchInfo info;
+        info.metrics = this->metrics();
+        info.depth = result.depth;
+        info.score = result.score;
+        info.nodes = info.metrics.totals.nodes;
+        info.nps = info.metrics.nps;
+        info.time = info.metrics.time;
+        info.hashfull = info.metrics.hashfull;
+        info.tbHits = info.metrics.totals.tbHits;
+        info.pv = result.pv;
+        info.pvLength = result.pvLength;
+        onInfo(info);
+    });
+
+    SearchResult result = main.think(boards[0], limits);
+
+    // Infinite and pondering searches must not report before they are told to
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->condition.wait(lock, [&]() { return this->stopped || (!limits.infinite && !this->pondering); });
+    }
+
+    for(size_t i = 1; i < this->searchers.size(); i++)
+    {
+        this->searchers[i]->stop();
+    }
+    for(std::thread& helper : helpers)
+    {
+        helper.join();
+    }
+
+    // Report the nodes and tablebase hits of every thread
+    result.stats.nodes = 0;
+    result.stats.tbHits = 0;
+    for(auto& searcher : this->searchers)
+    {
+        result.stats.nodes += searcher->getNodes();
+        result.stats.tbHits += searcher->getTbHits();
+    }
+
+    this->endTime = TimeManager::now();
+    this->searching = false;
+    if(onDone)
+    {
+        onDone(result);
+    }
+}
@@ -0,0 +1,1508 @@
+#include "../include/Engine/Syzygy.h"
+#include "../include/Engine/MappedFile.h"
+#include "../include/Engine/MoveGen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    using namespace Chess;
+    using namespace Chess::Syzygy;
+
+    /**
+     * The two kinds of table file, also the index of a table's files
+     */
+    enum TableType
+    {
+        WDL,
+        DTZ
+    };
+
+    // Flags stored with every table of a file
+    enum TableFlag : uint8_t
+    {
+        // DTZ only: the table stores black to move
+        STM = 1,
+
+        // DTZ only: values go through a map of the distances that occur
+        MAPPED = 2,
+
+        // DTZ only: wins and losses are stored in plies rather than moves
+        WIN_PLIES = 4,
+        LOSS_PLIES = 8,
+
+        // DTZ only: the map has 16 bit entries
+        WIDE = 16,
+
+        // Every position of the table has the same value
+        SINGLE_VALUE = 128
+    };
+
+    // First bytes of each kind of file
+    constexpr uint8_t Magic[2][4] = { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } };
+    constexpr const char* Extension[2] = { ".rtbw", ".rtbz" };
+
+    // Huffman symbols are 12 bits
+    typedef uint16_t Sym;
+
+    // Files are little endian except the compressed data, which is read as a big endian
+    // bit stream. The engine only runs on little endian machines.
+    template<typename T>
+    T readLittle(const uint8_t* bytes)
+    {
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    // Whether count bytes can be read at data without passing end
+    bool fits(const uint8_t* data, const uint8_t* end, size_t count)
+    {
+        return data <= end && count <= size_t(end - data);
+    }
+
+    uint32_t readBig32(const uint8_t* bytes)
+    {
+        return __builtin_bswap32(readLittle<uint32_t>(bytes));
+    }
+
+    uint64_t readBig64(const uint8_t* bytes)
+    {
+        return __builtin_bswap64(readLittle<uint64_t>(bytes));
+    }
+
+    /**
+     * The decoding data of one table of a file. A file holds one table per side to move
+     * (WDL files of unsymmetric material) and per file of the leading pawn (files with
+     * pawns). The pointers point into the mapped file.
+     */
+    struct PairsData
+    {
+        uint8_t flags = 0;
+
+        // Bytes per block of compressed data
+        size_t blockSize = 0;
+
+        // Values between entries of the sparse index
+        size_t span = 0;
+
+        uint32_t blockCount = 0;
+
+        // Longest and shortest Huffman code in bits. A single value table stores its
+        // value in minSymLen.
+        int maxSymLen = 0;
+        int minSymLen = 0;
+
+        // lowestSym[l] is the lowest symbol with a code of minSymLen + l bits
+        const uint8_t* lowestSym = nullptr;
+
+        // The pair of symbols each symbol expands to, 3 bytes per symbol
+        const uint8_t* btree = nullptr;
+
+        // Values in each block minus one, 16 bits each
+        const uint8_t* blockLength = nullptr;
+        size_t blockLengthSize = 0;
+
+        // Block and offset in the block of every span-th value, 6 bytes per entry
+        const uint8_t* sparseIndex = nullptr;
+        size_t sparseIndexSize = 0;
+
+        // The compressed blocks
+        const uint8_t* data = nullptr;
+
+        // base64[l] is the lowest code of minSymLen + l bits, left aligned in 64 bits
+        std::vector<uint64_t> base64;
+
+        // Number of values a symbol expands to, minus one
+        std::vector<uint8_t> symlen;
+
+        // The pieces in the order they are encoded, in the file's piece codes
+        uint8_t pieces[MAX_PIECES];
+
+        // Pieces encoded together and the multiplier of each group's index. The lengths
+        // end with a 0 and the index after the last group is the size of the table.
+        int groupLen[MAX_PIECES + 1];
+        uint64_t groupIdx[MAX_PIECES + 1];
+
+        // DTZ only: where the map of each WDL outcome starts
+        uint16_t mapIdx[4];
+    };
+
+    /**
+     * One file of a table and its mapping state. Probing threads hold the file by
+     * counting themselves in users; the mapping is only replaced when nobody does.
+     */
+    struct TableFile
+    {
+        std::string path;
+        MappedFile file;
+
+        // Set once the file is mapped and decoded, cleared before it is unmapped
+        std::atomic<bool> ready{ false };
+
+        // Threads reading the file right now
+        std::atomic<int> users{ 0 };
+
+        // Probed since the clock hand last passed, so not the next to be unmapped
+        std::atomic<bool> referenced{ false };
+
+        // Missing or corrupt, never tried again. Guarded by the mapping mutex.
+        bool broken = false;
+
+        // [side to move][file of the leading pawn]. WDL files of unsymmetric material
+        // store both sides to move, everything else one.
+        PairsData items[2][4];
+
+        // DTZ only: start of the value maps
+        const uint8_t* dtzMap = nullptr;
+    };
+
+    /**
+     * A material combination with its WDL and DTZ file
+     */
+    struct Table
+    {
+        // Material keys with the stronger side white and with it black
+        uint64_t key;
+        uint64_t key2;
+
+        int pieceCount;
+        bool hasPawns;
+
+        // Whether some piece (other than a king) is the only one of its kind and color
+        bool hasUniquePieces;
+
+        // Pawns of the leading color and of the other color
+        uint8_t pawnCount[2];
+
+        TableFile files[2];
+
+        PairsData* get(TableType type, int stm, int file)
+        {
+            return &this->files[type].items[type == WDL ? stm : 0][this->hasPawns ? file : 0];
+        }
+    };
+
+    // Index tables, see initIndexTables
+    int MapPawns[SQUARE_NB];
+    int MapB1H1H7[SQUARE_NB];
+    int MapA1D1D4[SQUARE_NB];
+    int MapKK[10][SQUARE_NB];
+    int Binomial[6][SQUARE_NB];
+    int LeadPawnIdx[6][SQUARE_NB];
+    int LeadPawnsSize[6][4];
+    std::once_flag indexTablesBuilt;
+
+    // Every table found by init, by both of its material keys
+    std::vector<std::unique_ptr<Table>> tables;
+    std::unordered_map<uint64_t, Table*> tablesByKey;
+    int largestTable = 0;
+    int probeLimit = MAX_PIECES;
+
+    // Guards mapping and unmapping, and everything below
+    std::mutex mapMutex;
+    size_t maxMappedFiles = DEFAULT_MAX_MAPPED_FILES;
+    size_t mappedFiles = 0;
+    uint64_t mapCount = 0;
+    uint64_t evictionCount = 0;
+    uint64_t failureCount = 0;
+
+    // Every file in the order the clock hand visits them when looking for one to unmap
+    std::vector<std::pair<TableFile*, Table*>> clockFiles;
+    size_t clockHand = 0;
+
+    // Distance of a square from the a1-h8 diagonal, positive above it
+    int offA1H8(Square s)
+    {
+        return rowOf(s) - colOf(s);
+    }
+
+    // Mirrors a square across the a1-h8 diagonal
+    Square flipDiagonal(Square s)
+    {
+        return ((s >> 3) | (s << 3)) & 63;
+    }
+
+    // Builds the tables that turn piece placements into indices
+    void initIndexTables()
+    {
+        Bitboards::init();
+
+        // MapB1H1H7 numbers the squares below the a1-h8 diagonal 0 to 27
+        int code = 0;
+        for(Square s = 0; s < SQUARE_NB; s++)
+        {
+            if(offA1H8(s) < 0)
+            {
+                MapB1H1H7[s] = code++;
+            }
+        }
+
+        // MapA1D1D4 numbers the a1-d1-d4 triangle 0 to 9, the diagonal last
+        std::vector<Square> diagonal;
+        code = 0;
+        for(Square s = 0; s <= makeSquare(3, 3); s++)
+        {
+            if(offA1H8(s) < 0 && colOf(s) <= 3)
+            {
+                MapA1D1D4[s] = code++;
+            }
+            else if(offA1H8(s) == 0 && colOf(s) <= 3)
+            {
+                diagonal.push_back(s);
+            }
+        }
+        for(Square s : diagonal)
+        {
+            MapA1D1D4[s] = code++;
+        }
+
+        // MapKK numbers the 462 legal placements of two kings with the first in the
+        // triangle. With the first on the diagonal the second may not be above it, and
+        // placements with both on the diagonal come last.
+        std::vector<std::pair<int, Square>> bothOnDiagonal;
+        code = 0;
+        for(int idx = 0; idx < 10; idx++)
+        {
+            for(Square s1 = 0; s1 <= makeSquare(3, 3); s1++)
+            {
+                if(MapA1D1D4[s1] != idx || (idx == 0 && s1 != makeSquare(0, 1)))
+                {
+                    continue;
+                }
+                for(Square s2 = 0; s2 < SQUARE_NB; s2++)
+                {
+                    if((Bitboards::attacks(Type::KING, s1, 0) | Bitboards::squareBB(s1)) & Bitboards::squareBB(s2))
+                    {
+                        continue;
+                    }
+                    if(offA1H8(s1) == 0 && offA1H8(s2) > 0)
+                    {
+                        continue;
+                    }
+                    if(offA1H8(s1) == 0 && offA1H8(s2) == 0)
+                    {
+                        bothOnDiagonal.emplace_back(idx, s2);
+                    }
+                    else
+                    {
+                        MapKK[idx][s2] = code++;
+                    }
+                }
+            }
+        }
+        for(auto [idx, s2] : bothOnDiagonal)
+        {
+            MapKK[idx][s2] = code++;
+        }
+
+        // Binomial[k][n] ways to choose k of n squares
+        Binomial[0][0] = 1;
+        for(int n = 1; n < SQUARE_NB; n++)
+        {
+            for(int k = 0; k < 6 && k <= n; k++)
+            {
+                Binomial[k][n] = (k > 0 ? Binomial[k - 1][n - 1] : 0) + (k < n ? Binomial[k][n - 1] : 0);
+            }
+        }
+
+        // MapPawns numbers a2-h7 from 47 down, edge files and low ranks first, so it is
+        // also the number of squares left for the other pawns when that square holds the
+        // leading pawn. LeadPawnIdx and LeadPawnsSize number the placements of up to 5
+        // leading pawns per file of the leading pawn.
+        int availableSquares = 47;
+        for(int leadPawnsCnt = 1; leadPawnsCnt <= 5; leadPawnsCnt++)
+        {
+            for(int f = 0; f < 4; f++)
+            {
+                int idx = 0;
+                for(int r = 1; r <= 6; r++)
+                {
+                    Square s = makeSquare(r, f);
+                    if(leadPawnsCnt == 1)
+                    {
+                        MapPawns[s] = availableSquares--;
+                        MapPawns[s ^ 7] = availableSquares--;
+                    }
+                    LeadPawnIdx[leadPawnsCnt][s] = idx;
+                    idx += Binomial[leadPawnsCnt - 1][MapPawns[s]];
+                }
+                LeadPawnsSize[leadPawnsCnt][f] = idx;
+            }
+        }
+    }
+
+    // A piece in the tables' code: the type from 1 (pawn) to 6 (king), plus 8 if black
+    uint8_t tablePiece(Color c, Type t)
+    {
+        return uint8_t(typeIndex(t) + 1 + (c == BLACK ? 8 : 0));
+    }
+
+    // Key of the material of both sides, 4 bits per piece kind. Kings are not counted.
+    uint64_t materialKey(const int counts[COLOR_NB][PIECE_TYPE_NB])
+    {
+        uint64_t key = 0;
+        for(int c = 0; c < COLOR_NB; c++)
+        {
+            for(int t = 0; t < typeIndex(Type::KING); t++)
+            {
+                key |= uint64_t(counts[c][t]) << (4 * (c * typeIndex(Type::KING) + t));
+            }
+        }
+        return key;
+    }
+
+    uint64_t materialKey(const Board& board)
+    {
+        int counts[COLOR_NB][PIECE_TYPE_NB] = {};
+        for(int c = 0; c < COLOR_NB; c++)
+        {
+            for(int t = 0; t < typeIndex(Type::KING); t++)
+            {
+                counts[c][t] = Bitboards::popCount(board.pieces(Color(c), Type(t)));
+            }
+        }
+        return materialKey(counts);
+    }
+
+    // Registers the table named like "KRPvKR", the stronger side first. Returns null if
+    // the name is not a table.
+    std::unique_ptr<Table> makeTable(const std::string& name)
+    {
+        size_t split = name.find('v');
+        if(split == std::string::npos || split == 0 || name[0] != 'K' || split + 1 >= name.size() || name[split + 1] != 'K')
+        {
+            return nullptr;
+        }
+
+        int counts[COLOR_NB][PIECE_TYPE_NB] = {};
+        for(size_t i = 0; i < name.size(); i++)
+        {
+            if(i == split)
+            {
+                continue;
+            }
+            const char* letter = std::strchr("PNBRQK", name[i]);
+            if(!letter || !name[i])
+            {
+                return nullptr;
+            }
+            counts[i < split ? WHITE : BLACK][letter - "PNBRQK"]++;
+        }
+        if(counts[WHITE][typeIndex(Type::KING)] != 1 || counts[BLACK][typeIndex(Type::KING)] != 1
+           || int(name.size()) - 1 > MAX_PIECES)
+        {
+            return nullptr;
+        }
+
+        auto table = std::make_unique<Table>();
+        table->key = materialKey(counts);
+        std::swap(counts[WHITE], counts[BLACK]);
+        table->key2 = materialKey(counts);
+        std::swap(counts[WHITE], counts[BLACK]);
+
+        table->pieceCount = int(name.size()) - 1;
+        int pawns[COLOR_NB] = { counts[WHITE][typeIndex(Type::PAWN)], counts[BLACK][typeIndex(Type::PAWN)] };
+        table->hasPawns = pawns[WHITE] + pawns[BLACK] > 0;
+        table->hasUniquePieces = false;
+        for(int c = 0; c < COLOR_NB; c++)
+        {
+            for(int t = 0; t < typeIndex(Type::KING); t++)
+            {
+                table->hasUniquePieces |= counts[c][t] == 1;
+            }
+        }
+
+        // The leading color is the one with fewer pawns, white if equal, since that
+        // compresses better
+        bool whiteLeads = !pawns[BLACK] || (pawns[WHITE] && pawns[BLACK] >= pawns[WHITE]);
+        table->pawnCount[0] = uint8_t(whiteLeads ? pawns[WHITE] : pawns[BLACK]);
+        table->pawnCount[1] = uint8_t(whiteLeads ? pawns[BLACK] : pawns[WHITE]);
+        return table;
+    }
+
+    // Splits the pieces of a table into the groups they are encoded in and works out
+    // each group's multiplier. order says where the leading group and the remaining
+    // pawns come in the encoding, 0xF if there are none.
+    void setGroups(const Table& table, PairsData* d, const int order[2], int file)
+    {
+        int n = 0;
+        int firstLen = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+        d->groupLen[n] = 1;
+
+        // Equal pieces go together, after a leading group of the two kings and, if there
+        // are unique pieces, a third piece
+        for(int i = 1; i < table.pieceCount; i++)
+        {
+            if(--firstLen > 0 || d->pieces[i] == d->pieces[i - 1])
+            {
+                d->groupLen[n]++;
+            }
+            else
+            {
+                d->groupLen[++n] = 1;
+            }
+        }
+        d->groupLen[++n] = 0;
+
+        // The index is g1 * N(g2) * N(g3) + g2 * N(g3) + g3 for groups g with N(g)
+        // placements each, in the table's order of groups
+        bool pp = table.hasPawns && table.pawnCount[1];
+        int next = pp ? 2 : 1;
+        int freeSquares = SQUARE_NB - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+        uint64_t idx = 1;
+        for(int k = 0; next < n || k == order[0] || k == order[1]; k++)
+        {
+            if(k == order[0])
+            {
+                d->groupIdx[0] = idx;
+                idx *= table.hasPawns ? LeadPawnsSize[d->groupLen[0]][file] : table.hasUniquePieces ? 31332 : 462;
+            }
+            else if(k == order[1])
+            {
+                d->groupIdx[1] = idx;
+                idx *= Binomial[d->groupLen[1]][48 - d->groupLen[0]];
+            }
+            else
+            {
+                d->groupIdx[next] = idx;
+                idx *= Binomial[d->groupLen[next]][freeSquares];
+                freeSquares -= d->groupLen[next++];
+            }
+        }
+        d->groupIdx[n] = idx;
+    }
+
+    // Number of values a symbol stands for, minus one, filled in for its children first.
+    // -1 if the tree refers to a symbol that does not exist.
+    int setSymlen(PairsData* d, Sym s, std::vector<bool>& visited)
+    {
+        visited[s] = true;
+        const uint8_t* lr = d->btree + 3 * s;
+        Sym right = Sym((lr[2] << 4) | (lr[1] >> 4));
+        if(right == 0xFFF)
+        {
+            return 0;
+        }
+        Sym left = Sym(((lr[1] & 0xF) << 8) | lr[0]);
+        if(left >= d->symlen.size() || right >= d->symlen.size())
+        {
+            return -1;
+        }
+
+        for(Sym child : { left, right })
+        {
+            if(!visited[child])
+            {
+                int length = setSymlen(d, child, visited);
+                if(length < 0)
+                {
+                    return -1;
+                }
+                d->symlen[child] = uint8_t(length);
+            }
+        }
+        return d->symlen[left] + d->symlen[right] + 1;
+    }
+
+    // Reads the sizes and Huffman code of a table. Returns the data after them, or
+    // nullptr if they run past end or make no sense.
+    const uint8_t* setSizes(PairsData* d, const uint8_t* data, const uint8_t* end)
+    {
+        if(!fits(data, end, 2))
+        {
+            return nullptr;
+        }
+        d->flags = *data++;
+        if(d->flags & SINGLE_VALUE)
+        {
+            d->minSymLen = *data++;
+            return data;
+        }
+
+        // Block size and span as powers of two, padding, block count and code lengths
+        if(!fits(data, end, 9) || data[0] >= 32 || data[1] >= 32)
+        {
+            return nullptr;
+        }
+        uint64_t tableSize = d->groupIdx[std::find(d->groupLen, d->groupLen + MAX_PIECES, 0) - d->groupLen];
+        d->blockSize = size_t(1) << *data++;
+        d->span = size_t(1) << *data++;
+        d->sparseIndexSize = size_t((tableSize + d->span - 1) / d->span);
+        int padding = *data++;
+        d->blockCount = readLittle<uint32_t>(data);
+        data += sizeof(uint32_t);
+
+        // The padding keeps the sparse index from pointing past the block lengths
+        d->blockLengthSize = d->blockCount + padding;
+        d->maxSymLen = *data++;
+        d->minSymLen = *data++;
+        d->lowestSym = data;
+
+        // Codes are 1 to 64 bits long, and the lowest symbol of every length and the
+        // symbol count must be there
+        if(d->minSymLen < 1 || d->maxSymLen < d->minSymLen || d->maxSymLen > 64
+           || !fits(data, end, (d->maxSymLen - d->minSymLen + 1) * sizeof(Sym) + sizeof(uint16_t)))
+        {
+            return nullptr;
+        }
+
+        // Canonical Huffman code: longer codes have lower values, so the lowest code of
+        // each length, left aligned in 64 bits, decreases with the length and a code's
+        // length is found by comparing against them
+        d->base64.assign(d->maxSymLen - d->minSymLen + 1, 0);
+        for(int i = int(d->base64.size()) - 2; i >= 0; i--)
+        {
+            d->base64[i] = (d->base64[i + 1] + readLittle<Sym>(d->lowestSym + 2 * i)
+                            - readLittle<Sym>(d->lowestSym + 2 * (i + 1))) / 2;
+        }
+        for(size_t i = 0; i < d->base64.size(); i++)
+        {
+            d->base64[i] <<= 64 - i - d->minSymLen;
+        }
+        data += d->base64.size() * sizeof(Sym);
+
+        // Values are compressed by recursive pairing: every symbol is a single value or
+        // stands for a pair of other symbols
+        d->symlen.assign(readLittle<uint16_t>(data), 0);
+        data += sizeof(uint16_t);
+        d->btree = data;
+        if(d->symlen.empty() || !fits(data, end, 3 * d->symlen.size() + (d->symlen.size() & 1)))
+        {
+            return nullptr;
+        }
+        std::vector<bool> visited(d->symlen.size());
+        for(Sym s = 0; s < d->symlen.size(); s++)
+        {
+            if(!visited[s])
+            {
+                int length = setSymlen(d, s, visited);
+                if(length < 0)
+                {
+                    return nullptr;
+                }
+                d->symlen[s] = uint8_t(length);
+            }
+        }
+        return data + 3 * d->symlen.size() + (d->symlen.size() & 1);
+    }
+
+    // Notes where the DTZ value maps of every leading pawn file start. Returns the data
+    // after them, or nullptr if they run past end.
+    const uint8_t* setDtzMap(Table& table, const uint8_t* data, const uint8_t* end, int maxFile)
+    {
+        TableFile& file = table.files[DTZ];
+        file.dtzMap = data;
+        for(int f = 0; f <= maxFile; f++)
+        {
+            PairsData* d = table.get(DTZ, 0, f);
+            if(!(d->flags & MAPPED))
+            {
+                continue;
+            }
+            if(d->flags & WIDE)
+            {
+                data += reinterpret_cast<uintptr_t>(data) & 1;
+                for(int i = 0; i < 4; i++)
+                {
+                    if(!fits(data, end, 2))
+                    {
+                        return nullptr;
+                    }
+                    d->mapIdx[i] = uint16_t((data - file.dtzMap) / 2 + 1);
+                    data += 2 * readLittle<uint16_t>(data) + 2;
+                }
+            }
+            else
+            {
+                for(int i = 0; i < 4; i++)
+                {
+                    if(!fits(data, end, 1))
+                    {
+                        return nullptr;
+                    }
+                    d->mapIdx[i] = uint16_t(data - file.dtzMap + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        return data + (reinterpret_cast<uintptr_t>(data) & 1);
+    }
+
+    // Decodes the layout of a mapped file. data is just after the magic. Returns false
+    // if the layout runs past the end of the file or makes no sense, so a broken file
+    // is reported instead of read out of bounds.
+    bool decodeFile(Table& table, TableType type, const uint8_t* data, const uint8_t* end)
+    {
+        // The first byte flags split (two sides to move) and pawn files
+        data++;
+
+        int sides = type == WDL && table.key != table.key2 ? 2 : 1;
+        int maxFile = table.hasPawns ? 3 : 0;
+        bool pp = table.hasPawns && table.pawnCount[1];
+
+        for(int f = 0; f <= maxFile; f++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                *table.get(type, i, f) = PairsData();
+            }
+            if(!fits(data, end, 1 + pp + table.pieceCount))
+            {
+                return false;
+            }
+
+            int order[2][2] = { { *data & 0xF, pp ? *(data + 1) & 0xF : 0xF },
+                                { *data >> 4, pp ? *(data + 1) >> 4 : 0xF } };
+            data += 1 + pp;
+
+            for(int k = 0; k < table.pieceCount; k++, data++)
+            {
+                for(int i = 0; i < sides; i++)
+                {
+                    table.get(type, i, f)->pieces[k] = uint8_t(i ? *data >> 4 : *data & 0xF);
+                }
+            }
+            for(int i = 0; i < sides; i++)
+            {
+                setGroups(table, table.get(type, i, f), order[i], f);
+            }
+        }
+        data += reinterpret_cast<uintptr_t>(data) & 1;
+
+        for(int f = 0; f <= maxFile; f++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                data = setSizes(table.get(type, i, f), data, end);
+                if(data == nullptr)
+                {
+                    return false;
+                }
+            }
+        }
+        if(type == DTZ)
+        {
+            data = setDtzMap(table, data, end, maxFile);
+            if(data == nullptr)
+            {
+                return false;
+            }
+        }
+
+        for(int f = 0; f <= maxFile; f++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                PairsData* d = table.get(type, i, f);
+                if(!fits(data, end, d->sparseIndexSize * 6))
+                {
+                    return false;
+                }
+                d->sparseIndex = data;
+                data += d->sparseIndexSize * 6;
+            }
+        }
+        for(int f = 0; f <= maxFile; f++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                PairsData* d = table.get(type, i, f);
+                if(!fits(data, end, d->blockLengthSize * sizeof(uint16_t)))
+                {
+                    return false;
+                }
+                d->blockLength = data;
+                data += d->blockLengthSize * sizeof(uint16_t);
+            }
+        }
+        for(int f = 0; f <= maxFile; f++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                // Blocks start on 64 byte boundaries
+                data = reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+                PairsData* d = table.get(type, i, f);
+                if(!fits(data, end, uint64_t(d->blockCount) * d->blockSize))
+                {
+                    return false;
+                }
+                d->data = data;
+                data += d->blockCount * d->blockSize;
+            }
+        }
+        return true;
+    }
+
+    // Unmaps the first file the clock hand finds that was not probed since it last
+    // passed and is not being read. Called with the mapping mutex held.
+    void evictOne()
+    {
+        for(size_t step = 0; step < 2 * clockFiles.size(); step++)
+        {
+            TableFile& file = *clockFiles[clockHand].first;
+            clockHand = (clockHand + 1) % clockFiles.size();
+            if(!file.ready.load())
+            {
+                continue;
+            }
+            if(file.referenced.exchange(false, std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            // A thread that counted itself in before ready was cleared keeps the file
+            file.ready.store(false);
+            if(file.users.load() != 0)
+            {
+                file.ready.store(true);
+                continue;
+            }
+            file.file.close();
+            mappedFiles--;
+            evictionCount++;
+            return;
+        }
+    }
+
+    // Maps and decodes a file. Called with the mapping mutex held.
+    bool mapFile(Table& table, TableType type)
+    {
+        TableFile& file = table.files[type];
+        while(mappedFiles >= maxMappedFiles && mappedFiles > 0)
+        {
+            size_t before = mappedFiles;
+            evictOne();
+            if(mappedFiles == before)
+            {
+                // Every mapped file is being read, go over the limit for now
+                break;
+            }
+        }
+
+        // Sizes are always 16 more than a multiple of 64
+        if(!file.file.open(file.path, MappedFile::Access::RANDOM) || file.file.size() % 64 != 16
+           || std::memcmp(file.file.data(), Magic[type], 4) != 0)
+        {
+            file.file.close();
+            return false;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(file.file.data());
+        if(!decodeFile(table, type, data + 4, data + file.file.size()))
+        {
+            file.file.close();
+            return false;
+        }
+        mappedFiles++;
+        mapCount++;
+        return true;
+    }
+
+    // Counts the thread in as a user of a file, mapping it first if needed. Returns false
+    // if the file is missing or broken.
+    bool acquire(Table& table, TableType type)
+    {
+        TableFile& file = table.files[type];
+        while(true)
+        {
+            file.users.fetch_add(1);
+            if(file.ready.load())
+            {
+                if(!file.referenced.load(std::memory_order_relaxed))
+                {
+                    file.referenced.store(true, std::memory_order_relaxed);
+                }
+                return true;
+            }
+            file.users.fetch_sub(1);
+
+            std::lock_guard<std::mutex> lock(mapMutex);
+            if(file.ready.load())
+            {
+                continue;
+            }
+            if(file.broken)
+            {
+                return false;
+            }
+            if(file.path.empty() || !mapFile(table, type))
+            {
+                file.broken = true;
+                failureCount++;
+                return false;
+            }
+            file.ready.store(true);
+        }
+    }
+
+    void release(Table& table, TableType type)
+    {
+        table.files[type].users.fetch_sub(1, std::memory_order_release);
+    }
+
+    // The value at an index of a table: finds its block through the sparse index,
+    // decodes Huffman codes up to the symbol holding it and expands that symbol's pairs
+    int decompressPairs(const PairsData* d, uint64_t idx)
+    {
+        if(d->flags & SINGLE_VALUE)
+        {
+            return d->minSymLen;
+        }
+
+        // Sparse index entry k points at the value k * span + span / 2. Walk from there
+        // to the block holding idx.
+        uint32_t k = uint32_t(idx / d->span);
+        uint32_t block = readLittle<uint32_t>(d->sparseIndex + 6 * k);
+        int offset = readLittle<uint16_t>(d->sparseIndex + 6 * k + 4);
+        offset += int(idx % d->span) - int(d->span / 2);
+
+        while(offset < 0)
+        {
+            offset += readLittle<uint16_t>(d->blockLength + 2 * --block) + 1;
+        }
+        while(offset > readLittle<uint16_t>(d->blockLength + 2 * block))
+        {
+            offset -= readLittle<uint16_t>(d->blockLength + 2 * block++) + 1;
+        }
+
+        // Decode symbols from the start of the block until one covers the offset
+        const uint8_t* ptr = d->data + uint64_t(block) * d->blockSize;
+        uint64_t buf64 = readBig64(ptr);
+        ptr += 8;
+        int buf64Size = 64;
+        Sym sym;
+        while(true)
+        {
+            int len = 0;
+            while(buf64 < d->base64[len])
+            {
+                len++;
+            }
+
+            // Codes of one length are consecutive, so the symbol is the lowest symbol of
+            // that length plus the distance from the lowest code
+            sym = Sym((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+            sym = Sym(sym + readLittle<Sym>(d->lowestSym + 2 * len));
+
+            if(offset < d->symlen[sym] + 1)
+            {
+                break;
+            }
+            offset -= d->symlen[sym] + 1;
+            len += d->minSymLen;
+            buf64 <<= len;
+            buf64Size -= len;
+            if(buf64Size <= 32)
+            {
+                buf64Size += 32;
+                buf64 |= uint64_t(readBig32(ptr)) << (64 - buf64Size);
+                ptr += 4;
+            }
+        }
+
+        // Expand the symbol's pairs down to the single value at the offset
+        while(d->symlen[sym])
+        {
+            const uint8_t* lr = d->btree + 3 * sym;
+            Sym left = Sym(((lr[1] & 0xF) << 8) | lr[0]);
+            if(offset < d->symlen[left] + 1)
+            {
+                sym = left;
+            }
+            else
+            {
+                offset -= d->symlen[left] + 1;
+                sym = Sym((lr[2] << 4) | (lr[1] >> 4));
+            }
+        }
+        const uint8_t* lr = d->btree + 3 * sym;
+        return ((lr[1] & 0xF) << 8) | lr[0];
+    }
+
+    // Turns a stored DTZ value into plies
+    int mapDtz(Table& table, int file, int value, WdlScore wdl)
+    {
+        constexpr int WdlMap[] = { 1, 3, 0, 2, 0 };
+
+        const PairsData* d = table.get(DTZ, 0, file);
+        const uint8_t* map = table.files[DTZ].dtzMap;
+        if(d->flags & MAPPED)
+        {
+            int start = d->mapIdx[WdlMap[wdl + 2]];
+            value = d->flags & WIDE ? readLittle<uint16_t>(map + 2 * (start + value)) : map[start + value];
+        }
+
+        // Wins and losses may be stored in moves, cursed wins and blessed losses always are
+        if((wdl == WDL_WIN && !(d->flags & WIN_PLIES)) || (wdl == WDL_LOSS && !(d->flags & LOSS_PLIES))
+           || wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS)
+        {
+            value *= 2;
+        }
+        return value + 1;
+    }
+
+    // Whether the pawn on a belongs before the pawn on b when encoding
+    bool pawnsBefore(Square a, Square b)
+    {
+        return MapPawns[a] < MapPawns[b];
+    }
+
+    // Looks the position up in a mapped file: a WdlScore for WDL files, plies for DTZ files
+    int lookUp(const Board& board, Table& table, TableType type, WdlScore wdl, ProbeState& state)
+    {
+        Square squares[MAX_PIECES];
+        uint8_t pieces[MAX_PIECES];
+        int size = 0;
+        int leadPawnsCnt = 0;
+        Bitboard leadPawns = 0;
+        int tbFile = 0;
+
+        // Tables are stored with the stronger side white, and tables of symmetric
+        // material only with white to move, so other positions are looked up with the
+        // colors swapped and the board mirrored
+        bool symmetricBlackToMove = table.key == table.key2 && board.sideToMove() == BLACK;
+        bool blackStronger = materialKey(board) != table.key;
+        bool flip = symmetricBlackToMove || blackStronger;
+        int flipColor = flip ? 8 : 0;
+        int flipSquares = flip ? 56 : 0;
+        int stm = int(flip) ^ int(board.sideToMove());
+
+        // Tables with pawns are split by the file of the leading pawn: the one with the
+        // highest MapPawns, nearest the edge and lowest
+        if(table.hasPawns)
+        {
+            uint8_t leadPiece = uint8_t(table.get(type, 0, 0)->pieces[0] ^ flipColor);
+            Bitboard b = leadPawns = board.pieces(Color(leadPiece >> 3), Type::PAWN);
+            while(b)
+            {
+                squares[size++] = Bitboards::popLsb(b) ^ flipSquares;
+            }
+            leadPawnsCnt = size;
+            std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, pawnsBefore));
+            tbFile = std::min(colOf(squares[0]), 7 - colOf(squares[0]));
+        }
+
+        // DTZ files only store one side to move, except for symmetric pawnless material
+        if(type == DTZ)
+        {
+            int storedStm = table.get(DTZ, 0, tbFile)->flags & STM;
+            if(storedStm != stm && !(table.key == table.key2 && !table.hasPawns))
+            {
+                state = ProbeState::CHANGE_STM;
+                return 0;
+            }
+        }
+
+        Bitboard b = board.pieces() ^ leadPawns;
+        while(b)
+        {
+            Square s = Bitboards::popLsb(b);
+            Piece p = board.pieceOn(s);
+            squares[size] = s ^ flipSquares;
+            pieces[size++] = uint8_t(tablePiece(colorOf(p), typeOf(p)) ^ flipColor);
+        }
+
+        // Put the pieces in the table's order
+        const PairsData* d = table.get(type, stm, tbFile);
+        for(int i = leadPawnsCnt; i < size - 1; i++)
+        {
+            for(int j = i + 1; j < size; j++)
+            {
+                if(d->pieces[i] == pieces[j])
+                {
+                    std::swap(pieces[i], pieces[j]);
+                    std::swap(squares[i], squares[j]);
+                    break;
+                }
+            }
+        }
+
+        // Mirror so the leading piece is on the a-d files
+        if(colOf(squares[0]) > 3)
+        {
+            for(int i = 0; i < size; i++)
+            {
+                squares[i] ^= 7;
+            }
+        }
+
+        uint64_t idx;
+        if(table.hasPawns)
+        {
+            // The leading pawns, the others in ascending MapPawns order
+            idx = LeadPawnIdx[leadPawnsCnt][squares[0]];
+            std::stable_sort(squares + 1, squares + leadPawnsCnt, pawnsBefore);
+            for(int i = 1; i < leadPawnsCnt; i++)
+            {
+                idx += Binomial[i][MapPawns[squares[i]]];
+            }
+        }
+        else
+        {
+            // Without pawns the board is also mirrored so the leading piece is on the
+            // first four ranks, then below the a1-h8 diagonal
+            if(rowOf(squares[0]) > 3)
+            {
+                for(int i = 0; i < size; i++)
+                {
+                    squares[i] ^= 56;
+                }
+            }
+            for(int i = 0; i < d->groupLen[0]; i++)
+            {
+                if(offA1H8(squares[i]) == 0)
+                {
+                    continue;
+                }
+                if(offA1H8(squares[i]) > 0)
+                {
+                    for(int j = i; j < size; j++)
+                    {
+                        squares[j] = flipDiagonal(squares[j]);
+                    }
+                }
+                break;
+            }
+
+            if(table.hasUniquePieces)
+            {
+                // The leading group is three pieces, numbered by whether each is on the
+                // diagonal. Later pieces skip the squares taken by earlier ones.
+                int adjust1 = squares[1] > squares[0];
+                int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+                if(offA1H8(squares[0]))
+                {
+                    idx = (MapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+                }
+                else if(offA1H8(squares[1]))
+                {
+                    idx = (6 * 63 + rowOf(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+                }
+                else if(offA1H8(squares[2]))
+                {
+                    idx = 6 * 63 * 62 + 4 * 28 * 62 + rowOf(squares[0]) * 7 * 28
+                        + (rowOf(squares[1]) - adjust1) * 28 + MapB1H1H7[squares[2]];
+                }
+                else
+                {
+                    idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rowOf(squares[0]) * 7 * 6
+                        + (rowOf(squares[1]) - adjust1) * 6 + (rowOf(squares[2]) - adjust2);
+                }
+            }
+            else
+            {
+                // The leading group is just the kings
+                idx = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+            }
+        }
+
+        // The remaining groups in ascending square order, each square counted without
+        // the squares of earlier groups below it
+        idx *= d->groupIdx[0];
+        Square* groupSq = squares + d->groupLen[0];
+        bool remainingPawns = table.hasPawns && table.pawnCount[1];
+        for(int next = 1; d->groupLen[next]; next++)
+        {
+            std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+            uint64_t n = 0;
+            for(int i = 0; i < d->groupLen[next]; i++)
+            {
+                int adjust = int(std::count_if(squares, groupSq, [&](Square s) { return groupSq[i] > s; }));
+                n += Binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+            }
+            remainingPawns = false;
+            idx += n * d->groupIdx[next];
+            groupSq += d->groupLen[next];
+        }
+
+        int value = decompressPairs(d, idx);
+        return type == WDL ? value - 2 : mapDtz(table, tbFile, value, wdl);
+    }
+
+    // Probes a table without looking at captures first
+    int probeTable(const Board& board, TableType type, ProbeState& state, WdlScore wdl = WDL_DRAW)
+    {
+        // Kings alone are a draw, there is no table
+        if(Bitboards::popCount(board.pieces()) == 2)
+        {
+            return WDL_DRAW;
+        }
+
+        auto found = tablesByKey.find(materialKey(board));
+        if(found == tablesByKey.end() || !acquire(*found->second, type))
+        {
+            state = ProbeState::FAIL;
+            return 0;
+        }
+        int value = lookUp(board, *found->second, type, wdl, state);
+        release(*found->second, type);
+        return value;
+    }
+
+    // WDL of a position after trying its captures, and with checkZeroing its pawn moves
+    // too, since the tables do not know about en passant and DTZ tables store
+    // meaningless values where the best move is a capture or pawn move
+    WdlScore searchZeroing(Board& board, ProbeState& state, bool checkZeroing)
+    {
+        WdlScore bestValue = WDL_LOSS;
+        MoveList moves;
+        generateLegalMoves(board, moves);
+        int moveCount = 0;
+
+        for(const ScoredMove& sm : moves)
+        {
+            Move m = sm.move;
+            if(!m.isCapture() && (!checkZeroing || typeOf(board.movedPiece(m)) != Type::PAWN))
+            {
+                continue;
+            }
+            moveCount++;
+
+            board.makeMove(m);
+            WdlScore value = WdlScore(-searchZeroing(board, state, false));
+            board.unmakeMove(m);
+
+            if(state == ProbeState::FAIL)
+            {
+                return WDL_DRAW;
+            }
+            if(value > bestValue)
+            {
+                bestValue = value;
+                if(value >= WDL_WIN)
+                {
+                    state = ProbeState::ZEROING_BEST_MOVE;
+                    return value;
+                }
+            }
+        }
+
+        // If every legal move was just searched the table is not needed, and may even be
+        // wrong, e.g. when the only moves are en passant captures
+        bool noMoreMoves = moveCount && moveCount == moves.size();
+        WdlScore value;
+        if(noMoreMoves)
+        {
+            value = bestValue;
+        }
+        else
+        {
+            value = WdlScore(probeTable(board, WDL, state));
+            if(state == ProbeState::FAIL)
+            {
+                return WDL_DRAW;
+            }
+        }
+
+        if(bestValue >= value)
+        {
+            state = bestValue > WDL_DRAW || noMoreMoves ? ProbeState::ZEROING_BEST_MOVE : ProbeState::OK;
+            return bestValue;
+        }
+        state = ProbeState::OK;
+        return value;
+    }
+
+    // DTZ of a position just before a capture or pawn move with the given outcome
+    int dtzBeforeZeroing(WdlScore wdl)
+    {
+        return wdl == WDL_WIN ? 1 : wdl == WDL_CURSED_WIN ? 101 : wdl == WDL_BLESSED_LOSS ? -101 : wdl == WDL_LOSS ? -1 : 0;
+    }
+
+    int signOf(int value)
+    {
+        return (value > 0) - (value < 0);
+    }
+
+    // Whether the side to move is checkmated
+    bool isMate(const Board& board)
+    {
+        if(!board.inCheck())
+        {
+            return false;
+        }
+        MoveList moves;
+        generateLegalMoves(board, moves);
+        return moves.size() == 0;
+    }
+};
+
+size_t Chess::Syzygy::init(const std::string& paths)
+{
+    std::call_once(indexTablesBuilt, initIndexTables);
+
+    std::lock_guard<std::mutex> lock(mapMutex);
+    tablesByKey.clear();
+    clockFiles.clear();
+    clockHand = 0;
+    tables.clear();
+    mappedFiles = 0;
+    largestTable = 0;
+
+#ifdef _WIN32
+    constexpr char SEPARATOR = ';';
+#else
+    constexpr char SEPARATOR = ':';
+#endif
+
+    // The first directory holding a file wins
+    std::unordered_map<std::string, std::string> found[2];
+    size_t start = 0;
+    while(start <= paths.size())
+    {
+        size_t end = std::min(paths.find(SEPARATOR, start), paths.size());
+        std::string directory = paths.substr(start, end - start);
+        start = end + 1;
+
+        std::error_code error;
+        if(directory.empty() || directory == "<empty>")
+        {
+            continue;
+        }
+        for(const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            std::string extension = entry.path().extension().string();
+            for(int type = WDL; type <= DTZ; type++)
+            {
+                if(extension == Extension[type])
+                {
+                    found[type].emplace(entry.path().stem().string(), entry.path().string());
+                }
+            }
+        }
+    }
+
+    for(const auto& [name, path] : found[WDL])
+    {
+        std::unique_ptr<Table> table = makeTable(name);
+        if(!table || tablesByKey.count(table->key))
+        {
+            continue;
+        }
+        table->files[WDL].path = path;
+        auto dtz = found[DTZ].find(name);
+        if(dtz != found[DTZ].end())
+        {
+            table->files[DTZ].path = dtz->second;
+        }
+
+        tablesByKey[table->key] = table.get();
+        tablesByKey[table->key2] = table.get();
+        largestTable = std::max(largestTable, table->pieceCount);
+        for(int type = WDL; type <= DTZ; type++)
+        {
+            clockFiles.emplace_back(&table->files[type], table.get());
+        }
+        tables.push_back(std::move(table));
+    }
+    return tables.size();
+}
+
+int Chess::Syzygy::maxPieces()
+{
+    return largestTable;
+}
+
+void Chess::Syzygy::setProbeLimit(int pieces)
+{
+    probeLimit = std::clamp(pieces, 0, MAX_PIECES);
+}
+
+int Chess::Syzygy::cardinality()
+{
+    return std::min(largestTable, probeLimit);
+}
+
+void Chess::Syzygy::setMaxMappedFiles(size_t files)
+{
+    std::lock_guard<std::mutex> lock(mapMutex);
+    maxMappedFiles = std::max<size_t>(files, 1);
+    while(mappedFiles > maxMappedFiles)
+    {
+        size_t before = mappedFiles;
+        evictOne();
+        if(mappedFiles == before)
+        {
+            break;
+        }
+    }
+}
+
+Chess::Syzygy::Stats Chess::Syzygy::stats()
+{
+    std::lock_guard<std::mutex> lock(mapMutex);
+    Stats stats;
+    stats.tables = tables.size();
+    stats.maxPieces = largestTable;
+    stats.mappedFiles = mappedFiles;
+    stats.maps = mapCount;
+    stats.evictions = evictionCount;
+    stats.failures = failureCount;
+    return stats;
+}
+
+Chess::Syzygy::WdlScore Chess::Syzygy::probeWdl(Board& board, ProbeState& state)
+{
+    state = ProbeState::OK;
+    return searchZeroing(board, state, false);
+}
+
+int Chess::Syzygy::probeDtz(Board& board, ProbeState& state)
+{
+    state = ProbeState::OK;
+    WdlScore wdl = searchZeroing(board, state, true);
+
+    // DTZ tables do not store draws
+    if(state == ProbeState::FAIL || wdl == WDL_DRAW)
+    {
+        return 0;
+    }
+
+    // Where the best move zeroes the counter the table's value is meaningless
+    if(state == ProbeState::ZEROING_BEST_MOVE)
+    {
+        return dtzBeforeZeroing(wdl);
+    }
+
+    int dtz = probeTable(board, DTZ, state, wdl);
+    if(state == ProbeState::FAIL)
+    {
+        return 0;
+    }
+    if(state != ProbeState::CHANGE_STM)
+    {
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+    }
+
+    // The table stores the other side to move, so look one move ahead for the reply
+    // with the best DTZ of the right sign
+    int minDtz = 0xFFFF;
+    MoveList moves;
+    generateLegalMoves(board, moves);
+    for(const ScoredMove& sm : moves)
+    {
+        Move m = sm.move;
+        bool zeroing = m.isCapture() || typeOf(board.movedPiece(m)) == Type::PAWN;
+
+        board.makeMove(m);
+
+        // After a zeroing move the distance is the one before it; the position after it
+        // only gives the sign
+        dtz = zeroing ? -dtzBeforeZeroing(searchZeroing(board, state, false)) : -probeDtz(board, state);
+        if(dtz == 1 && isMate(board))
+        {
+            minDtz = 1;
+        }
+        if(!zeroing)
+        {
+            dtz += signOf(dtz);
+        }
+        if(dtz < minDtz && signOf(dtz) == signOf(wdl))
+        {
+            minDtz = dtz;
+        }
+
+        board.unmakeMove(m);
+        if(state == ProbeState::FAIL)
+        {
+            return 0;
+        }
+    }
+
+    // No legal moves: mated
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Chess::Syzygy::rootProbe(Board& board, std::vector<RootMove>& moves)
+{
+    MoveList legal;
+    generateLegalMoves(board, legal);
+    moves.clear();
+
+    ProbeState state = ProbeState::OK;
+    int cnt50 = board.halfmoveClock();
+    int bound = MAX_DTZ - 100;
+    for(const ScoredMove& sm : legal)
+    {
+        Move m = sm.move;
+        board.makeMove(m);
+
+        // DTZ counted from the root
+        int dtz;
+        if(board.halfmoveClock() == 0)
+        {
+            dtz = dtzBeforeZeroing(WdlScore(-probeWdl(board, state)));
+        }
+        else if(board.isDraw(1))
+        {
+            dtz = 0;
+        }
+        else
+        {
+            dtz = -probeDtz(board, state);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+        if(dtz == 2 && isMate(board))
+        {
+            dtz = 1;
+        }
+        board.unmakeMove(m);
+
+        if(state == ProbeState::FAIL)
+        {
+            return false;
+        }
+
+        // Wins that beat the fifty move rule rank equally, the rest by how close the
+        // rule is. Losses rank equally unless the rule may still save them.
+        int rank = dtz > 0 ? (dtz + cnt50 <= 99 ? MAX_DTZ : MAX_DTZ - (dtz + cnt50))
+                 : dtz < 0 ? (-dtz * 2 + cnt50 < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + cnt50))
+                 : 0;
+
+        // Cursed wins score at least 1 cp, growing as the win gets closer
+        int pawn = PieceValue[typeIndex(Type::PAWN)];
+        int score = rank >= bound ? VALUE_TB_WIN
+                  : rank > 0 ? std::max(3, rank - (MAX_DTZ - 200)) * pawn / 200
+                  : rank == 0 ? VALUE_DRAW
+                  : rank > -bound ? std::min(-3, rank + (MAX_DTZ - 200)) * pawn / 200
+                  : -VALUE_TB_WIN;
+        moves.push_back({ m, rank, score });
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const RootMove& a, const RootMove& b) { return a.rank > b.rank; });
+    return true;
+}
+
+bool Chess::Syzygy::rootProbeWdl(Board& board, std::vector<RootMove>& moves)
+{
+    constexpr int WdlToRank[] = { -MAX_DTZ, -MAX_DTZ + 101, 0, MAX_DTZ - 101, MAX_DTZ };
+    constexpr int WdlToScore[] = { -VALUE_TB_WIN, VALUE_DRAW - 2, VALUE_DRAW, VALUE_DRAW + 2, VALUE_TB_WIN };
+
+    MoveList legal;
+    generateLegalMoves(board, legal);
+    moves.clear();
+
+    ProbeState state = ProbeState::OK;
+    for(const ScoredMove& sm : legal)
+    {
+        Move m = sm.move;
+        board.makeMove(m);
+        WdlScore wdl = board.isDraw(1) ? WDL_DRAW : WdlScore(-probeWdl(board, state));
+        board.unmakeMove(m);
+
+        if(state == ProbeState::FAIL)
+        {
+            return false;
+        }
+        moves.push_back({ m, WdlToRank[wdl + 2], WdlToScore[wdl + 2] });
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const RootMove& a, const RootMove& b) { return a.rank > b.rank; });
+    return true;
+}
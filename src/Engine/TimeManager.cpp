@@ -0,0 +1,132 @@
+#include "../include/Engine/TimeManager.h"
+#include "../include/Engine/Search.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // How fast the memory of earlier best move changes fades, per iteration
+    constexpr double INSTABILITY_DECAY = 0.5;
+
+    // Score drop in centipawns at which the time extension for falling scores is largest
+    constexpr int MAX_SCORE_DROP = 100;
+
+    // Largest extension for a falling score, as a factor of the soft limit
+    constexpr double MAX_SCORE_DROP_FACTOR = 1.5;
+
+    // The factor from the best move's share of the nodes is this minus the share, within
+    // bounds. A move that takes nearly all the effort is clearly best and gets less time.
+    constexpr double EFFORT_BASE = 1.6;
+    constexpr double MIN_EFFORT_FACTOR = 0.5;
+    constexpr double MAX_EFFORT_FACTOR = 1.2;
+};
+
+Chess::TimeManager::TimeManager()
+{
+    this->startTime = 0;
+    this->limited = false;
+    this->fixedTime = false;
+    this->softLimit = 0;
+    this->hardLimit = 0;
+    this->instability = 0.0;
+    this->previousScore = VALUE_NONE;
+    this->iterations = 0;
+}
+
+int64_t Chess::TimeManager::now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Chess::TimeManager::init(const SearchLimits& limits, int rootMoves)
+{
+    this->startTime.store(now(), std::memory_order_relaxed);
+    this->instability = 0.0;
+    this->previousBestMove = Move();
+    this->previousScore = VALUE_NONE;
+    this->iterations = 0;
+    this->limited = false;
+    this->fixedTime = false;
+
+    if(limits.movetime)
+    {
+        this->limited = true;
+        this->fixedTime = true;
+        this->softLimit = this->hardLimit = limits.movetime;
+    }
+    else if(limits.time > 0)
+    {
+        // Spread the remaining time over the moves still to play, never betting more
+        // than a fixed share of the clock on a single move
+        int64_t available = std::max<int64_t>(limits.time - MOVE_OVERHEAD, 1);
+        int64_t maximum = std::max<int64_t>(int64_t(available * MAX_TIME_SHARE), 1);
+        int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+
+        this->limited = true;
+        this->softLimit = std::clamp<int64_t>(available / movesToGo + limits.increment * 3 / 4, 1, maximum);
+        this->hardLimit = std::clamp<int64_t>(int64_t(this->softLimit * HARD_LIMIT_FACTOR), this->softLimit, maximum);
+
+        // A forced move only needs the first iteration, for a move to ponder on
+        if(rootMoves == 1)
+        {
+            this->softLimit = 0;
+        }
+    }
+}
+
+void Chess::TimeManager::restart()
+{
+    this->startTime.store(now(), std::memory_order_relaxed);
+}
+
+int64_t Chess::TimeManager::elapsed() const
+{
+    return now() - this->startTime.load(std::memory_order_relaxed);
+}
+
+bool Chess::TimeManager::hardLimitReached(int64_t nowMs) const
+{
+    return this->limited && nowMs - this->startTime.load(std::memory_order_relaxed) >= this->hardLimit;
+}
+
+bool Chess::TimeManager::stopAfterIteration(Move bestMove, int score, double bestMoveNodeShare)
+{
+    // Best move changes count most in the iteration they happen and fade afterwards
+    this->instability *= INSTABILITY_DECAY;
+    if(this->iterations++ > 0 && bestMove != this->previousBestMove)
+    {
+        this->instability += 1.0;
+    }
+
+    double scoreFactor = 1.0;
+    if(this->previousScore != VALUE_NONE && score < this->previousScore)
+    {
+        int drop = std::min(this->previousScore - score, MAX_SCORE_DROP);
+        scoreFactor += (MAX_SCORE_DROP_FACTOR - 1.0) * drop / MAX_SCORE_DROP;
+    }
+
+    this->previousBestMove = bestMove;
+    this->previousScore = score;
+
+    if(!this->limited || this->fixedTime)
+    {
+        return false;
+    }
+
+    double instabilityFactor = 1.0 + this->instability;
+    double effortFactor = std::clamp(EFFORT_BASE - bestMoveNodeShare, MIN_EFFORT_FACTOR, MAX_EFFORT_FACTOR);
+    double budget = this->softLimit * instabilityFactor * scoreFactor * effortFactor;
+
+    return elapsed() >= std::min<double>(budget, double(this->hardLimit));
+}
+
+uint64_t Chess::TimeManager::checkInterval(uint64_t nodes, int64_t elapsedMs)
+{
+    if(elapsedMs <= 0)
+    {
+        return MIN_CHECK_INTERVAL;
+    }
+    return std::clamp<uint64_t>(nodes * CHECK_PERIOD_MS / uint64_t(elapsedMs), MIN_CHECK_INTERVAL, MAX_CHECK_INTERVAL);
+}
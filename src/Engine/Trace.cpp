@@ -0,0 +1,213 @@
+#include "../include/Engine/Trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    /**
+     * A span as recorded, with absolute times in ticks
+     */
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    /**
+     * The ring of one thread. Only its thread writes events; count is atomic so write()
+     * can see how far it got. When the thread exits the buffer is handed to the next new
+     * thread, preferring one with the same name, so a search starting threads over and
+     * over keeps one row per helper instead of allocating a buffer per thread.
+     */
+    struct ThreadBuffer
+    {
+        int id;
+        std::string name;
+        std::vector<Event> events;
+        size_t mask;
+        std::atomic<uint64_t> count{0};
+        bool inUse = true;
+    };
+
+    // Every thread's buffer. They are never freed, so write() can still save the spans of
+    // threads that are gone.
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    size_t eventsPerThread = Chess::Trace::DEFAULT_EVENTS_PER_THREAD;
+
+    // A tick count and the steady clock at the same moment, taken by start(), to measure
+    // how many ticks make a nanosecond
+    uint64_t calibrationTicks = 0;
+    std::chrono::steady_clock::time_point calibrationTime;
+
+    /**
+     * The calling thread's buffer, created on its first span
+     */
+    struct ThreadState
+    {
+        ThreadBuffer* buffer = nullptr;
+        std::string name;
+
+        ~ThreadState()
+        {
+            if(this->buffer != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(buffersMutex);
+                this->buffer->inUse = false;
+            }
+        }
+    };
+
+    thread_local ThreadState threadState;
+
+    ThreadBuffer& buffer()
+    {
+        if(threadState.buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            ThreadBuffer* reused = nullptr;
+            for(const auto& b : buffers)
+            {
+                if(!b->inUse && (reused == nullptr || (b->name == threadState.name && reused->name != threadState.name)))
+                {
+                    reused = b.get();
+                }
+            }
+
+            if(reused == nullptr)
+            {
+                auto created = std::make_unique<ThreadBuffer>();
+                created->id = int(buffers.size()) + 1;
+                created->events.resize(eventsPerThread);
+                created->mask = eventsPerThread - 1;
+                reused = created.get();
+                buffers.push_back(std::move(created));
+            }
+
+            reused->inUse = true;
+            if(!threadState.name.empty())
+            {
+                reused->name = threadState.name;
+            }
+            else if(reused->name.empty())
+            {
+                reused->name = "thread " + std::to_string(reused->id);
+            }
+            threadState.buffer = reused;
+        }
+        return *threadState.buffer;
+    }
+
+    // Characters JSON strings can not hold as they are
+    std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        for(char c : text)
+        {
+            if(c == '"' || c == '\\')
+            {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+std::atomic<bool> Chess::Trace::recording{false};
+
+void Chess::Trace::start(size_t events)
+{
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        eventsPerThread = std::bit_ceil(std::max<size_t>(events, 2));
+        calibrationTicks = now();
+        calibrationTime = std::chrono::steady_clock::now();
+    }
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void Chess::Trace::stop()
+{
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void Chess::Trace::setThreadName(const std::string& name)
+{
+    // Threads that never record a span never get a buffer
+    threadState.name = name;
+    if(threadState.buffer != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threadState.buffer->name = name;
+    }
+}
+
+void Chess::Trace::record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer& b = buffer();
+    uint64_t i = b.count.load(std::memory_order_relaxed);
+    b.events[i & b.mask] = { name, start, end };
+    b.count.store(i + 1, std::memory_order_release);
+}
+
+bool Chess::Trace::write(const std::string& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if(!file)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    // Without a counter, or too soon after start() to measure it, ticks are nanoseconds
+    double ticksPerMicrosecond = 1000.0;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - calibrationTime).count();
+    uint64_t ticks = now() - calibrationTicks;
+    if(calibrationTicks != 0 && elapsed > 1000000)
+    {
+        ticksPerMicrosecond = double(ticks) / double(elapsed) * 1000.0;
+    }
+
+    // Times are written relative to the earliest span kept
+    uint64_t origin = UINT64_MAX;
+    for(const auto& b : buffers)
+    {
+        uint64_t count = b->count.load(std::memory_order_acquire);
+        for(uint64_t i = count > b->events.size() ? count - b->events.size() : 0; i < count; i++)
+        {
+            origin = std::min(origin, b->events[i & b->mask].start);
+        }
+    }
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    char line[256];
+    for(const auto& b : buffers)
+    {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id
+             << ",\"args\":{\"name\":\"" << escape(b->name) << "\"}}";
+        first = false;
+
+        uint64_t count = b->count.load(std::memory_order_acquire);
+        for(uint64_t i = count > b->events.size() ? count - b->events.size() : 0; i < count; i++)
+        {
+            const Event& e = b->events[i & b->mask];
+            int length = std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                       e.name, b->id, double(e.start - origin) / ticksPerMicrosecond,
+                                       double(e.end - e.start) / ticksPerMicrosecond);
+            file.write(line, std::min<int>(length, int(sizeof(line)) - 1));
+        }
+        b->count.store(0, std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+    return bool(file);
+}
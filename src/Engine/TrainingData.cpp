@@ -0,0 +1,129 @@
+#include "../include/Engine/TrainingData.h"
+#include "../include/Engine/Bitboards.h"
+
+#include <algorithm>
+
+namespace
+{
+    using namespace Chess;
+
+    // Wraps a path in single quotes for the shell
+    std::string shellQuote(const std::string& text)
+    {
+        std::string quoted = "'";
+        for(char c : text)
+        {
+            if(c == '\'')
+            {
+                quoted += "'\\''";
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+        return quoted + "'";
+    }
+};
+
+Chess::TrainingData::PackedPosition Chess::TrainingData::pack(const Board& board, int score)
+{
+    PackedPosition record = {};
+    record.occupancy = board.pieces();
+    Bitboard occupied = record.occupancy;
+    for(int i = 0; occupied; i++)
+    {
+        Square s = Bitboards::popLsb(occupied);
+        record.pieces[i / 2] |= uint8_t(board.pieceOn(s) << (4 * (i % 2)));
+    }
+    record.score = int16_t(std::clamp(score, int(INT16_MIN), int(INT16_MAX)));
+    record.fullmoveNumber = uint16_t(std::min(board.fullmoveNumber(), int(UINT16_MAX)));
+    record.halfmoveClock = uint8_t(std::min(board.halfmoveClock(), int(UINT8_MAX)));
+    record.flags = uint8_t(board.sideToMove() | (board.castlingRights() << 1));
+    record.epSquare = uint8_t(board.epSquare());
+    record.result = DRAW;
+    return record;
+}
+
+bool Chess::TrainingData::unpack(const PackedPosition& record, Fen::Position& position)
+{
+    // Files are mapped as they are, so every field is checked before it is used
+    if(Bitboards::popCount(record.occupancy) > 32 || (record.flags >> 5) != 0 || record.epSquare > SQ_NONE
+       || record.result < BLACK_WINS || record.result > WHITE_WINS)
+    {
+        return false;
+    }
+
+    std::fill(position.squares, position.squares + SQUARE_NB, NO_PIECE);
+    int kings[COLOR_NB] = { 0, 0 };
+    Bitboard occupied = record.occupancy;
+    for(int i = 0; occupied; i++)
+    {
+        Square s = Bitboards::popLsb(occupied);
+        Piece piece = Piece((record.pieces[i / 2] >> (4 * (i % 2))) & 0xF);
+        if(piece >= NO_PIECE)
+        {
+            return false;
+        }
+        position.squares[s] = piece;
+        if(typeOf(piece) == Type::KING)
+        {
+            kings[colorOf(piece)]++;
+        }
+    }
+    if(kings[WHITE] != 1 || kings[BLACK] != 1)
+    {
+        return false;
+    }
+    position.sideToMove = Color(record.flags & 1);
+    position.castling = uint8_t(record.flags >> 1);
+    position.epSquare = record.epSquare;
+    position.halfmoveClock = record.halfmoveClock;
+    position.fullmoveNumber = record.fullmoveNumber;
+    return true;
+}
+
+Chess::TrainingData::Writer::~Writer()
+{
+    close();
+}
+
+bool Chess::TrainingData::Writer::open(const std::string& path, const std::string& compressor)
+{
+    close();
+    this->failed = false;
+    this->written = 0;
+    this->piped = !compressor.empty();
+    this->file = this->piped ? popen((compressor + " > " + shellQuote(path)).c_str(), "w") : std::fopen(path.c_str(), "wb");
+    return this->file != nullptr;
+}
+
+bool Chess::TrainingData::Writer::write(const PackedPosition* records, size_t count)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(this->file == nullptr || std::fwrite(records, sizeof(PackedPosition), count, this->file) != count)
+    {
+        this->failed = true;
+        return false;
+    }
+    this->written += count;
+    return true;
+}
+
+bool Chess::TrainingData::Writer::close()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(this->file == nullptr)
+    {
+        return !this->failed;
+    }
+    this->failed |= std::fflush(this->file) != 0;
+    this->failed |= (this->piped ? pclose(this->file) : std::fclose(this->file)) != 0;
+    this->file = nullptr;
+    return !this->failed;
+}
+
+bool Chess::TrainingData::Reader::open(const std::string& path, MappedFile::Access access)
+{
+    return this->file.open(path, access) && this->file.size() % sizeof(PackedPosition) == 0;
+}
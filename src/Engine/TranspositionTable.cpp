@@ -0,0 +1,150 @@
+#include "../include/Engine/TranspositionTable.h"
+#include "../include/Engine/Trace.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Layout of Slot::data, low bits first
+    constexpr int MOVE_SHIFT = 0;
+    constexpr int SCORE_SHIFT = 16;
+    constexpr int EVAL_SHIFT = 32;
+    constexpr int DEPTH_SHIFT = 48;
+    constexpr int BOUND_SHIFT = 56;
+    constexpr int GENERATION_SHIFT = 58;
+
+    // The generation is kept in the top 6 bits
+    constexpr uint8_t GENERATION_MASK = 63;
+
+    // Entries that were written by a search this many generations ago count as
+    // worthless as depth 0 entries of the current one, per generation of age
+    constexpr int AGE_WEIGHT = 8;
+
+    // Depth is stored with an offset so qsearch's depth 0 and below fit in 8 bits
+    constexpr int DEPTH_OFFSET = 8;
+
+    // Number of buckets sampled by hashfull()
+    constexpr size_t HASHFULL_SAMPLE = 250;
+
+    inline uint64_t pack(Chess::Move move, int score, int eval, int depth, Chess::Bound bound, uint8_t generation)
+    {
+        return uint64_t(move.raw()) << MOVE_SHIFT
+             | uint64_t(uint16_t(int16_t(score))) << SCORE_SHIFT
+             | uint64_t(uint16_t(int16_t(eval))) << EVAL_SHIFT
+             | uint64_t(uint8_t(depth + DEPTH_OFFSET)) << DEPTH_SHIFT
+             | uint64_t(bound) << BOUND_SHIFT
+             | uint64_t(generation) << GENERATION_SHIFT;
+    }
+
+    inline int depthOf(uint64_t data) { return int((data >> DEPTH_SHIFT) & 0xFF) - DEPTH_OFFSET; }
+    inline uint8_t generationOf(uint64_t data) { return uint8_t(data >> GENERATION_SHIFT); }
+    inline Chess::Bound boundOf(uint64_t data) { return Chess::Bound((data >> BOUND_SHIFT) & 3); }
+};
+
+Chess::TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    this->bucketCount = 0;
+    this->generation = 0;
+    resize(megabytes);
+}
+
+void Chess::TranspositionTable::resize(size_t megabytes)
+{
+    this->megabytes = std::max<size_t>(megabytes, 1);
+    this->bucketCount = this->megabytes * 1024 * 1024 / sizeof(Bucket);
+    this->buckets = std::make_unique<Bucket[]>(this->bucketCount);
+    clear();
+}
+
+void Chess::TranspositionTable::clear()
+{
+    for(size_t i = 0; i < this->bucketCount; i++)
+    {
+        for(Slot& slot : this->buckets[i].slots)
+        {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    this->generation = 0;
+}
+
+void Chess::TranspositionTable::newSearch()
+{
+    this->generation = (this->generation + 1) & GENERATION_MASK;
+}
+
+bool Chess::TranspositionTable::probe(uint64_t key, TTEntry& entry) const
+{
+    CHESS_TRACE_SCOPE("tt probe");
+    const Bucket& bucket = bucketOf(key);
+    for(const Slot& slot : bucket.slots)
+    {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if((slot.check.load(std::memory_order_relaxed) ^ data) == key && boundOf(data) != BOUND_NONE)
+        {
+            entry.move = Move::fromRaw(uint16_t(data >> MOVE_SHIFT));
+            entry.score = int16_t(data >> SCORE_SHIFT);
+            entry.eval = int16_t(data >> EVAL_SHIFT);
+            entry.depth = depthOf(data);
+            entry.bound = boundOf(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Chess::TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, Bound bound)
+{
+    CHESS_TRACE_SCOPE("tt store");
+    Bucket& bucket = bucketOf(key);
+
+    // Reuse the position's own slot if it has one, otherwise replace the shallowest,
+    // oldest slot
+    Slot* replace = &bucket.slots[0];
+    int worstValue = 1 << 30;
+    for(Slot& slot : bucket.slots)
+    {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if((slot.check.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            // Keep the old best move rather than forgetting it
+            if(!move.isValid())
+            {
+                move = Move::fromRaw(uint16_t(data >> MOVE_SHIFT));
+            }
+            replace = &slot;
+            break;
+        }
+
+        int age = (this->generation - generationOf(data)) & GENERATION_MASK;
+        int value = depthOf(data) - AGE_WEIGHT * age;
+        if(value < worstValue)
+        {
+            worstValue = value;
+            replace = &slot;
+        }
+    }
+
+    uint64_t data = pack(move, score, eval, depth, bound, this->generation);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int Chess::TranspositionTable::hashfull() const
+{
+    size_t sample = std::min(HASHFULL_SAMPLE, this->bucketCount);
+    int used = 0;
+    for(size_t i = 0; i < sample; i++)
+    {
+        for(const Slot& slot : this->buckets[i].slots)
+        {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if(boundOf(data) != BOUND_NONE && generationOf(data) == this->generation)
+            {
+                used++;
+            }
+        }
+    }
+    return int(used * 1000 / (sample * BUCKET_SIZE));
+}
@@ -0,0 +1,69 @@
+#include "../include/Engine/Zobrist.h"
+
+#include <mutex>
+
+uint64_t Chess::Zobrist::PieceSquare[PIECE_NB][SQUARE_NB];
+uint64_t Chess::Zobrist::Castling[16];
+uint64_t Chess::Zobrist::EnPassant[8];
+uint64_t Chess::Zobrist::Side;
+uint64_t Chess::Zobrist::NoPawns;
+
+namespace
+{
+    // SplitMix64, seeded with a constant so keys (and anything persisted with them) are
+    // stable between runs.
+    uint64_t nextKey(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    void buildKeys()
+    {
+        using namespace Chess;
+
+        uint64_t state = 0x436865737343505ULL;
+        for(int p = 0; p < PIECE_NB; p++)
+        {
+            for(Square s = 0; s < SQUARE_NB; s++)
+            {
+                Zobrist::PieceSquare[p][s] = nextKey(state);
+            }
+        }
+
+        // Castling keys are built from one key per right so that the key of a mask
+        // is the XOR of the keys of its rights.
+        uint64_t rightKeys[4];
+        for(int i = 0; i < 4; i++)
+        {
+            rightKeys[i] = nextKey(state);
+        }
+        for(int mask = 0; mask < 16; mask++)
+        {
+            Zobrist::Castling[mask] = 0;
+            for(int i = 0; i < 4; i++)
+            {
+                if(mask & (1 << i))
+                {
+                    Zobrist::Castling[mask] ^= rightKeys[i];
+                }
+            }
+        }
+
+        for(int col = 0; col < 8; col++)
+        {
+            Zobrist::EnPassant[col] = nextKey(state);
+        }
+
+        Zobrist::Side = nextKey(state);
+        Zobrist::NoPawns = nextKey(state);
+    }
+};
+
+void Chess::Zobrist::init()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, buildKeys);
+}
@@ -1,4 +1,5 @@
 #include "../include/SDL/SDLWindow.h"
+#include "../include/Engine/Trace.h"
 
 SDLWindow::SDLWindow(std::string title, std::shared_ptr<LogManager> lm)
 {
@@ -209,6 +210,8 @@ void SDLWindow::drawFilledRect(SDL_Rect *rect, SDL_Color color)
 
 void SDLWindow::render()
 {   
+    CHESS_TRACE_SCOPE("present");
+
     // Render the buffer
     SDL_RenderPresent(this->renderer);
 }
@@ -0,0 +1,447 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/SearchPool.h"
+#include "../include/Engine/Syzygy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace Chess;
+
+    /**
+     * The outcome of a test. Skipped tests, such as ones needing files that are not
+     * there, exit with SKIP_EXIT_CODE so ctest reports them as skipped.
+     */
+    enum class Result
+    {
+        PASSED,
+        FAILED,
+        SKIPPED
+    };
+
+    constexpr int SKIP_EXIT_CODE = 77;
+
+    /**
+     * A position with its known perft count
+     */
+    struct PerftCase
+    {
+        const char* fen;
+        int depth;
+        uint64_t nodes;
+    };
+
+    // The usual perft positions of the Chess Programming Wiki: the start position,
+    // "Kiwipete", and positions full of en passant, promotion and castling traps
+    constexpr PerftCase PerftCases[] = {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603 },
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624 },
+        { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333 },
+        { "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 4, 422333 },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+        { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 }
+    };
+
+    // Starting points of the random games of the see and keys tests
+    constexpr const char* RandomGameFens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+    };
+
+    // Random games played from each of RandomGameFens, and their longest length
+    constexpr int RANDOM_GAMES = 200;
+    constexpr int RANDOM_GAME_PLIES = 200;
+
+    /**
+     * Plays random legal moves from each of RandomGameFens, calling visit(board) before
+     * every move. Returns false as soon as visit does.
+     */
+    template<typename Visit>
+    bool playRandomGames(Visit visit)
+    {
+        std::mt19937_64 random(20240611);
+        for(const char* fen : RandomGameFens)
+        {
+            for(int game = 0; game < RANDOM_GAMES; game++)
+            {
+                Board board;
+                board.setFen(fen);
+                for(int ply = 0; ply < RANDOM_GAME_PLIES; ply++)
+                {
+                    if(!visit(board))
+                    {
+                        return false;
+                    }
+
+                    MoveList legal;
+                    generateLegalMoves(board, legal);
+                    if(legal.size() == 0 || board.isDraw(0))
+                    {
+                        break;
+                    }
+                    board.makeMove(legal[int(random() % uint64_t(legal.size()))].move);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Leaf counts of the standard positions
+    Result testPerft()
+    {
+        bool passed = true;
+        for(const PerftCase& c : PerftCases)
+        {
+            Board board;
+            board.setFen(c.fen);
+            uint64_t nodes = perft(board, c.depth);
+            if(nodes != c.nodes)
+            {
+                std::cerr << "perft " << c.depth << " of " << c.fen << ": " << nodes << ", expected " << c.nodes << std::endl;
+                passed = false;
+            }
+        }
+        return passed ? Result::PASSED : Result::FAILED;
+    }
+
+    // seeGe agrees with see around the exchange's value for every capture of random
+    // positions. Promotions are left out, seeGe judges them as even by design.
+    Result testSee()
+    {
+        uint64_t captures = 0;
+        bool passed = playRandomGames([&captures](Board& board)
+        {
+            MoveList moves;
+            generateMoves<CAPTURES>(board, moves);
+            for(const ScoredMove& sm : moves)
+            {
+                Move m = sm.move;
+                if(m.isPromotion())
+                {
+                    continue;
+                }
+
+                int value = board.see(m);
+                for(int threshold = value - 1; threshold <= value + 1; threshold++)
+                {
+                    if(board.seeGe(m, threshold) != (value >= threshold))
+                    {
+                        std::cerr << "see of " << m.toUci() << " in " << board.fen() << " is " << value
+                                  << " but seeGe(" << threshold << ") is " << board.seeGe(m, threshold) << std::endl;
+                        return false;
+                    }
+                }
+                captures++;
+            }
+            return true;
+        });
+        std::cout << captures << " captures checked" << std::endl;
+        return passed ? Result::PASSED : Result::FAILED;
+    }
+
+    // The keys kept up to date by makeMove and unmakeMove equal those of the same
+    // position set up from its FEN
+    Result testKeys()
+    {
+        uint64_t positions = 0;
+        bool passed = playRandomGames([&positions](Board& board)
+        {
+            Board rebuilt;
+            rebuilt.setFen(board.fen());
+            if(board.key() != rebuilt.key() || board.pawnKey() != rebuilt.pawnKey())
+            {
+                std::cerr << "incremental keys of " << board.fen() << " differ from the FEN's" << std::endl;
+                return false;
+            }
+
+            // Every move, not only the one played, must be taken back exactly
+            MoveList legal;
+            generateLegalMoves(board, legal);
+            for(const ScoredMove& sm : legal)
+            {
+                uint64_t key = board.key(), pawnKey = board.pawnKey();
+                board.makeMove(sm.move);
+                board.unmakeMove(sm.move);
+                if(board.key() != key || board.pawnKey() != pawnKey)
+                {
+                    std::cerr << "keys of " << board.fen() << " change after " << sm.move.toUci() << " is taken back" << std::endl;
+                    return false;
+                }
+            }
+            positions++;
+            return true;
+        });
+        std::cout << positions << " positions checked" << std::endl;
+        return passed ? Result::PASSED : Result::FAILED;
+    }
+
+    // Pondering searches the test starts and the time each may take to report
+    constexpr int PONDER_SEARCHES = 50;
+    constexpr auto PONDER_TIMEOUT = std::chrono::seconds(5);
+
+    // A ponder hit sent right after a pondering search on a short clock is started still
+    // lets the clock end the search, however early it arrives
+    Result testPonderhit()
+    {
+        SearchPool pool;
+        pool.setHashSize(1);
+        Board board;
+        board.setStartPosition();
+
+        SearchLimits limits;
+        limits.ponder = true;
+        limits.time = 200;
+        for(int i = 0; i < PONDER_SEARCHES; i++)
+        {
+            std::atomic<bool> done = false;
+            pool.start(board, limits, nullptr, [&done](const SearchResult&) { done = true; });
+            pool.ponderhit();
+
+            auto deadline = std::chrono::steady_clock::now() + PONDER_TIMEOUT;
+            while(!done && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if(!done)
+            {
+                std::cerr << "search " << i << " still pondering after its ponder hit" << std::endl;
+                pool.stop();
+                pool.wait();
+                return Result::FAILED;
+            }
+            pool.wait();
+        }
+        return Result::PASSED;
+    }
+
+    // Writes a file of size bytes starting with header, the rest zeros
+    bool writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& header, size_t size)
+    {
+        std::vector<uint8_t> bytes(size);
+        std::copy(header.begin(), header.end(), bytes.begin());
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(size));
+        return bool(file);
+    }
+
+    // Probes that can not be answered fail cleanly and leave the board as it was: with
+    // no tables, with tables of other material, and with files that are not tables.
+    // Needs no real tables.
+    Result testSyzygy()
+    {
+        constexpr const char* fen = "7k/8/6K1/8/8/8/8/1Q6 w - - 0 1";
+        bool passed = true;
+        auto expectFail = [&passed](const char* setup)
+        {
+            Board board;
+            board.setFen(fen);
+            Syzygy::ProbeState wdlState, dtzState;
+            Syzygy::probeWdl(board, wdlState);
+            Syzygy::probeDtz(board, dtzState);
+            std::vector<Syzygy::RootMove> moves;
+            bool ranked = Syzygy::rootProbe(board, moves) || Syzygy::rootProbeWdl(board, moves);
+            if(wdlState != Syzygy::ProbeState::FAIL || dtzState != Syzygy::ProbeState::FAIL || ranked || board.fen() != fen)
+            {
+                std::cerr << "probing KQvK " << setup << " did not fail cleanly" << std::endl;
+                passed = false;
+            }
+        };
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "chess_tests_syzygy";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        if(Syzygy::init((directory / "missing").string()) != 0 || Syzygy::maxPieces() != 0)
+        {
+            std::cerr << "a missing directory has tables" << std::endl;
+            passed = false;
+        }
+        expectFail("without tables");
+
+        // A table of other material is found but never used for KQvK
+        const std::vector<uint8_t> wdlMagic = { 0x71, 0xE8, 0x23, 0x5D };
+        writeFile(directory / "KRvK.rtbw", wdlMagic, 64 * 4 + 16);
+        writeFile(directory / "notes.txt", {}, 100);
+        writeFile(directory / "KXvK.rtbw", wdlMagic, 64 + 16);
+        if(Syzygy::init(directory.string()) != 1 || Syzygy::maxPieces() != 3)
+        {
+            std::cerr << "expected only KRvK among the files of " << directory << std::endl;
+            passed = false;
+        }
+        expectFail("with only a KRvK table");
+
+        // Files with a wrong magic, a wrong size, and a right magic followed by a layout
+        // that makes no sense
+        uint64_t failures = Syzygy::stats().failures;
+        const std::vector<std::vector<uint8_t>> headers = { { 1, 2, 3, 4 }, wdlMagic, wdlMagic };
+        const size_t sizes[] = { 64 + 16, 64 + 17, 64 * 64 + 16 };
+        for(int i = 0; i < 3; i++)
+        {
+            writeFile(directory / "KQvK.rtbw", headers[i], sizes[i]);
+            Syzygy::init(directory.string());
+            expectFail("with a broken table");
+        }
+        if(Syzygy::stats().failures < failures + 3)
+        {
+            std::cerr << "broken tables were not counted as failures" << std::endl;
+            passed = false;
+        }
+
+        Syzygy::init("");
+        std::filesystem::remove_all(directory);
+        return passed ? Result::PASSED : Result::FAILED;
+    }
+
+    /**
+     * A tablebase position with its known outcome. dtz is the exact distance when
+     * exactDtz is set, otherwise only its sign is checked. best, if set, is the only
+     * move keeping the result: rootProbe must rank it above every other move.
+     */
+    struct TableCase
+    {
+        const char* fen;
+        Syzygy::WdlScore wdl;
+        int dtz;
+        bool exactDtz;
+        const char* best;
+    };
+
+    // Positions whose outcome follows from a move or two of play, so the values do not
+    // depend on trusting another prober
+    constexpr TableCase TableCases[] = {
+        // KQvK: Qb8 mates, and the losing side to move
+        { "7k/8/6K1/8/8/8/8/1Q6 w - - 0 1", Syzygy::WDL_WIN, 1, true, nullptr },
+        { "7k/8/6K1/8/8/8/8/1Q6 b - - 0 1", Syzygy::WDL_LOSS, -1, false, nullptr },
+
+        // KRvK: Ra8 mates
+        { "7k/8/6K1/8/8/8/8/R7 w - - 0 1", Syzygy::WDL_WIN, 1, true, nullptr },
+
+        // KPvK: the pawn queens at once, and the defending king in front of the pawn
+        { "8/4P3/8/8/8/8/k7/4K3 w - - 0 1", Syzygy::WDL_WIN, 1, true, nullptr },
+        { "8/8/8/8/8/4k3/4P3/4K3 w - - 0 1", Syzygy::WDL_DRAW, 0, true, nullptr },
+
+        // KRPvKR: only taking the rook wins, anything else lets it take the pawn or rook
+        { "4k3/8/8/8/8/8/r3P3/R3K3 w - - 0 1", Syzygy::WDL_WIN, 1, true, "a1a2" }
+    };
+
+    // The known outcomes of TableCases with the tables in CHESS_SYZYGY_PATH. Skipped
+    // when it is not set.
+    Result testSyzygyTables()
+    {
+        const char* path = std::getenv("CHESS_SYZYGY_PATH");
+        if(path == nullptr || *path == '\0')
+        {
+            std::cout << "CHESS_SYZYGY_PATH is not set" << std::endl;
+            return Result::SKIPPED;
+        }
+        if(Syzygy::init(path) == 0 || Syzygy::maxPieces() < 4)
+        {
+            std::cerr << "no tables of up to 4 pieces in " << path << std::endl;
+            return Result::FAILED;
+        }
+
+        bool passed = true;
+        for(const TableCase& c : TableCases)
+        {
+            Board board;
+            board.setFen(c.fen);
+            Syzygy::ProbeState wdlState, dtzState;
+            Syzygy::WdlScore wdl = Syzygy::probeWdl(board, wdlState);
+            int dtz = Syzygy::probeDtz(board, dtzState);
+            bool dtzRight = c.exactDtz ? dtz == c.dtz : (dtz > 0) == (c.dtz > 0) && (dtz < 0) == (c.dtz < 0);
+            if(wdlState == Syzygy::ProbeState::FAIL || dtzState == Syzygy::ProbeState::FAIL || wdl != c.wdl || !dtzRight)
+            {
+                std::cerr << c.fen << ": wdl " << wdl << " dtz " << dtz << ", expected wdl " << c.wdl << " dtz " << c.dtz << std::endl;
+                passed = false;
+            }
+
+            std::vector<Syzygy::RootMove> moves;
+            if(!Syzygy::rootProbe(board, moves) || moves.empty())
+            {
+                std::cerr << c.fen << ": root moves could not be ranked" << std::endl;
+                passed = false;
+                continue;
+            }
+
+            // The best rank is the position's outcome seen from the root
+            int best = moves[0].rank;
+            if((best > 0) != (c.wdl > 0) || (best < 0) != (c.wdl < 0))
+            {
+                std::cerr << c.fen << ": best root move " << moves[0].move.toUci() << " has rank " << best << std::endl;
+                passed = false;
+            }
+            if(c.best != nullptr && (moves[0].move.toUci() != c.best || (moves.size() > 1 && moves[1].rank >= best)))
+            {
+                std::cerr << c.fen << ": " << c.best << " is not ranked above every other move" << std::endl;
+                passed = false;
+            }
+        }
+        Syzygy::init("");
+        return passed ? Result::PASSED : Result::FAILED;
+    }
+
+    /**
+     * A test ctest can run by name
+     */
+    struct Test
+    {
+        const char* name;
+        Result (*run)();
+    };
+
+    constexpr Test Tests[] = {
+        { "perft", testPerft },
+        { "see", testSee },
+        { "keys", testKeys },
+        { "ponderhit", testPonderhit },
+        { "syzygy", testSyzygy },
+        { "syzygy_tables", testSyzygyTables }
+    };
+};
+
+/**
+ * Checks of the engine's move generation, static exchange evaluation, Zobrist keys,
+ * pondering and tablebase probing, registered with ctest one test per name.
+ *
+ * Usage: chess_tests [name...]
+ * Runs the named tests, or every test without names. Exits with 1 if any fails and with
+ * 77 if every test run was skipped.
+ */
+int main(int argc, char** argv)
+{
+    bool passed = true, skipped = true;
+    for(const Test& test : Tests)
+    {
+        bool selected = argc == 1;
+        for(int i = 1; i < argc; i++)
+        {
+            selected = selected || std::strcmp(argv[i], test.name) == 0;
+        }
+        if(!selected)
+        {
+            continue;
+        }
+
+        Result result = test.run();
+        std::cout << test.name << ": " << (result == Result::PASSED ? "passed" : result == Result::FAILED ? "FAILED" : "skipped") << std::endl;
+        passed = passed && result != Result::FAILED;
+        skipped = skipped && result == Result::SKIPPED;
+    }
+    return !passed ? 1 : skipped ? SKIP_EXIT_CODE : 0;
+}
@@ -0,0 +1,233 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/Epd.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace Chess;
+
+    // Budget per position when none is given
+    constexpr uint64_t DEFAULT_NODES = 1000000;
+
+    // Hash table megabytes per worker when none is given
+    constexpr size_t DEFAULT_HASH_MB = 16;
+
+    /**
+     * Results of finished positions, written out in input order as soon as every earlier
+     * position is done
+     */
+    class OrderedWriter
+    {
+        public:
+            OrderedWriter(std::ostream& out, size_t count) : out(out), lines(count), done(count, false) {}
+
+            // Stores the line of a position and writes every line that is now next in order
+            void finish(size_t index, std::string line)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->lines[index] = std::move(line);
+                this->done[index] = true;
+                while(this->next < this->lines.size() && this->done[this->next])
+                {
+                    this->out << this->lines[this->next] << '\n';
+                    std::string().swap(this->lines[this->next]);
+                    this->next++;
+                }
+                this->out.flush();
+            }
+
+        private:
+            std::ostream& out;
+            std::mutex mutex;
+            std::vector<std::string> lines;
+            std::vector<bool> done;
+
+            // First position not written yet
+            size_t next = 0;
+    };
+
+    // The position of a board as EPD, without move counters
+    std::string epdPosition(const Board& board)
+    {
+        char fen[Fen::MAX_LENGTH];
+        std::string_view text(fen, board.writeFen(fen));
+        return std::string(text.substr(0, text.rfind(' ', text.rfind(' ') - 1)));
+    }
+
+    // The result of a search as an EPD line: best move, centipawn score (and moves to mate
+    // if there is one), depth, nodes and principal variation, all in SAN, followed by the
+    // input's id if it has one
+    std::string formatResult(Board& board, const SearchResult& result, std::string_view id)
+    {
+        std::ostringstream line;
+        line << epdPosition(board);
+        if(result.bestMove.isValid())
+        {
+            line << " bm " << toSan(board, result.bestMove) << ";";
+        }
+        line << " ce " << result.score << ";";
+        if(std::abs(result.score) >= VALUE_MATE_IN_MAX_PLY)
+        {
+            int moves = result.score > 0 ? (VALUE_MATE - result.score + 1) / 2 : -(VALUE_MATE + result.score) / 2;
+            line << " dm " << moves << ";";
+        }
+        line << " acd " << result.depth << "; acn " << result.stats.nodes << ";";
+
+        if(result.pvLength > 0)
+        {
+            line << " pv";
+            for(int i = 0; i < result.pvLength; i++)
+            {
+                line << " " << toSan(board, result.pv[i]);
+                board.makeMove(result.pv[i]);
+            }
+            for(int i = result.pvLength - 1; i >= 0; i--)
+            {
+                board.unmakeMove(result.pv[i]);
+            }
+            line << ";";
+        }
+        if(!id.empty())
+        {
+            line << " id \"" << id << "\";";
+        }
+        return line.str();
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/**
+ * Analyses every position of an EPD file on a pool of workers, each an independent
+ * single threaded search with its own hash table. Workers take the next position as
+ * soon as they finish one; results are written as EPD lines in input order as soon as
+ * every earlier position is done.
+ *
+ * Each position starts from an empty hash table and history, so a node limited run gives
+ * the same output whatever the number of workers.
+ *
+ * Usage: chess_analyze <input.epd> <output.epd> [--nodes n] [--movetime ms] [--depth d]
+ *                      [--workers n] [--hash mb]
+ * --hash is per worker. Without a limit each position gets a million nodes.
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: chess_analyze <input.epd> <output.epd> [--nodes n] [--movetime ms] [--depth d] [--workers n] [--hash mb]"
+                  << std::endl;
+        return 1;
+    }
+
+    SearchLimits limits;
+    int workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    size_t hashMb = DEFAULT_HASH_MB;
+    for(int i = 3; i + 1 < argc; i += 2)
+    {
+        if(std::strcmp(argv[i], "--nodes") == 0)
+        {
+            limits.nodes = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if(std::strcmp(argv[i], "--movetime") == 0)
+        {
+            limits.movetime = std::atoll(argv[i + 1]);
+        }
+        else if(std::strcmp(argv[i], "--depth") == 0)
+        {
+            limits.depth = std::clamp(std::atoi(argv[i + 1]), 1, MAX_PLY - 1);
+        }
+        else if(std::strcmp(argv[i], "--workers") == 0)
+        {
+            workers = std::max(1, std::atoi(argv[i + 1]));
+        }
+        else if(std::strcmp(argv[i], "--hash") == 0)
+        {
+            hashMb = size_t(std::max(1, std::atoi(argv[i + 1])));
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if(limits.nodes == 0 && limits.movetime == 0 && limits.depth == MAX_PLY - 1)
+    {
+        limits.nodes = DEFAULT_NODES;
+    }
+
+    EpdFile epd;
+    if(!epd.load(argv[1]))
+    {
+        std::cerr << "Could not read " << argv[1] << std::endl;
+        return 1;
+    }
+    std::ofstream output(argv[2], std::ios::trunc);
+    if(!output)
+    {
+        std::cerr << "Could not write " << argv[2] << std::endl;
+        return 1;
+    }
+    workers = int(std::min<size_t>(size_t(workers), std::max<size_t>(epd.size(), 1)));
+
+    auto start = std::chrono::steady_clock::now();
+    OrderedWriter writer(output, epd.size());
+    std::atomic<size_t> nextPosition{0};
+    std::atomic<uint64_t> totalNodes{0};
+    auto work = [&]()
+    {
+        TranspositionTable tt(hashMb);
+        Searcher searcher(tt);
+        Board board;
+        uint64_t nodes = 0;
+        for(size_t index = nextPosition++; index < epd.size(); index = nextPosition++)
+        {
+            tt.clear();
+            searcher.clearHistory();
+            searcher.newSearch();
+            board.setPosition(epd.position(index));
+            SearchResult result = searcher.think(board, limits);
+            nodes += result.stats.nodes;
+            writer.finish(index, formatResult(board, result, epd.operation(index, "id")));
+        }
+        totalNodes += nodes;
+    };
+
+    std::vector<std::thread> threads;
+    for(int i = 1; i < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    double seconds = secondsSince(start);
+    std::cout << "Positions: " << epd.size() << " on " << workers << " workers in " << std::fixed << std::setprecision(2)
+              << seconds << " s" << std::endl;
+    std::cout << "Positions/s: " << std::setprecision(1) << epd.size() / std::max(seconds, 1e-9)
+              << ", nodes/s: " << std::setprecision(0) << totalNodes / std::max(seconds, 1e-9) << std::endl;
+    if(epd.getSkippedLines() > 0)
+    {
+        std::cout << "Skipped " << epd.getSkippedLines() << " invalid lines" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "../include/Engine/GameArchive.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    // Games read at random positions by the random access benchmark
+    constexpr uint64_t RANDOM_READS = 100000;
+
+    // Prints the rate of one benchmark run. Runs that do not replay the moves get no
+    // plies rate, only a blank column.
+    void report(const char* name, uint64_t games, uint64_t plies, double seconds, uint64_t checksum, bool replayed = true)
+    {
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << games / seconds / 1000.0 << " games/ms";
+        if(replayed)
+        {
+            std::cout << std::setprecision(1) << std::setw(10) << plies / seconds / 1e6 << " Mplies/s";
+        }
+        else
+        {
+            std::cout << std::setw(19) << "";
+        }
+        std::cout << std::setprecision(3) << std::setw(10) << seconds << " s"
+                  << "   checksum " << std::hex << checksum << std::dec << std::endl;
+    }
+
+    // Times reading a whole archive with and without replaying the moves, reading games
+    // at random through the index and replaying on several threads
+    int bench(const std::string& path, int threads)
+    {
+        Archive::Reader reader;
+        if(!reader.open(path))
+        {
+            std::cerr << "Could not read " << path << std::endl;
+            return 1;
+        }
+        std::cout << "Games: " << reader.size() << ", strings: " << reader.stringCount() << ", "
+                  << std::fixed << std::setprecision(1) << reader.fileSize() / 1048576.0 << " MB" << std::endl;
+
+        // Result counts only need the record headers
+        uint64_t results[4] = {};
+        uint64_t plies = 0;
+        auto start = std::chrono::steady_clock::now();
+        reader.read([&](const Archive::Game& game)
+        {
+            results[int(game.result)]++;
+            plies += uint64_t(game.plies);
+        }, false);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("headers", reader.size(), plies, seconds, results[1] * 3 + results[2] * 5 + results[3] * 7, false);
+
+        uint64_t checksum = 0;
+        start = std::chrono::steady_clock::now();
+        uint64_t corrupt = reader.read([&](const Archive::Game& game)
+        {
+            for(int i = 0; i < game.plies; i++)
+            {
+                checksum += game.moves[i].raw() * uint64_t(i + 1);
+            }
+        });
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("replay", reader.size(), plies, seconds, checksum);
+
+        std::mt19937_64 random(1);
+        Archive::Game game;
+        uint64_t randomPlies = 0;
+        checksum = 0;
+        start = std::chrono::steady_clock::now();
+        for(uint64_t i = 0; i < RANDOM_READS && reader.size() > 0; i++)
+        {
+            if(reader.game(random() % reader.size(), game) && game.plies > 0)
+            {
+                randomPlies += uint64_t(game.plies);
+                checksum += game.moves[game.plies - 1].raw();
+            }
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("random replay", reader.size() ? RANDOM_READS : 0, randomPlies, seconds, checksum);
+
+        std::atomic<uint64_t> parallelChecksum = 0;
+        start = std::chrono::steady_clock::now();
+        corrupt += Archive::readParallel(path, threads, [&](const Archive::Game& game, int)
+        {
+            uint64_t sum = 0;
+            for(int i = 0; i < game.plies; i++)
+            {
+                sum += game.moves[i].raw() * uint64_t(i + 1);
+            }
+            parallelChecksum += sum;
+        });
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::string name = "replay, " + std::to_string(threads) + " thr";
+        report(name.c_str(), reader.size(), plies, seconds, parallelChecksum);
+
+        if(corrupt)
+        {
+            std::cerr << corrupt << " corrupt games" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+};
+
+/**
+ * Converts between PGN and the binary game archive, and benchmarks reading archives.
+ *
+ * Usage: chess_archive pack <pgn> <archive>
+ *        chess_archive unpack <archive> <pgn>
+ *        chess_archive bench <archive> [threads]
+ */
+int main(int argc, char** argv)
+{
+    if((argc == 3 || argc == 4) && std::strcmp(argv[1], "bench") == 0)
+    {
+        return bench(argv[2], argc == 4 ? std::atoi(argv[3]) : int(std::thread::hardware_concurrency()));
+    }
+    if(argc != 4 || (std::strcmp(argv[1], "pack") != 0 && std::strcmp(argv[1], "unpack") != 0))
+    {
+        std::cerr << "Usage: chess_archive pack <pgn> <archive> | unpack <archive> <pgn> | bench <archive> [threads]" << std::endl;
+        return 1;
+    }
+
+    bool pack = std::strcmp(argv[1], "pack") == 0;
+    Archive::ConvertStats stats;
+    auto start = std::chrono::steady_clock::now();
+    bool converted = pack ? Archive::fromPgn(argv[2], argv[3], stats) : Archive::toPgn(argv[2], argv[3], stats);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(!converted)
+    {
+        std::cerr << "Could not convert " << argv[2] << " to " << argv[3] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Games: " << stats.games << ", plies: " << stats.plies << ", errors: " << stats.errors
+              << ", " << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,485 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/Evaluation.h"
+#include "../include/Engine/Fen.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Pawns.h"
+#include "../include/Engine/Trace.h"
+#include "../include/Engine/TranspositionTable.h"
+#include "../include/Engine/Zobrist.h"
+
+#ifdef CHESS_BENCH_GUI
+#include "../include/Chess/Chess.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Every allocation made by the process, counted by the operators below
+    std::atomic<uint64_t> allocations{0};
+};
+
+// Counting replacements of the global allocation functions, so each benchmark can report
+// how many allocations an operation makes. Deallocation is left to the usual functions.
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = std::size_t(alignment);
+    if(void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace
+{
+    using namespace Chess;
+
+    // Each benchmark repeats its batch until it ran at least this long
+    constexpr int DEFAULT_MIN_MILLISECONDS = 300;
+
+    // Positions move generation is measured on, one per kind of position
+    constexpr const char* OPENING_FEN = START_FEN;
+    constexpr const char* MIDDLEGAME_FEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    constexpr const char* ENDGAME_FEN = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1";
+    constexpr const char* CHECK_FEN = "r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4";
+    constexpr const char* PROMOTION_FEN = "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1";
+
+    // Results are added here so the compiler can not drop the work
+    volatile uint64_t sink = 0;
+
+    /**
+     * One microbenchmark. run performs a batch of operations and returns how many.
+     */
+    struct Benchmark
+    {
+        std::string name;
+        std::function<uint64_t()> run;
+    };
+
+    struct Measurement
+    {
+        std::string name;
+        uint64_t operations;
+        double nsPerOp;
+        double allocationsPerOp;
+    };
+
+    Measurement measure(const Benchmark& benchmark, int minMilliseconds)
+    {
+        // One untimed batch warms caches and lazily built tables
+        sink = sink + benchmark.run();
+
+        uint64_t operations = 0;
+        uint64_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds elapsed{0};
+        while(elapsed < std::chrono::milliseconds(minMilliseconds))
+        {
+            operations += benchmark.run();
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        uint64_t allocated = allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        return { benchmark.name, operations, double(elapsed.count()) / double(operations), double(allocated) / double(operations) };
+    }
+
+    void addMoveGeneration(std::vector<Benchmark>& benchmarks, const std::string& kind, const char* fen)
+    {
+        auto board = std::make_shared<Board>();
+        board->setFen(fen);
+        benchmarks.push_back({ "movegen/legal/" + kind, [board]()
+        {
+            MoveList moves;
+            for(int i = 0; i < 1000; i++)
+            {
+                moves.clear();
+                generateLegalMoves(*board, moves);
+                sink = sink + uint64_t(moves.size());
+            }
+            return uint64_t(1000);
+        }});
+        benchmarks.push_back({ "movegen/pseudo/" + kind, [board]()
+        {
+            MoveList moves;
+            for(int i = 0; i < 1000; i++)
+            {
+                moves.clear();
+                generateMoves<ALL>(*board, moves);
+                sink = sink + uint64_t(moves.size());
+            }
+            return uint64_t(1000);
+        }});
+    }
+
+    std::vector<Benchmark> engineBenchmarks()
+    {
+        std::vector<Benchmark> benchmarks;
+        addMoveGeneration(benchmarks, "opening", OPENING_FEN);
+        addMoveGeneration(benchmarks, "middlegame", MIDDLEGAME_FEN);
+        addMoveGeneration(benchmarks, "endgame", ENDGAME_FEN);
+        addMoveGeneration(benchmarks, "check", CHECK_FEN);
+        addMoveGeneration(benchmarks, "promotion", PROMOTION_FEN);
+
+        // Every legal move of a busy position made and taken back
+        benchmarks.push_back({ "board/make_unmake", []()
+        {
+            static Board board;
+            static MoveList moves;
+            if(moves.size() == 0)
+            {
+                board.setFen(MIDDLEGAME_FEN);
+                generateLegalMoves(board, moves);
+            }
+            for(const ScoredMove& move : moves)
+            {
+                board.makeMove(move.move);
+                sink = sink + board.key();
+                board.unmakeMove(move.move);
+            }
+            return uint64_t(moves.size());
+        }});
+
+        // The legal quiet moves of the same position made and taken back: the updates of
+        // the keys, the piece-square sums and the accumulators with no capture to undo
+        benchmarks.push_back({ "board/make_unmake_quiet", []()
+        {
+            static Board board;
+            static MoveList moves;
+            if(moves.size() == 0)
+            {
+                board.setFen(MIDDLEGAME_FEN);
+                MoveList legal;
+                generateLegalMoves(board, legal);
+                for(const ScoredMove& move : legal)
+                {
+                    if(!move.move.isNoisy())
+                    {
+                        moves.add(move.move);
+                    }
+                }
+            }
+            for(const ScoredMove& move : moves)
+            {
+                board.makeMove(move.move);
+                sink = sink + board.key();
+                board.unmakeMove(move.move);
+            }
+            return uint64_t(moves.size());
+        }});
+
+        // The key of a position from scratch
+        benchmarks.push_back({ "zobrist/full", []()
+        {
+            static Board board;
+            static bool ready = false;
+            if(!ready)
+            {
+                ready = board.setFen(MIDDLEGAME_FEN);
+            }
+            for(int i = 0; i < 1000; i++)
+            {
+                Bitboard pieces = board.pieces();
+                uint64_t key = 0;
+                while(pieces)
+                {
+                    Square s = Bitboards::popLsb(pieces);
+                    key ^= Zobrist::PieceSquare[board.pieceOn(s)][s];
+                }
+                key ^= Zobrist::Castling[board.castlingRights()] ^ (board.sideToMove() == BLACK ? Zobrist::Side : 0);
+                sink = sink + key;
+            }
+            return uint64_t(1000);
+        }});
+
+        // Static evaluation with a warm pawn table, as in the search
+        benchmarks.push_back({ "eval/middlegame", []()
+        {
+            static Board board;
+            static PawnTable pawns;
+            static bool ready = false;
+            if(!ready)
+            {
+                ready = board.setFen(MIDDLEGAME_FEN);
+            }
+            for(int i = 0; i < 1000; i++)
+            {
+                sink = sink + uint64_t(evaluate(board, pawns));
+            }
+            return uint64_t(1000);
+        }});
+
+        // Exchange evaluation of every capture of a tactical position
+        benchmarks.push_back({ "see/captures", []()
+        {
+            static Board board;
+            static MoveList captures;
+            if(captures.size() == 0)
+            {
+                board.setFen(MIDDLEGAME_FEN);
+                MoveList moves;
+                generateLegalMoves(board, moves);
+                for(const ScoredMove& move : moves)
+                {
+                    if(move.move.isCapture())
+                    {
+                        captures.add(move.move);
+                    }
+                }
+            }
+            for(int i = 0; i < 100; i++)
+            {
+                for(const ScoredMove& move : captures)
+                {
+                    sink = sink + uint64_t(board.see(move.move));
+                }
+            }
+            return uint64_t(100 * captures.size());
+        }});
+
+        // Random keys spread over the whole table, so most accesses miss the caches
+        benchmarks.push_back({ "tt/store_probe", []()
+        {
+            static TranspositionTable tt(TranspositionTable::DEFAULT_SIZE_MB);
+            static std::mt19937_64 random(1);
+            TTEntry entry;
+            for(int i = 0; i < 1000; i++)
+            {
+                uint64_t key = random();
+                tt.store(key, Move(), i, i, i & 15, BOUND_EXACT);
+                sink = sink + uint64_t(tt.probe(key, entry)) + uint64_t(tt.probe(key ^ 1, entry));
+            }
+            return uint64_t(1000);
+        }});
+
+        // Text to a plain position, and on to a board with keys and check information
+        benchmarks.push_back({ "fen/parse", []()
+        {
+            Fen::Position position;
+            for(int i = 0; i < 1000; i++)
+            {
+                sink = sink + Fen::parse(i & 1 ? MIDDLEGAME_FEN : ENDGAME_FEN, position);
+            }
+            return uint64_t(1000);
+        }});
+        benchmarks.push_back({ "fen/set_board", []()
+        {
+            static Board board;
+            for(int i = 0; i < 1000; i++)
+            {
+                sink = sink + uint64_t(board.setFen(i & 1 ? MIDDLEGAME_FEN : ENDGAME_FEN));
+            }
+            return uint64_t(1000);
+        }});
+
+#ifdef CHESS_TRACE
+        // A span while recording and while not, the cost every instrumented function pays
+        benchmarks.push_back({ "trace/span", []()
+        {
+            Trace::start(1 << 16);
+            for(int i = 0; i < 1000; i++)
+            {
+                CHESS_TRACE_SCOPE("bench");
+            }
+            Trace::stop();
+            return uint64_t(1000);
+        }});
+        benchmarks.push_back({ "trace/span_off", []()
+        {
+            for(int i = 0; i < 1000; i++)
+            {
+                CHESS_TRACE_SCOPE("bench");
+                sink = sink + 1;
+            }
+            return uint64_t(1000);
+        }});
+#endif
+        return benchmarks;
+    }
+
+#ifdef CHESS_BENCH_GUI
+    /**
+     * A game and a window drawn with SDL's dummy video driver and software renderer, so
+     * the GUI benchmarks run on machines without a display. Created on first use.
+     */
+    struct GuiState
+    {
+        std::shared_ptr<LogManager> lm;
+        std::unique_ptr<GameApplication> game;
+        std::unique_ptr<SDLWindow> window;
+    };
+
+    GuiState& gui()
+    {
+        static GuiState state = []()
+        {
+            setenv("SDL_VIDEODRIVER", "dummy", 0);
+            setenv("SDL_RENDER_DRIVER", "software", 0);
+            static char name[] = "chess_bench";
+            static char* arguments[] = { name, nullptr };
+            GuiState created;
+            created.lm = std::make_shared<LogManager>(1, arguments);
+            created.game = std::make_unique<GameApplication>(created.lm);
+            created.window = std::make_unique<SDLWindow>("chess_bench", created.lm);
+            created.window->createWindow();
+            return created;
+        }();
+        return state;
+    }
+
+    void addGuiBenchmarks(std::vector<Benchmark>& benchmarks)
+    {
+        // One piece image loaded, uploaded and drawn, as every piece is each frame
+        benchmarks.push_back({ "gui/draw_image", []()
+        {
+            static std::string path = "../src/Assets/ChessPieces/Theme/Default/White/queen.png";
+            SDL_Rect rect = { 0, 0, 100, 100 };
+            for(int i = 0; i < 10; i++)
+            {
+                gui().window->drawImage(&path, &rect);
+            }
+            return uint64_t(10);
+        }});
+
+        // A whole frame: drawChessBoard, the pieces and presenting
+        benchmarks.push_back({ "gui/draw_frame", []()
+        {
+            gui().game->drawFrame();
+            return uint64_t(1);
+        }});
+    }
+#endif
+
+    void writeJson(std::ostream& out, const std::vector<Measurement>& measurements)
+    {
+        out << "{\n  \"benchmarks\": [\n";
+        for(size_t i = 0; i < measurements.size(); i++)
+        {
+            const Measurement& m = measurements[i];
+            out << "    { \"name\": \"" << m.name << "\", \"operations\": " << m.operations << ", \"ns_per_op\": "
+                << std::fixed << std::setprecision(2) << m.nsPerOp << ", \"allocs_per_op\": " << std::setprecision(4)
+                << m.allocationsPerOp << " }" << (i + 1 < measurements.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+};
+
+/**
+ * Microbenchmarks of the engine's hot paths, and of the GUI's drawing when it is built
+ * with the GUI. Each reports nanoseconds and allocations per operation; --json writes the
+ * results as JSON too ("-" for standard output) so they can be compared between commits.
+ * The GUI benchmarks load the piece images relative to the build directory, like the game.
+ *
+ * Usage: chess_bench [--filter <text>] [--min-time <ms>] [--json <file>]
+ */
+int main(int argc, char** argv)
+{
+    std::string filter, jsonPath;
+    int minMilliseconds = DEFAULT_MIN_MILLISECONDS;
+    for(int i = 1; i < argc; i++)
+    {
+        // Every option takes a value
+        const char* option = argv[i];
+        if(std::strcmp(option, "--filter") != 0 && std::strcmp(option, "--min-time") != 0 && std::strcmp(option, "--json") != 0)
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+        if(++i == argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+
+        if(std::strcmp(option, "--filter") == 0)
+        {
+            filter = argv[i];
+        }
+        else if(std::strcmp(option, "--min-time") == 0)
+        {
+            minMilliseconds = std::max(1, std::atoi(argv[i]));
+        }
+        else
+        {
+            jsonPath = argv[i];
+        }
+    }
+
+    // Sets up the attack tables and keys before anything is timed
+    Board setup;
+
+    std::vector<Benchmark> benchmarks = engineBenchmarks();
+#ifdef CHESS_BENCH_GUI
+    addGuiBenchmarks(benchmarks);
+#endif
+
+    std::vector<Measurement> measurements;
+    for(const Benchmark& benchmark : benchmarks)
+    {
+        if(!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        Measurement m = measure(benchmark, minMilliseconds);
+        std::cout << std::left << std::setw(28) << m.name << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                  << m.nsPerOp << " ns/op" << std::setprecision(3) << std::setw(10) << m.allocationsPerOp << " allocs/op"
+                  << std::endl;
+        measurements.push_back(m);
+    }
+
+    if(jsonPath == "-")
+    {
+        writeJson(std::cout, measurements);
+    }
+    else if(!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath, std::ios::trunc);
+        writeJson(file, measurements);
+        if(!file)
+        {
+            std::cerr << "Could not write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "../include/Engine/Bitbase.h"
+#include "../include/Engine/Board.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    void printStats(const Bitbase::GenerateStats& stats)
+    {
+        std::cout << "Positions: " << stats.positions << ", possible: " << stats.legal << std::endl;
+        std::cout << "Wins: " << stats.wins << ", draws: " << stats.draws << ", losses: " << stats.losses << std::endl;
+        std::cout << "Passes: " << stats.passes << ", smaller endgames: " << stats.subtables << std::endl;
+        std::cout << "Memory: " << std::fixed << std::setprecision(1) << stats.memoryBytes / (1024.0 * 1024.0) << " MiB, time: "
+                  << std::setprecision(2) << stats.seconds << " s" << std::endl;
+    }
+
+    int generate(const std::string& signature, const std::string& path, int threads)
+    {
+        Bitbase::GenerateStats stats;
+        if(!Bitbase::generate(signature, path, threads, stats))
+        {
+            std::cerr << "Invalid endgame " << signature << " or could not write " << path << std::endl;
+            return 1;
+        }
+        std::cout << Bitbase::normalize(signature) << " on " << threads << " threads" << std::endl;
+        printStats(stats);
+        return 0;
+    }
+
+    int probe(const std::string& path, const std::string& fen)
+    {
+        Bitbase bitbase;
+        Board board;
+        if(!bitbase.open(path) || !board.setFen(fen))
+        {
+            std::cerr << "Could not read " << path << " or invalid FEN " << fen << std::endl;
+            return 1;
+        }
+
+        const char* names[] = { "not in the bitbase", "win", "loss", "draw" };
+        std::cout << bitbase.signature() << ": " << names[bitbase.probe(board)] << " for the side to move" << std::endl;
+        return 0;
+    }
+
+    // Generates an endgame on 1, 2, 4... threads up to maxThreads without writing it
+    int scaling(const std::string& signature, int maxThreads)
+    {
+        double single = 0;
+        for(int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+        {
+            Bitbase::GenerateStats stats;
+            if(!Bitbase::generate(signature, "", threads, stats))
+            {
+                std::cerr << "Invalid endgame " << signature << std::endl;
+                return 1;
+            }
+            if(threads == 1)
+            {
+                single = stats.seconds;
+            }
+            std::cout << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(2) << std::setw(8)
+                      << stats.seconds << " s, speedup " << single / std::max(stats.seconds, 1e-9) << std::endl;
+            if(threads == maxThreads)
+            {
+                break;
+            }
+        }
+        return 0;
+    }
+};
+
+/**
+ * Generates, probes and measures endgame bitbases. Endgames are written like KQKR:
+ * white's pieces starting with its king, then black's.
+ *
+ * Usage: chess_bitbase gen <endgame> <file> [threads]
+ *        chess_bitbase probe <file> <fen>
+ *        chess_bitbase scaling <endgame> [max threads]
+ */
+int main(int argc, char** argv)
+{
+    int hardware = int(std::max(1u, std::thread::hardware_concurrency()));
+    if(argc < 3)
+    {
+        std::cerr << "Usage: chess_bitbase gen <endgame> <file> [threads] | probe <file> <fen> | scaling <endgame> [max threads]"
+                  << std::endl;
+        return 1;
+    }
+
+    if(std::strcmp(argv[1], "gen") == 0 && argc >= 4)
+    {
+        return generate(argv[2], argv[3], argc > 4 ? std::max(1, std::atoi(argv[4])) : hardware);
+    }
+    if(std::strcmp(argv[1], "probe") == 0 && argc >= 4)
+    {
+        // The FEN may be quoted or given as separate fields
+        std::string fen = argv[3];
+        for(int i = 4; i < argc; i++)
+        {
+            fen += std::string(" ") + argv[i];
+        }
+        return probe(argv[2], fen);
+    }
+    if(std::strcmp(argv[1], "scaling") == 0)
+    {
+        return scaling(argv[2], argc > 3 ? std::max(1, std::atoi(argv[3])) : hardware);
+    }
+
+    std::cerr << "Unknown command " << argv[1] << std::endl;
+    return 1;
+}
@@ -0,0 +1,240 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/GameArchive.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Polyglot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    using namespace Chess;
+
+    // Plies of each game that go into a book by default
+    constexpr int DEFAULT_BOOK_PLIES = 16;
+
+    // Random positions probed by the benchmark and the longest random line leading to one
+    constexpr int BENCH_PROBES = 100000;
+    constexpr int BENCH_MAX_PLIES = 12;
+
+    // Writes a number big-endian, as Polyglot books store them
+    void writeBigEndian(std::ofstream& file, uint64_t value, int size)
+    {
+        for(int i = size - 1; i >= 0; i--)
+        {
+            file.put(char((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    // Builds a book from the first plies of every game of an archive. A move's weight is
+    // 2 for each win and 1 for each draw or unknown result of the side that played it;
+    // moves that only ever lost are left out, like Polyglot does.
+    int make(const std::string& archivePath, const std::string& bookPath, int plies)
+    {
+        Archive::Reader archive;
+        if(!archive.open(archivePath))
+        {
+            std::cerr << "Could not read " << archivePath << std::endl;
+            return 1;
+        }
+
+        struct Entry
+        {
+            uint64_t key;
+            uint16_t move;
+            uint64_t weight;
+        };
+        // One entry per move played, merged after sorting
+        std::vector<Entry> entries;
+        Board board;
+        archive.read([&](const Archive::Game& game)
+        {
+            board.setPosition(game.start);
+            for(int ply = 0; ply < std::min(plies, game.plies); ply++)
+            {
+                Move m = game.moves[ply];
+                Archive::Result win = board.sideToMove() == WHITE ? Archive::Result::WHITE_WINS : Archive::Result::BLACK_WINS;
+                Archive::Result loss = board.sideToMove() == WHITE ? Archive::Result::BLACK_WINS : Archive::Result::WHITE_WINS;
+                uint64_t weight = game.result == win ? 2 : game.result == loss ? 0 : 1;
+                entries.push_back({ Polyglot::key(board), Polyglot::encodeMove(m), weight });
+                board.makeMove(m);
+            }
+        });
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+        {
+            return a.key != b.key ? a.key < b.key : a.move < b.move;
+        });
+        size_t merged = 0;
+        for(size_t i = 0; i < entries.size(); i++)
+        {
+            if(merged > 0 && entries[merged - 1].key == entries[i].key && entries[merged - 1].move == entries[i].move)
+            {
+                entries[merged - 1].weight += entries[i].weight;
+            }
+            else
+            {
+                entries[merged++] = entries[i];
+            }
+        }
+        entries.resize(merged);
+
+        // Polyglot lists a position's moves best first
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+        {
+            return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+        });
+
+        std::ofstream file(bookPath, std::ios::binary | std::ios::trunc);
+        size_t written = 0;
+        for(size_t first = 0; first < entries.size(); )
+        {
+            // Weights are scaled per position to fit 16 bits
+            size_t last = first;
+            while(last < entries.size() && entries[last].key == entries[first].key)
+            {
+                last++;
+            }
+            uint64_t scale = std::max<uint64_t>(1, (entries[first].weight + UINT16_MAX - 1) / UINT16_MAX);
+            for(size_t i = first; i < last && entries[i].weight > 0; i++)
+            {
+                writeBigEndian(file, entries[i].key, 8);
+                writeBigEndian(file, entries[i].move, 2);
+                writeBigEndian(file, std::max<uint64_t>(1, entries[i].weight / scale), 2);
+                writeBigEndian(file, 0, 4);
+                written++;
+            }
+            first = last;
+        }
+        if(!file)
+        {
+            std::cerr << "Could not write " << bookPath << std::endl;
+            return 1;
+        }
+        std::cout << "Entries: " << written << " from " << archive.size() << " games" << std::endl;
+        return 0;
+    }
+
+    // Lists the book moves of a position
+    int probe(const std::string& bookPath, const std::string& fen)
+    {
+        Polyglot::Book book;
+        Board board;
+        if(!book.open(bookPath) || !board.setFen(fen))
+        {
+            std::cerr << "Could not read " << bookPath << " or invalid FEN " << fen << std::endl;
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Polyglot::BookMove> moves = book.moves(board);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t total = 0;
+        for(const Polyglot::BookMove& move : moves)
+        {
+            total += move.weight;
+        }
+        std::cout << "Key: " << std::hex << std::setw(16) << std::setfill('0') << Polyglot::key(board)
+                  << std::dec << std::setfill(' ') << std::endl;
+        for(const Polyglot::BookMove& move : moves)
+        {
+            std::cout << std::left << std::setw(8) << toSan(board, move.move) << std::right << std::setw(8) << move.weight
+                      << std::fixed << std::setprecision(1) << std::setw(8) << 100.0 * move.weight / std::max<uint64_t>(total, 1)
+                      << "%" << std::endl;
+        }
+        std::cout << moves.size() << " moves in " << std::fixed << std::setprecision(1) << micros << " us" << std::endl;
+        return 0;
+    }
+
+    // Times probing positions reached by short random lines
+    int bench(const std::string& bookPath)
+    {
+        Polyglot::Book book;
+        if(!book.open(bookPath))
+        {
+            std::cerr << "Could not read " << bookPath << std::endl;
+            return 1;
+        }
+
+        std::mt19937_64 random(1);
+        std::vector<Fen::Position> positions(BENCH_PROBES);
+        Board board;
+        MoveList moves;
+        for(Fen::Position& position : positions)
+        {
+            board.setStartPosition();
+            int plies = int(random() % (BENCH_MAX_PLIES + 1));
+            for(int ply = 0; ply < plies; ply++)
+            {
+                moves.clear();
+                generateLegalMoves(board, moves);
+                if(moves.size() == 0)
+                {
+                    break;
+                }
+                board.makeMove(moves[int(random() % uint64_t(moves.size()))].move);
+            }
+            position = board.getPosition();
+        }
+
+        // Only the probes are timed, not setting up the boards
+        uint64_t hits = 0;
+        std::chrono::steady_clock::duration elapsed{};
+        for(const Fen::Position& position : positions)
+        {
+            board.setPosition(position);
+            auto start = std::chrono::steady_clock::now();
+            hits += book.pick(board, Polyglot::Selection::WEIGHTED_RANDOM).isValid();
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << "Entries: " << book.size() << ", probes: " << positions.size() << ", in book: " << hits << ", "
+                  << std::fixed << std::setprecision(2) << seconds * 1e6 / positions.size() << " us/probe" << std::endl;
+        return 0;
+    }
+};
+
+/**
+ * Builds, probes and benchmarks Polyglot opening books.
+ *
+ * Usage: chess_book make <archive> <book> [plies]
+ *        chess_book probe <book> [fen]
+ *        chess_book bench <book>
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: chess_book make <archive> <book> [plies] | probe <book> [fen] | bench <book>" << std::endl;
+        return 1;
+    }
+
+    if(std::strcmp(argv[1], "make") == 0 && argc >= 4)
+    {
+        return make(argv[2], argv[3], argc > 4 ? std::atoi(argv[4]) : DEFAULT_BOOK_PLIES);
+    }
+    if(std::strcmp(argv[1], "probe") == 0)
+    {
+        // The FEN may be quoted or given as separate fields
+        std::string fen = argc > 3 ? argv[3] : START_FEN;
+        for(int i = 4; i < argc; i++)
+        {
+            fen += std::string(" ") + argv[i];
+        }
+        return probe(argv[2], fen);
+    }
+    if(std::strcmp(argv[1], "bench") == 0)
+    {
+        return bench(argv[2]);
+    }
+
+    std::cerr << "Unknown command " << argv[1] << std::endl;
+    return 1;
+}
@@ -0,0 +1,319 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Search.h"
+#include "../include/Engine/TrainingData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace Chess;
+
+    constexpr uint64_t DEFAULT_POSITIONS = 1000000;
+    constexpr uint64_t DEFAULT_NODES = 5000;
+    constexpr size_t DEFAULT_HASH_MB = 8;
+
+    // Random moves played from the start position so games differ
+    constexpr int DEFAULT_RANDOM_PLIES = 8;
+
+    // Games are drawn after this many plies, and this many records fit a game's buffer
+    constexpr int MAX_GAME_PLIES = 400;
+
+    // Records a worker collects before handing them to the writer, 1 MiB
+    constexpr size_t BATCH_RECORDS = 32768;
+
+    // A game is adjudicated once the score stayed beyond this for ADJUDICATE_PLIES plies
+    constexpr int ADJUDICATE_SCORE = 2000;
+    constexpr int ADJUDICATE_PLIES = 8;
+
+    // Positions are only kept if the score is within this, no mate scores
+    constexpr int MAX_RECORD_SCORE = 10000;
+
+    /**
+     * What every worker shares
+     */
+    struct Settings
+    {
+        uint64_t positions = DEFAULT_POSITIONS;
+        SearchLimits limits;
+        int randomPlies = DEFAULT_RANDOM_PLIES;
+        size_t hashMb = DEFAULT_HASH_MB;
+        uint64_t seed = 1;
+    };
+
+    struct Progress
+    {
+        std::atomic<uint64_t> positions{0};
+        std::atomic<uint64_t> games{0};
+        std::atomic<uint64_t> nodes{0};
+        std::atomic<bool> failed{false};
+    };
+
+    // Whether neither side can ever mate: bare kings or a single minor piece
+    bool insufficientMaterial(const Board& board)
+    {
+        Bitboard heavy = board.pieces(Type::PAWN) | board.pieces(Type::ROOK) | board.pieces(Type::QUEEN);
+        return heavy == 0 && Bitboards::popCount(board.pieces(Type::KNIGHT) | board.pieces(Type::BISHOP)) <= 1;
+    }
+
+    // Plays games until enough positions were written. Everything is allocated up front:
+    // the game's records and the batch are fixed size buffers reused for every game.
+    void work(int worker, const Settings& settings, TrainingData::Writer& writer, Progress& progress)
+    {
+        TranspositionTable tt(settings.hashMb);
+        Searcher searcher(tt);
+        Board board;
+        MoveList moves;
+        std::mt19937_64 random(settings.seed + uint64_t(worker) * 0x9E3779B97F4A7C15ULL);
+        std::vector<TrainingData::PackedPosition> game(MAX_GAME_PLIES);
+        std::vector<TrainingData::PackedPosition> batch(BATCH_RECORDS);
+        size_t batched = 0;
+        uint64_t nodes = 0;
+
+        while(progress.positions < settings.positions && !progress.failed)
+        {
+            board.setStartPosition();
+            tt.clear();
+            searcher.clearHistory();
+            bool playable = true;
+            for(int ply = 0; ply < settings.randomPlies && playable; ply++)
+            {
+                moves.clear();
+                generateLegalMoves(board, moves);
+                playable = moves.size() > 0;
+                if(playable)
+                {
+                    board.makeMove(moves[int(random() % uint64_t(moves.size()))].move);
+                }
+            }
+
+            // White's point of view; the loop ends with the result set
+            TrainingData::Result result = TrainingData::DRAW;
+            int recorded = 0;
+            int decisivePlies = 0;
+            for(int ply = 0; playable; ply++)
+            {
+                moves.clear();
+                generateLegalMoves(board, moves);
+                if(moves.size() == 0)
+                {
+                    if(board.inCheck())
+                    {
+                        result = board.sideToMove() == WHITE ? TrainingData::BLACK_WINS : TrainingData::WHITE_WINS;
+                    }
+                    break;
+                }
+                if(board.isDraw(0) || insufficientMaterial(board) || ply >= MAX_GAME_PLIES)
+                {
+                    break;
+                }
+
+                tt.newSearch();
+                searcher.newSearch();
+                SearchResult search = searcher.think(board, settings.limits);
+                nodes += search.stats.nodes;
+
+                // Quiet positions with a quiet best move are what static evaluation is
+                // tuned on
+                if(!board.inCheck() && !search.bestMove.isNoisy() && std::abs(search.score) < MAX_RECORD_SCORE)
+                {
+                    game[recorded++] = TrainingData::pack(board, search.score);
+                }
+
+                int whiteScore = board.sideToMove() == WHITE ? search.score : -search.score;
+                decisivePlies = std::abs(whiteScore) >= ADJUDICATE_SCORE ? decisivePlies + 1 : 0;
+                if(decisivePlies >= ADJUDICATE_PLIES)
+                {
+                    result = whiteScore > 0 ? TrainingData::WHITE_WINS : TrainingData::BLACK_WINS;
+                    break;
+                }
+                board.makeMove(search.bestMove);
+            }
+
+            for(int i = 0; i < recorded; i++)
+            {
+                game[i].result = result;
+                batch[batched++] = game[i];
+                if(batched == BATCH_RECORDS)
+                {
+                    progress.failed = progress.failed || !writer.write(batch.data(), batched);
+                    batched = 0;
+                }
+            }
+            progress.positions += uint64_t(recorded);
+            progress.games++;
+        }
+
+        if(batched > 0 && !writer.write(batch.data(), batched))
+        {
+            progress.failed = true;
+        }
+        progress.nodes += nodes;
+    }
+
+    // Counts the records of a file by result and shows the first one
+    int summarize(const std::string& path)
+    {
+        TrainingData::Reader reader;
+        if(!reader.open(path))
+        {
+            std::cerr << "Could not read " << path << " as uncompressed records" << std::endl;
+            return 1;
+        }
+
+        // Only records that unpack are counted, since the file may be compressed output
+        // or something else entirely
+        uint64_t results[3] = { 0, 0, 0 };
+        uint64_t corrupt = 0, first = reader.size();
+        Fen::Position position;
+        for(uint64_t i = 0; i < reader.size(); i++)
+        {
+            if(!TrainingData::unpack(reader[i], position))
+            {
+                corrupt++;
+                continue;
+            }
+            results[reader[i].result + 1]++;
+            first = std::min(first, i);
+        }
+        std::cout << "Positions: " << reader.size() << ", white wins: " << results[2] << ", draws: " << results[1]
+                  << ", black wins: " << results[0] << ", corrupt: " << corrupt << std::endl;
+        Board board;
+        if(first < reader.size() && TrainingData::unpack(reader[first], position) && board.setPosition(position))
+        {
+            std::cout << "First: " << board.fen() << " score " << reader[first].score << std::endl;
+        }
+        if(corrupt)
+        {
+            std::cerr << corrupt << " corrupt records in " << path << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+};
+
+/**
+ * Generates training positions from fixed node self-play on every core and writes them
+ * as 32 byte records, see TrainingData. Each game starts with a few random moves; in-check
+ * positions, positions whose best move is a capture or promotion and mate scores are
+ * left out.
+ *
+ * Usage: chess_datagen <output> [--positions n] [--nodes n] [--workers n] [--random-plies n]
+ *                      [--hash mb] [--seed n] [--compress command]
+ *        chess_datagen --summary <file>
+ * --compress pipes the records through a command such as "zstd -q" into the output.
+ */
+int main(int argc, char** argv)
+{
+    if(argc == 3 && std::strcmp(argv[1], "--summary") == 0)
+    {
+        return summarize(argv[2]);
+    }
+    // An output starting with "--" is a mistyped option such as --help, not a file name
+    if(argc < 2 || std::strncmp(argv[1], "--", 2) == 0)
+    {
+        std::cerr << "Usage: chess_datagen <output> [--positions n] [--nodes n] [--workers n] [--random-plies n] [--hash mb]"
+                     " [--seed n] [--compress command] | --summary <file>" << std::endl;
+        return 1;
+    }
+
+    Settings settings;
+    settings.limits.nodes = DEFAULT_NODES;
+    int workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::string compressor;
+    for(int i = 2; i < argc; i += 2)
+    {
+        // Every option takes a value
+        if(i + 1 == argc)
+        {
+            std::cerr << (std::strncmp(argv[i], "--", 2) == 0 ? "Missing value for " : "Unknown option ") << argv[i] << std::endl;
+            return 1;
+        }
+
+        if(std::strcmp(argv[i], "--positions") == 0)
+        {
+            settings.positions = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if(std::strcmp(argv[i], "--nodes") == 0)
+        {
+            settings.limits.nodes = std::max<uint64_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        }
+        else if(std::strcmp(argv[i], "--workers") == 0)
+        {
+            workers = std::max(1, std::atoi(argv[i + 1]));
+        }
+        else if(std::strcmp(argv[i], "--random-plies") == 0)
+        {
+            settings.randomPlies = std::max(0, std::atoi(argv[i + 1]));
+        }
+        else if(std::strcmp(argv[i], "--hash") == 0)
+        {
+            settings.hashMb = size_t(std::max(1, std::atoi(argv[i + 1])));
+        }
+        else if(std::strcmp(argv[i], "--seed") == 0)
+        {
+            settings.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if(std::strcmp(argv[i], "--compress") == 0)
+        {
+            compressor = argv[i + 1];
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    TrainingData::Writer writer;
+    if(!writer.open(argv[1], compressor))
+    {
+        std::cerr << "Could not write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Progress progress;
+    std::vector<std::thread> threads;
+    for(int i = 0; i < workers; i++)
+    {
+        threads.emplace_back(work, i, std::cref(settings), std::ref(writer), std::ref(progress));
+    }
+
+    // The main thread only reports progress
+    auto secondsSince = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    while(progress.positions < settings.positions && !progress.failed)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::cerr << "\r" << progress.positions << " positions, " << progress.games << " games, " << std::fixed
+                  << std::setprecision(0) << progress.positions / std::max(secondsSince(), 1e-9) << " positions/s   " << std::flush;
+    }
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    bool written = writer.close() && !progress.failed;
+
+    double seconds = secondsSince();
+    std::cerr << std::endl;
+    std::cout << "Positions: " << writer.size() << " from " << progress.games << " games on " << workers << " workers in "
+              << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+    std::cout << "Positions/s: " << std::setprecision(0) << writer.size() / std::max(seconds, 1e-9)
+              << ", nodes/s: " << progress.nodes / std::max(seconds, 1e-9) << ", per day: "
+              << std::setprecision(1) << writer.size() / std::max(seconds, 1e-9) * 86400 / 1e6 << "M" << std::endl;
+    if(!written)
+    {
+        std::cerr << "Could not write every record to " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
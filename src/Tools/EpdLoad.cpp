@@ -0,0 +1,115 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/Epd.h"
+#include "../include/Engine/MoveGen.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    using namespace Chess;
+
+    // Longest random game played before starting over when generating positions
+    constexpr int MAX_GAME_PLIES = 200;
+
+    // Writes count positions from random games as EPD lines with an id operation
+    bool generate(const std::string& path, uint64_t count)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+        {
+            return false;
+        }
+
+        std::mt19937_64 random(1);
+        Board board;
+        MoveList moves;
+        char fen[Fen::MAX_LENGTH];
+        for(uint64_t i = 0; i < count; )
+        {
+            moves.clear();
+            generateLegalMoves(board, moves);
+            if(moves.size() == 0 || board.gamePly() >= MAX_GAME_PLIES || board.isDraw(0))
+            {
+                board.setStartPosition();
+                continue;
+            }
+            board.makeMove(moves[int(random() % uint64_t(moves.size()))].move);
+
+            // EPD leaves out the move counters
+            size_t length = board.writeFen(fen);
+            std::string_view text(fen, length);
+            text = text.substr(0, text.rfind(' ', text.rfind(' ') - 1));
+            file << text << " id \"" << i++ << "\";\n";
+        }
+        return bool(file);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/**
+ * Loads an EPD file and reports how fast positions are parsed, then how fast they are
+ * set up on a Board and written back out as FEN.
+ *
+ * Usage: chess_epd_load <file>
+ *        chess_epd_load --generate <file> <count>
+ * The second form writes count positions from random games, for testing.
+ */
+int main(int argc, char** argv)
+{
+    if(argc == 4 && std::strcmp(argv[1], "--generate") == 0)
+    {
+        if(!generate(argv[2], std::strtoull(argv[3], nullptr, 10)))
+        {
+            std::cerr << "Could not write " << argv[2] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if(argc != 2)
+    {
+        std::cerr << "Usage: chess_epd_load <file> | --generate <file> <count>" << std::endl;
+        return 1;
+    }
+
+    EpdFile epd;
+    auto start = std::chrono::steady_clock::now();
+    if(!epd.load(argv[1]))
+    {
+        std::cerr << "Could not read " << argv[1] << std::endl;
+        return 1;
+    }
+    double loadSeconds = secondsSince(start);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Positions:      " << epd.size() << " (" << epd.getSkippedLines() << " lines skipped)" << std::endl;
+    std::cout << "Load time:      " << loadSeconds << " s, "
+              << std::setprecision(1) << epd.getBytesRead() / 1048576.0 / loadSeconds << " MB/s" << std::endl;
+    std::cout << "Parse rate:     " << std::setprecision(0) << epd.size() / loadSeconds << " positions/s" << std::endl;
+
+    // Round trip every position through a Board. The checksum keeps the work from being
+    // optimised away and is the same on every run.
+    Board board;
+    char fen[Fen::MAX_LENGTH];
+    uint64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < epd.size(); i++)
+    {
+        board.setPosition(epd.position(i));
+        checksum += board.key() + board.writeFen(fen);
+    }
+    double roundTripSeconds = secondsSince(start);
+
+    std::cout << "Board + FEN:    " << epd.size() / roundTripSeconds << " positions/s" << std::endl;
+    std::cout << "Checksum:       " << std::hex << checksum << std::dec << std::endl;
+    return 0;
+}
@@ -0,0 +1,455 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/Epd.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Search.h"
+#include "../include/Engine/Syzygy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace Chess;
+
+    // Games played when no number is given, unless the SPRT ends the match first
+    constexpr int DEFAULT_GAMES = 1000;
+
+    // Node budget per move of a configuration with no limit at all
+    constexpr uint64_t DEFAULT_NODES = 20000;
+
+    // Games are drawn after this many plies if nothing ended them before
+    constexpr int MAX_GAME_PLIES = 400;
+
+    /**
+     * How one side of the match searches
+     */
+    struct EngineConfig
+    {
+        std::string name;
+        SearchLimits limits;
+        size_t hashMb = 16;
+
+        // Clock for the whole game and increment per move in milliseconds, 0 for none
+        int64_t time = 0;
+        int64_t increment = 0;
+    };
+
+    /**
+     * When games are ended early. A side resigns once both engines scored the position at
+     * least resignScore against it for resignMoves moves each; a game is drawn once both
+     * scored it within drawScore for drawMoves moves each, after drawAfterPly.
+     */
+    struct Adjudication
+    {
+        int resignScore = 1000;
+        int resignMoves = 3;
+        int drawScore = 10;
+        int drawMoves = 8;
+        int drawAfterPly = 80;
+
+        // End games in the Syzygy tablebases with their known result
+        bool tablebases = false;
+    };
+
+    /**
+     * Sequential probability ratio test of the Elo difference of the first engine over
+     * the second: H0 says it is elo0, H1 says it is elo1
+     */
+    struct Sprt
+    {
+        double elo0 = 0;
+        double elo1 = 5;
+        double alpha = 0.05;
+        double beta = 0.05;
+
+        double lowerBound() const { return std::log(beta / (1 - alpha)); }
+        double upperBound() const { return std::log((1 - beta) / alpha); }
+
+        // Log likelihood ratio of H1 over H0 for a score, with the trinomial normal
+        // approximation
+        static double llr(int wins, int draws, int losses, double elo0, double elo1)
+        {
+            int n = wins + draws + losses;
+            double score = n ? (wins + 0.5 * draws) / n : 0;
+            double variance = n ? (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / n : 0;
+
+            // Until two different results were seen there is no spread to measure
+            if(variance <= 0)
+            {
+                return 0;
+            }
+            double s0 = expectedScore(elo0), s1 = expectedScore(elo1);
+            return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+        }
+
+        static double expectedScore(double elo) { return 1 / (1 + std::pow(10, -elo / 400)); }
+    };
+
+    // Game result from the first engine's point of view
+    enum class Outcome
+    {
+        WIN,
+        DRAW,
+        LOSS
+    };
+
+    /**
+     * Everything a game needs, allocated once per worker and reused for every game so
+     * playing moves allocates nothing
+     */
+    struct GameSlot
+    {
+        std::unique_ptr<TranspositionTable> tables[2];
+        std::unique_ptr<Searcher> searchers[2];
+        Board board;
+        MoveList moves;
+
+        // Clocks left in milliseconds by color
+        int64_t clocks[COLOR_NB];
+
+        // Table and searcher i belong to engine i, whichever color it plays
+        explicit GameSlot(const EngineConfig engines[2])
+        {
+            for(int i = 0; i < 2; i++)
+            {
+                this->tables[i] = std::make_unique<TranspositionTable>(engines[i].hashMb);
+                this->searchers[i] = std::make_unique<Searcher>(*this->tables[i]);
+            }
+        }
+    };
+
+    // Reads a configuration like "name=base,nodes=20000,hash=16" or "tc=10+0.1", the
+    // time control in seconds
+    bool parseConfig(const std::string& text, EngineConfig& config)
+    {
+        std::stringstream fields(text);
+        std::string field;
+        bool limited = false;
+        while(std::getline(fields, field, ','))
+        {
+            size_t equals = field.find('=');
+            if(equals == std::string::npos)
+            {
+                return false;
+            }
+            std::string key = field.substr(0, equals), value = field.substr(equals + 1);
+            if(key == "name")
+            {
+                config.name = value;
+            }
+            else if(key == "nodes")
+            {
+                config.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+                limited = true;
+            }
+            else if(key == "depth")
+            {
+                config.limits.depth = std::clamp(std::atoi(value.c_str()), 1, MAX_PLY - 1);
+                limited = true;
+            }
+            else if(key == "movetime")
+            {
+                config.limits.movetime = std::atoll(value.c_str());
+                limited = true;
+            }
+            else if(key == "tc")
+            {
+                size_t plus = value.find('+');
+                config.time = int64_t(std::atof(value.substr(0, plus).c_str()) * 1000);
+                config.increment = plus == std::string::npos ? 0 : int64_t(std::atof(value.substr(plus + 1).c_str()) * 1000);
+                limited = config.time > 0;
+            }
+            else if(key == "hash")
+            {
+                config.hashMb = size_t(std::max(1, std::atoi(value.c_str())));
+            }
+            else
+            {
+                return false;
+            }
+        }
+        if(!limited)
+        {
+            config.limits.nodes = DEFAULT_NODES;
+        }
+        return true;
+    }
+
+    // Whether neither side can ever mate: bare kings or a single minor piece
+    bool insufficientMaterial(const Board& board)
+    {
+        Bitboard heavy = board.pieces(Type::PAWN) | board.pieces(Type::ROOK) | board.pieces(Type::QUEEN);
+        return heavy == 0 && Bitboards::popCount(board.pieces(Type::KNIGHT) | board.pieces(Type::BISHOP)) <= 1;
+    }
+
+    // Plays a game from an opening. engines[e] is played by the slot's searcher e, and
+    // white is engine whiteEngine. Returns the result for white.
+    Outcome playGame(GameSlot& slot, const Fen::Position& opening, const EngineConfig engines[2], int whiteEngine, const Adjudication& rules)
+    {
+        Board& board = slot.board;
+        board.setPosition(opening);
+        for(int e = 0; e < 2; e++)
+        {
+            slot.tables[e]->clear();
+            slot.searchers[e]->clearHistory();
+            slot.clocks[e == whiteEngine ? WHITE : BLACK] = engines[e].time;
+        }
+
+        // Consecutive plies the adjudication conditions held, with white's scores
+        int resignPlies[COLOR_NB] = { 0, 0 };
+        int drawPlies = 0;
+        for(int ply = 0; ; ply++)
+        {
+            Color us = board.sideToMove();
+            Outcome usWins = us == WHITE ? Outcome::WIN : Outcome::LOSS;
+            Outcome usLoses = us == WHITE ? Outcome::LOSS : Outcome::WIN;
+
+            slot.moves.clear();
+            generateLegalMoves(board, slot.moves);
+            if(slot.moves.size() == 0)
+            {
+                return board.inCheck() ? usLoses : Outcome::DRAW;
+            }
+            if(board.isDraw(0) || insufficientMaterial(board) || ply >= MAX_GAME_PLIES)
+            {
+                return Outcome::DRAW;
+            }
+            if(rules.tablebases && board.castlingRights() == NO_CASTLING
+               && Bitboards::popCount(board.pieces()) <= Syzygy::maxPieces())
+            {
+                Syzygy::ProbeState state;
+                Syzygy::WdlScore wdl = Syzygy::probeWdl(board, state);
+                if(state != Syzygy::ProbeState::FAIL)
+                {
+                    return wdl == Syzygy::WDL_WIN ? usWins : wdl == Syzygy::WDL_LOSS ? usLoses : Outcome::DRAW;
+                }
+            }
+
+            int engine = us == WHITE ? whiteEngine : 1 - whiteEngine;
+            const EngineConfig& config = engines[engine];
+            SearchLimits limits = config.limits;
+            if(config.time > 0)
+            {
+                limits.time = std::max<int64_t>(slot.clocks[us], 1);
+                limits.increment = config.increment;
+            }
+            Searcher& searcher = *slot.searchers[engine];
+            slot.tables[engine]->newSearch();
+            searcher.newSearch();
+            int64_t start = TimeManager::now();
+            SearchResult result = searcher.think(board, limits);
+            if(config.time > 0)
+            {
+                slot.clocks[us] -= TimeManager::now() - start;
+                if(slot.clocks[us] < 0)
+                {
+                    return usLoses;
+                }
+                slot.clocks[us] += config.increment;
+            }
+            board.makeMove(result.bestMove);
+
+            int whiteScore = us == WHITE ? result.score : -result.score;
+            for(int c = 0; c < COLOR_NB; c++)
+            {
+                bool losing = c == WHITE ? whiteScore <= -rules.resignScore : whiteScore >= rules.resignScore;
+                resignPlies[c] = losing ? resignPlies[c] + 1 : 0;
+                if(resignPlies[c] >= 2 * rules.resignMoves)
+                {
+                    return c == WHITE ? Outcome::LOSS : Outcome::WIN;
+                }
+            }
+            drawPlies = ply >= rules.drawAfterPly && std::abs(whiteScore) <= rules.drawScore ? drawPlies + 1 : 0;
+            if(drawPlies >= 2 * rules.drawMoves)
+            {
+                return Outcome::DRAW;
+            }
+        }
+    }
+
+    // Elo difference of a score fraction, and the half width of its 95% interval
+    void eloEstimate(int wins, int draws, int losses, double& elo, double& margin)
+    {
+        int n = wins + draws + losses;
+        double score = n ? (wins + 0.5 * draws) / n : 0.5;
+        double variance = n ? (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / n : 0;
+        auto toElo = [](double s)
+        {
+            s = std::clamp(s, 1e-6, 1 - 1e-6);
+            return -400 * std::log10(1 / s - 1);
+        };
+        double deviation = n ? 1.96 * std::sqrt(variance / n) : 0;
+        elo = toElo(score);
+        margin = (toElo(score + deviation) - toElo(score - deviation)) / 2;
+    }
+};
+
+/**
+ * Plays two search configurations against each other on several threads. Each opening
+ * of an EPD file is played twice with colors reversed. After every game a sequential
+ * probability ratio test decides whether the first configuration is elo1 rather than
+ * elo0 Elo stronger; the match stops as soon as either hypothesis is accepted.
+ *
+ * Configurations are comma separated key=value lists: name, nodes, depth, movetime (ms),
+ * tc (seconds + increment, e.g. 10+0.1) and hash (MB). Without a limit a configuration
+ * searches 20000 nodes per move.
+ *
+ * Usage: chess_match <openings.epd> <config1> <config2> [--games n] [--workers n]
+ *                    [--elo0 e] [--elo1 e] [--alpha a] [--beta b] [--resign cp moves]
+ *                    [--draw cp moves ply] [--syzygy path]
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cerr << "Usage: chess_match <openings.epd> <config1> <config2> [--games n] [--workers n] [--elo0 e] [--elo1 e]"
+                     " [--alpha a] [--beta b] [--resign cp moves] [--draw cp moves ply] [--syzygy path]" << std::endl;
+        return 1;
+    }
+
+    EngineConfig engines[2];
+    for(int i = 0; i < 2; i++)
+    {
+        engines[i].name = i == 0 ? "first" : "second";
+        if(!parseConfig(argv[2 + i], engines[i]))
+        {
+            std::cerr << "Invalid configuration " << argv[2 + i] << std::endl;
+            return 1;
+        }
+    }
+
+    int games = DEFAULT_GAMES;
+    int workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    Sprt sprt;
+    Adjudication rules;
+    for(int i = 4; i < argc; i++)
+    {
+        auto next = [&]() { return i + 1 < argc ? argv[++i] : "0"; };
+        if(std::strcmp(argv[i], "--games") == 0)
+        {
+            games = std::max(1, std::atoi(next()));
+        }
+        else if(std::strcmp(argv[i], "--workers") == 0)
+        {
+            workers = std::max(1, std::atoi(next()));
+        }
+        else if(std::strcmp(argv[i], "--elo0") == 0)
+        {
+            sprt.elo0 = std::atof(next());
+        }
+        else if(std::strcmp(argv[i], "--elo1") == 0)
+        {
+            sprt.elo1 = std::atof(next());
+        }
+        else if(std::strcmp(argv[i], "--alpha") == 0)
+        {
+            sprt.alpha = std::atof(next());
+        }
+        else if(std::strcmp(argv[i], "--beta") == 0)
+        {
+            sprt.beta = std::atof(next());
+        }
+        else if(std::strcmp(argv[i], "--resign") == 0)
+        {
+            rules.resignScore = std::atoi(next());
+            rules.resignMoves = std::atoi(next());
+        }
+        else if(std::strcmp(argv[i], "--draw") == 0)
+        {
+            rules.drawScore = std::atoi(next());
+            rules.drawMoves = std::atoi(next());
+            rules.drawAfterPly = std::atoi(next());
+        }
+        else if(std::strcmp(argv[i], "--syzygy") == 0)
+        {
+            rules.tablebases = Syzygy::init(next()) > 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    EpdFile openings;
+    if(!openings.load(argv[1]) || openings.size() == 0)
+    {
+        std::cerr << "Could not read openings from " << argv[1] << std::endl;
+        return 1;
+    }
+    // Games come in pairs on the same opening
+    games += games % 2;
+    workers = std::min(workers, games);
+
+    std::cout << engines[0].name << " vs " << engines[1].name << ": up to " << games << " games on " << workers
+              << " workers, SPRT elo0 " << sprt.elo0 << " elo1 " << sprt.elo1 << " bounds [" << std::fixed
+              << std::setprecision(2) << sprt.lowerBound() << ", " << sprt.upperBound() << "]" << std::endl;
+
+    std::mutex resultMutex;
+    int results[3] = { 0, 0, 0 };
+    int verdict = 0;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> finished{false};
+    auto work = [&]()
+    {
+        GameSlot slot(engines);
+        for(int game = nextGame++; game < games && !finished; game = nextGame++)
+        {
+            // The first engine has white in even games
+            bool firstIsWhite = game % 2 == 0;
+            Outcome white = playGame(slot, openings.position(size_t(game / 2) % openings.size()), engines, firstIsWhite ? 0 : 1, rules);
+            Outcome first = firstIsWhite || white == Outcome::DRAW ? white : white == Outcome::WIN ? Outcome::LOSS : Outcome::WIN;
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if(finished)
+            {
+                break;
+            }
+            results[int(first)]++;
+            int wins = results[int(Outcome::WIN)], draws = results[int(Outcome::DRAW)], losses = results[int(Outcome::LOSS)];
+            double llr = Sprt::llr(wins, draws, losses, sprt.elo0, sprt.elo1);
+            double elo, margin;
+            eloEstimate(wins, draws, losses, elo, margin);
+            std::cout << "Games " << wins + draws + losses << ": +" << wins << " =" << draws << " -" << losses
+                      << ", Elo " << std::setprecision(1) << elo << " +/- " << margin << ", LLR " << std::setprecision(2)
+                      << llr << std::endl;
+            if(llr >= sprt.upperBound() || llr <= sprt.lowerBound())
+            {
+                verdict = llr >= sprt.upperBound() ? 1 : -1;
+                finished = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int i = 1; i < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if(verdict != 0)
+    {
+        std::cout << "SPRT: H" << (verdict > 0 ? "1" : "0") << " accepted, " << engines[0].name
+                  << (verdict > 0 ? " is stronger" : " is not stronger") << std::endl;
+    }
+    else
+    {
+        std::cout << "SPRT: inconclusive after " << games << " games" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Nnue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    using namespace Chess;
+
+    // Longest random game played before starting over
+    constexpr int MAX_GAME_PLIES = 200;
+
+    /**
+     * What one kernel did over the benchmark
+     */
+    struct KernelResult
+    {
+        uint64_t evaluations;
+        double seconds;
+        int64_t checksum;
+    };
+
+    // Plays random games from the start position, updating the accumulators and
+    // evaluating after every move. The same seed gives the same games for every kernel.
+    KernelResult run(uint64_t evaluations, uint64_t seed)
+    {
+        std::mt19937_64 random(seed);
+        Board board;
+        Nnue::AccumulatorStack stack;
+        board.attachAccumulators(&stack);
+
+        KernelResult result{ 0, 0.0, 0 };
+        MoveList moves;
+        auto start = std::chrono::steady_clock::now();
+        while(result.evaluations < evaluations)
+        {
+            moves.clear();
+            generateLegalMoves(board, moves);
+            if(moves.size() == 0 || board.gamePly() >= MAX_GAME_PLIES || board.isDraw(0))
+            {
+                board.attachAccumulators(nullptr);
+                board.setStartPosition();
+                board.attachAccumulators(&stack);
+                continue;
+            }
+
+            board.makeMove(moves[int(random() % uint64_t(moves.size()))].move);
+            result.checksum += Nnue::evaluate(*board.accumulator(), board.sideToMove());
+            result.evaluations++;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        board.attachAccumulators(nullptr);
+        return result;
+    }
+};
+
+/**
+ * Measures NNUE evaluations per second with every kernel the CPU supports. Each
+ * evaluation includes the incremental accumulator update of the move before it.
+ *
+ * Usage: chess_nnue_bench [network file] [evaluations]
+ * Without a network file a randomly generated network is used.
+ */
+int main(int argc, char** argv)
+{
+    if(argc > 1 && std::string(argv[1]) != "random")
+    {
+        if(!Nnue::load(argv[1]))
+        {
+            std::cerr << "Could not load network " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        Nnue::randomize(1);
+    }
+    uint64_t evaluations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    std::cout << "kernel      evals/s    speedup   checksum" << std::endl;
+
+    double baseline = 0.0;
+    int64_t expectedChecksum = 0;
+    bool agree = true;
+    for(Nnue::Kernel kernel : { Nnue::Kernel::SCALAR, Nnue::Kernel::SSE41, Nnue::Kernel::AVX2 })
+    {
+        if(!Nnue::setKernel(kernel))
+        {
+            std::cout << std::left << std::setw(8) << Nnue::kernelName(kernel) << "not supported" << std::endl;
+            continue;
+        }
+
+        KernelResult result = run(evaluations, 2024);
+        double rate = double(result.evaluations) / result.seconds;
+        if(kernel == Nnue::Kernel::SCALAR)
+        {
+            baseline = rate;
+            expectedChecksum = result.checksum;
+        }
+        agree = agree && result.checksum == expectedChecksum;
+
+        std::cout << std::left << std::setw(8) << Nnue::kernelName(kernel)
+                  << std::right << std::setw(12) << uint64_t(rate)
+                  << std::setw(10) << std::fixed << std::setprecision(2) << rate / baseline << "x"
+                  << std::setw(11) << result.checksum << std::endl;
+    }
+
+    if(!agree)
+    {
+        std::cout << "Kernels disagree on the evaluations" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MappedFile.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Pgn.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    // Longest random game written when generating a corpus
+    constexpr int MAX_GAME_PLIES = 160;
+
+    // Writes games of random moves as PGN, with tags, move numbers, the odd comment and
+    // a result, so every part of the reader is exercised
+    bool generate(const std::string& path, uint64_t games)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+        {
+            return false;
+        }
+
+        std::mt19937_64 random(1);
+        Board board;
+        MoveList moves;
+        for(uint64_t g = 0; g < games; g++)
+        {
+            file << "[Event \"Random game\"]\n[Site \"?\"]\n[Round \"" << g + 1 << "\"]\n"
+                 << "[White \"Random\"]\n[Black \"Random\"]\n[Result \"*\"]\n\n";
+
+            board.setStartPosition();
+            int lineLength = 0;
+            for(int ply = 0; ply < MAX_GAME_PLIES; ply++)
+            {
+                moves.clear();
+                generateLegalMoves(board, moves);
+                if(moves.size() == 0 || board.isDraw(0))
+                {
+                    break;
+                }
+
+                Move m = moves[int(random() % uint64_t(moves.size()))].move;
+                std::string text = (ply % 2 == 0 ? std::to_string(ply / 2 + 1) + ". " : "") + toSan(board, m);
+                if(random() % 50 == 0)
+                {
+                    text += " {a comment}";
+                }
+                board.makeMove(m);
+
+                if(lineLength + int(text.size()) > 79)
+                {
+                    file << '\n';
+                    lineLength = 0;
+                }
+                file << (lineLength ? " " : "") << text;
+                lineLength += int(text.size()) + 1;
+            }
+            file << " *\n\n";
+        }
+        return bool(file);
+    }
+
+    // Prints the totals and rates of one run
+    void report(const char* name, const Pgn::Stats& stats, double seconds, uint64_t checksum)
+    {
+        std::cout << std::left << std::setw(14) << name << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(12) << stats.games / seconds << " games/s"
+                  << std::setprecision(1) << std::setw(10) << stats.bytes / 1048576.0 / seconds << " MB/s"
+                  << std::setprecision(3) << std::setw(10) << seconds << " s"
+                  << "   checksum " << std::hex << checksum << std::dec << std::endl;
+    }
+};
+
+/**
+ * Reads a PGN file through a memory mapping, first on one thread and then split across
+ * several, and reports games and megabytes per second. Every move of every game is
+ * resolved against the move generator.
+ *
+ * Usage: chess_pgn_bench <file> [threads]
+ *        chess_pgn_bench --generate <file> <games>
+ * The second form writes a corpus of random games, for testing.
+ */
+int main(int argc, char** argv)
+{
+    if(argc == 4 && std::strcmp(argv[1], "--generate") == 0)
+    {
+        if(!generate(argv[2], std::strtoull(argv[3], nullptr, 10)))
+        {
+            std::cerr << "Could not write " << argv[2] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if(argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: chess_pgn_bench <file> [threads] | --generate <file> <games>" << std::endl;
+        return 1;
+    }
+
+    MappedFile file;
+    if(!file.open(argv[1]))
+    {
+        std::cerr << "Could not read " << argv[1] << std::endl;
+        return 1;
+    }
+    int threads = argc > 2 ? std::atoi(argv[2]) : int(std::thread::hardware_concurrency());
+
+    // The checksum adds up every move, so both runs must agree on it
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    Pgn::Reader reader;
+    Pgn::Stats stats = reader.read(file.view(), [&](const Pgn::Game& game)
+    {
+        for(int i = 0; i < game.plies; i++)
+        {
+            checksum += game.moves[i].raw() * uint64_t(i + 1);
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Games: " << stats.games << ", plies: " << stats.plies << ", games with errors: " << stats.errors
+              << ", " << std::fixed << std::setprecision(1) << stats.bytes / 1048576.0 << " MB" << std::endl;
+    report("1 thread", stats, seconds, checksum);
+
+    std::atomic<uint64_t> parallelChecksum = 0;
+    start = std::chrono::steady_clock::now();
+    stats = Pgn::readParallel(file.view(), threads, [&](const Pgn::Game& game, int)
+    {
+        uint64_t sum = 0;
+        for(int i = 0; i < game.plies; i++)
+        {
+            sum += game.moves[i].raw() * uint64_t(i + 1);
+        }
+        parallelChecksum += sum;
+    });
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string name = std::to_string(threads) + " threads";
+    report(name.c_str(), stats, seconds, parallelChecksum);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "../include/Engine/Board.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/PositionIndex.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    using namespace Chess;
+
+    // Lookups timed by the benchmark, half of them keys that are in the index
+    constexpr int BENCH_LOOKUPS = 1000000;
+
+    // Prints what was played from a position
+    int query(const std::string& archivePath, const std::string& indexPath, const std::string& fen)
+    {
+        Archive::Reader archive;
+        PositionIndex index;
+        if(!archive.open(archivePath, MappedFile::Access::RANDOM) || !index.open(indexPath))
+        {
+            std::cerr << "Could not read " << archivePath << " or " << indexPath << std::endl;
+            return 1;
+        }
+        Board board;
+        if(!board.setFen(fen))
+        {
+            std::cerr << "Invalid FEN " << fen << std::endl;
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<PositionIndex::MoveStats> moves = index.explore(board.key(), archive);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        for(const PositionIndex::MoveStats& stats : moves)
+        {
+            std::string move = stats.move.isValid() ? toSan(board, stats.move) : "(end)";
+            std::cout << std::left << std::setw(8) << move << std::right << std::setw(10) << stats.games << " games"
+                      << "   +" << stats.whiteWins << " =" << stats.draws << " -" << stats.blackWins << std::endl;
+        }
+        std::cout << moves.size() << " moves in " << std::fixed << std::setprecision(1) << micros << " us" << std::endl;
+        return 0;
+    }
+
+    // Times lookups with both searches
+    int bench(const std::string& indexPath)
+    {
+        PositionIndex index;
+        if(!index.open(indexPath) || index.size() == 0)
+        {
+            std::cerr << "Could not read " << indexPath << std::endl;
+            return 1;
+        }
+        std::cout << "Entries: " << index.size() << ", games: " << index.gameCount() << std::endl;
+
+        std::mt19937_64 random(1);
+        std::vector<uint64_t> keys(BENCH_LOOKUPS);
+        for(uint64_t& key : keys)
+        {
+            key = random() % 2 ? index.entries()[random() % index.size()].key : random();
+        }
+
+        // Touch every page the lookups need first, so page faults of the fresh mapping
+        // are not counted against either search
+        uint64_t warm = 0;
+        for(uint64_t key : keys)
+        {
+            warm += index.find(key, PositionIndex::Search::BINARY).size();
+        }
+
+        for(PositionIndex::Search search : { PositionIndex::Search::BINARY, PositionIndex::Search::EYTZINGER })
+        {
+            uint64_t found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(uint64_t key : keys)
+            {
+                found += index.find(key, search).size();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << std::left << std::setw(10) << (search == PositionIndex::Search::BINARY ? "binary" : "eytzinger")
+                      << std::right << std::fixed << std::setprecision(0) << std::setw(8) << seconds * 1e9 / keys.size()
+                      << " ns/lookup   " << found << " entries" << (found == warm ? "" : "  MISMATCH") << std::endl;
+        }
+        return 0;
+    }
+};
+
+/**
+ * Builds and queries the position index of a game archive.
+ *
+ * Usage: chess_position_index build <archive> <index> [threads]
+ *        chess_position_index query <archive> <index> <fen>
+ *        chess_position_index bench <index>
+ */
+int main(int argc, char** argv)
+{
+    if(argc >= 4 && argc <= 5 && std::strcmp(argv[1], "build") == 0)
+    {
+        int threads = argc == 5 ? std::atoi(argv[4]) : int(std::thread::hardware_concurrency());
+        PositionIndex::BuildStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if(!PositionIndex::build(argv[2], argv[3], threads, stats))
+        {
+            std::cerr << "Could not build " << argv[3] << " from " << argv[2] << std::endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Games: " << stats.games << ", entries: " << stats.entries << ", errors: " << stats.errors
+                  << ", " << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+        return 0;
+    }
+    if(argc >= 5 && std::strcmp(argv[1], "query") == 0)
+    {
+        // The FEN may be quoted or given as separate fields
+        std::string fen = argv[4];
+        for(int i = 5; i < argc; i++)
+        {
+            fen += std::string(" ") + argv[i];
+        }
+        return query(argv[2], argv[3], fen);
+    }
+    if(argc == 3 && std::strcmp(argv[1], "bench") == 0)
+    {
+        return bench(argv[2]);
+    }
+
+    std::cerr << "Usage: chess_position_index build <archive> <index> [threads] | query <archive> <index> <fen>"
+              << " | bench <index>" << std::endl;
+    return 1;
+}
@@ -0,0 +1,364 @@
+#include "../include/Uci/UciEngine.h"
+#include "../include/Engine/Bench.h"
+#include "../include/Engine/MoveGen.h"
+#include "../include/Engine/Nnue.h"
+#include "../include/Engine/Psqt.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+
+Chess::UciEngine::UciEngine(std::istream& in, std::ostream& out) : in(in), out(out)
+{
+}
+
+void Chess::UciEngine::loop()
+{
+    std::string line;
+    while(std::getline(this->in, line))
+    {
+        if(!execute(line))
+        {
+            break;
+        }
+    }
+
+    this->pool.stop();
+    this->pool.wait();
+}
+
+void Chess::UciEngine::send(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(this->outputMutex);
+    this->out << line << std::endl;
+}
+
+bool Chess::UciEngine::execute(const std::string& line)
+{
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if(command == "uci")
+    {
+        send(std::string("id name ") + ENGINE_NAME);
+        send("id author chess-cpp developers");
+        send("option name Hash type spin default " + std::to_string(TranspositionTable::DEFAULT_SIZE_MB)
+             + " min 1 max " + std::to_string(SearchPool::MAX_HASH_MB));
+        send("option name Threads type spin default 1 min 1 max " + std::to_string(SearchPool::MAX_THREADS));
+        send("option name Ponder type check default false");
+        send("option name OwnBook type check default false");
+        send("option name BookFile type string default <empty>");
+        send("option name BookBestMove type check default false");
+        send("option name EvalFile type string default <empty>");
+        send("option name EvalWeights type string default <empty>");
+        send("option name SyzygyPath type string default <empty>");
+        send("option name SyzygyProbeLimit type spin default " + std::to_string(Syzygy::MAX_PIECES)
+             + " min 0 max " + std::to_string(Syzygy::MAX_PIECES));
+        send("option name SyzygyMaxFiles type spin default " + std::to_string(Syzygy::DEFAULT_MAX_MAPPED_FILES)
+             + " min 1 max 65536");
+        send("uciok");
+    }
+    else if(command == "isready")
+    {
+        send("readyok");
+    }
+    else if(command == "ucinewgame")
+    {
+        this->pool.stop();
+        this->pool.clear();
+        this->board.setStartPosition();
+    }
+    else if(command == "position")
+    {
+        position(args);
+    }
+    else if(command == "go")
+    {
+        go(args);
+    }
+    else if(command == "stop")
+    {
+        this->pool.stop();
+    }
+    else if(command == "ponderhit")
+    {
+        this->pool.ponderhit();
+    }
+    else if(command == "setoption")
+    {
+        setOption(args);
+    }
+    else if(command == "bench")
+    {
+        bench(args);
+    }
+    else if(command == "quit")
+    {
+        return false;
+    }
+    else if(!command.empty())
+    {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+void Chess::UciEngine::position(std::istringstream& args)
+{
+    std::string token, fen;
+    args >> token;
+    if(token == "startpos")
+    {
+        fen = START_FEN;
+        args >> token;
+    }
+    else if(token == "fen")
+    {
+        while(args >> token && token != "moves")
+        {
+            fen += token + " ";
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    Board next;
+    if(!next.setFen(fen))
+    {
+        send("info string invalid fen " + fen);
+        return;
+    }
+
+    // token is now "moves" if there are any
+    while(args >> token)
+    {
+        Move m = findLegalMove(next, token);
+        if(!m.isValid())
+        {
+            send("info string illegal move " + token);
+            break;
+        }
+        next.makeMove(m);
+    }
+    this->board = next;
+}
+
+void Chess::UciEngine::go(std::istringstream& args)
+{
+    SearchLimits limits;
+    int64_t time[COLOR_NB] = { 0, 0 };
+    int64_t increment[COLOR_NB] = { 0, 0 };
+    bool clock[COLOR_NB] = { false, false };
+
+    std::string token;
+    while(args >> token)
+    {
+        if(token == "depth") args >> limits.depth;
+        else if(token == "nodes") args >> limits.nodes;
+        else if(token == "movetime") args >> limits.movetime;
+        else if(token == "wtime") clock[WHITE] = bool(args >> time[WHITE]);
+        else if(token == "btime") clock[BLACK] = bool(args >> time[BLACK]);
+        else if(token == "winc") args >> increment[WHITE];
+        else if(token == "binc") args >> increment[BLACK];
+        else if(token == "movestogo") args >> limits.movesToGo;
+        else if(token == "infinite") limits.infinite = true;
+        else if(token == "ponder") limits.ponder = true;
+    }
+
+    // A book move is played at once, except when the GUI wants a search that runs
+    // until it says stop
+    if(this->ownBook && !limits.infinite && !limits.ponder)
+    {
+        Move bookMove = this->book.pick(this->board, this->bookSelection);
+        if(bookMove.isValid())
+        {
+            send("info string book move");
+            send("bestmove " + bookMove.toUci());
+            return;
+        }
+    }
+
+    // The search's time manager only needs the side to move's clock. A clock at or below
+    // zero, which some GUIs send just before the flag falls, still limits the search:
+    // the move gets 1 ms plus the increment, as 0 would mean no clock at all.
+    Color us = this->board.sideToMove();
+    limits.time = clock[us] && time[us] <= 0 ? 1 + std::max<int64_t>(increment[us], 0) : time[us];
+    limits.increment = increment[us];
+
+    this->pool.start(this->board, limits,
+        [this](const SearchInfo& info)
+        {
+            std::string line = "info depth " + std::to_string(info.depth)
+                             + " score " + formatScore(info.score)
+                             + " nodes " + std::to_string(info.nodes)
+                             + " nps " + std::to_string(info.nps)
+                             + " hashfull " + std::to_string(info.hashfull)
+                             + " tbhits " + std::to_string(info.tbHits)
+                             + " time " + std::to_string(info.time)
+                             + " pv";
+            for(int i = 0; i < info.pvLength; i++)
+            {
+                line += ' ';
+                line += info.pv[i].toUci();
+            }
+            send(line);
+            send("info string metrics " + formatMetrics(info.metrics));
+        },
+        [this](const SearchResult& result)
+        {
+            std::string line = "bestmove " + result.bestMove.toUci();
+            if(result.pvLength > 1)
+            {
+                line += " ponder " + result.pv[1].toUci();
+            }
+            send(line);
+        });
+}
+
+void Chess::UciEngine::bench(std::istringstream& args)
+{
+    if(this->pool.isSearching())
+    {
+        send("info string bench can not run while searching");
+        return;
+    }
+
+    int depth = Bench::DEFAULT_DEPTH;
+    args >> depth;
+    depth = std::clamp(depth, 1, MAX_PLY - 1);
+    Bench::Result result = Bench::run(depth, [this](int index, const char* fen, uint64_t nodes)
+    {
+        send("info string position " + std::to_string(index) + "/" + std::to_string(Bench::positionCount())
+             + " nodes " + std::to_string(nodes) + " fen " + fen);
+    });
+    send("info string bench depth " + std::to_string(depth) + " positions " + std::to_string(result.positions));
+    send("info string time " + std::to_string(result.milliseconds) + " ms");
+    send(std::to_string(result.nodes) + " nodes " + std::to_string(result.nps()) + " nps");
+}
+
+void Chess::UciEngine::setOption(std::istringstream& args)
+{
+    std::string token, name, value;
+    args >> token;
+    while(args >> token && token != "value")
+    {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    // The value runs to the end of the line, so paths may have spaces
+    std::getline(args >> std::ws, value);
+
+    if(this->pool.isSearching())
+    {
+        send("info string options can not be changed while searching");
+        return;
+    }
+
+    if(name == "Hash" && !value.empty())
+    {
+        this->pool.setHashSize(std::strtoul(value.c_str(), nullptr, 10));
+    }
+    else if(name == "Threads" && !value.empty())
+    {
+        this->pool.setThreadCount(std::atoi(value.c_str()));
+    }
+    else if(name == "OwnBook")
+    {
+        this->ownBook = value == "true";
+    }
+    else if(name == "BookBestMove")
+    {
+        this->bookSelection = value == "true" ? Polyglot::Selection::BEST : Polyglot::Selection::WEIGHTED_RANDOM;
+    }
+    else if(name == "BookFile" && !value.empty() && value != "<empty>")
+    {
+        if(!this->book.open(value))
+        {
+            send("info string could not open book " + value);
+        }
+    }
+    else if(name == "EvalFile" && !value.empty() && value != "<empty>")
+    {
+        // A network that fails to load leaves the previous evaluation in use
+        if(Nnue::load(value))
+        {
+            send("info string loaded network " + value);
+        }
+        else
+        {
+            send("info string could not load network " + value);
+        }
+    }
+    else if(name == "EvalWeights" && !value.empty() && value != "<empty>")
+    {
+        // A text file of "<name> <mg> <eg>" lines overriding the piece-square evaluation:
+        // "value.<piece> 320 330" sets a piece value and "psqt.<piece>.<square> 12 10" a
+        // square's bonus for white, mirrored for black. Pieces are pawn, knight, bishop,
+        // rook, queen and king, lines starting with '#' are comments and weights not
+        // mentioned keep their value, see Psqt::loadWeights. The next position command
+        // sets the board up with them.
+        if(Psqt::loadWeights(value))
+        {
+            send("info string loaded evaluation weights " + value);
+        }
+        else
+        {
+            send("info string could not load evaluation weights " + value);
+        }
+    }
+    else if(name == "SyzygyPath")
+    {
+        size_t tables = Syzygy::init(value);
+        send("info string found " + std::to_string(tables) + " tablebases with up to "
+             + std::to_string(Syzygy::maxPieces()) + " pieces");
+    }
+    else if(name == "SyzygyProbeLimit" && !value.empty())
+    {
+        Syzygy::setProbeLimit(std::atoi(value.c_str()));
+    }
+    else if(name == "SyzygyMaxFiles" && !value.empty())
+    {
+        Syzygy::setMaxMappedFiles(std::strtoul(value.c_str(), nullptr, 10));
+    }
+    else if(name != "Ponder" && name != "BookFile" && name != "EvalFile" && name != "EvalWeights")
+    {
+        send("info string unknown option " + name);
+    }
+}
+
+std::string Chess::UciEngine::formatScore(int score)
+{
+    if(score >= VALUE_MATE_IN_MAX_PLY)
+    {
+        return "mate " + std::to_string((VALUE_MATE - score + 1) / 2);
+    }
+    if(score <= -VALUE_MATE_IN_MAX_PLY)
+    {
+        return "mate " + std::to_string(-(VALUE_MATE + score) / 2);
+    }
+    return "cp " + std::to_string(score);
+}
+
+std::string Chess::UciEngine::formatMetrics(const SearchMetrics& metrics)
+{
+    const SearchStats& totals = metrics.totals;
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3)
+         << "nodes " << totals.nodes << " qnodes " << totals.qsearchNodes << " nps " << metrics.nps << " threadnps ";
+    for(size_t i = 0; i < metrics.threadNps.size(); i++)
+    {
+        text << (i ? "," : "") << metrics.threadNps[i];
+    }
+    text << " ttprobes " << totals.ttProbes << " tthitrate " << totals.ttHitRate() << " ttcutrate " << totals.ttCutoffRate()
+         << " hashfull " << metrics.hashfull << " researchrate " << totals.researchRate() << " tbhits " << totals.tbHits;
+
+    // Branching factor of every iteration after the first, as depth:factor
+    text << std::setprecision(2) << " ebf";
+    for(int depth = 2; depth <= metrics.depth; depth++)
+    {
+        text << (depth > 2 ? "," : " ") << depth << ":" << totals.branchingFactor(depth);
+    }
+    return text.str();
+}
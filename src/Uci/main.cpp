@@ -0,0 +1,64 @@
+#include "../include/Uci/UciEngine.h"
+#include "../include/Engine/Trace.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * Entry point of the headless UCI engine. Arguments, if any, are run as one command
+ * before exiting, e.g. "chess_uci bench 12" for the speed check. A leading
+ * "--trace <file>" writes a Chrome trace of the session on exit, in builds configured
+ * with -DCHESS_TRACE=ON.
+ */
+int main(int argc, char** argv)
+{
+    // Stay responsive to GUIs that read the output line by line
+    std::ios::sync_with_stdio(false);
+    std::cout.setf(std::ios::unitbuf);
+
+    int first = 1;
+    std::string traceFile;
+    if(argc > 2 && std::strcmp(argv[1], "--trace") == 0)
+    {
+        traceFile = argv[2];
+        first = 3;
+#ifdef CHESS_TRACE
+        Chess::Trace::start();
+        CHESS_TRACE_THREAD("uci");
+#else
+        std::cerr << "--trace needs a build configured with -DCHESS_TRACE=ON" << std::endl;
+        traceFile.clear();
+#endif
+    }
+
+    if(argc > first)
+    {
+        std::string command;
+        for(int i = first; i < argc; i++)
+        {
+            command += std::string(i > first ? " " : "") + argv[i];
+        }
+        std::istringstream input(command + "\nquit\n");
+        Chess::UciEngine engine(input, std::cout);
+        engine.loop();
+    }
+    else
+    {
+        Chess::UciEngine engine(std::cin, std::cout);
+        engine.loop();
+    }
+
+    // The engine is destroyed, so no search thread is still recording
+    if(!traceFile.empty())
+    {
+        Chess::Trace::stop();
+        if(!Chess::Trace::write(traceFile))
+        {
+            std::cerr << "Could not write " << traceFile << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -2,7 +2,14 @@
 
 #include <format>
 #include <map>
-
+#include <memory>
+
+#include "../Engine/Board.h"
+#include "../Engine/EngineThread.h"
+#include "../Engine/MoveGen.h"
+#include "../Engine/Polyglot.h"
+#include "../Engine/PositionIndex.h"
+#include "../Engine/Trace.h"
 #include "../Logger/LogManager.h"
 #include "../SDL/SDLWindow.h"
 #include "../Themes/ThemeManager.h"
@@ -42,9 +49,9 @@ namespace Chess
     class GameApplication
     {
         public:
-            // Constructor that initializes the app
+            // Constructor that initializes the app with the game starting from a FEN
             // Still need to invoke the run method to actually execute.
-            GameApplication(std::shared_ptr<LogManager> lm_ptr);
+            GameApplication(std::shared_ptr<LogManager> lm_ptr, const std::string& fen = START_FEN);
 
             // Destructor. Performs clean up
             ~GameApplication();
@@ -52,10 +59,24 @@ namespace Chess
             // Method that starts the application
             void run();
 
+            // Draws the board and pieces of the current position and presents the frame.
+            // run() calls it whenever something changed; chess_bench times it.
+            void drawFrame();
+
             // Draws a chess piece at a certain row and column on the board.
             // The row and col are 0 based, meaning that the top left corner is (0,0)
             void drawChessPiece(std::shared_ptr<Chess::ChessPiece> piece, int row, int col, bool isWhite);
 
+            // Opens a game archive and its position index for the move explorer, which then
+            // lists what was played in the games that reached each position. Returns false
+            // if either can not be read.
+            bool openExplorer(const std::string& archivePath, const std::string& indexPath);
+
+            // Opens a Polyglot opening book for the engine, which then plays its moves
+            // without searching while the game is in the book. Returns false if it can not
+            // be read.
+            bool openBook(const std::string& bookPath);
+
         private:
             // Log manager
             std::shared_ptr<LogManager> lm;
@@ -97,13 +118,70 @@ namespace Chess
             // Track whether this turn is for white pieces or black
             bool isWhiteTurn;
 
+            // Time the app aims to spend on each frame, about 60 frames per second
+            static constexpr Uint32 FRAME_TIME_MS = 16;
+
+            // Time the engine gets to think about each of its moves
+            static constexpr int64_t ENGINE_MOVE_TIME_MS = 2000;
+
+            // The game being played. The pieces on screen are rebuilt from it after every move.
+            Board board;
+
+            // The engine playing against the user. It searches on its own thread so the
+            // window keeps responding while it thinks.
+            std::unique_ptr<EngineThread> engine;
+
+            // The side the engine plays
+            Color engineColor;
+
+            // Id of the search the engine is running for the game, 0 when it is not thinking
+            uint32_t engineSearchId;
+
+            // Id of the search pondering on the user's expected reply, 0 when not pondering
+            uint32_t ponderSearchId;
+
+            // The reply the engine is pondering on
+            Move ponderMove;
+
+            // Square the user started dragging a piece from, SQ_NONE when not dragging
+            Square dragFrom;
+
+            // Whether the board has to be drawn again in the next frame
+            bool changeDetected;
+
+            // The engine's opening book, not open if none was given
+            Polyglot::Book book;
+
+            // The move explorer's games and the index of their positions
+            Archive::Reader explorerArchive;
+            PositionIndex explorerIndex;
+
+            // Whether the move explorer has been opened
+            bool explorerOpen;
+
+            // Most moves the move explorer lists for a position
+            static constexpr size_t EXPLORER_MOVES = 8;
+
+            // Whether the search metrics are drawn over the board, toggled with M
+            bool showMetrics;
+
+            // Counters of the engine's latest search, as of its last completed iteration
+            SearchMetrics metrics;
+
+            // Height of a bar of the metrics overlay and the space around it, in pixels
+            static constexpr int METRICS_BAR_HEIGHT = 10;
+            static constexpr int METRICS_BAR_GAP = 4;
+
+            // Branching factor that fills a whole bar of the overlay
+            static constexpr double METRICS_MAX_BRANCHING = 8.0;
+
             // Displays the app banner
             void displayBanner();
 
             // Initializes the chess board by drawing it onto the window
             void drawChessBoard();
 
-            // Initializes and places chess pieces in their appropriate places
+            // Places the chess pieces of the board's position and draws them
             void initializeChessPieces();
 
             // Draws chess pieces from their positions
@@ -112,6 +190,45 @@ namespace Chess
             // Draws board from where the pieces are on the board.
             void drawBoardFromLastPosition();
 
+            // Handles a single event from the window
+            void handleEvent(const SDL_Event& event);
+
+            // Converts a mouse position to the square under it, SQ_NONE if it is off the board
+            Square squareAt(int mouseX, int mouseY);
+
+            // Plays a user's drag from one square to another if it is a legal move
+            void tryUserMove(Square from, Square to);
+
+            // Plays a move on the board and updates the pieces on screen
+            void playMove(Move move);
+
+            // Rebuilds the piece maps from the board
+            void syncPiecesFromBoard();
+
+            // Creates the GUI piece for an engine piece type
+            std::shared_ptr<Chess::ChessPiece> createChessPiece(Type type, int row, int col, bool isWhite);
+
+            // Asks the engine to find its move in the current position
+            void startEngineSearch();
+
+            // Lets the engine think on the user's time about the reply it expects
+            void startPondering(Move expectedReply);
+
+            // Applies every update the engine has sent since the last frame
+            void processEngineUpdates();
+
+            // Starts a new game from the initial position
+            void newGame();
+
+            // Logs the move explorer's moves for the current position
+            void showExplorer();
+
+            // Draws the search metrics as bars over the top of the board
+            void drawMetricsOverlay();
+
+            // Logs the search metrics as text, which the overlay has no font for
+            void logMetrics();
+
             // Draws a Pawn at a certain row and column on the board
             void drawPawn(std::shared_ptr<Chess::Pawn> piece, int row, int col, bool isWhite);
 
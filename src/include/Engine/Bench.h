@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Chess
+{
+    /**
+     * The standard speed check: a fixed set of positions searched to a fixed depth on one
+     * thread, each from an empty hash table and fresh history. The total node count is a
+     * signature of the search; it only changes when the search behaves differently, so a
+     * change meant to be a pure speedup must leave it alone. Tablebases and an NNUE network
+     * change it too, so compare signatures with neither set up.
+     */
+    namespace Bench
+    {
+        // Depth searched when none is given
+        constexpr int DEFAULT_DEPTH = 6;
+
+        // Size of the hash table in megabytes
+        constexpr size_t HASH_MB = 16;
+
+        /**
+         * Totals of a bench run
+         */
+        struct Result
+        {
+            int positions = 0;
+            uint64_t nodes = 0;
+            int64_t milliseconds = 0;
+
+            uint64_t nps() const { return this->milliseconds > 0 ? this->nodes * 1000 / uint64_t(this->milliseconds) : 0; }
+        };
+
+        // Called after each position with its number from 1, its FEN and its node count
+        typedef std::function<void(int index, const char* fen, uint64_t nodes)> PositionCallback;
+
+        // Number of built in positions
+        int positionCount();
+
+        // Searches every built in position to the given depth
+        Result run(int depth, PositionCallback onPosition = nullptr);
+    };
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * The win, draw or loss of every position of a small endgame (KPK, KRK, KQKR...),
+     * generated on the spot by retrograde analysis rather than shipped as large files.
+     *
+     * Positions are numbered densely: side to move, white king (in the a1-d1-d4 triangle
+     * without pawns, on the a-d files with them, the rest follows by symmetry) and then
+     * every other piece on any of the 64 squares. Results take 2 bits each, 32 positions
+     * to a word. Generation repeatedly sweeps the positions still undecided on several
+     * threads, deciding each from its children, until a sweep changes nothing; what is
+     * left is drawn. Captures and promotions lead into smaller endgames, which are
+     * generated first.
+     *
+     * A generated bitbase is written as a header followed by the words and opened with a
+     * memory mapping, so the engine can probe it without a load step. Castling and en
+     * passant are not considered.
+     */
+    class Bitbase
+    {
+        public:
+            static constexpr char MAGIC[8] = { 'C', 'H', 'S', 'B', 'B', 'A', 'S', '1' };
+            static constexpr uint32_t VERSION = 1;
+
+            // Most pieces, kings included. Four piece endgames take seconds to a minute on
+            // one core; five piece ones take many times longer and about 84 MB each.
+            static constexpr int MAX_PIECES = 5;
+
+            /**
+             * The result of a position for the side to move
+             */
+            enum Value : uint8_t
+            {
+                // Not decided yet while generating, or not in the bitbase when probing
+                UNKNOWN = 0,
+                WIN = 1,
+                LOSS = 2,
+
+                // Also stored for impossible positions
+                DRAW = 3
+            };
+
+            /**
+             * Start of the file
+             */
+            struct Header
+            {
+                char magic[8];
+                uint32_t version;
+                uint32_t pieceCount;
+
+                // Material as written by signature(), zero padded
+                char signature[8];
+
+                // Positions in the index, followed by (positions + 31) / 32 words
+                uint64_t positions;
+            };
+
+            /**
+             * What generating a bitbase took
+             */
+            struct GenerateStats
+            {
+                // Positions in the index and how many of them are possible
+                uint64_t positions = 0;
+                uint64_t legal = 0;
+
+                // Possible positions by result for the side to move
+                uint64_t wins = 0;
+                uint64_t draws = 0;
+                uint64_t losses = 0;
+
+                // Sweeps over the positions until nothing changed
+                int passes = 0;
+
+                // Smaller endgames generated along the way
+                int subtables = 0;
+
+                // Bytes of all result arrays held at once
+                uint64_t memoryBytes = 0;
+
+                double seconds = 0;
+            };
+
+            /**
+             * The pieces of an endgame in canonical order: white before black, and within a
+             * color the king first, then queens down to pawns. Slot i of a position's
+             * squares holds the square of piece i.
+             */
+            struct Material
+            {
+                int count = 0;
+                Color colors[MAX_PIECES];
+                Type types[MAX_PIECES];
+
+                // Slot of each color's king
+                int kingSlot[COLOR_NB];
+
+                // Pawns break the diagonal and rank symmetries
+                bool hasPawns = false;
+
+                // Squares the white king is indexed on and positions in the index
+                uint64_t kingSquares = 0;
+                uint64_t positions = 0;
+
+                // Count of every colored piece, 4 bits each, to find the material of a board
+                uint64_t key = 0;
+            };
+
+            // Puts material like "KQKR" (white's pieces, then black's, each starting with
+            // the king) in the canonical order: kings first, then queens down to pawns.
+            // Returns an empty string if it is not a valid endgame of up to MAX_PIECES.
+            static std::string normalize(const std::string& signature);
+
+            // Generates the bitbase of an endgame on the given number of threads and
+            // writes it to path. Returns false if the signature is invalid or the file
+            // can not be written.
+            static bool generate(const std::string& signature, const std::string& path, int threads, GenerateStats& stats);
+
+            // Maps a bitbase file. Returns false if it can not be read or is not a bitbase.
+            bool open(const std::string& path);
+
+            bool isOpen() const { return this->header != nullptr; }
+
+            // The endgame, e.g. "KQKR"
+            std::string signature() const;
+
+            // The result of a position for its side to move. Positions with the colors
+            // of the endgame swapped are looked up mirrored; UNKNOWN if the material is
+            // neither.
+            Value probe(const Board& board) const;
+
+        private:
+            MappedFile file;
+            Material material;
+            const Header* header = nullptr;
+            const uint64_t* words = nullptr;
+    };
+};
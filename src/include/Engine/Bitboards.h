@@ -0,0 +1,131 @@
+#pragma once
+
+#include <bit>
+#include <string>
+
+#include "Types.h"
+
+namespace Chess
+{
+    namespace Bitboards
+    {
+        constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+        constexpr Bitboard FILE_H = FILE_A << 7;
+        constexpr Bitboard RANK_1 = 0xFFULL;
+        constexpr Bitboard RANK_2 = RANK_1 << 8;
+        constexpr Bitboard RANK_4 = RANK_1 << 24;
+        constexpr Bitboard RANK_5 = RANK_1 << 32;
+        constexpr Bitboard RANK_7 = RANK_1 << 48;
+        constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+        /**
+         * A magic bitboard entry for one square of one slider type. The relevant
+         * occupancy is multiplied by the magic number and shifted down to index the
+         * square's slice of the attack table.
+         */
+        struct Magic
+        {
+            Bitboard mask;
+            Bitboard magic;
+            Bitboard* attacks;
+            unsigned shift;
+
+            unsigned index(Bitboard occupied) const
+            {
+                return unsigned(((occupied & mask) * magic) >> shift);
+            }
+        };
+
+        // Pawn captures from each square, by color
+        extern Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+
+        // Knight moves from each square
+        extern Bitboard KnightAttacks[SQUARE_NB];
+
+        // King moves from each square
+        extern Bitboard KingAttacks[SQUARE_NB];
+
+        // Squares strictly between two squares on a shared line, empty otherwise
+        extern Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
+
+        // The full line through two squares, empty if they are not aligned
+        extern Bitboard LineBB[SQUARE_NB][SQUARE_NB];
+
+        // Magic entries for the sliders
+        extern Magic RookMagics[SQUARE_NB];
+        extern Magic BishopMagics[SQUARE_NB];
+
+        // Builds every attack table. Safe to call more than once, only the first call does work.
+        void init();
+
+        // Renders a bitboard as an 8x8 grid for debugging
+        std::string toString(Bitboard b);
+
+        // A bitboard with only the given square set
+        constexpr Bitboard squareBB(Square s) { return 1ULL << s; }
+
+        // Number of set bits
+        inline int popCount(Bitboard b) { return std::popcount(b); }
+
+        // Index of the least significant set bit. b must not be empty
+        inline Square lsb(Bitboard b) { return std::countr_zero(b); }
+
+        // Index of the most significant set bit. b must not be empty
+        inline Square msb(Bitboard b) { return 63 - std::countl_zero(b); }
+
+        // Removes and returns the least significant set bit. b must not be empty
+        inline Square popLsb(Bitboard& b)
+        {
+            Square s = lsb(b);
+            b &= b - 1;
+            return s;
+        }
+
+        // Whether more than one bit is set
+        constexpr bool moreThanOne(Bitboard b) { return b & (b - 1); }
+
+        // Shifts a bitboard one row towards the given side's opponent
+        constexpr Bitboard pawnPush(Color c, Bitboard b) { return c == WHITE ? b << 8 : b >> 8; }
+
+        // Squares attacked by a set of pawns of the given color
+        constexpr Bitboard pawnAttacksBB(Color c, Bitboard b)
+        {
+            return c == WHITE ? ((b & ~FILE_A) << 7) | ((b & ~FILE_H) << 9)
+                              : ((b & ~FILE_A) >> 9) | ((b & ~FILE_H) >> 7);
+        }
+
+        // Bishop attacks from a square given the board occupancy
+        inline Bitboard bishopAttacks(Square s, Bitboard occupied)
+        {
+            const Magic& m = BishopMagics[s];
+            return m.attacks[m.index(occupied)];
+        }
+
+        // Rook attacks from a square given the board occupancy
+        inline Bitboard rookAttacks(Square s, Bitboard occupied)
+        {
+            const Magic& m = RookMagics[s];
+            return m.attacks[m.index(occupied)];
+        }
+
+        // Queen attacks from a square given the board occupancy
+        inline Bitboard queenAttacks(Square s, Bitboard occupied)
+        {
+            return bishopAttacks(s, occupied) | rookAttacks(s, occupied);
+        }
+
+        // Attacks of any non pawn piece type from a square given the board occupancy
+        inline Bitboard attacks(Type t, Square s, Bitboard occupied)
+        {
+            switch(t)
+            {
+                case Type::KNIGHT: return KnightAttacks[s];
+                case Type::BISHOP: return bishopAttacks(s, occupied);
+                case Type::ROOK:   return rookAttacks(s, occupied);
+                case Type::QUEEN:  return queenAttacks(s, occupied);
+                case Type::KING:   return KingAttacks[s];
+                default:           return 0;
+            }
+        }
+    };
+};
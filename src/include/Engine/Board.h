@@ -0,0 +1,278 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Bitboards.h"
+#include "Fen.h"
+#include "Move.h"
+#include "Nnue.h"
+#include "Psqt.h"
+#include "Types.h"
+#include "Zobrist.h"
+
+namespace Chess
+{
+    // FEN of the standard starting position
+    constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    /**
+     * The part of the position that cannot be recovered when a move is taken back. One
+     * of these is pushed for every move made on the Board and popped when it is unmade.
+     */
+    struct StateInfo
+    {
+        // Zobrist key of the position
+        uint64_t key;
+
+        // Zobrist key of the pawns only, for the pawn hash table
+        uint64_t pawnKey;
+
+        // Pieces giving check to the side to move
+        Bitboard checkers;
+
+        // Pieces of the side to move that are pinned to their own king
+        Bitboard pinned;
+
+        // The en passant target square, SQ_NONE if there is none
+        Square epSquare;
+
+        // Remaining castling rights as a CastlingRights mask
+        uint8_t castling;
+
+        // The piece captured by the move that led here, NO_PIECE if none
+        Piece captured;
+
+        // Plies since the last capture or pawn move, for the fifty move rule
+        int halfmoveClock;
+
+        // Plies since the last null move, bounds the repetition scan
+        int pliesFromNull;
+    };
+
+    /**
+     * The engine's board representation. Pieces are kept both as bitboards (for move
+     * generation and attack detection) and as a mailbox (for "what is on this square").
+     * Moves are made and unmade in place so search never copies the board.
+     */
+    class Board
+    {
+        public:
+            // Constructs a board set up in the standard starting position
+            Board();
+
+            // Resets the board to the standard starting position
+            void setStartPosition();
+
+            // Sets the board up from a FEN string. The move counters may be left out.
+            // Returns false and leaves the board untouched if the FEN can not be parsed,
+            // or sets up the starting position if it describes an impossible position.
+            // Does not allocate once the board has been constructed.
+            bool setFen(std::string_view fen);
+
+            // Sets the board up from a parsed FEN. Returns false and sets up the starting
+            // position if the side that just moved is in check.
+            bool setPosition(const Fen::Position& position);
+
+            // The current position as plain values. The en passant square is only set if
+            // a capture on it is possible.
+            Fen::Position getPosition() const;
+
+            // Writes the FEN of the current position into buffer, which must have room for
+            // Fen::MAX_LENGTH characters. Returns its length.
+            size_t writeFen(char* buffer) const;
+
+            // The FEN of the current position
+            std::string fen() const;
+
+            // All pieces on the board
+            Bitboard pieces() const { return this->occupied; }
+
+            // All pieces of one color
+            Bitboard pieces(Color c) const { return this->byColor[c]; }
+
+            // All pieces of one type, both colors
+            Bitboard pieces(Type t) const { return this->byType[typeIndex(t)]; }
+
+            // All pieces of one color and type
+            Bitboard pieces(Color c, Type t) const { return this->byColor[c] & this->byType[typeIndex(t)]; }
+
+            // All pieces of one color and either of two types
+            Bitboard pieces(Color c, Type t1, Type t2) const
+            {
+                return this->byColor[c] & (this->byType[typeIndex(t1)] | this->byType[typeIndex(t2)]);
+            }
+
+            // The piece on a square, NO_PIECE if it is empty
+            Piece pieceOn(Square s) const { return this->mailbox[s]; }
+
+            // The piece a move would move
+            Piece movedPiece(Move m) const { return this->mailbox[m.from()]; }
+
+            // The side to move
+            Color sideToMove() const { return this->stm; }
+
+            // The square of a side's king
+            Square kingSquare(Color c) const { return Bitboards::lsb(pieces(c, Type::KING)); }
+
+            // Remaining castling rights as a CastlingRights mask
+            uint8_t castlingRights() const { return state().castling; }
+
+            // The en passant target square, SQ_NONE if there is none
+            Square epSquare() const { return state().epSquare; }
+
+            // Zobrist key of the position
+            uint64_t key() const { return state().key; }
+
+            // Zobrist key of the pawns of both sides
+            uint64_t pawnKey() const { return state().pawnKey; }
+
+            // Plies since the last capture or pawn move
+            int halfmoveClock() const { return state().halfmoveClock; }
+
+            // Number of moves made on this board since it was set up
+            int gamePly() const { return this->ply; }
+
+            // The move number as written in a FEN, starting at 1 and counting up after black moves
+            int fullmoveNumber() const { return 1 + (this->startPly + this->ply) / 2; }
+
+            // Pieces giving check to the side to move
+            Bitboard checkers() const { return state().checkers; }
+
+            // Whether the side to move is in check
+            bool inCheck() const { return state().checkers != 0; }
+
+            // Pieces of the side to move that are pinned to their king
+            Bitboard pinned() const { return state().pinned; }
+
+            // The piece captured by the last move, NO_PIECE if it was not a capture
+            Piece capturedPiece() const { return state().captured; }
+
+            // Sum of the material and piece-square scores of every piece, from white's
+            // point of view. Kept up to date as pieces move.
+            Score psqtScore() const { return this->psqt; }
+
+            // Game phase from the remaining non pawn material, MAX_PHASE at the start
+            int gamePhase() const { return this->phase; }
+
+            // Keeps an NNUE accumulator stack up to date from the current position on, or
+            // stops doing so if stack is null. Moves made before attaching must not be
+            // taken back while attached, and copies of the board share the stack.
+            void attachAccumulators(Nnue::AccumulatorStack* stack);
+
+            // The NNUE accumulator of the current position, null if no stack is attached
+            const Nnue::Accumulator* accumulator() const
+            {
+                return this->accumulators ? &this->accumulators->current() : nullptr;
+            }
+
+            // Pieces of both colors that attack a square, given an occupancy
+            Bitboard attackersTo(Square s, Bitboard occupancy) const;
+
+            // Whether a square is attacked by the given side
+            bool isAttacked(Square s, Color by) const;
+
+            // Whether a move could be played in this position, ignoring whether it leaves
+            // the king in check. Used to validate moves that did not come from the move
+            // generator such as hash moves and killers.
+            bool isPseudoLegal(Move m) const;
+
+            // Whether a pseudo-legal move leaves the mover's king safe
+            bool isLegal(Move m) const;
+
+            // Whether a pseudo-legal move gives check, directly or by discovery
+            bool givesCheck(Move m) const;
+
+            // Whether the position is drawn by the fifty move rule or by repetition. A
+            // single repetition inside the search tree (less than ply moves ago) is
+            // enough, since the side to move could repeat again.
+            bool isDraw(int ply) const;
+
+            // Static exchange evaluation. Plays out every capture on the move's target
+            // square, least valuable attacker first, and returns the material the side to
+            // move ends up winning (negative if it loses material).
+            int see(Move m) const;
+
+            // Whether the static exchange evaluation of a move is at least threshold. Much
+            // cheaper than see() since it stops as soon as the answer is known.
+            bool seeGe(Move m, int threshold) const;
+
+            // Plays a pseudo-legal move
+            void makeMove(Move m);
+
+            // Takes back the last move, which must be m
+            void unmakeMove(Move m);
+
+            // Passes the turn without moving. Must not be used when in check
+            void makeNullMove();
+
+            // Takes back a null move
+            void unmakeNullMove();
+
+        private:
+            // Pieces of each type, both colors
+            Bitboard byType[PIECE_TYPE_NB];
+
+            // Pieces of each color
+            Bitboard byColor[COLOR_NB];
+
+            // All pieces
+            Bitboard occupied;
+
+            // Running sum of Psqt::Table over all pieces
+            Score psqt;
+
+            // Running sum of Psqt::PhaseWeight over all pieces
+            int phase;
+
+            // The piece on each square
+            Piece mailbox[SQUARE_NB];
+
+            // NNUE accumulators updated by makeMove, null when the network is not in use
+            Nnue::AccumulatorStack* accumulators;
+
+            // The side to move
+            Color stm;
+
+            // Number of moves made since the board was set up
+            int ply;
+
+            // Plies played before the board was set up, as given by the FEN's move number
+            int startPly;
+
+            // One entry per move played, the back is the current state. Capacity is
+            // reserved up front so making moves does not allocate.
+            std::vector<StateInfo> states;
+
+            // The current state
+            const StateInfo& state() const { return this->states.back(); }
+
+            // Removes every piece and resets the state stack
+            void clear();
+
+            // Places a piece on an empty square
+            void putPiece(Piece p, Square s);
+
+            // Removes the piece from a square
+            void removePiece(Square s);
+
+            // Moves a piece from one square to an empty square
+            void movePiece(Square from, Square to);
+
+            // Pushes the accumulator of the position a move just reached. Each side's
+            // accumulator is updated from the features the move changed, or rebuilt if
+            // that side's king moved.
+            void pushAccumulator(const Nnue::DirtyPieces& dirty, Piece moved);
+
+            // Whether the side to move has any legal move
+            bool hasLegalMove() const;
+
+            // The square of the least valuable piece of color c in attackers, or SQ_NONE.
+            // Its type is stored in type.
+            Square leastValuableAttacker(Bitboard attackers, Color c, Type& type) const;
+
+            // Computes checkers and pinned pieces for the side to move
+            void updateCheckInfo(StateInfo& st) const;
+    };
+};
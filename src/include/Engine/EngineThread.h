@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "Board.h"
+#include "Move.h"
+#include "Search.h"
+#include "SearchPool.h"
+#include "SpscQueue.h"
+
+namespace Chess
+{
+    /**
+     * A request from the GUI to the engine thread
+     */
+    struct EngineCommand
+    {
+        enum Type
+        {
+            // Start searching board with limits
+            SEARCH,
+
+            // Finish the search now and report its best move
+            STOP,
+
+            // Abandon the search without reporting a best move
+            CANCEL,
+
+            // The expected move was played, the pondering search becomes a normal one
+            PONDERHIT,
+
+            // Forget everything learnt in earlier games
+            NEW_GAME,
+
+            // Leave the engine thread
+            QUIT
+        };
+
+        Type type = STOP;
+
+        // Id the search's updates are tagged with
+        uint32_t searchId = 0;
+
+        // Position to search, including the moves leading to it for repetition detection
+        Board board;
+        SearchLimits limits;
+    };
+
+    /**
+     * Progress or the outcome of a search, sent from the engine back to the GUI
+     */
+    struct EngineUpdate
+    {
+        enum Type
+        {
+            // A search iteration has completed
+            INFO,
+
+            // The search is over and bestMove should be played
+            BEST_MOVE
+        };
+
+        Type type = INFO;
+
+        // Id of the search this update belongs to
+        uint32_t searchId = 0;
+
+        int depth = 0;
+        int score = 0;
+        uint64_t nodes = 0;
+        uint64_t nps = 0;
+
+        // Milliseconds since the search started
+        int64_t time = 0;
+
+        Move pv[MAX_PLY];
+        int pvLength = 0;
+
+        // Only set for INFO. The search's counters so far.
+        SearchMetrics metrics;
+
+        // Only set for BEST_MOVE. ponderMove is the expected reply, if the search has one.
+        Move bestMove;
+        Move ponderMove;
+    };
+
+    /**
+     * Runs the engine next to a GUI without ever blocking it. Commands go to a dedicated
+     * engine thread through one lock-free queue and search progress comes back through
+     * another, which the GUI drains with poll() once per frame.
+     *
+     * Every method must be called from the same (GUI) thread. Each queue has exactly one
+     * producer and one consumer: the GUI pushes commands that the engine thread pops, and
+     * the search pool's main thread pushes updates that the GUI pops. Searches never
+     * overlap, so there is only ever one search thread producing updates.
+     */
+    class EngineThread
+    {
+        public:
+            // Queue capacities. Commands are rare, updates arrive once per iteration.
+            static constexpr size_t COMMAND_QUEUE_SIZE = 16;
+            static constexpr size_t UPDATE_QUEUE_SIZE = 256;
+
+            // Starts the engine thread with the given number of search threads and hash size
+            EngineThread(int threads = 1, size_t hashMb = TranspositionTable::DEFAULT_SIZE_MB);
+
+            // Cancels any search and joins the engine thread
+            ~EngineThread();
+
+            // Starts searching a copy of the board. A running search is stopped first and its
+            // remaining updates carry the old id. Returns the id of the new search.
+            uint32_t search(const Board& board, const SearchLimits& limits);
+
+            // Ends the running search early. Its best move is still reported.
+            void stop();
+
+            // Tells a search started with limits.ponder that the expected move was played.
+            // It keeps its tree and the time limit starts counting now.
+            void ponderhit();
+
+            // Ends the running search and throws its result away, e.g. when the position
+            // on the board was changed under it
+            void cancel();
+
+            // Clears the hash and history tables for a new game
+            void newGame();
+
+            // Takes the oldest pending update. Returns false if there is none. Never blocks.
+            bool poll(EngineUpdate& update);
+
+        private:
+            SearchPool pool;
+
+            // GUI to engine thread
+            SpscQueue<EngineCommand, COMMAND_QUEUE_SIZE> commands;
+
+            // Search thread to GUI
+            SpscQueue<EngineUpdate, UPDATE_QUEUE_SIZE> updates;
+
+            std::thread thread;
+
+            // Id handed out by the next call to search(). Only used by the GUI thread.
+            uint32_t nextSearchId;
+
+            // Search whose best move must not be reported. Read by the search thread.
+            std::atomic<uint32_t> cancelledSearchId;
+
+            // Set once the GUI stops draining updates, so the search thread gives up
+            // waiting for room in the queue
+            std::atomic<bool> quitting;
+
+            // Body of the engine thread
+            void run();
+
+            // Queues a command, waiting for room if the engine thread is behind
+            void send(EngineCommand&& command);
+
+            // Queues an update from the search thread. Progress updates are dropped when
+            // the GUI is behind, best moves wait for room.
+            void publish(EngineUpdate&& update);
+    };
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Fen.h"
+
+namespace Chess
+{
+    /**
+     * The positions of an EPD file, loaded in bulk. Each line is a FEN (usually without
+     * move counters) followed by operations such as bm e4; id "test 1";. Positions are
+     * kept in one contiguous array and all operations in one shared string, so a file of
+     * millions of lines costs a handful of allocations.
+     */
+    class EpdFile
+    {
+        public:
+            // Size of the chunks the file is read in
+            static constexpr size_t READ_CHUNK_SIZE = 1 << 20;
+
+            // Reads every line of a file, replacing what was loaded before. Blank lines and
+            // lines starting with '#' are ignored, lines that are not a valid position are
+            // counted and skipped. Returns false if the file can not be opened.
+            bool load(const std::string& path);
+
+            // Parses one line and appends it. Returns false if it is not a valid position.
+            bool add(std::string_view line);
+
+            // Removes every position
+            void clear();
+
+            // Number of positions loaded
+            size_t size() const { return this->positions.size(); }
+
+            // Lines skipped by the last load because they did not parse
+            size_t getSkippedLines() const { return this->skippedLines; }
+
+            // Bytes read by the last load
+            uint64_t getBytesRead() const { return this->bytesRead; }
+
+            const Fen::Position& position(size_t index) const { return this->positions[index]; }
+
+            // Everything after the position on its line, e.g. "bm e4; id \"test 1\";"
+            std::string_view operations(size_t index) const;
+
+            // The operand of one operation of a position without quotes, e.g. "e4" for
+            // "bm", or an empty view if the line does not have that operation
+            std::string_view operation(size_t index, std::string_view opcode) const;
+
+        private:
+            std::vector<Fen::Position> positions;
+
+            // Start of each position's operations in operationText, plus one final entry
+            // for the end of the last one
+            std::vector<uint32_t> operationOffsets = { 0 };
+
+            std::string operationText;
+
+            size_t skippedLines = 0;
+            uint64_t bytesRead = 0;
+    };
+};
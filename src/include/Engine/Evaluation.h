@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Board.h"
+#include "Pawns.h"
+
+namespace Chess
+{
+    // Small bonus for having the move
+    constexpr int TEMPO_BONUS = 10;
+
+    // Bonus for a passed pawn whose next square is empty, per row it has advanced
+    constexpr Score FREE_PASSER_BONUS = { 0, 5 };
+
+    // Static evaluation of a position in centipawns from the side to move's point of view.
+    // Uses the NNUE network if the board has accumulators attached. Otherwise adds the
+    // pawn structure from the pawn table to the board's incrementally updated material and
+    // piece-square sums, and blends middlegame and endgame values by game phase.
+    int evaluate(const Board& board, PawnTable& pawnTable);
+};
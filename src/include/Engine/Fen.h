@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * Forsyth-Edwards Notation without allocating: text is parsed from a string_view into
+     * a plain Position and written into a caller's buffer. The Board and the EPD loader
+     * are both built on it.
+     */
+    namespace Fen
+    {
+        // Room needed to write any FEN, including the terminating null
+        constexpr size_t MAX_LENGTH = 128;
+
+        // Largest halfmove clock and fullmove number a FEN may give
+        constexpr int MAX_MOVE_COUNTER = 10000;
+
+        /**
+         * Everything a FEN describes, as plain values
+         */
+        struct Position
+        {
+            Piece squares[SQUARE_NB];
+            Color sideToMove;
+
+            // CastlingRights flags. Rights whose king or rook is not in place are dropped.
+            uint8_t castling;
+
+            // The en passant square as written, SQ_NONE for "-"
+            Square epSquare;
+
+            int halfmoveClock;
+            int fullmoveNumber;
+        };
+
+        // Parses the placement, side to move, castling and en passant fields and the move
+        // counters if they follow. Returns the number of characters read, so EPD
+        // operations can be picked up after them, or 0 if the text is not a FEN of a
+        // position with one king per side and no pawns on the first or last row, or if a
+        // counter is negative or above MAX_MOVE_COUNTER.
+        size_t parse(std::string_view text, Position& position);
+
+        // Writes a FEN and a terminating null into buffer, which must have room for
+        // MAX_LENGTH characters. Returns the length without the null.
+        size_t write(const Position& position, char* buffer);
+    };
+};
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Board.h"
+#include "Fen.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include "Pgn.h"
+
+namespace Chess
+{
+    /**
+     * A compact binary game database. Compared to PGN it is several times smaller and is
+     * read without any text parsing:
+     *
+     *  - Tag names and values are interned into one string table, so a player or event
+     *    that appears in thousands of games is stored once and each tag costs 8 bytes.
+     *  - Each move is stored as its number among the pseudo-legal moves of the position
+     *    it is played in, which always fits one byte. The numbering is worked out from
+     *    the attack tables one piece at a time, so replaying builds no move lists and
+     *    needs no legality checks or notation.
+     *  - An index of record offsets gives constant time access to any game.
+     *
+     * The file is a Header, the game records, the string table and the index. It is read
+     * through a MappedFile, so opening an archive costs nothing and games are paged in as
+     * they are touched. All numbers are stored in the machine's byte order.
+     */
+    namespace Archive
+    {
+        constexpr char MAGIC[8] = { 'C', 'H', 'S', 'A', 'R', 'C', 'H', '1' };
+        constexpr uint32_t VERSION = 1;
+
+        /**
+         * Outcome of a game as stored in its record
+         */
+        enum class Result : uint8_t
+        {
+            UNKNOWN,
+            WHITE_WINS,
+            BLACK_WINS,
+            DRAW
+        };
+
+        // Result from PGN result text, UNKNOWN for "*" and anything unexpected
+        Result parseResult(std::string_view text);
+
+        // PGN result text of a result
+        const char* resultText(Result result);
+
+        /**
+         * Start of the file
+         */
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t stringCount;
+            uint64_t gameCount;
+
+            // Offset of the string table: stringCount + 1 uint32_t offsets into the
+            // character data that follows them
+            uint64_t stringsOffset;
+
+            // Offset of the index: gameCount + 1 uint64_t record offsets, the last one
+            // being the end of the last record
+            uint64_t indexOffset;
+        };
+
+        /**
+         * Fixed part of a game record. It is followed by tagCount Tags and then by one
+         * byte per ply, padded so the next record starts 4 byte aligned.
+         */
+        struct RecordHeader
+        {
+            uint32_t plies;
+            uint16_t tagCount;
+            Result result;
+
+            // False if the source game had a move that could not be read, in which case
+            // the moves stop before it
+            uint8_t complete;
+        };
+
+        /**
+         * A tag pair as two string table ids
+         */
+        struct Tag
+        {
+            uint32_t name;
+            uint32_t value;
+        };
+
+        class Reader;
+
+        /**
+         * One game read from an archive. The tags point into the mapping and the moves
+         * into the reader, so they are only valid until the reader reads another game.
+         */
+        struct Game
+        {
+            // Position of the game in the archive
+            uint64_t index;
+
+            Result result;
+            bool complete;
+
+            // Position the moves start from, from the FEN tag or the standard start
+            Fen::Position start;
+
+            // Decoded moves, nullptr if the game was read without them
+            const Move* moves;
+            int plies;
+
+            // Zobrist key of the position before each move and, at keys[plies], of the
+            // final position. nullptr together with moves.
+            const uint64_t* keys;
+
+            const Tag* tags;
+            int tagCount;
+
+            // The archive the game belongs to, to look up the tags' strings
+            const Reader* archive;
+
+            std::string_view tagName(int i) const;
+            std::string_view tagValue(int i) const;
+
+            // Value of a tag, e.g. tag("White"), or an empty view
+            std::string_view tag(std::string_view name) const;
+        };
+
+        // Called for each game. The parallel reader passes the index of the thread
+        // calling, from 0 to threads - 1.
+        typedef std::function<void(const Game&)> GameCallback;
+        typedef std::function<void(const Game&, int thread)> ParallelGameCallback;
+
+        /**
+         * Builds an archive game by game. Records are written to the file as they are
+         * added; the string table and the index are kept in memory and written by finish().
+         */
+        class Writer
+        {
+            public:
+                // Finishes the archive if that has not been done
+                ~Writer();
+
+                // Creates the file, replacing an existing one. Returns false if it can not
+                // be written.
+                bool open(const std::string& path);
+
+                // Appends a game read from PGN. Every tag is kept, including Result and FEN.
+                // Returns false if the game's moves are not legal from its start position.
+                bool add(const Pgn::Game& game);
+
+                // Appends a game from its tag pairs and moves
+                bool add(const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                         const Fen::Position& start, const Move* moves, int plies, Result result, bool complete = true);
+
+                // Writes the string table and index and closes the file. Returns false if
+                // anything could not be written.
+                bool finish();
+
+                uint64_t size() const { return this->offsets.size() - 1; }
+
+            private:
+                // Id of a string, interning it if it is new
+                uint32_t intern(std::string_view s);
+
+                std::ofstream file;
+                bool failed = false;
+
+                std::unordered_map<std::string, uint32_t> stringIds;
+                std::vector<std::string_view> strings;
+
+                // Record offsets so far plus the offset the next record will start at
+                std::vector<uint64_t> offsets;
+
+                // Scratch space reused by every add
+                Board board;
+                std::vector<char> record;
+                std::vector<std::pair<std::string_view, std::string_view>> tagPairs;
+        };
+
+        /**
+         * Reads an archive through a memory mapping
+         */
+        class Reader
+        {
+            public:
+                Reader();
+
+                // Maps an archive. Returns false if it can not be read or is not an
+                // archive of this version.
+                bool open(const std::string& path, MappedFile::Access access = MappedFile::Access::SEQUENTIAL);
+
+                uint64_t size() const { return this->header ? this->header->gameCount : 0; }
+
+                uint32_t stringCount() const { return this->header ? this->header->stringCount : 0; }
+
+                // A string of the string table
+                std::string_view string(uint32_t id) const
+                {
+                    return std::string_view(this->stringData + this->stringOffsets[id],
+                                            this->stringOffsets[id + 1] - this->stringOffsets[id]);
+                }
+
+                // Id of a string, or UINT32_MAX if no tag uses it. Searches the whole table.
+                uint32_t findString(std::string_view s) const;
+
+                // Reads game index. With replay false only the tags, result and length
+                // are read and moves is nullptr, which is enough for most statistics and
+                // many times faster. Returns false if the game's moves are corrupt.
+                bool game(uint64_t index, Game& game, bool replay = true);
+
+                // Reads games [first, last) in order, passing each to onGame. Returns the
+                // number of games that were corrupt.
+                uint64_t read(uint64_t first, uint64_t last, const GameCallback& onGame, bool replay = true);
+
+                // Reads every game
+                uint64_t read(const GameCallback& onGame, bool replay = true) { return read(0, size(), onGame, replay); }
+
+                // Size of the file in bytes
+                size_t fileSize() const { return this->file.size(); }
+
+            private:
+                MappedFile file;
+                const Header* header = nullptr;
+                const uint32_t* stringOffsets = nullptr;
+                const char* stringData = nullptr;
+                const uint64_t* recordOffsets = nullptr;
+
+                // Id of "FEN", whose games do not start from the standard position
+                uint32_t fenId = UINT32_MAX;
+
+                Fen::Position startPosition;
+                Board board;
+                std::vector<Move> moves;
+                std::vector<uint64_t> keys;
+        };
+
+        // Splits the games of an archive into one range per thread and reads them at the
+        // same time, each thread through its own Reader. Games are in order within a
+        // thread but not across threads. Returns the number of corrupt games, or
+        // UINT64_MAX if the archive can not be opened.
+        uint64_t readParallel(const std::string& path, int threads, const ParallelGameCallback& onGame,
+                              bool replay = true);
+
+        /**
+         * Totals of a conversion
+         */
+        struct ConvertStats
+        {
+            uint64_t games = 0;
+            uint64_t plies = 0;
+
+            // Games that were skipped or cut short because a move could not be read
+            uint64_t errors = 0;
+        };
+
+        // Converts a PGN file into an archive
+        bool fromPgn(const std::string& pgnPath, const std::string& archivePath, ConvertStats& stats);
+
+        // Converts an archive back into PGN. Tags are written in their original order and
+        // moves in SAN, so a PGN file without comments and variations round trips exactly
+        // apart from line breaks.
+        bool toPgn(const std::string& archivePath, const std::string& pgnPath, ConvertStats& stats);
+
+        // Appends a game as PGN text. The board is used as scratch space.
+        void appendPgn(const Game& game, Board& board, std::string& out);
+    };
+};
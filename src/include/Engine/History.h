@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Move.h"
+#include "Types.h"
+
+namespace Chess
+{
+    // Bound on the magnitude of every history entry
+    constexpr int HISTORY_MAX = 16384;
+
+    // Quiet move success statistics indexed by [side to move][from][to]
+    typedef int16_t ButterflyHistory[COLOR_NB][SQUARE_NB][SQUARE_NB];
+
+    // Quiet move success statistics indexed by [moved piece][to]
+    typedef int16_t PieceToHistory[PIECE_NB][SQUARE_NB];
+
+    // Piece-to statistics for the reply to an earlier move, indexed by that move's
+    // [moved piece][to] and then by the reply's [moved piece][to]
+    typedef PieceToHistory ContinuationHistory[PIECE_NB][SQUARE_NB];
+
+    // Adds bonus to a history entry with gravity: the closer the entry already is to
+    // HISTORY_MAX in the bonus' direction the less it moves, so entries stay bounded and
+    // old results decay as new ones come in.
+    inline void updateHistoryEntry(int16_t& entry, int bonus)
+    {
+        bonus = bonus > HISTORY_MAX ? HISTORY_MAX : (bonus < -HISTORY_MAX ? -HISTORY_MAX : bonus);
+        int absBonus = bonus < 0 ? -bonus : bonus;
+        entry = int16_t(entry + bonus - entry * absBonus / HISTORY_MAX);
+    }
+
+    /**
+     * The move ordering statistics of one search thread: butterfly and continuation
+     * history, two killer moves per ply and a countermove table. The tables are
+     * allocated once with the thread and cleared or aged in place between searches.
+     */
+    class HistoryTables
+    {
+        public:
+            HistoryTables();
+
+            // Forgets everything, e.g. when a new game starts
+            void clear();
+
+            // Scales all history down and drops the killers between two searches of the same
+            // game, so the next search starts from useful but not stale statistics
+            void age();
+
+            // The two killer moves of a ply
+            const Move* getKillers(int ply) const { return this->killers[ply]; }
+
+            // Records a quiet move that caused a cutoff at a ply
+            void storeKiller(int ply, Move m);
+
+            // The move that last refuted the previous move, given the piece it moved and where to
+            Move getCounterMove(Piece previousPiece, Square previousTo) const
+            {
+                return this->counterMoves[previousPiece][previousTo];
+            }
+
+            // Records the move that refuted the previous move
+            void storeCounterMove(Piece previousPiece, Square previousTo, Move m)
+            {
+                this->counterMoves[previousPiece][previousTo] = m;
+            }
+
+            // The butterfly table, for the move picker
+            const ButterflyHistory& getButterfly() const { return this->butterfly; }
+
+            // The continuation table following a move of a piece to a square
+            PieceToHistory* getContinuation(Piece previousPiece, Square previousTo)
+            {
+                return &this->continuation[previousPiece][previousTo];
+            }
+
+            // Rewards the quiet move that caused a cutoff and penalises the quiet moves tried
+            // before it. continuations holds the tables of the previous two moves, either of
+            // which may be null.
+            void updateQuietStats(Color us, Piece piece, Move best, const Move* triedQuiets,
+                                  const Piece* triedPieces, int triedCount, int depth,
+                                  PieceToHistory* const* continuations);
+
+            // The size of the bonus for a cutoff at the given depth
+            static int statBonus(int depth);
+
+        private:
+            // History by side, from and to
+            ButterflyHistory butterfly;
+
+            // History by the previous move's piece and destination and this move's piece and destination
+            ContinuationHistory continuation;
+
+            // Killer moves per ply, most recent first
+            Move killers[MAX_PLY + 1][2];
+
+            // Refutation of each previous [piece][to]
+            Move counterMoves[PIECE_NB][SQUARE_NB];
+
+            // Applies a bonus to one quiet move in every table
+            void updateQuiet(Color us, Piece piece, Move m, int bonus, PieceToHistory* const* continuations);
+    };
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Chess
+{
+    /**
+     * A read-only memory mapping of a whole file. Large databases, indexes and books are
+     * read through it so nothing has to be loaded up front: pages are brought in by the
+     * OS as they are touched and shared between processes.
+     */
+    class MappedFile
+    {
+        public:
+            /**
+             * How the file is going to be read, passed on to the OS as a paging hint
+             */
+            enum class Access
+            {
+                SEQUENTIAL,
+                RANDOM
+            };
+
+            MappedFile() = default;
+
+            // Unmaps the file
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // Maps a file, unmapping the previous one. Returns false if it can not be opened.
+            bool open(const std::string& path, Access access = Access::SEQUENTIAL);
+
+            // Unmaps the file
+            void close();
+
+            bool isOpen() const { return this->opened; }
+
+            const char* data() const { return this->bytes; }
+            size_t size() const { return this->length; }
+
+            // The whole file as text
+            std::string_view view() const { return std::string_view(this->bytes, this->length); }
+
+        private:
+            const char* bytes = nullptr;
+            size_t length = 0;
+            bool opened = false;
+    };
+};
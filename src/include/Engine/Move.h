@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * The kind of move encoded in the top 4 bits of a Move. Bit 2 marks a capture and
+     * bit 3 marks a promotion, with the low 2 bits holding the promotion piece.
+     */
+    enum MoveFlag : uint16_t
+    {
+        QUIET = 0,
+        DOUBLE_PUSH = 1,
+        KING_CASTLE = 2,
+        QUEEN_CASTLE = 3,
+        CAPTURE = 4,
+        EN_PASSANT = 5,
+        PROMO_KNIGHT = 8,
+        PROMO_BISHOP = 9,
+        PROMO_ROOK = 10,
+        PROMO_QUEEN = 11,
+        PROMO_CAPTURE_KNIGHT = 12,
+        PROMO_CAPTURE_BISHOP = 13,
+        PROMO_CAPTURE_ROOK = 14,
+        PROMO_CAPTURE_QUEEN = 15
+    };
+
+    /**
+     * A chess move packed into 16 bits: 6 bits for the from square, 6 bits for the to
+     * square and 4 bits of MoveFlag. A default constructed Move (a1a1) means "no move".
+     */
+    class Move
+    {
+        public:
+            // Constructs the null move
+            constexpr Move() : data(0) {}
+
+            // Constructs a move from its squares and flag
+            constexpr Move(Square from, Square to, MoveFlag flag = QUIET)
+                : data(uint16_t(from | (to << 6) | (flag << 12))) {}
+
+            // Rebuilds a move from its packed 16 bit form
+            static constexpr Move fromRaw(uint16_t raw) { Move m; m.data = raw; return m; }
+
+            // The square the piece moves from
+            constexpr Square from() const { return data & 63; }
+
+            // The square the piece moves to
+            constexpr Square to() const { return (data >> 6) & 63; }
+
+            // The kind of move
+            constexpr MoveFlag flag() const { return MoveFlag(data >> 12); }
+
+            // Whether the move captures a piece, including en passant
+            constexpr bool isCapture() const { return data & (CAPTURE << 12); }
+
+            // Whether the move promotes a pawn
+            constexpr bool isPromotion() const { return data & (PROMO_KNIGHT << 12); }
+
+            // Whether the move is a capture or a promotion
+            constexpr bool isNoisy() const { return data & ((CAPTURE | PROMO_KNIGHT) << 12); }
+
+            // Whether the move is castling
+            constexpr bool isCastling() const { return flag() == KING_CASTLE || flag() == QUEEN_CASTLE; }
+
+            // The piece a pawn promotes to. Only meaningful if isPromotion() is true
+            constexpr Type promotionType() const { return Type(typeIndex(Type::KNIGHT) + ((data >> 12) & 3)); }
+
+            // The packed 16 bit form of the move
+            constexpr uint16_t raw() const { return data; }
+
+            // Whether this is a real move rather than the null move
+            constexpr bool isValid() const { return data != 0; }
+
+            constexpr bool operator==(const Move& other) const { return data == other.data; }
+            constexpr bool operator!=(const Move& other) const { return data != other.data; }
+
+            // The move in UCI long algebraic notation, e.g. "e2e4" or "e7e8q"
+            std::string toUci() const
+            {
+                if(!isValid())
+                {
+                    return "0000";
+                }
+
+                std::string uci = squareToString(from()) + squareToString(to());
+                if(isPromotion())
+                {
+                    uci += "nbrq"[(data >> 12) & 3];
+                }
+                return uci;
+            }
+
+        private:
+            // The packed move
+            uint16_t data;
+    };
+
+    /**
+     * A move with an ordering score attached, as used by the move generator and picker
+     */
+    struct ScoredMove
+    {
+        Move move;
+        int score;
+    };
+
+    /**
+     * A fixed capacity list of moves that lives on the stack so move generation never
+     * allocates.
+     */
+    class MoveList
+    {
+        public:
+            MoveList() : count(0) {}
+
+            // Appends a move with a zero score
+            void add(Move m) { moves[count++] = { m, 0 }; }
+
+            // Number of moves in the list
+            int size() const { return count; }
+
+            // Empties the list
+            void clear() { count = 0; }
+
+            ScoredMove& operator[](int i) { return moves[i]; }
+            const ScoredMove& operator[](int i) const { return moves[i]; }
+
+            ScoredMove* begin() { return moves; }
+            ScoredMove* end() { return moves + count; }
+            const ScoredMove* begin() const { return moves; }
+            const ScoredMove* end() const { return moves + count; }
+
+        private:
+            // The storage for the moves
+            ScoredMove moves[MAX_MOVES];
+
+            // Number of moves stored
+            int count;
+    };
+};
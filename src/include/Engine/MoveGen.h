@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Board.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * Which subset of the pseudo-legal moves to generate. CAPTURES also includes every
+     * promotion, so CAPTURES and QUIETS together make up ALL.
+     */
+    enum GenType
+    {
+        CAPTURES,
+        QUIETS,
+        ALL
+    };
+
+    // Appends the pseudo-legal moves of the requested kind to the list. The moves may
+    // leave the king in check, so callers must check Board::isLegal before playing them.
+    template<GenType T>
+    void generateMoves(const Board& board, MoveList& list);
+
+    // Appends only the legal moves to the list
+    void generateLegalMoves(const Board& board, MoveList& list);
+
+    // The legal move written in UCI notation (e.g. "e2e4", "e7e8q"), or an invalid Move
+    // if there is no such legal move
+    Move findLegalMove(const Board& board, std::string_view uci);
+
+    // The legal move written in standard algebraic notation (e.g. "Nf3", "exd5", "O-O",
+    // "e8=Q+"), or an invalid Move if the text is not a unique legal move. Check marks and
+    // annotations are optional, castling may also be written with zeros.
+    Move findSanMove(const Board& board, std::string_view san);
+
+    // A legal move in standard algebraic notation, with a check or mate mark. The board is
+    // used as scratch space to look for mate and is back in its original state afterwards.
+    std::string toSan(Board& board, Move m);
+
+    // Counts the leaf nodes of the legal move tree to the given depth. Used to verify
+    // move generation and to benchmark make/unmake.
+    uint64_t perft(Board& board, int depth);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+#include "History.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * Hands out the moves of a position one at a time in the order search wants to try
+     * them: hash move, winning captures, killers, countermove, quiets by history and
+     * finally losing captures. Each stage is only generated once the previous one is
+     * used up, so a node that cuts off early never pays for generating its quiet moves.
+     *
+     * Moves are pseudo-legal. The caller must check Board::isLegal before playing one.
+     */
+    class MovePicker
+    {
+        public:
+            // Constructs a picker for a main search node. killers must point to two moves.
+            // history may be null if no statistics are available, otherwise continuations
+            // must point to the continuation tables of the previous two moves (either may
+            // be null).
+            MovePicker(const Board& board, Move ttMove, const Move* killers, Move counterMove,
+                       const ButterflyHistory* history, PieceToHistory* const* continuations);
+
+            // Constructs a picker for a quiescence search node, which only sees captures and
+            // promotions, plus quiet checks when generateChecks is true. When the side to
+            // move is in check every move is returned so mates are still found.
+            MovePicker(const Board& board, Move ttMove, bool generateChecks);
+
+            // Returns the next move to try, or an invalid Move when there are none left.
+            // Once skipQuiets is passed as true the remaining quiet moves are dropped.
+            Move nextMove(bool skipQuiets = false);
+
+        private:
+            /**
+             * The stages of the picker, in the order they are visited
+             */
+            enum Stage
+            {
+                TT_MOVE,
+                CAPTURE_INIT,
+                GOOD_CAPTURE,
+                KILLER_1,
+                KILLER_2,
+                COUNTERMOVE,
+                QUIET_INIT,
+                QUIET,
+                BAD_CAPTURE,
+                DONE,
+
+                QS_TT_MOVE,
+                QS_CAPTURE_INIT,
+                QS_CAPTURE,
+                QS_CHECK_INIT,
+                QS_CHECK,
+                QS_DONE
+            };
+
+            // The position moves are picked for
+            const Board& board;
+
+            // The current stage
+            int stage;
+
+            // The hash move
+            Move ttMove;
+
+            // The two killer moves for this ply
+            Move killers[2];
+
+            // The move that last refuted the opponent's previous move
+            Move counterMove;
+
+            // History used to order quiet moves, may be null
+            const ButterflyHistory* history;
+
+            // Continuation history of the previous two moves, entries may be null
+            const PieceToHistory* continuations[2];
+
+            // Whether a quiescence picker should return quiet checks after the captures
+            bool generateChecks;
+
+            // Captures and promotions. Losing captures are moved to the front of the list
+            // while the good ones are picked, and played last.
+            MoveList captures;
+
+            // Quiet moves
+            MoveList quiets;
+
+            // Index of the next move to look at in the current list
+            int current;
+
+            // Number of losing captures stored at the front of the captures list
+            int badCaptureCount;
+
+            // Scores captures by victim value first and attacker value second (MVV-LVA).
+            // Exchange evaluation then splits them into winning and losing captures.
+            void scoreCaptures();
+
+            // Scores quiet moves by the sum of their butterfly and continuation history
+            void scoreQuiets();
+
+            // Whether a capture loses material according to static exchange evaluation
+            bool isLosingCapture(Move m) const;
+
+            // Whether a move is one of the special moves already handed out by an earlier stage
+            bool isSpecialQuiet(Move m) const;
+
+            // Swaps the highest scored move of list[current..] into list[current] and returns it
+            Move pickBest(MoveList& list);
+    };
+};
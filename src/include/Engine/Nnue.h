@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+namespace Chess
+{
+    class Board;
+
+    /**
+     * An efficiently updatable neural network (NNUE) evaluation using HalfKP features:
+     * every non king piece is a feature relative to each side's own king. The first
+     * layer's output (the accumulator) is kept per position and updated as pieces move,
+     * so evaluating a position mostly costs the small dense layers on top.
+     *
+     * The layout and file format match the original HalfKP 256x2-32-32-1 networks.
+     */
+    namespace Nnue
+    {
+        // Number of piece-square features per king square: 10 piece kinds on 64 squares plus one
+        constexpr int PIECE_SQUARE_NB = 641;
+
+        // Number of input features per perspective
+        constexpr int INPUT_DIMENSIONS = PIECE_SQUARE_NB * SQUARE_NB;
+
+        // Size of the accumulator for one perspective
+        constexpr int HALF_DIMENSIONS = 256;
+
+        // Sizes of the dense layers
+        constexpr int HIDDEN1_DIMENSIONS = 32;
+        constexpr int HIDDEN2_DIMENSIONS = 32;
+
+        // File format version of the networks that can be loaded
+        constexpr uint32_t FILE_VERSION = 0x7AF32F16;
+
+        /**
+         * The first layer's output for both perspectives of one position
+         */
+        struct alignas(64) Accumulator
+        {
+            int16_t values[COLOR_NB][HALF_DIMENSIONS];
+        };
+
+        /**
+         * One accumulator per ply of the line being played on a Board. Capacity is reserved
+         * up front so making moves does not allocate.
+         */
+        class AccumulatorStack
+        {
+            public:
+                AccumulatorStack();
+
+                // The accumulator of the current position
+                Accumulator& current() { return this->entries[this->top]; }
+
+                // The accumulator of the position before the current one
+                Accumulator& previous() { return this->entries[this->top - 1]; }
+
+                // Adds an entry for a new position. References to earlier entries may be
+                // invalidated if the stack has to grow.
+                void push()
+                {
+                    if(++this->top == int(this->entries.size()))
+                    {
+                        this->entries.emplace_back();
+                    }
+                }
+
+                // Drops the current entry, returning to the previous position
+                void pop() { this->top--; }
+
+                // Drops every entry but one
+                void reset() { this->top = 0; }
+
+            private:
+                std::vector<Accumulator> entries;
+                int top;
+        };
+
+        /**
+         * The features a move removes and adds, as (piece, square) pairs. Kings are not
+         * features and are never listed.
+         */
+        struct DirtyPieces
+        {
+            Piece removedPieces[2];
+            Square removedSquares[2];
+            int removedCount = 0;
+
+            Piece addedPieces[2];
+            Square addedSquares[2];
+            int addedCount = 0;
+
+            void remove(Piece p, Square s)
+            {
+                this->removedPieces[this->removedCount] = p;
+                this->removedSquares[this->removedCount++] = s;
+            }
+
+            void add(Piece p, Square s)
+            {
+                this->addedPieces[this->addedCount] = p;
+                this->addedSquares[this->addedCount++] = s;
+            }
+        };
+
+        /**
+         * The instruction sets the network can be run with
+         */
+        enum class Kernel
+        {
+            SCALAR,
+            SSE41,
+            AVX2
+        };
+
+        // Loads a network file. Returns false, keeping the previous network, if the file
+        // can not be read or is not a supported network.
+        bool load(const std::string& path);
+
+        // Fills the network with deterministic pseudo-random weights. Used for benchmarking
+        // when no network file is at hand.
+        void randomize(uint64_t seed);
+
+        // Whether a network has been loaded or generated
+        bool isLoaded();
+
+        // Whether the CPU can run a kernel
+        bool isSupported(Kernel kernel);
+
+        // The fastest kernel the CPU supports
+        Kernel bestKernel();
+
+        // The kernel in use. Defaults to bestKernel()
+        Kernel currentKernel();
+
+        // Switches kernels. Returns false if the CPU does not support it.
+        bool setKernel(Kernel kernel);
+
+        // Human readable kernel name
+        const char* kernelName(Kernel kernel);
+
+        // Rebuilds one perspective of an accumulator from scratch
+        void refresh(const Board& board, Accumulator& accumulator, Color perspective);
+
+        // Computes one perspective of child from parent by removing and adding the
+        // features of a move. The perspective's king must not have moved.
+        void update(const Accumulator& parent, Accumulator& child, Color perspective, Square kingSquare,
+                    const DirtyPieces& dirty);
+
+        // Evaluates the position from an up to date accumulator, in centipawns from the
+        // side to move's point of view
+        int evaluate(const Accumulator& accumulator, Color sideToMove);
+    };
+};
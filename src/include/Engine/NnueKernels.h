@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Chess
+{
+    namespace Nnue
+    {
+        /**
+         * The hot loops of the network for one instruction set. Dimensions passed in must
+         * be multiples of 32 and all buffers must be 64 byte aligned.
+         */
+        struct KernelSet
+        {
+            // child = parent - sum(removed rows) + sum(added rows), over HALF_DIMENSIONS values
+            void (*updateAccumulator)(const int16_t* parent, int16_t* child,
+                                      const int16_t* const* removed, int removedCount,
+                                      const int16_t* const* added, int addedCount);
+
+            // Clamps both halves of an accumulator to [0, 127], side to move first
+            void (*transform)(const int16_t* us, const int16_t* them, uint8_t* output);
+
+            // output[i] = biases[i] + sum_j weights[i * inputDim + j] * input[j]
+            void (*affine)(const uint8_t* input, int inputDim, const int8_t* weights,
+                           const int32_t* biases, int32_t* output, int outputDim);
+
+            // output[i] = clamp(input[i] >> 6, 0, 127)
+            void (*clippedRelu)(const int32_t* input, uint8_t* output, int dim);
+        };
+
+        // Portable C++ kernels
+        extern const KernelSet ScalarKernels;
+
+#if defined(__x86_64__) || defined(__i386__)
+        // SSE4.1 kernels
+        extern const KernelSet Sse41Kernels;
+
+        // AVX2 kernels
+        extern const KernelSet Avx2Kernels;
+#endif
+    };
+};
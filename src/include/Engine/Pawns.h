@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Board.h"
+#include "Psqt.h"
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * Everything the evaluation knows about one pawn structure. The structure score only
+     * depends on the pawns, the shelter scores also depend on where the kings are and are
+     * recomputed when a king has moved since they were cached.
+     */
+    struct PawnEntry
+    {
+        // Pawn key of the structure, 0 for an unused entry. Real pawn keys are never 0.
+        uint64_t key;
+
+        // Passed, isolated, doubled and backward pawn terms, from white's point of view
+        Score score;
+
+        // Passed pawns of each side
+        Bitboard passed[COLOR_NB];
+
+        // King squares the shelter scores were computed for
+        Square kingSquares[COLOR_NB];
+
+        // Bonus for the pawns in front of each side's king
+        Score shelter[COLOR_NB];
+    };
+
+    /**
+     * A hash table of pawn structure evaluations indexed by the board's pawn key. Pawn
+     * moves are rare compared to other moves, so almost every lookup in a search is a
+     * hit. Each search thread owns one so no locking is needed.
+     */
+    class PawnTable
+    {
+        public:
+            // Number of entries, a power of two
+            static constexpr size_t ENTRY_COUNT = 1 << 14;
+
+            PawnTable();
+
+            // The entry for the board's pawn structure and king squares, evaluated
+            // first if it is not cached
+            const PawnEntry& probe(const Board& board);
+
+            // Forgets every cached structure
+            void clear();
+
+            // Lookups and hits since the counters were last reset
+            uint64_t getProbes() const { return this->probes; }
+            uint64_t getHits() const { return this->hits; }
+
+            // Resets the lookup counters
+            void resetStats();
+
+        private:
+            std::vector<PawnEntry> entries;
+            uint64_t probes;
+            uint64_t hits;
+    };
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "Board.h"
+#include "Fen.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * Reading of PGN game databases. The text is tokenized in place, usually straight
+     * from a MappedFile, and each game's moves are resolved against the move generator
+     * into a Move array that is reused from game to game, so reading allocates nothing
+     * per game. Only the main line is read: comments, NAGs and variations are skipped.
+     */
+    namespace Pgn
+    {
+        /**
+         * One game as read from the text. The views point into the text and the moves into
+         * the reader, so they are only valid while the callback that receives it runs.
+         */
+        struct Game
+        {
+            // The tag pair section, e.g. [Event "..."] [Site "..."] ...
+            std::string_view tags;
+
+            // "1-0", "0-1", "1/2-1/2" or "*", empty if the game text ends without one
+            std::string_view result;
+
+            // Position the moves start from, from the FEN tag or the standard start
+            Fen::Position start;
+
+            const Move* moves;
+            int plies;
+
+            // False if a move could not be resolved. The moves up to it are still given.
+            bool complete;
+
+            // Value of a tag without quotes, e.g. tag("White"), or an empty view
+            std::string_view tag(std::string_view name) const;
+        };
+
+        /**
+         * Totals over everything read
+         */
+        struct Stats
+        {
+            uint64_t games = 0;
+            uint64_t plies = 0;
+
+            // Games with a move that could not be resolved
+            uint64_t errors = 0;
+
+            uint64_t bytes = 0;
+
+            Stats& operator+=(const Stats& other);
+        };
+
+        // Called for each game. The parallel reader passes the index of the thread
+        // calling, from 0 to threads - 1.
+        typedef std::function<void(const Game&)> GameCallback;
+        typedef std::function<void(const Game&, int thread)> ParallelGameCallback;
+
+        /**
+         * Reads games one after the other on the calling thread
+         */
+        class Reader
+        {
+            public:
+                Reader();
+
+                // Reads every game in text, in order
+                Stats read(std::string_view text, const GameCallback& onGame);
+
+            private:
+                Board board;
+                std::vector<Move> moves;
+        };
+
+        // Position of the first game starting at or after from, or text.size() if there
+        // is none. A game starts with a tag line that follows a blank line.
+        size_t nextGameStart(std::string_view text, size_t from);
+
+        // Splits text at game boundaries into one piece per thread and reads them at the
+        // same time. Games are in order within a thread but not across threads.
+        Stats readParallel(std::string_view text, int threads, const ParallelGameCallback& onGame);
+    };
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * Opening books in the Polyglot .bin format: a file of 16 byte big-endian entries
+     * (key, move, weight, learn) sorted by the position's Polyglot key. Books are read
+     * through a MappedFile and probed with a binary search, so a book of any size is
+     * ready as soon as it is opened and a probe costs a few page touches.
+     *
+     * Polyglot keys use their own table of 781 random numbers (Random64 in Polyglot's
+     * sources), unrelated to the engine's Zobrist keys and compiled in.
+     */
+    namespace Polyglot
+    {
+        // Numbers in the key table: 12 pieces on 64 squares, 4 castling rights, 8 en
+        // passant files and the side to move
+        constexpr int RANDOM_COUNT = 781;
+
+        // The Polyglot key of a position. The en passant file only counts if a pawn of
+        // the side to move stands next to the pawn that just moved.
+        uint64_t key(const Board& board);
+
+        // A move in Polyglot's encoding, with castling written as the king taking its rook
+        uint16_t encodeMove(Move m);
+
+        /**
+         * One of a position's moves in a book
+         */
+        struct BookMove
+        {
+            Move move;
+            uint16_t weight;
+            uint32_t learn;
+        };
+
+        /**
+         * How to choose among a position's book moves
+         */
+        enum class Selection
+        {
+            // The move with the highest weight
+            BEST,
+
+            // A move at random with a probability proportional to its weight
+            WEIGHTED_RANDOM
+        };
+
+        /**
+         * A Polyglot book mapped into memory
+         */
+        class Book
+        {
+            public:
+                // Size of an entry in the file
+                static constexpr size_t ENTRY_SIZE = 16;
+
+                Book();
+
+                // Maps a book. Returns false if it can not be read or its size is not a
+                // whole number of entries.
+                bool open(const std::string& path);
+
+                bool isOpen() const { return this->file.isOpen(); }
+
+                // Number of entries
+                size_t size() const { return this->file.size() / ENTRY_SIZE; }
+
+                // The legal book moves of a position in the order of the book, usually
+                // highest weight first
+                std::vector<BookMove> moves(const Board& board) const;
+
+                // Chooses a book move, or returns an invalid Move if the position is not
+                // in the book
+                Move pick(const Board& board, Selection selection);
+
+            private:
+                MappedFile file;
+                std::mt19937_64 random;
+        };
+    };
+};
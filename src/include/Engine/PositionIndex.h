@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "GameArchive.h"
+#include "MappedFile.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * An on-disk index from positions to the games of a game archive that reached them,
+     * answering "which games had this position and what was played next". Every position
+     * of every game is an Entry of (Zobrist key, game, ply, next move), and the file holds
+     * them sorted by key so a memory mapping can be searched as is, with no load step.
+     *
+     * On top of the entries sits a search tree holding the first key of each block of
+     * BLOCK_SIZE entries in Eytzinger (breadth first) order. Its top levels share a few
+     * cache lines, so a lookup touches far fewer pages than a plain binary search of the
+     * entries. Both searches are available, mostly to compare them.
+     */
+    class PositionIndex
+    {
+        public:
+            static constexpr char MAGIC[8] = { 'C', 'H', 'S', 'P', 'I', 'D', 'X', '1' };
+            static constexpr uint32_t VERSION = 1;
+
+            // Entries per block of the search tree
+            static constexpr uint32_t BLOCK_SIZE = 64;
+
+            /**
+             * Start of the file
+             */
+            struct Header
+            {
+                char magic[8];
+                uint32_t version;
+                uint32_t blockSize;
+                uint64_t entryCount;
+
+                // Games in the archive the index was built from
+                uint64_t gameCount;
+
+                // Key of the standard start position, to catch an index built with other
+                // Zobrist keys
+                uint64_t startKey;
+
+                // Offset of the search tree: blockCount + 1 uint64_t keys (the first one
+                // unused) followed by as many uint32_t block numbers
+                uint64_t treeOffset;
+                uint64_t blockCount;
+            };
+
+            /**
+             * One position of one game. Entries follow the header, sorted by key, game
+             * and ply.
+             */
+            struct Entry
+            {
+                uint64_t key;
+                uint32_t game;
+                uint16_t ply;
+
+                // Raw Move played from the position, 0 if the game ended there
+                uint16_t move;
+            };
+
+            /**
+             * How to look up a key
+             */
+            enum class Search
+            {
+                BINARY,
+                EYTZINGER
+            };
+
+            /**
+             * What was played from a position across the games that reached it
+             */
+            struct MoveStats
+            {
+                // The move, invalid for the games that ended in the position
+                Move move;
+
+                uint32_t games = 0;
+                uint32_t whiteWins = 0;
+                uint32_t draws = 0;
+                uint32_t blackWins = 0;
+            };
+
+            /**
+             * Totals of an index build
+             */
+            struct BuildStats
+            {
+                uint64_t games = 0;
+                uint64_t entries = 0;
+
+                // Games that could not be read from the archive
+                uint64_t errors = 0;
+            };
+
+            // Maps an index. Returns false if it can not be read, is not an index of this
+            // version or was built with other Zobrist keys.
+            bool open(const std::string& path);
+
+            uint64_t size() const { return this->header ? this->header->entryCount : 0; }
+
+            // Games in the archive the index belongs to
+            uint64_t gameCount() const { return this->header ? this->header->gameCount : 0; }
+
+            const Entry* entries() const { return this->first; }
+
+            // Every entry of a position, sorted by game and ply. The span points into the
+            // mapping.
+            std::span<const Entry> find(uint64_t key, Search search = Search::EYTZINGER) const;
+
+            // The moves played from a position with the results they led to, most played
+            // first. A game that reached the position more than once counts once per move.
+            // Results come from the game headers of the archive the index was built from.
+            std::vector<MoveStats> explore(uint64_t key, Archive::Reader& archive) const;
+
+            // Builds an index over every game of an archive. Games are read and their
+            // entries sorted on several threads, then merged into the file.
+            static bool build(const std::string& archivePath, const std::string& indexPath, int threads,
+                              BuildStats& stats);
+
+        private:
+            // Position of the first entry with a key not below key
+            const Entry* lowerBound(uint64_t key, Search search) const;
+
+            MappedFile file;
+            const Header* header = nullptr;
+            const Entry* first = nullptr;
+            const uint64_t* treeKeys = nullptr;
+            const uint32_t* treeBlocks = nullptr;
+    };
+};
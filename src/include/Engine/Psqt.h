@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * A pair of middlegame and endgame values. Evaluation terms are kept as both and
+     * blended by game phase at the end.
+     */
+    struct Score
+    {
+        int mg;
+        int eg;
+
+        constexpr Score operator+(const Score& other) const { return { mg + other.mg, eg + other.eg }; }
+        constexpr Score operator-(const Score& other) const { return { mg - other.mg, eg - other.eg }; }
+        constexpr Score operator-() const { return { -mg, -eg }; }
+        Score& operator+=(const Score& other) { mg += other.mg; eg += other.eg; return *this; }
+        Score& operator-=(const Score& other) { mg -= other.mg; eg -= other.eg; return *this; }
+    };
+
+    namespace Psqt
+    {
+        // Game phase at the start of the game. Each piece contributes PhaseWeight and the
+        // phase is clamped to this, so MAX_PHASE means pure middlegame and 0 pure endgame.
+        constexpr int MAX_PHASE = 24;
+
+        // How much each piece type contributes to the game phase
+        constexpr int PhaseWeight[PIECE_TYPE_NB] = { 0, 1, 1, 2, 4, 0 };
+
+        /**
+         * The tunable weights of the evaluation: a material value per piece type and a
+         * piece-square bonus per piece type and square. Squares are from white's point of
+         * view with a1 = 0, black uses the vertically mirrored square.
+         */
+        struct Weights
+        {
+            Score pieceValue[PIECE_TYPE_NB];
+            Score pieceSquare[PIECE_TYPE_NB][SQUARE_NB];
+        };
+
+        // The compiled in weights
+        extern const Weights DefaultWeights;
+
+        // The weights in use. Starts as a copy of DefaultWeights.
+        extern Weights CurrentWeights;
+
+        // Material plus piece-square score of every piece on every square, from white's
+        // point of view (black pieces are negative). Built from CurrentWeights and read by
+        // the Board to keep its evaluation sums up to date incrementally.
+        extern Score Table[PIECE_NB][SQUARE_NB];
+
+        // Builds Table from CurrentWeights. Safe to call more than once, only the first call does work.
+        void init();
+
+        // Overrides CurrentWeights from a text file and rebuilds Table. Each line is
+        // "<name> <mg> <eg>", where name is either "value.<piece>" or
+        // "psqt.<piece>.<square>", e.g. "psqt.knight.f3 12 10". Lines starting with '#'
+        // are ignored and weights that are not mentioned keep their value. Returns false
+        // and leaves the weights untouched if the file can not be read or has an error.
+        // Boards that are already set up must be set up again to see the new weights.
+        bool loadWeights(const std::string& path);
+    };
+};
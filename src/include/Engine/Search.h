@@ -0,0 +1,305 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "Board.h"
+#include "History.h"
+#include "Move.h"
+#include "Pawns.h"
+#include "Syzygy.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
+namespace Chess
+{
+    /**
+     * What the search is allowed to spend. A zero node count, move time or clock time
+     * means no limit.
+     */
+    struct SearchLimits
+    {
+        int depth = MAX_PLY - 1;
+        uint64_t nodes = 0;
+
+        // Milliseconds the search may take. Overrides the clock.
+        int64_t movetime = 0;
+
+        // The side to move's clock: milliseconds left, increment per move and the moves
+        // until the next time control (0 if the rest of the game must be played in time)
+        int64_t time = 0;
+        int64_t increment = 0;
+        int movesToGo = 0;
+
+        // Search until told to stop, even if the depth limit is reached
+        bool infinite = false;
+
+        // Search on the opponent's time. The clock only starts once ponderhit() is called.
+        bool ponder = false;
+    };
+
+    /**
+     * Counters collected while searching. They are plain integers owned by one search
+     * thread, so counting costs nothing more than an increment.
+     */
+    struct SearchStats
+    {
+        // Every node visited, including quiescence nodes
+        uint64_t nodes = 0;
+
+        // Nodes visited by the quiescence search
+        uint64_t qsearchNodes = 0;
+
+        // Captures skipped in quiescence because they could not raise alpha
+        uint64_t deltaPrunes = 0;
+
+        // Captures skipped in quiescence because they lose material
+        uint64_t seePrunes = 0;
+
+        // Pawn table lookups and how many of them found the structure cached
+        uint64_t pawnProbes = 0;
+        uint64_t pawnHits = 0;
+
+        // Endgame tablebase probes made by the search and how many found the position
+        uint64_t tbProbes = 0;
+        uint64_t tbHits = 0;
+
+        // Transposition table lookups, how many found the position and how many of those
+        // settled the node with the stored score
+        uint64_t ttProbes = 0;
+        uint64_t ttHits = 0;
+        uint64_t ttCutoffs = 0;
+
+        // Moves after the first searched with a null window, and how many of them beat
+        // alpha and had to be searched again with the full window
+        uint64_t nullWindowSearches = 0;
+        uint64_t nullWindowResearches = 0;
+
+        // Nodes spent on each completed iteration, indexed by depth
+        uint64_t iterationNodes[MAX_PLY] = {};
+
+        // Fraction of all nodes that were quiescence nodes
+        double qsearchShare() const { return nodes ? double(qsearchNodes) / double(nodes) : 0.0; }
+
+        // Fraction of pawn table lookups that were hits
+        double pawnHitRate() const { return pawnProbes ? double(pawnHits) / double(pawnProbes) : 0.0; }
+
+        // Fractions of transposition table lookups that were hits and that were cutoffs
+        double ttHitRate() const { return ttProbes ? double(ttHits) / double(ttProbes) : 0.0; }
+        double ttCutoffRate() const { return ttProbes ? double(ttCutoffs) / double(ttProbes) : 0.0; }
+
+        // Fraction of null window searches that had to be repeated
+        double researchRate() const { return nullWindowSearches ? double(nullWindowResearches) / double(nullWindowSearches) : 0.0; }
+
+        // Effective branching factor of an iteration: its nodes over those of the one
+        // before. 0 if either was not completed.
+        double branchingFactor(int depth) const
+        {
+            return depth > 1 && depth < MAX_PLY && iterationNodes[depth - 1] && iterationNodes[depth]
+                 ? double(iterationNodes[depth]) / double(iterationNodes[depth - 1]) : 0.0;
+        }
+
+        // Adds another thread's counters, except its iteration nodes
+        void add(const SearchStats& other);
+    };
+
+    /**
+     * The outcome of a search
+     */
+    struct SearchResult
+    {
+        // The move to play, invalid if the position has no legal moves
+        Move bestMove;
+
+        // Score of the best move from the side to move's point of view
+        int score = 0;
+
+        // Deepest fully completed iteration
+        int depth = 0;
+
+        // Principal variation, starting with bestMove
+        Move pv[MAX_PLY];
+        int pvLength = 0;
+
+        // Counters for the whole search
+        SearchStats stats;
+    };
+
+    /**
+     * What the search remembers about each ply of the line it is currently searching
+     */
+    struct SearchStackEntry
+    {
+        // The move being searched at this ply
+        Move currentMove;
+
+        // The piece that move moves
+        Piece movedPiece;
+
+        // Continuation history for replies to the move, null if there is no move
+        PieceToHistory* continuation;
+    };
+
+    /**
+     * An iterative deepening alpha-beta search. Each Searcher owns all of its state so
+     * several of them can run on different threads.
+     */
+    class Searcher
+    {
+        public:
+            // Called with the result so far after every completed iteration
+            typedef std::function<void(const SearchResult&)> IterationCallback;
+
+            // Constructs a searcher storing its results in tt, which may be shared with
+            // other searchers. threadIndex 0 is the main thread of a search, only it keeps
+            // track of time and later ones vary their iterations.
+            explicit Searcher(TranspositionTable& tt, int threadIndex = 0);
+
+            // Searches the position until the limits are reached or stop() is called. The
+            // board is used as scratch space and is back in its original state afterwards.
+            SearchResult think(Board& board, const SearchLimits& limits);
+
+            // Asks a running search to return as soon as possible. Safe to call from any
+            // thread. The request stays until newSearch(), so it also ends a search that is
+            // only about to start.
+            void stop();
+
+            // Withdraws a stop request, zeroes the published node count and sets whether the
+            // next search ponders. Called for every searcher before a search on several
+            // threads is started, so a ponderhit() that arrives as soon as the threads run
+            // is not undone by them.
+            void newSearch(bool ponder = false);
+
+            // Tells a pondering search that the expected move was played, so its time
+            // limit starts counting now. Safe to call from any thread.
+            void ponderhit();
+
+            // Sets the function called after every completed iteration
+            void setIterationCallback(IterationCallback callback);
+
+            // Nodes searched so far by the current search. Updated every few thousand
+            // nodes, so it can be read from any thread while searching.
+            uint64_t getNodes() const;
+
+            // Tablebase hits of the current search, published along with the node count
+            uint64_t getTbHits() const;
+
+            // Counters of the current or last search
+            const SearchStats& getStats() const;
+
+            // Copy of the counters as of their last publication, which happens along with
+            // the node count and after every iteration. Safe to call from any thread.
+            SearchStats getPublishedStats() const;
+
+            // Forgets all move ordering statistics and cached evaluations, e.g. when a new game starts
+            void clearHistory();
+
+        private:
+            // Fixed margin added to a capture's gain before delta pruning it
+            static constexpr int DELTA_MARGIN = 200;
+
+            // Shared hash table of search results
+            TranspositionTable& tt;
+
+            // Position of this searcher among the threads of a search
+            int threadIndex;
+
+            // Limits of the current search
+            SearchLimits limits;
+
+            // Deadlines of the current search. Only the main thread acts on them.
+            TimeManager timeManager;
+
+            // When the current search started, in steady clock milliseconds. Unlike the
+            // time manager's clock it is not restarted on a ponder hit, so it measures speed.
+            int64_t searchStartTime;
+
+            // Node count at which to next read the clock and publish the node count
+            uint64_t nextCheck;
+
+            // Nodes spent on the current best root move in the current iteration
+            uint64_t rootBestMoveNodes;
+
+            // Set while pondering, cleared by ponderhit()
+            std::atomic<bool> pondering;
+
+            // Copy of stats.nodes that other threads may read
+            std::atomic<uint64_t> publishedNodes;
+
+            // Copy of stats.tbHits that other threads may read
+            std::atomic<uint64_t> publishedTbHits;
+
+            // Copy of stats that other threads may read, guarded by publishedMutex. It is
+            // only locked when publishing, so counting never synchronises.
+            mutable std::mutex publishedMutex;
+            SearchStats publishedStats;
+
+            // Called after every completed iteration, may be empty
+            IterationCallback onIteration;
+
+            // Counters of the current search
+            SearchStats stats;
+
+            // Set by stop() from another thread
+            std::atomic<bool> stopRequested;
+
+            // Set once the current search ran out of budget, every node then unwinds
+            bool aborted;
+
+            // Move ordering statistics. Allocated once since the tables are large.
+            std::unique_ptr<HistoryTables> history;
+
+            // Cached pawn structure evaluations
+            std::unique_ptr<PawnTable> pawnTable;
+
+            // NNUE accumulators attached to the board while searching if a network is loaded
+            std::unique_ptr<Nnue::AccumulatorStack> accumulators;
+
+            // The line being searched. Offset by two so ply - 2 is always a valid index.
+            SearchStackEntry stack[MAX_PLY + 2];
+
+            // Triangular principal variation table, pvTable[ply] holds the line from ply
+            Move pvTable[MAX_PLY][MAX_PLY];
+            int pvLength[MAX_PLY];
+
+            // Best move of the last completed iteration, tried first at the root
+            Move previousBestMove;
+
+            // Set when the tablebases ranked the root moves. Only the best ranked ones are
+            // searched then, and rootTbScore is reported unless the search finds a mate.
+            bool rootInTB;
+            MoveList rootMoves;
+            int rootTbScore;
+
+            // Whether the search probes the tablebases below the root
+            bool tbProbing;
+
+            // Principal variation search of a main node
+            int search(Board& board, int alpha, int beta, int depth, int ply);
+
+            // Quiescence search that resolves captures so the static evaluation is only
+            // taken in quiet positions. qsPly counts plies since the main search ended,
+            // checks are only generated on the first one.
+            int qsearch(Board& board, int alpha, int beta, int ply, int qsPly);
+
+            // Ranks the root moves with the tablebases if the position is in them. DTZ
+            // rankings are exact, so nothing is probed below the root after one.
+            void probeRoot(Board& board);
+
+            // Stores m followed by the child's line as the principal variation of ply
+            void updatePv(int ply, Move m);
+
+            // Whether the search has run out of budget
+            bool shouldStop();
+
+            // Makes the counters so far readable by other threads
+            void publishStats();
+
+            // Static evaluation, counting pawn table lookups
+            int evaluate(const Board& board);
+    };
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace Chess
+{
+    /**
+     * Snapshot of a search's counters across its threads. Every thread counts in plain
+     * integers of its own and publishes a copy every few thousand nodes, so a snapshot is
+     * up to a few milliseconds behind and counting never pays for it.
+     */
+    struct SearchMetrics
+    {
+        // Milliseconds since the search started
+        int64_t time = 0;
+
+        // Counters of all threads added up. The iteration nodes, and so the branching
+        // factors, are the main thread's.
+        SearchStats totals;
+
+        // Deepest iteration the main thread completed
+        int depth = 0;
+
+        // Nodes per second of all threads together and of each thread, main thread first
+        uint64_t nps = 0;
+        std::vector<uint64_t> threadNps;
+
+        // Permille of the transposition table in use
+        int hashfull = 0;
+    };
+
+    /**
+     * Progress of a running search, reported after every iteration of the main thread
+     */
+    struct SearchInfo
+    {
+        int depth;
+        int score;
+
+        // Nodes searched by all threads together
+        uint64_t nodes;
+        uint64_t nps;
+
+        // Milliseconds since the search started
+        int64_t time;
+
+        // Permille of the transposition table in use
+        int hashfull;
+
+        // Positions found in the endgame tablebases by all threads together
+        uint64_t tbHits;
+
+        const Move* pv;
+        int pvLength;
+
+        // Everything counted so far
+        SearchMetrics metrics;
+    };
+
+    /**
+     * Runs searches in the background on one or more threads sharing a transposition
+     * table (Lazy SMP). Each thread searches its own copy of the position and they help
+     * each other only through the table. The main thread's result is the one reported.
+     *
+     * All methods are meant to be called from one controlling thread, except stop() and
+     * ponderhit() which may be called from any thread.
+     */
+    class SearchPool
+    {
+        public:
+            // Called from the main search thread after every iteration
+            typedef std::function<void(const SearchInfo&)> InfoCallback;
+
+            // Called from the main search thread once the search is over
+            typedef std::function<void(const SearchResult&)> DoneCallback;
+
+            // Largest number of threads and hash size accepted
+            static constexpr int MAX_THREADS = 256;
+            static constexpr size_t MAX_HASH_MB = 65536;
+
+            SearchPool();
+
+            // Stops and waits for a running search
+            ~SearchPool();
+
+            // Sets the number of search threads. Waits for a running search first.
+            void setThreadCount(int count);
+            int getThreadCount() const;
+
+            // Resizes the transposition table. Waits for a running search first.
+            void setHashSize(size_t megabytes);
+
+            // Forgets everything learnt in earlier searches, e.g. when a new game starts.
+            // Waits for a running search first.
+            void clear();
+
+            // Starts searching a copy of the board in the background. A search that is
+            // already running is stopped first. Infinite and pondering searches keep going
+            // until stop(), or ponderhit() for a pondering search, even if they run out of
+            // depth, so their result is never reported too early.
+            void start(const Board& board, const SearchLimits& limits, InfoCallback onInfo, DoneCallback onDone);
+
+            // Ends the running search, which then reports its result
+            void stop();
+
+            // The opponent played the expected move: a pondering search becomes a normal
+            // one and its clock starts now
+            void ponderhit();
+
+            // Blocks until the running search, if any, has reported its result
+            void wait();
+
+            // Whether a search is running
+            bool isSearching() const;
+
+            // Permille of the transposition table used by the current or last search
+            int hashfull() const;
+
+            // Counters of the current or last search. Safe to call while searching, from
+            // the controlling thread or the callbacks.
+            SearchMetrics metrics() const;
+
+        private:
+            TranspositionTable tt;
+            std::vector<std::unique_ptr<Searcher>> searchers;
+
+            // Thread running the main searcher and coordinating the helpers
+            std::thread mainThread;
+
+            // Set from start() until the result has been reported
+            std::atomic<bool> searching;
+
+            // When the current or last search started and when it ended, 0 while it
+            // runs. Steady clock milliseconds.
+            std::atomic<int64_t> startTime;
+            std::atomic<int64_t> endTime;
+
+            // Guards stopped and pondering, which the main thread waits on
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool stopped;
+            bool pondering;
+
+            // Body of the main search thread
+            void run(std::vector<Board> boards, SearchLimits limits, InfoCallback onInfo, DoneCallback onDone);
+    };
+};
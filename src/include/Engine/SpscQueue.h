@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Chess
+{
+    /**
+     * A bounded lock-free queue for exactly one producer thread and one consumer thread.
+     * Items live in a ring buffer and the two threads only share the head and tail
+     * indices, each kept on its own cache line so they do not slow each other down.
+     *
+     * Capacity must be a power of two. One slot is always left empty, so the queue holds
+     * at most Capacity - 1 items.
+     */
+    template<typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        public:
+            SpscQueue() : head(0), tail(0) {}
+
+            SpscQueue(const SpscQueue&) = delete;
+            SpscQueue& operator=(const SpscQueue&) = delete;
+
+            // Producer side. Moves item into the queue, returns false if it is full.
+            bool push(T&& item)
+            {
+                size_t t = this->tail.load(std::memory_order_relaxed);
+                size_t next = (t + 1) & (Capacity - 1);
+                if(next == this->head.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+
+                this->items[t] = std::move(item);
+                this->tail.store(next, std::memory_order_release);
+                this->tail.notify_one();
+                return true;
+            }
+
+            // Consumer side. Moves the oldest item out, returns false if the queue is empty.
+            bool pop(T& item)
+            {
+                size_t h = this->head.load(std::memory_order_relaxed);
+                if(h == this->tail.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+
+                item = std::move(this->items[h]);
+                this->head.store((h + 1) & (Capacity - 1), std::memory_order_release);
+                return true;
+            }
+
+            // Consumer side. Sleeps until the queue is not empty.
+            void wait()
+            {
+                size_t h = this->head.load(std::memory_order_relaxed);
+                this->tail.wait(h, std::memory_order_acquire);
+            }
+
+        private:
+            // Next slot to read, only written by the consumer
+            alignas(64) std::atomic<size_t> head;
+
+            // Next slot to write, only written by the producer
+            alignas(64) std::atomic<size_t> tail;
+
+            alignas(64) T items[Capacity];
+    };
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "Move.h"
+
+namespace Chess
+{
+    /**
+     * Probing of Syzygy endgame tablebases: WDL tables (.rtbw) giving the win, draw or
+     * loss of a position and DTZ tables (.rtbz) giving the distance to the next capture
+     * or pawn move on the way there. Tables are found by scanning the configured
+     * directories once; each file is only memory mapped when it is first probed, and at
+     * most a configured number of files stay mapped so address space use is bounded.
+     *
+     * Probes may be made from any number of threads at once. init and setMaxMappedFiles
+     * must not be called while probing.
+     */
+    namespace Syzygy
+    {
+        // Most pieces in a table, kings included
+        constexpr int MAX_PIECES = 7;
+
+        // Files kept mapped by default, enough for every 5 and 6 piece table
+        constexpr size_t DEFAULT_MAX_MAPPED_FILES = 1024;
+
+        // Rank given by rootProbe to a move that wins or loses regardless of the fifty
+        // move rule
+        constexpr int MAX_DTZ = 1 << 18;
+
+        /**
+         * The outcome of a position for the side to move. Cursed wins and blessed losses
+         * are wins and losses that the fifty move rule turns into draws.
+         */
+        enum WdlScore : int
+        {
+            WDL_LOSS = -2,
+            WDL_BLESSED_LOSS = -1,
+            WDL_DRAW = 0,
+            WDL_CURSED_WIN = 1,
+            WDL_WIN = 2
+        };
+
+        /**
+         * How a probe went
+         */
+        enum class ProbeState
+        {
+            // No table for the position, or it could not be read
+            FAIL,
+
+            OK,
+
+            // The DTZ table only stores the other side to move (internal to DTZ probes)
+            CHANGE_STM,
+
+            // The best move is a capture or pawn move (internal to DTZ probes)
+            ZEROING_BEST_MOVE
+        };
+
+        /**
+         * A legal root move ranked by the tables. Higher ranks are better, moves of equal
+         * rank are equally good as far as the tables can tell.
+         */
+        struct RootMove
+        {
+            Move move;
+            int rank;
+
+            // Search score to report for the move
+            int score;
+        };
+
+        /**
+         * Process wide counters of the table files
+         */
+        struct Stats
+        {
+            // Tables found by init and the most pieces in any of them
+            size_t tables = 0;
+            int maxPieces = 0;
+
+            // Files mapped right now
+            size_t mappedFiles = 0;
+
+            // Files mapped, unmapped to stay under the limit, and found broken so far
+            uint64_t maps = 0;
+            uint64_t evictions = 0;
+            uint64_t failures = 0;
+        };
+
+        // Forgets every table, then registers the ones found in paths, a list of
+        // directories separated by ':' (';' on Windows). Returns the number of tables.
+        size_t init(const std::string& paths);
+
+        // Most pieces in any table found, 0 if there are none
+        int maxPieces();
+
+        // Positions with more pieces than this are not probed by the search
+        void setProbeLimit(int pieces);
+
+        // Most pieces in a position the search probes: the smaller of maxPieces and the
+        // probe limit
+        int cardinality();
+
+        // Sets how many files may be mapped at once. Files that have not been probed for
+        // a while are unmapped to make room, except ones being read right now.
+        void setMaxMappedFiles(size_t files);
+
+        // Counters since the program started
+        Stats stats();
+
+        // The outcome of a position without castling rights, searching captures first
+        // since the tables ignore en passant. The board is back in its original state
+        // afterwards.
+        WdlScore probeWdl(Board& board, ProbeState& state);
+
+        // Plies to the next capture or pawn move, positive if the side to move wins and
+        // negative if it loses, 0 for draws. Cursed wins and blessed losses are 100 further
+        // out. Only exact right after a capture or pawn move, otherwise it may be a little
+        // longer than the true distance.
+        int probeDtz(Board& board, ProbeState& state);
+
+        // Ranks every legal move of a position by DTZ, so the best ones keep a win in
+        // hand with the fifty move rule and make progress. The moves are sorted best
+        // first. Returns false if some position could not be probed.
+        bool rootProbe(Board& board, std::vector<RootMove>& moves);
+
+        // Ranks every legal move by WDL only, for when the DTZ tables are missing
+        bool rootProbeWdl(Board& board, std::vector<RootMove>& moves);
+    };
+};
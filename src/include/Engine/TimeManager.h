@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "Move.h"
+
+namespace Chess
+{
+    struct SearchLimits;
+
+    /**
+     * Decides how long a search may take. A game clock is turned into two deadlines: a
+     * soft one, after which no new iteration is started, and a hard one, at which the
+     * search is cut off wherever it is. The soft deadline is stretched while the best
+     * move keeps changing or the score is falling, and shrunk when one move takes almost
+     * all of the search effort.
+     *
+     * The clock is read every few hundred to few thousand nodes. The interval is
+     * recalibrated at every read from the speed measured so far, so it stays close to
+     * CHECK_PERIOD_MS whatever the hardware and position.
+     */
+    class TimeManager
+    {
+        public:
+            // Milliseconds kept in reserve for communication delays when playing on a clock
+            static constexpr int64_t MOVE_OVERHEAD = 30;
+
+            // Moves assumed to be left in the game when the clock does not say
+            static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+            // Most of the remaining time one move may get, as a fraction of it
+            static constexpr double MAX_TIME_SHARE = 0.75;
+
+            // The hard deadline is at most this many times the soft one
+            static constexpr double HARD_LIMIT_FACTOR = 5.0;
+
+            // Milliseconds aimed for between two reads of the clock
+            static constexpr int64_t CHECK_PERIOD_MS = 1;
+
+            // Bounds of the number of nodes between two reads of the clock
+            static constexpr uint64_t MIN_CHECK_INTERVAL = 128;
+            static constexpr uint64_t MAX_CHECK_INTERVAL = 65536;
+
+            TimeManager();
+
+            // Sets up the deadlines of a new search and starts its clock. rootMoves is the
+            // number of legal moves, a search with only one has nothing to think about.
+            void init(const SearchLimits& limits, int rootMoves);
+
+            // Starts the clock again, e.g. on a ponder hit. Safe to call from any thread.
+            void restart();
+
+            // Milliseconds since the clock started
+            int64_t elapsed() const;
+
+            // Whether the search has any deadline
+            bool isLimited() const { return this->limited; }
+
+            // Milliseconds after which the hard deadline has passed
+            int64_t getHardLimit() const { return this->hardLimit; }
+
+            // Milliseconds after which no new iteration should start, before adjustments
+            int64_t getSoftLimit() const { return this->softLimit; }
+
+            // Whether the hard deadline has passed, given the current steady clock time
+            bool hardLimitReached(int64_t nowMs) const;
+
+            // Called by the main thread after every completed iteration with its best move,
+            // score and the share of the iteration's nodes spent on the best move. Returns
+            // whether the search should stop instead of starting another iteration.
+            bool stopAfterIteration(Move bestMove, int score, double bestMoveNodeShare);
+
+            // Steady clock time in milliseconds
+            static int64_t now();
+
+            // Nodes to search before the next read of the clock, given the nodes searched
+            // and the milliseconds elapsed so far
+            static uint64_t checkInterval(uint64_t nodes, int64_t elapsedMs);
+
+        private:
+            // When the clock started, in steady clock milliseconds
+            std::atomic<int64_t> startTime;
+
+            // Whether there is a deadline at all
+            bool limited;
+
+            // Whether the deadlines come from a fixed move time and must not be adjusted
+            bool fixedTime;
+
+            int64_t softLimit;
+            int64_t hardLimit;
+
+            // Decaying count of best move changes between iterations
+            double instability;
+
+            // Best move and score of the previous iteration
+            Move previousBestMove;
+            int previousScore;
+            int iterations;
+    };
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+namespace Chess
+{
+    /**
+     * Timeline instrumentation. CHESS_TRACE_SCOPE("name") records the time from the
+     * statement to the end of its block as a span in a ring buffer owned by the calling
+     * thread, so recording takes no lock and never allocates after a thread's first span.
+     * write() saves every thread's spans in the Chrome trace event format, which
+     * chrome://tracing and ui.perfetto.dev open.
+     *
+     * The macros only exist in builds configured with -DCHESS_TRACE=ON; otherwise they
+     * expand to nothing and cost nothing. Compiled in, a span is only recorded between
+     * start() and stop(), and costs a relaxed load when tracing is off.
+     */
+    namespace Trace
+    {
+        // Spans kept per thread by default; older ones are overwritten
+        constexpr size_t DEFAULT_EVENTS_PER_THREAD = 1 << 20;
+
+        // Set while recording. Only read directly by Scope.
+        extern std::atomic<bool> recording;
+
+        // Starts recording, keeping the last eventsPerThread spans of each thread (rounded
+        // up to a power of two). Threads that already recorded keep their buffer size.
+        void start(size_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+
+        // Stops recording. The spans stay until the next write.
+        void stop();
+
+        // Names the calling thread in the trace, e.g. "search 1"
+        void setThreadName(const std::string& name);
+
+        // Writes the spans of every thread as Chrome trace JSON and forgets them. Spans
+        // threads record while it runs may be torn, so call it once they are idle.
+        // Returns false if the file can not be written.
+        bool write(const std::string& path);
+
+        // A timestamp in ticks, never 0. On x86-64 this reads the time stamp counter, which
+        // costs half of a steady clock read; write() converts ticks to microseconds.
+        inline uint64_t now()
+        {
+#if defined(__x86_64__) || defined(_M_X64)
+            return __rdtsc() | 1;
+#else
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count()) | 1;
+#endif
+        }
+
+        // Appends a span to the calling thread's buffer. start and end come from now(),
+        // and name must outlive the trace, normally a string literal.
+        void record(const char* name, uint64_t start, uint64_t end);
+
+        /**
+         * Records a span from its construction to its destruction
+         */
+        class Scope
+        {
+            public:
+                explicit Scope(const char* name) : name(name), start(recording.load(std::memory_order_relaxed) ? now() : 0) {}
+
+                ~Scope()
+                {
+                    if(this->start)
+                    {
+                        record(this->name, this->start, now());
+                    }
+                }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                const char* name;
+                uint64_t start;
+        };
+    };
+};
+
+#ifdef CHESS_TRACE
+#define CHESS_TRACE_CONCAT_INNER(a, b) a##b
+#define CHESS_TRACE_CONCAT(a, b) CHESS_TRACE_CONCAT_INNER(a, b)
+#define CHESS_TRACE_SCOPE(name) ::Chess::Trace::Scope CHESS_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define CHESS_TRACE_THREAD(name) ::Chess::Trace::setThreadName(name)
+#else
+#define CHESS_TRACE_SCOPE(name) ((void)0)
+#define CHESS_TRACE_THREAD(name) ((void)0)
+#endif
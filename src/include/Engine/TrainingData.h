@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "Board.h"
+#include "Fen.h"
+#include "MappedFile.h"
+
+namespace Chess
+{
+    /**
+     * Positions from self-play for evaluation tuning. Each position is a fixed 32 byte
+     * record holding the board, the search score and the result of the game, so files of
+     * hundreds of millions of positions are written and read without any text and any
+     * record can be found by its number. Records are stored in the machine's byte order
+     * with no header; a file is just records back to back.
+     */
+    namespace TrainingData
+    {
+        /**
+         * Outcome of the game a position was played in, from white's point of view
+         */
+        enum Result : int8_t
+        {
+            BLACK_WINS = -1,
+            DRAW = 0,
+            WHITE_WINS = 1
+        };
+
+        /**
+         * One position. Pieces are listed in square order, a1 first, one Piece per 4
+         * bits with the low nibble first, so the 32 pieces a position can have fit in 16
+         * bytes.
+         */
+        struct PackedPosition
+        {
+            // Squares with a piece on them
+            uint64_t occupancy;
+
+            uint8_t pieces[16];
+
+            // Search score in centipawns for the side to move
+            int16_t score;
+
+            uint16_t fullmoveNumber;
+            uint8_t halfmoveClock;
+
+            // Side to move in bit 0, CastlingRights in bits 1 to 4
+            uint8_t flags;
+
+            // SQ_NONE if there is none
+            uint8_t epSquare;
+
+            Result result;
+        };
+        static_assert(sizeof(PackedPosition) == 32, "Training records must stay 32 bytes");
+
+        // Packs a board with its score. The result is filled in once the game is over.
+        PackedPosition pack(const Board& board, int score);
+
+        // Unpacks a record into a position for Board::setPosition. Returns false, leaving
+        // the position undefined, if the record is corrupt: more than 32 pieces, a piece
+        // code that is no Piece, not one king per side, flags, en passant square or
+        // result out of range.
+        bool unpack(const PackedPosition& record, Fen::Position& position);
+
+        /**
+         * Appends records to a file, or to the input of a compressor that writes it, from
+         * any number of threads. Each call takes a whole batch, which is written with one
+         * call under a lock, so threads should collect records in a buffer of their own.
+         */
+        class Writer
+        {
+            public:
+                // Closes the output if that has not been done
+                ~Writer();
+
+                // Creates the file, replacing an existing one. If compressor is not empty it
+                // is a shell command reading records on its standard input, e.g. "zstd -q",
+                // and its output is redirected to the file. Returns false if the file or the
+                // command can not be opened.
+                bool open(const std::string& path, const std::string& compressor = "");
+
+                // Appends records. Returns false if they could not all be written.
+                bool write(const PackedPosition* records, size_t count);
+
+                // Flushes and closes the output. Returns false if anything failed,
+                // including the compressor.
+                bool close();
+
+                // Records written so far
+                uint64_t size() const { return this->written; }
+
+            private:
+                std::FILE* file = nullptr;
+                bool piped = false;
+                bool failed = false;
+                uint64_t written = 0;
+                std::mutex mutex;
+        };
+
+        /**
+         * Reads an uncompressed record file through a memory mapping
+         */
+        class Reader
+        {
+            public:
+                // Maps a file. Returns false if it can not be read or is not a whole
+                // number of records.
+                bool open(const std::string& path, MappedFile::Access access = MappedFile::Access::SEQUENTIAL);
+
+                uint64_t size() const { return this->file.size() / sizeof(PackedPosition); }
+
+                const PackedPosition& operator[](uint64_t index) const
+                {
+                    return reinterpret_cast<const PackedPosition*>(this->file.data())[index];
+                }
+
+            private:
+                MappedFile file;
+        };
+    };
+};
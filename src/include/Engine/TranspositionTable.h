@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Move.h"
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * What a stored score says about the true score of a position
+     */
+    enum Bound : uint8_t
+    {
+        BOUND_NONE = 0,
+        BOUND_UPPER = 1,
+        BOUND_LOWER = 2,
+        BOUND_EXACT = 3
+    };
+
+    /**
+     * A transposition table entry as returned by a probe
+     */
+    struct TTEntry
+    {
+        Move move;
+        int score;
+        int eval;
+        int depth;
+        Bound bound;
+    };
+
+    /**
+     * The hash table of search results shared by every search thread. Threads read and
+     * write it without locks: each slot stores its key XORed with its data, so a slot torn
+     * by two threads writing at once simply fails to match on the next probe.
+     */
+    class TranspositionTable
+    {
+        public:
+            // Default size in megabytes
+            static constexpr size_t DEFAULT_SIZE_MB = 16;
+
+            explicit TranspositionTable(size_t megabytes = DEFAULT_SIZE_MB);
+
+            // Reallocates the table, dropping everything stored. Must not be called while searching.
+            void resize(size_t megabytes);
+
+            // Empties the table. Must not be called while searching.
+            void clear();
+
+            // Called when a new search starts, so entries from older searches are replaced first
+            void newSearch();
+
+            // Looks a position up. Returns whether it was found and fills in entry if so.
+            bool probe(uint64_t key, TTEntry& entry) const;
+
+            // Stores a search result, replacing the least useful slot of the position's bucket
+            void store(uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+
+            // Permille of the table filled by the current search, estimated from a sample
+            int hashfull() const;
+
+            // Size of the table in megabytes
+            size_t sizeMb() const { return this->megabytes; }
+
+        private:
+            // One slot: the key XOR data, and the data packed into 64 bits. Relaxed atomics
+            // compile to plain loads and stores but make the sharing well defined.
+            struct Slot
+            {
+                std::atomic<uint64_t> check;
+                std::atomic<uint64_t> data;
+            };
+
+            // Slots sharing an index, one cache line
+            static constexpr int BUCKET_SIZE = 4;
+            struct alignas(64) Bucket
+            {
+                Slot slots[BUCKET_SIZE];
+            };
+
+            std::unique_ptr<Bucket[]> buckets;
+            size_t bucketCount;
+            size_t megabytes;
+
+            // Age of the current search, wraps around
+            uint8_t generation;
+
+            // The bucket of a key. Multiplying spreads the key over any bucket count.
+            Bucket& bucketOf(uint64_t key) const
+            {
+                return this->buckets[size_t((unsigned __int128)(key) * this->bucketCount >> 64)];
+            }
+    };
+
+    // Converts a score to how it is stored: mate and tablebase scores relative to the
+    // position instead of the root, so they stay correct when the position is reached at
+    // another ply
+    inline int scoreToTT(int score, int ply)
+    {
+        return score >= VALUE_TB_WIN_IN_MAX_PLY ? score + ply : score <= -VALUE_TB_WIN_IN_MAX_PLY ? score - ply : score;
+    }
+
+    // Converts a stored score back to a score relative to the root
+    inline int scoreFromTT(int score, int ply)
+    {
+        return score >= VALUE_TB_WIN_IN_MAX_PLY ? score - ply : score <= -VALUE_TB_WIN_IN_MAX_PLY ? score + ply : score;
+    }
+};
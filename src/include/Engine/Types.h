@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "../Chess/ChessPiece.h"
+
+namespace Chess
+{
+    // A set of squares packed into 64 bits. Bit 0 is a1 and bit 63 is h8.
+    typedef uint64_t Bitboard;
+
+    // A square on the board from 0 to 63. The square index is row * 8 + col, using
+    // the same row and col as the GUI (row 0 is white's back rank, col 0 is the a-file).
+    typedef int Square;
+
+    // Marker for "no square", e.g. when there is no en passant square
+    constexpr Square SQ_NONE = 64;
+
+    // Number of squares on the board
+    constexpr int SQUARE_NB = 64;
+
+    // Number of piece types in the Type enum
+    constexpr int PIECE_TYPE_NB = 6;
+
+    // Upper bound on the number of legal moves in any chess position
+    constexpr int MAX_MOVES = 256;
+
+    // Upper bound on the search depth in plies
+    constexpr int MAX_PLY = 128;
+
+    // Search scores in centipawns from the side to move's point of view. Mate scores are
+    // VALUE_MATE minus the distance to mate in plies.
+    constexpr int VALUE_DRAW = 0;
+    constexpr int VALUE_MATE = 32000;
+    constexpr int VALUE_INFINITE = 32001;
+    constexpr int VALUE_NONE = 32002;
+    constexpr int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+
+    // Scores of positions the endgame tablebases prove won, just below every mate score.
+    // They count down with the distance from the root like mate scores do.
+    constexpr int VALUE_TB_WIN = VALUE_MATE_IN_MAX_PLY - 1;
+    constexpr int VALUE_TB_WIN_IN_MAX_PLY = VALUE_TB_WIN - MAX_PLY;
+
+    /**
+     * The side to move, or the owner of a piece. Used as an array index by the engine.
+     */
+    enum Color : int
+    {
+        WHITE,
+        BLACK
+    };
+
+    // Number of colors
+    constexpr int COLOR_NB = 2;
+
+    /**
+     * A colored piece as stored in the board's mailbox. The value is color * 6 + type
+     * so it can index tables directly.
+     */
+    enum Piece : uint8_t
+    {
+        W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+        B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+        NO_PIECE
+    };
+
+    // Number of colored pieces
+    constexpr int PIECE_NB = 12;
+
+    /**
+     * Castling rights as a 4 bit mask
+     */
+    enum CastlingRights : uint8_t
+    {
+        NO_CASTLING = 0,
+        WHITE_OO = 1,
+        WHITE_OOO = 2,
+        BLACK_OO = 4,
+        BLACK_OOO = 8,
+        ALL_CASTLING = 15
+    };
+
+    // Material values of each piece type in centipawns, used for move ordering and exchanges.
+    // The king is given a value of zero since it can never be captured.
+    constexpr int PieceValue[PIECE_TYPE_NB] = { 100, 320, 330, 500, 900, 0 };
+
+    // Flips the color
+    constexpr Color operator~(Color c) { return Color(c ^ 1); }
+
+    // Converts a Type to an array index
+    constexpr int typeIndex(Type t) { return static_cast<int>(t); }
+
+    // Builds a colored piece from its color and type
+    constexpr Piece makePiece(Color c, Type t) { return Piece(c * PIECE_TYPE_NB + typeIndex(t)); }
+
+    // The type of a colored piece. Must not be called with NO_PIECE
+    constexpr Type typeOf(Piece p) { return Type(p % PIECE_TYPE_NB); }
+
+    // The color of a colored piece. Must not be called with NO_PIECE
+    constexpr Color colorOf(Piece p) { return Color(p >= B_PAWN); }
+
+    // Builds a square from its row and column
+    constexpr Square makeSquare(int row, int col) { return row * 8 + col; }
+
+    // The row (rank) of a square, 0 based from white's side
+    constexpr int rowOf(Square s) { return s >> 3; }
+
+    // The column (file) of a square, 0 based from the a-file
+    constexpr int colOf(Square s) { return s & 7; }
+
+    // The row of a square as seen from the given side, so row 0 is always that side's back rank
+    constexpr int relativeRow(Color c, Square s) { return c == WHITE ? rowOf(s) : 7 - rowOf(s); }
+
+    // Mirrors a square vertically, mapping a1 to a8
+    constexpr Square flipSquare(Square s) { return s ^ 56; }
+
+    // Converts a square to algebraic notation, e.g. 12 -> "e2"
+    inline std::string squareToString(Square s)
+    {
+        return std::string{ char('a' + colOf(s)), char('1' + rowOf(s)) };
+    }
+};
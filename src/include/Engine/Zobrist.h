@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Types.h"
+
+namespace Chess
+{
+    /**
+     * Random keys used to hash positions. A position's key is the XOR of the keys of
+     * everything in it, so it can be updated incrementally as moves are made.
+     */
+    namespace Zobrist
+    {
+        // One key per colored piece per square
+        extern uint64_t PieceSquare[PIECE_NB][SQUARE_NB];
+
+        // One key per combination of castling rights
+        extern uint64_t Castling[16];
+
+        // One key per en passant file
+        extern uint64_t EnPassant[8];
+
+        // Toggled when black is to move
+        extern uint64_t Side;
+
+        // Starting value of the pawn key, so positions without pawns have a non zero key too
+        extern uint64_t NoPawns;
+
+        // Fills the key tables. Safe to call more than once, only the first call does work.
+        void init();
+    };
+};
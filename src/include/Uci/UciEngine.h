@@ -0,0 +1,75 @@
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "../Engine/Board.h"
+#include "../Engine/Polyglot.h"
+#include "../Engine/SearchPool.h"
+#include "../Engine/Syzygy.h"
+
+namespace Chess
+{
+    /**
+     * The engine's UCI front end. Commands are read on the calling thread while searches
+     * run on the SearchPool's threads, so commands like stop and isready are answered
+     * while the engine is thinking.
+     */
+    class UciEngine
+    {
+        public:
+            // Name reported to the GUI
+            static constexpr const char* ENGINE_NAME = "chess-cpp";
+
+            UciEngine(std::istream& in, std::ostream& out);
+
+            // Handles commands until quit or the end of the input
+            void loop();
+
+        private:
+            std::istream& in;
+            std::ostream& out;
+
+            // Serialises output from the command and search threads
+            std::mutex outputMutex;
+
+            // The position set by the last position command
+            Board board;
+
+            // The search threads
+            SearchPool pool;
+
+            // Opening book played from when OwnBook is set, so known openings take no
+            // search time
+            Polyglot::Book book;
+            bool ownBook = false;
+            Polyglot::Selection bookSelection = Polyglot::Selection::WEIGHTED_RANDOM;
+
+            // Handles one command line. Returns false on quit.
+            bool execute(const std::string& line);
+
+            // "position [startpos | fen <fen>] [moves <move>...]"
+            void position(std::istringstream& args);
+
+            // "go [depth|nodes|movetime|wtime|btime|winc|binc|movestogo <n>] [infinite] [ponder]"
+            void go(std::istringstream& args);
+
+            // "setoption name <name> [value <value>]"
+            void setOption(std::istringstream& args);
+
+            // "bench [depth]": searches the built in positions and reports the node
+            // signature and speed
+            void bench(std::istringstream& args);
+
+            // Writes one line to the output
+            void send(const std::string& line);
+
+            // Formats a score as "cp <n>" or "mate <n>"
+            static std::string formatScore(int score);
+
+            // Formats search counters as the text of an "info string metrics" line
+            static std::string formatMetrics(const SearchMetrics& metrics);
+    };
+};
@@ -1,17 +1,112 @@
 #include "include/Chess/Chess.h"
+#include "include/Engine/Nnue.h"
+#include "include/Engine/Psqt.h"
+
+#include <cstring>
+#include <iostream>
 
 /**
  * Main function
+ *
+ * Usage: chess [--fen <fen>] [--explorer <archive> <index>] [--book <book>]
+ *              [--nnue <file>] [--weights <file>] [--trace <file>]
+ *              [spdlog levels, e.g. SPDLOG_LEVEL=debug]
+ * The FEN may be quoted as one argument or given as separate fields. The explorer takes a
+ * game archive and its position index, see chess_archive and chess_position_index. The
+ * book is a Polyglot .bin file. --nnue makes the engine evaluate with an NNUE network
+ * instead of the piece-square tables, and --weights replaces the piece-square weights
+ * with those of a text file in the format of Psqt::loadWeights. With --trace, builds
+ * configured with -DCHESS_TRACE=ON write a Chrome trace of the session on exit.
  */
 int main(int argc, char** argv)
 {
     // The log manager that instantiates logging for the whole app
     auto lm_ptr = std::make_shared<LogManager>(argc, argv);
-    
+
+    // The position the game starts from and the move explorer's files
+    std::string fen = Chess::START_FEN;
+    std::string explorerArchive, explorerIndex;
+    std::string bookFile;
+    std::string traceFile, nnueFile, weightsFile;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--explorer") == 0 && i + 2 < argc)
+        {
+            explorerArchive = argv[++i];
+            explorerIndex = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--book") == 0 && i + 1 < argc)
+        {
+            bookFile = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--nnue") == 0 && i + 1 < argc)
+        {
+            nnueFile = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--weights") == 0 && i + 1 < argc)
+        {
+            weightsFile = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            traceFile = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--fen") == 0)
+        {
+            fen.clear();
+            while(i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0 && std::strchr(argv[i + 1], '=') == nullptr)
+            {
+                fen += (fen.empty() ? "" : " ") + std::string(argv[++i]);
+            }
+        }
+    }
+
+#ifdef CHESS_TRACE
+    if(!traceFile.empty())
+    {
+        Chess::Trace::start();
+        CHESS_TRACE_THREAD("gui");
+    }
+#else
+    if(!traceFile.empty())
+    {
+        std::cerr << "--trace needs a build configured with -DCHESS_TRACE=ON" << std::endl;
+    }
+#endif
+
+    // Loaded before the game is set up, since the engine may start thinking right away
+    if(!nnueFile.empty() && !Chess::Nnue::load(nnueFile))
+    {
+        std::cerr << "Could not load the NNUE network " << nnueFile << ", using the piece-square tables" << std::endl;
+    }
+    if(!weightsFile.empty() && !Chess::Psqt::loadWeights(weightsFile))
+    {
+        std::cerr << "Could not load the evaluation weights " << weightsFile << ", using the built in ones" << std::endl;
+    }
+
     // The chess game
-    Chess::GameApplication chess(lm_ptr);
+    Chess::GameApplication chess(lm_ptr, fen);
+    if(!bookFile.empty())
+    {
+        chess.openBook(bookFile);
+    }
+    if(!explorerArchive.empty())
+    {
+        chess.openExplorer(explorerArchive, explorerIndex);
+    }
     chess.run();
 
+#ifdef CHESS_TRACE
+    // The engine thread is idle once the game is over
+    if(!traceFile.empty())
+    {
+        Chess::Trace::stop();
+        if(!Chess::Trace::write(traceFile))
+        {
+            std::cerr << "Could not write " << traceFile << std::endl;
+        }
+    }
+#endif
+
     return 0;
 }
-